@@ -0,0 +1,333 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <stdexcept>
+
+#if __AVX__ && __F16C__
+#include <immintrin.h>
+#endif
+
+#include "allreduce_engine.h"
+#include "half.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+// Tag of the messages of native allreduces. Communicators only carry one
+// collective operation at a time, so messages of different allreduces do not
+// mix.
+const int ALLREDUCE_TAG = 0x4852;
+
+// Crossover between recursive doubling and the ring for float16 when no
+// thresholds are set. Every step of the ring pays the network latency when
+// the ranks span nodes.
+const int64_t FLOAT16_LOCAL_CROSSOVER_BYTES = 64 * 1024;
+const int64_t FLOAT16_CROSS_NODE_CROSSOVER_BYTES = 1024 * 1024;
+
+int ElementSize(MPIDataType dtype) {
+  switch (dtype) {
+  case HOROVOD_UINT8:
+  case HOROVOD_INT8:
+  case HOROVOD_BOOL:
+    return 1;
+  case HOROVOD_UINT16:
+  case HOROVOD_INT16:
+  case HOROVOD_FLOAT16:
+    return 2;
+  case HOROVOD_INT32:
+  case HOROVOD_FLOAT32:
+    return 4;
+  default:
+    return 8;
+  }
+}
+
+template <typename T>
+void SumInteger(const T* src, T* dst, int64_t num_elements) {
+  for (int64_t i = 0; i < num_elements; ++i) {
+    dst[i] = (T)(dst[i] + src[i]);
+  }
+}
+
+void SumFloat(const float* src, float* dst, int64_t num_elements) {
+  int64_t i = 0;
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    for (; i < (num_elements / 8) * 8; i += 8) {
+      _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i),
+                                              _mm256_loadu_ps(src + i)));
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+void SumDouble(const double* src, double* dst, int64_t num_elements) {
+  int64_t i = 0;
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    for (; i < (num_elements / 4) * 4; i += 4) {
+      _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(dst + i),
+                                              _mm256_loadu_pd(src + i)));
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+void SumFloat16(const unsigned short* src, unsigned short* dst,
+                int64_t num_elements) {
+  int64_t i = 0;
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    for (; i < (num_elements / 8) * 8; i += 8) {
+      __m256 src_m256 = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)(src + i)));
+      __m256 dst_m256 = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)(dst + i)));
+      __m128i sum_m128i =
+          _mm256_cvtps_ph(_mm256_add_ps(dst_m256, src_m256), 0);
+      _mm_storeu_si128((__m128i*)(dst + i), sum_m128i);
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    float src_float;
+    float dst_float;
+    HalfBits2Float(const_cast<unsigned short*>(src + i), &src_float);
+    HalfBits2Float(dst + i, &dst_float);
+    dst_float += src_float;
+    Float2HalfBits(&dst_float, dst + i);
+  }
+}
+
+} // namespace
+
+AllreduceAlgorithm SelectAllreduceAlgorithm(int64_t num_bytes,
+                                            int64_t num_elements,
+                                            MPIDataType dtype, int size,
+                                            int local_size,
+                                            int64_t recursive_doubling_bytes,
+                                            int64_t ring_bytes) {
+  if (size == 1 || !IsSummable(dtype)) {
+    return AllreduceAlgorithm::MPI;
+  }
+  bool native_only = dtype == HOROVOD_FLOAT16;
+  if (native_only && recursive_doubling_bytes == 0 && ring_bytes == 0) {
+    recursive_doubling_bytes = size == local_size
+                                   ? FLOAT16_LOCAL_CROSSOVER_BYTES
+                                   : FLOAT16_CROSS_NODE_CROSSOVER_BYTES;
+    ring_bytes = recursive_doubling_bytes;
+  }
+  // The ring needs an element per rank.
+  bool ring_possible = num_elements >= size;
+  if (recursive_doubling_bytes > 0 && num_bytes < recursive_doubling_bytes) {
+    return AllreduceAlgorithm::RECURSIVE_DOUBLING;
+  }
+  if (ring_bytes > 0 && num_bytes >= ring_bytes && ring_possible) {
+    return AllreduceAlgorithm::RING;
+  }
+  if (native_only) {
+    return ring_possible ? AllreduceAlgorithm::RING
+                         : AllreduceAlgorithm::RECURSIVE_DOUBLING;
+  }
+  return AllreduceAlgorithm::MPI;
+}
+
+bool IsSummable(MPIDataType dtype) {
+  return dtype != HOROVOD_BOOL;
+}
+
+void SumBuffer(const void* src, void* dst, int64_t num_elements,
+               MPIDataType dtype) {
+  switch (dtype) {
+  case HOROVOD_UINT8:
+    SumInteger((const uint8_t*)src, (uint8_t*)dst, num_elements);
+    break;
+  case HOROVOD_INT8:
+    SumInteger((const int8_t*)src, (int8_t*)dst, num_elements);
+    break;
+  case HOROVOD_UINT16:
+    SumInteger((const uint16_t*)src, (uint16_t*)dst, num_elements);
+    break;
+  case HOROVOD_INT16:
+    SumInteger((const int16_t*)src, (int16_t*)dst, num_elements);
+    break;
+  case HOROVOD_INT32:
+    SumInteger((const int32_t*)src, (int32_t*)dst, num_elements);
+    break;
+  case HOROVOD_INT64:
+    SumInteger((const int64_t*)src, (int64_t*)dst, num_elements);
+    break;
+  case HOROVOD_FLOAT16:
+    SumFloat16((const unsigned short*)src, (unsigned short*)dst,
+               num_elements);
+    break;
+  case HOROVOD_FLOAT32:
+    SumFloat((const float*)src, (float*)dst, num_elements);
+    break;
+  case HOROVOD_FLOAT64:
+    SumDouble((const double*)src, (double*)dst, num_elements);
+    break;
+  default:
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
+                           " cannot be summed.");
+  }
+}
+
+int RingAllreduce(void* buffer, int64_t num_elements, MPIDataType dtype,
+                  MPI_Datatype datatype, MPI_Comm comm,
+                  std::vector<char>& scratch) {
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  if (size == 1) {
+    return MPI_SUCCESS;
+  }
+
+  // The buffer is split in a segment per rank, the first
+  // num_elements % size of which have one more element.
+  int element_size = ElementSize(dtype);
+  int64_t quotient = num_elements / size;
+  int64_t remainder = num_elements % size;
+  auto segment_begin = [&](int segment) {
+    return segment * quotient + std::min((int64_t)segment, remainder);
+  };
+  auto segment_size = [&](int segment) {
+    return quotient + (segment < remainder ? 1 : 0);
+  };
+  auto segment_data = [&](int segment) {
+    return (char*)buffer + segment_begin(segment) * element_size;
+  };
+  size_t scratch_bytes = (size_t)segment_size(0) * element_size;
+  if (scratch.size() < scratch_bytes) {
+    scratch.resize(scratch_bytes);
+  }
+
+  int left = (rank + size - 1) % size;
+  int right = (rank + 1) % size;
+
+  // Reduce-scatter: in step s, every rank adds segment rank - s - 1, received
+  // from the left, to its own, and passes it on in the next step. Rank ends up
+  // with the sum of segment rank + 1.
+  for (int s = 0; s < size - 1; ++s) {
+    int send_segment = (rank + size - s) % size;
+    int recv_segment = (rank + size - s - 1) % size;
+    int result = MPI_Sendrecv(
+        segment_data(send_segment), (int)segment_size(send_segment), datatype,
+        right, ALLREDUCE_TAG, scratch.data(), (int)segment_size(recv_segment),
+        datatype, left, ALLREDUCE_TAG, comm, MPI_STATUS_IGNORE);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+    SumBuffer(scratch.data(), segment_data(recv_segment),
+              segment_size(recv_segment), dtype);
+  }
+
+  // Allgather: the sums travel around the ring, straight into the buffer.
+  for (int s = 0; s < size - 1; ++s) {
+    int send_segment = (rank + 1 + size - s) % size;
+    int recv_segment = (rank + size - s) % size;
+    int result = MPI_Sendrecv(
+        segment_data(send_segment), (int)segment_size(send_segment), datatype,
+        right, ALLREDUCE_TAG, segment_data(recv_segment),
+        (int)segment_size(recv_segment), datatype, left, ALLREDUCE_TAG, comm,
+        MPI_STATUS_IGNORE);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+  }
+  return MPI_SUCCESS;
+}
+
+int RecursiveDoublingAllreduce(void* buffer, int64_t num_elements,
+                               MPIDataType dtype, MPI_Datatype datatype,
+                               MPI_Comm comm, std::vector<char>& scratch) {
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  if (size == 1) {
+    return MPI_SUCCESS;
+  }
+
+  size_t scratch_bytes = (size_t)num_elements * ElementSize(dtype);
+  if (scratch.size() < scratch_bytes) {
+    scratch.resize(scratch_bytes);
+  }
+
+  // With a number of ranks which is not a power of two, the first extra ranks
+  // at even positions hand their data to the next rank and wait for the
+  // result. The others exchange data with partners at doubling distances
+  // among the power of two remaining ranks. Both partners add the same two
+  // values, so all ranks get the same result.
+  int power_of_two = 1;
+  while (power_of_two * 2 <= size) {
+    power_of_two *= 2;
+  }
+  int extra = size - power_of_two;
+  int result;
+  int virtual_rank;
+  if (rank < 2 * extra) {
+    if (rank % 2 == 0) {
+      result = MPI_Send(buffer, (int)num_elements, datatype, rank + 1,
+                        ALLREDUCE_TAG, comm);
+      virtual_rank = -1;
+    } else {
+      result = MPI_Recv(scratch.data(), (int)num_elements, datatype, rank - 1,
+                        ALLREDUCE_TAG, comm, MPI_STATUS_IGNORE);
+      SumBuffer(scratch.data(), buffer, num_elements, dtype);
+      virtual_rank = rank / 2;
+    }
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+  } else {
+    virtual_rank = rank - extra;
+  }
+
+  if (virtual_rank >= 0) {
+    for (int distance = 1; distance < power_of_two; distance *= 2) {
+      int virtual_partner = virtual_rank ^ distance;
+      int partner = virtual_partner < extra ? virtual_partner * 2 + 1
+                                            : virtual_partner + extra;
+      result = MPI_Sendrecv(buffer, (int)num_elements, datatype, partner,
+                            ALLREDUCE_TAG, scratch.data(), (int)num_elements,
+                            datatype, partner, ALLREDUCE_TAG, comm,
+                            MPI_STATUS_IGNORE);
+      if (result != MPI_SUCCESS) {
+        return result;
+      }
+      SumBuffer(scratch.data(), buffer, num_elements, dtype);
+    }
+  }
+
+  if (rank < 2 * extra) {
+    if (rank % 2 == 0) {
+      return MPI_Recv(buffer, (int)num_elements, datatype, rank + 1,
+                      ALLREDUCE_TAG, comm, MPI_STATUS_IGNORE);
+    }
+    return MPI_Send(buffer, (int)num_elements, datatype, rank - 1,
+                    ALLREDUCE_TAG, comm);
+  }
+  return MPI_SUCCESS;
+}
+
+} // namespace common
+} // namespace horovod
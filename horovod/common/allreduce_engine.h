@@ -0,0 +1,80 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_ALLREDUCE_ENGINE_H
+#define HOROVOD_ALLREDUCE_ENGINE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "mpi_message.h"
+#define OMPI_SKIP_MPICXX
+#include "mpi.h"
+
+namespace horovod {
+namespace common {
+
+// Allreduce implementations built on MPI point-to-point operations, which sum
+// with the kernels of SumBuffer instead of an MPI_Op.
+enum class AllreduceAlgorithm {
+  // MPI_Allreduce, with the algorithm chosen by the MPI library.
+  MPI,
+  // Reduce-scatter followed by allgather around a ring. Sends 2 (size - 1) /
+  // size of the buffer in 2 (size - 1) steps, which is bandwidth optimal.
+  RING,
+  // Exchange of the whole buffer with partners at distance 1, 2, 4, ... in
+  // log2(size) steps, which suits small messages.
+  RECURSIVE_DOUBLING
+};
+
+// Choose the algorithm for an allreduce of num_bytes bytes of dtype over size
+// ranks, local_size of which share a node. Messages smaller than
+// recursive_doubling_bytes use recursive doubling, messages of at least
+// ring_bytes use the ring, and zero disables either. Messages in between,
+// and all messages when both are disabled, use MPI_Allreduce, except float16
+// ones, since MPI applies the float16_sum operation through its slow generic
+// path; they use the native algorithms with crossovers depending on whether
+// the ranks span nodes. The result must be the same on all ranks.
+AllreduceAlgorithm SelectAllreduceAlgorithm(int64_t num_bytes,
+                                            int64_t num_elements,
+                                            MPIDataType dtype, int size,
+                                            int local_size,
+                                            int64_t recursive_doubling_bytes,
+                                            int64_t ring_bytes);
+
+// Returns whether SumBuffer supports dtype.
+bool IsSummable(MPIDataType dtype);
+
+// Adds num_elements elements of src to dst. Floating point types are summed
+// with AVX when the CPU supports it, and float16 is summed in float32.
+void SumBuffer(const void* src, void* dst, int64_t num_elements,
+               MPIDataType dtype);
+
+// Sums buffer over the ranks of comm in place, around a ring. datatype is the
+// MPI datatype of dtype. Scratch holds one segment of the buffer, and grows if
+// needed. Returns the first MPI error.
+int RingAllreduce(void* buffer, int64_t num_elements, MPIDataType dtype,
+                  MPI_Datatype datatype, MPI_Comm comm,
+                  std::vector<char>& scratch);
+
+// Same as above, by recursive doubling. Scratch holds the whole buffer.
+int RecursiveDoublingAllreduce(void* buffer, int64_t num_elements,
+                               MPIDataType dtype, MPI_Datatype datatype,
+                               MPI_Comm comm, std::vector<char>& scratch);
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_ALLREDUCE_ENGINE_H
@@ -13,8 +13,10 @@
 // limitations under the License.
 // =============================================================================
 
-#include <sstream>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <sstream>
 
 #include "common.h"
 
@@ -61,45 +63,95 @@ const std::string& Status::reason() const {
 }
 
 void TensorShape::AddDim(int64_t dim) {
-  shape_.push_back(dim);
+  if (dims_ < MAX_INLINE_DIMS) {
+    inline_dims_[dims_] = dim;
+  } else {
+    if (dims_ == MAX_INLINE_DIMS) {
+      overflow_dims_.assign(inline_dims_, inline_dims_ + MAX_INLINE_DIMS);
+    }
+    overflow_dims_.push_back(dim);
+  }
+  ++dims_;
 }
 
 void TensorShape::AppendShape(TensorShape& other) {
-  for (auto dim : other.shape_) {
-    shape_.push_back(dim);
+  for (int i = 0; i < other.dims(); ++i) {
+    AddDim(other.dim_size(i));
   }
 }
 
 const std::string TensorShape::DebugString() const {
   std::stringstream args;
   args << "[";
-  for (auto it = shape_.begin(); it != shape_.end(); ++it) {
-    if (it != shape_.begin()) {
+  for (int i = 0; i < dims_; ++i) {
+    if (i > 0) {
       args << ", ";
     }
-    args << *it;
+    args << dims_data()[i];
   }
   args << "]";
   return args.str();
 }
 
 int TensorShape::dims() const {
-  return (int)shape_.size();
+  return dims_;
 }
 
 int64_t TensorShape::dim_size(int idx) const {
   assert(idx >= 0);
-  assert(idx < shape_.size());
-  return shape_[idx];
+  assert(idx < dims_);
+  return dims_data()[idx];
 }
 
 int64_t TensorShape::num_elements() const {
   int64_t result = 1;
-  for (auto dim : shape_) {
-    result *= dim;
+  for (int i = 0; i < dims_; ++i) {
+    result *= dims_data()[i];
   }
   return result;
 }
 
+bool TensorShape::operator==(const TensorShape& rhs) const {
+  return dims_ == rhs.dims_ &&
+         std::equal(dims_data(), dims_data() + dims_, rhs.dims_data());
+}
+
+const int64_t* TensorShape::dims_data() const {
+  return dims_ <= MAX_INLINE_DIMS ? inline_dims_ : overflow_dims_.data();
+}
+
+FutureReadyEvent::FutureReadyEvent() : future_(promise_.get_future()) {}
+
+void FutureReadyEvent::Set() {
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    promise_.set_value();
+    std::swap(callbacks, callbacks_);
+  }
+  for (auto& callback : callbacks) {
+    callback();
+  }
+}
+
+std::shared_future<void> FutureReadyEvent::future() const { return future_; }
+
+bool FutureReadyEvent::Ready() const {
+  return future_.wait_for(std::chrono::seconds(0)) ==
+         std::future_status::ready;
+}
+
+bool FutureReadyEvent::NotifyWhenReady(std::function<void()> callback) {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!Ready()) {
+      callbacks_.push_back(std::move(callback));
+      return true;
+    }
+  }
+  callback();
+  return true;
+}
+
 } // namespace common
 } // namespace horovod
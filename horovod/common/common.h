@@ -16,8 +16,12 @@
 #ifndef HOROVOD_COMMON_H
 #define HOROVOD_COMMON_H
 
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "mpi_message.h"
 
@@ -52,6 +56,9 @@ private:
   Status(StatusType type, std::string reason);
 };
 
+// Shapes of up to MAX_INLINE_DIMS dimensions, which covers almost all
+// tensors, are stored inline, so that shapes are built and copied without
+// allocating.
 class TensorShape {
 public:
   void AddDim(int64_t dim);
@@ -62,24 +69,53 @@ public:
   int64_t dim_size(int idx) const;
   int64_t num_elements() const;
 
-  inline bool operator==(const TensorShape& rhs) const {
-    return shape_ == rhs.shape_;
-  }
+  bool operator==(const TensorShape& rhs) const;
 
   inline bool operator!=(const TensorShape& rhs) const {
-    return shape_ != rhs.shape_;
+    return !(*this == rhs);
   }
 
 private:
-  std::vector<int64_t> shape_;
+  static const int MAX_INLINE_DIMS = 6;
+
+  const int64_t* dims_data() const;
+
+  int dims_ = 0;
+  int64_t inline_dims_[MAX_INLINE_DIMS];
+  // All the dimensions, once there are more than MAX_INLINE_DIMS.
+  std::vector<int64_t> overflow_dims_;
 };
 
 class ReadyEvent {
 public:
   virtual bool Ready() const = 0;
+  // Calls the callback once the event is ready, right away if it already is,
+  // from any thread. Returns false without calling it if the event cannot
+  // notify, in which case it is polled with Ready().
+  virtual bool NotifyWhenReady(std::function<void()> /*callback*/) {
+    return false;
+  }
   virtual ~ReadyEvent() = default;
 };
 
+// A ReadyEvent backed by a future, for data produced on the CPU by another
+// thread, which calls Set() once the data is ready.
+class FutureReadyEvent : public ReadyEvent {
+public:
+  FutureReadyEvent();
+  void Set();
+  std::shared_future<void> future() const;
+  virtual bool Ready() const override;
+  virtual bool NotifyWhenReady(std::function<void()> callback) override;
+
+private:
+  std::promise<void> promise_;
+  std::shared_future<void> future_;
+  // Callbacks waiting for the event, protected by the mutex.
+  std::mutex mutex_;
+  std::vector<std::function<void()>> callbacks_;
+};
+
 class OpContext;
 
 class PersistentBuffer {
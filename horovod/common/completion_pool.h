@@ -0,0 +1,167 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_COMPLETION_POOL_H
+#define HOROVOD_COMPLETION_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mpsc_queue.h"
+
+namespace horovod {
+namespace common {
+
+// CompletionPool is a fixed pool of threads which handle tasks submitted by
+// other threads, used to run user callbacks and collective operations off the
+// background thread.
+//
+// Every thread consumes its own MPSCQueue. Tasks are either spread over the
+// threads in turn, or submitted to a given thread, which handles them in
+// order. Tasks are filled in place in the cells of the queues, so
+// buffers owned by a task are reused by the tasks filled into the same cell
+// later. The handler is responsible for releasing whatever a task must not
+// keep alive.
+template <class T> class CompletionPool {
+public:
+  ~CompletionPool() { Stop(); }
+
+  // Starts the threads, each of which calls the handler on the tasks of its
+  // queue in order.
+  void Start(int num_threads, uint64_t capacity,
+             std::function<void(T&)> handler) {
+    handler_ = std::move(handler);
+    stop_ = false;
+    for (int i = 0; i < num_threads; ++i) {
+      workers_.emplace_back(new Worker(capacity));
+    }
+    for (auto& worker : workers_) {
+      Worker* w = worker.get();
+      w->thread = std::thread([this, w]() { Run(*w); });
+    }
+  }
+
+  // Runs the remaining tasks and joins the threads.
+  void Stop() {
+    for (auto& worker : workers_) {
+      std::lock_guard<std::mutex> guard(worker->mutex);
+      stop_ = true;
+      worker->cond.notify_all();
+    }
+    for (auto& worker : workers_) {
+      worker->thread.join();
+    }
+    workers_.clear();
+  }
+
+  bool started() const { return !workers_.empty(); }
+
+  size_t size() const { return workers_.size(); }
+
+  // Fills a task in place with fill(T&) and hands it over to a thread of the
+  // pool, waiting if the queue of that thread is full.
+  template <class Fill> void Submit(Fill fill) {
+    Submit(next_worker_.fetch_add(1, std::memory_order_relaxed) %
+               workers_.size(),
+           fill);
+  }
+
+  // Same as above, for the thread with the given index.
+  template <class Fill> void Submit(size_t index, Fill fill) {
+    auto& worker = *workers_[index];
+    ++worker.submitted;
+    auto position = worker.queue.Reserve(1);
+    fill(worker.queue.At(position));
+    worker.queue.Publish(position);
+    // Pairs with the fence in Run: either the thread sees the task before it
+    // sleeps, or this thread sees it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.waiting) {
+      std::lock_guard<std::mutex> guard(worker.mutex);
+      worker.cond.notify_all();
+    }
+  }
+
+  // Waits until the threads have handled every task submitted so far.
+  void Wait() {
+    for (auto& worker : workers_) {
+      std::unique_lock<std::mutex> lock(worker->mutex);
+      worker->draining = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      worker->idle_cond.wait(lock, [&]() {
+        return worker->handled == worker->submitted;
+      });
+      worker->draining = false;
+    }
+  }
+
+private:
+  struct Worker {
+    explicit Worker(uint64_t capacity) : queue(capacity) {}
+    MPSCQueue<T> queue;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic_bool waiting{false};
+    // Number of tasks submitted to and handled by the thread, and whether
+    // another thread waits for them to be equal.
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> handled{0};
+    std::condition_variable idle_cond;
+    std::atomic_bool draining{false};
+  };
+
+  void Run(Worker& worker) {
+    auto& queue = worker.queue;
+    for (;;) {
+      if (queue.Ready()) {
+        handler_(queue.Peek());
+        queue.Pop();
+        ++worker.handled;
+        // Pairs with the fence in Wait.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.draining) {
+          std::lock_guard<std::mutex> guard(worker.mutex);
+          worker.idle_cond.notify_all();
+        }
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(worker.mutex);
+      if (stop_ && !queue.Ready()) {
+        return;
+      }
+      worker.waiting = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      worker.cond.wait(lock, [&]() { return queue.Ready() || stop_; });
+      worker.waiting = false;
+    }
+  }
+
+  std::function<void(T&)> handler_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<uint64_t> next_worker_{0};
+  // Set under the mutexes of the workers, so that none misses it.
+  std::atomic_bool stop_{false};
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_COMPLETION_POOL_H
@@ -0,0 +1,123 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "fused_datatype_cache.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+int CreateDatatype(MPI_Datatype base_type, const BlockList& block_list,
+                   MPI_Datatype* datatype) {
+  auto& counts = block_list.counts;
+  auto& addresses = block_list.addresses;
+
+  // Blocks of equal size are described with the more compact block type.
+  bool equal_counts = true;
+  for (auto count : counts) {
+    equal_counts &= count == counts[0];
+  }
+  int result;
+  if (!counts.empty() && equal_counts) {
+    result = MPI_Type_create_hindexed_block((int)counts.size(), counts[0],
+                                            addresses.data(), base_type,
+                                            datatype);
+  } else {
+    result = MPI_Type_create_hindexed((int)counts.size(), counts.data(),
+                                      addresses.data(), base_type, datatype);
+  }
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  result = MPI_Type_commit(datatype);
+  if (result != MPI_SUCCESS) {
+    MPI_Type_free(datatype);
+  }
+  return result;
+}
+
+} // namespace
+
+FusedDatatypeCache::FusedDatatypeCache(size_t capacity)
+    : capacity_(capacity) {}
+
+int FusedDatatypeCache::Get(MPI_Datatype base_type,
+                            const std::vector<BlockList>& block_lists,
+                            const std::vector<MPI_Datatype>** datatypes) {
+  Key key;
+  for (auto& block_list : block_lists) {
+    key.push_back((int64_t)block_list.addresses.size());
+    for (size_t i = 0; i < block_list.addresses.size(); ++i) {
+      key.push_back((int64_t)block_list.addresses[i]);
+      key.push_back(block_list.counts[i]);
+    }
+  }
+
+  auto it = cache_.find(key);
+  if (it != cache_.end()) {
+    if (it->second.base_type == base_type) {
+      lru_.splice(lru_.begin(), lru_, it->second.lru_iter);
+      *datatypes = &it->second.datatypes;
+      return MPI_SUCCESS;
+    }
+    Erase(it);
+  }
+
+  CacheEntry entry;
+  entry.base_type = base_type;
+  for (auto& block_list : block_lists) {
+    MPI_Datatype datatype;
+    int result = CreateDatatype(base_type, block_list, &datatype);
+    if (result != MPI_SUCCESS) {
+      for (auto& created : entry.datatypes) {
+        MPI_Type_free(&created);
+      }
+      return result;
+    }
+    entry.datatypes.push_back(datatype);
+  }
+
+  if (cache_.size() >= capacity_) {
+    Erase(cache_.find(lru_.back()));
+  }
+  lru_.push_front(key);
+  entry.lru_iter = lru_.begin();
+  auto& cached = cache_.emplace(std::move(key), std::move(entry)).first->second;
+  *datatypes = &cached.datatypes;
+  return MPI_SUCCESS;
+}
+
+void FusedDatatypeCache::Erase(
+    std::unordered_map<Key, CacheEntry>::iterator it) {
+  for (auto& datatype : it->second.datatypes) {
+    MPI_Type_free(&datatype);
+  }
+  lru_.erase(it->second.lru_iter);
+  cache_.erase(it);
+}
+
+void FusedDatatypeCache::Clear() {
+  for (auto& it : cache_) {
+    for (auto& datatype : it.second.datatypes) {
+      MPI_Type_free(&datatype);
+    }
+  }
+  cache_.clear();
+  lru_.clear();
+}
+
+} // namespace common
+} // namespace horovod
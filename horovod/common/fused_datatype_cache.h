@@ -0,0 +1,81 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_FUSED_DATATYPE_CACHE_H
+#define HOROVOD_FUSED_DATATYPE_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#define OMPI_SKIP_MPICXX
+#include "mpi.h"
+
+#include "hashes.h"
+
+namespace horovod {
+namespace common {
+
+// Memory blocks of a set of fused tensors: counts[i] elements at the absolute
+// address addresses[i].
+struct BlockList {
+  std::vector<MPI_Aint> addresses;
+  std::vector<int> counts;
+};
+
+// FusedDatatypeCache keeps committed MPI derived datatypes which describe the
+// memory of fused tensors, so that MPI can move the data of the tensors
+// directly instead of a copy in the fusion buffer.
+//
+// Datatypes use absolute addresses, so they are used with MPI_BOTTOM as the
+// buffer. The datatypes of one operation are cached together, keyed by the
+// addresses and element counts of all their blocks, which repeat across steps
+// whenever the framework reuses its allocations. The datatypes of the least
+// recently used operation are freed once the cache is full.
+class FusedDatatypeCache {
+public:
+  explicit FusedDatatypeCache(size_t capacity = 64);
+
+  // Sets datatypes to committed datatypes of base_type elements, one for each
+  // block list, creating them if they are not cached. The datatypes remain
+  // valid until the next call. Returns the MPI error code.
+  int Get(MPI_Datatype base_type, const std::vector<BlockList>& block_lists,
+          const std::vector<MPI_Datatype>** datatypes);
+
+  // Frees all cached datatypes. Must be called before MPI is finalized.
+  void Clear();
+
+private:
+  using Key = std::vector<int64_t>;
+
+  struct CacheEntry {
+    MPI_Datatype base_type;
+    std::vector<MPI_Datatype> datatypes;
+    std::list<Key>::iterator lru_iter;
+  };
+
+  void Erase(std::unordered_map<Key, CacheEntry>::iterator it);
+
+  size_t capacity_;
+  std::unordered_map<Key, CacheEntry> cache_;
+
+  // Keys ordered from the most to the least recently used.
+  std::list<Key> lru_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_FUSED_DATATYPE_CACHE_H
@@ -134,6 +134,11 @@ inline void Float2HalfBits(float* src, unsigned short* dest) {
 
 void float16_sum(void* invec, void* inoutvec, int* len, MPI_Datatype* datatype);
 
+#if __AVX__ && __F16C__
+// Returns whether the CPU supports AVX and F16C at runtime.
+bool is_avx_and_f16c();
+#endif
+
 } // namespace common
 } // namespace horovod
 
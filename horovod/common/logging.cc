@@ -36,9 +36,8 @@ void LogMessage::GenerateLogMessage(bool log_time) {
 }
 
 LogMessage::~LogMessage() {
-  static LogLevel min_log_level = MinLogLevelFromEnv();
   static bool log_time = LogTimeFromEnv();
-  if (severity_ >= min_log_level) {
+  if (ShouldLog(severity_)) {
     GenerateLogMessage(log_time);
   }
 }
@@ -72,6 +71,11 @@ LogLevel ParseLogLevelStr(const char* env_var_val) {
   }
 }
 
+bool ShouldLog(LogLevel severity) {
+  static LogLevel min_log_level = MinLogLevelFromEnv();
+  return severity >= min_log_level;
+}
+
 LogLevel MinLogLevelFromEnv() {
   const char* env_var_val = getenv("HOROVOD_LOG_LEVEL");
   if (env_var_val == nullptr) {
@@ -32,16 +32,26 @@ class LogMessageFatal : public LogMessage {
   ~LogMessageFatal();
 };
 
-#define _HVD_LOG_TRACE \
-  LogMessage(__FILE__, __LINE__, LogLevel::TRACE)
-#define _HVD_LOG_DEBUG \
-  LogMessage(__FILE__, __LINE__, LogLevel::DEBUG)
-#define _HVD_LOG_INFO \
-  LogMessage(__FILE__, __LINE__, LogLevel::INFO)
-#define _HVD_LOG_WARNING \
-  LogMessage(__FILE__, __LINE__, LogLevel::WARNING)
-#define _HVD_LOG_ERROR \
-  LogMessage(__FILE__, __LINE__, LogLevel::ERROR)
+// Returns whether messages of the severity are logged.
+bool ShouldLog(LogLevel severity);
+
+// Discards a streamed message, so that messages below the minimum log level
+// are skipped without formatting them.
+class LogMessageVoidify {
+ public:
+  void operator&(const std::ostream&) {}
+};
+
+#define _HVD_LOG_IF_ENABLED(severity)                                         \
+  !ShouldLog(severity) ? (void)0                                              \
+                       : LogMessageVoidify() &                                \
+                             LogMessage(__FILE__, __LINE__, severity)
+
+#define _HVD_LOG_TRACE _HVD_LOG_IF_ENABLED(LogLevel::TRACE)
+#define _HVD_LOG_DEBUG _HVD_LOG_IF_ENABLED(LogLevel::DEBUG)
+#define _HVD_LOG_INFO _HVD_LOG_IF_ENABLED(LogLevel::INFO)
+#define _HVD_LOG_WARNING _HVD_LOG_IF_ENABLED(LogLevel::WARNING)
+#define _HVD_LOG_ERROR _HVD_LOG_IF_ENABLED(LogLevel::ERROR)
 #define _HVD_LOG_FATAL \
   LogMessageFatal(__FILE__, __LINE__)
 
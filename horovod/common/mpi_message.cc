@@ -59,6 +59,23 @@ const std::string& MPIDataType_Name(MPIDataType value) {
   }
 }
 
+const std::string& Compression_Name(Compression value) {
+  switch (value) {
+  case NO_COMPRESSION:
+    static const std::string none("none");
+    return none;
+  case FP16_COMPRESSION:
+    static const std::string fp16("fp16");
+    return fp16;
+  case TOPK_COMPRESSION:
+    static const std::string topk("topk");
+    return topk;
+  default:
+    static const std::string unknown("<unknown>");
+    return unknown;
+  }
+}
+
 const std::string& MPIRequest::RequestType_Name(RequestType value) {
   switch (value) {
   case RequestType::ALLREDUCE:
@@ -70,6 +87,15 @@ const std::string& MPIRequest::RequestType_Name(RequestType value) {
   case RequestType::BROADCAST:
     static const std::string broadcast("BROADCAST");
     return broadcast;
+  case RequestType::REDUCESCATTER:
+    static const std::string reducescatter("REDUCESCATTER");
+    return reducescatter;
+  case RequestType::ALLTOALL:
+    static const std::string alltoall("ALLTOALL");
+    return alltoall;
+  case RequestType::SPARSE_ALLREDUCE:
+    static const std::string sparse_allreduce("SPARSE_ALLREDUCE");
+    return sparse_allreduce;
   default:
     static const std::string unknown("<unknown>");
     return unknown;
@@ -116,6 +142,30 @@ void MPIRequest::add_tensor_shape(int64_t value) {
   tensor_shape_.push_back(value);
 }
 
+void MPIRequest::clear_tensor_shape() { tensor_shape_.clear(); }
+
+int32_t MPIRequest::tensor_id() const { return tensor_id_; }
+
+void MPIRequest::set_tensor_id(int32_t value) { tensor_id_ = value; }
+
+const std::vector<int64_t>& MPIRequest::tensor_splits() const {
+  return tensor_splits_;
+}
+
+void MPIRequest::set_tensor_splits(const std::vector<int64_t>& value) {
+  tensor_splits_ = value;
+}
+
+void MPIRequest::clear_tensor_splits() { tensor_splits_.clear(); }
+
+int64_t MPIRequest::dense_rows() const { return dense_rows_; }
+
+void MPIRequest::set_dense_rows(int64_t value) { dense_rows_ = value; }
+
+Compression MPIRequest::compression() const { return compression_; }
+
+void MPIRequest::set_compression(Compression value) { compression_ = value; }
+
 namespace {
 
 void MPIRequest_ParseFromWire(MPIRequest& request,
@@ -123,29 +173,53 @@ void MPIRequest_ParseFromWire(MPIRequest& request,
   request.set_request_rank(obj->request_rank());
   request.set_request_type((MPIRequest::RequestType)obj->request_type());
   request.set_tensor_type((MPIDataType)obj->tensor_type());
-  request.set_tensor_name(obj->tensor_name()->str());
+  if (obj->tensor_name() != nullptr) {
+    request.set_tensor_name(obj->tensor_name()->str());
+  }
   request.set_root_rank(obj->root_rank());
   request.set_device(obj->device());
   request.set_tensor_shape(std::vector<int64_t>(obj->tensor_shape()->begin(),
                                                 obj->tensor_shape()->end()));
+  request.set_tensor_id(obj->tensor_id());
+  if (obj->tensor_splits() != nullptr) {
+    request.set_tensor_splits(std::vector<int64_t>(
+        obj->tensor_splits()->begin(), obj->tensor_splits()->end()));
+  }
+  request.set_dense_rows(obj->dense_rows());
+  request.set_compression((Compression)obj->compression());
 }
 
 void MPIRequest_SerializeToWire(const MPIRequest& request,
                                 flatbuffers::FlatBufferBuilder& builder,
                                 flatbuffers::Offset<wire::MPIRequest>& obj) {
   // FlatBuffers must be built bottom-up.
-  auto tensor_name_wire = builder.CreateString(request.tensor_name());
+  flatbuffers::Offset<flatbuffers::String> tensor_name_wire;
+  if (request.tensor_id() < 0) {
+    tensor_name_wire = builder.CreateString(request.tensor_name());
+  }
   auto tensor_shape_wire = builder.CreateVector(request.tensor_shape());
+  flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_splits_wire;
+  if (!request.tensor_splits().empty()) {
+    tensor_splits_wire = builder.CreateVector(request.tensor_splits());
+  }
 
   wire::MPIRequestBuilder request_builder(builder);
   request_builder.add_request_rank(request.request_rank());
   request_builder.add_request_type(
       (wire::MPIRequestType)request.request_type());
   request_builder.add_tensor_type((wire::MPIDataType)request.tensor_type());
-  request_builder.add_tensor_name(tensor_name_wire);
+  if (request.tensor_id() < 0) {
+    request_builder.add_tensor_name(tensor_name_wire);
+  }
   request_builder.add_root_rank(request.root_rank());
   request_builder.add_device(request.device());
   request_builder.add_tensor_shape(tensor_shape_wire);
+  request_builder.add_tensor_id(request.tensor_id());
+  if (!request.tensor_splits().empty()) {
+    request_builder.add_tensor_splits(tensor_splits_wire);
+  }
+  request_builder.add_dense_rows(request.dense_rows());
+  request_builder.add_compression((wire::Compression)request.compression());
   obj = request_builder.Finish();
 }
 
@@ -185,7 +259,7 @@ void MPIRequestList::add_request(const MPIRequest& value) {
 }
 
 void MPIRequestList::emplace_request(MPIRequest&& value) {
-  requests_.emplace_back(value);
+  requests_.emplace_back(std::move(value));
 }
 
 void MPIRequestList::ParseFromBytes(MPIRequestList& request_list,
@@ -237,6 +311,15 @@ const std::string& MPIResponse::ResponseType_Name(ResponseType value) {
   case ResponseType::ERROR:
     static const std::string error("ERROR");
     return error;
+  case ResponseType::REDUCESCATTER:
+    static const std::string reducescatter("REDUCESCATTER");
+    return reducescatter;
+  case ResponseType::ALLTOALL:
+    static const std::string alltoall("ALLTOALL");
+    return alltoall;
+  case ResponseType::SPARSE_ALLREDUCE:
+    static const std::string sparse_allreduce("SPARSE_ALLREDUCE");
+    return sparse_allreduce;
   default:
     static const std::string unknown("<unknown>");
     return unknown;
@@ -271,10 +354,31 @@ const std::string MPIResponse::tensor_names_string() const {
 
 void MPIResponse::set_tensor_names(const std::vector<std::string>& value) {
   tensor_names_ = value;
+  tensor_ids_.assign(value.size(), -1);
+}
+
+void MPIResponse::add_tensor_name(const std::string& value,
+                                  int32_t tensor_id) {
+  if (spare_tensor_names_.empty()) {
+    tensor_names_.push_back(value);
+  } else {
+    tensor_names_.push_back(std::move(spare_tensor_names_.back()));
+    spare_tensor_names_.pop_back();
+    tensor_names_.back().assign(value);
+  }
+  tensor_ids_.push_back(tensor_id);
 }
 
-void MPIResponse::add_tensor_name(const std::string& value) {
-  tensor_names_.push_back(value);
+void MPIResponse::set_tensor_name(int index, const std::string& value) {
+  tensor_names_[index] = value;
+}
+
+const std::vector<int32_t>& MPIResponse::tensor_ids() const {
+  return tensor_ids_;
+}
+
+void MPIResponse::set_tensor_id(int index, int32_t value) {
+  tensor_ids_[index] = value;
 }
 
 const std::string& MPIResponse::error_message() const { return error_message_; }
@@ -304,20 +408,37 @@ void MPIResponse::add_tensor_size(int64_t value) {
 }
 
 void MPIResponse::add_allgather_response(const MPIResponse& response) {
-  assert(response_type() == MPIResponse::ResponseType::ALLGATHER);
+  assert(response_type() == MPIResponse::ResponseType::ALLGATHER ||
+         response_type() == MPIResponse::ResponseType::ALLTOALL ||
+         response_type() == MPIResponse::ResponseType::SPARSE_ALLREDUCE);
+  assert(response.response_type() == response_type());
   assert(response.tensor_names().size() == 1);
   assert(response.devices() == devices());
-  add_tensor_name(response.tensor_names()[0]);
+  add_tensor_name(response.tensor_names()[0], response.tensor_ids()[0]);
   for (auto size : response.tensor_sizes()) {
     add_tensor_size(size);
   }
 }
 
+void MPIResponse::clear() {
+  response_type_ = ResponseType::ALLREDUCE;
+  for (auto& name : tensor_names_) {
+    spare_tensor_names_.push_back(std::move(name));
+  }
+  tensor_names_.clear();
+  tensor_ids_.clear();
+  error_message_.clear();
+  devices_.clear();
+  tensor_sizes_.clear();
+}
+
 void MPIResponse_ParseFromWire(MPIResponse& response,
                                const wire::MPIResponse* obj) {
   response.set_response_type((MPIResponse::ResponseType)obj->response_type());
-  for (const auto& tensor_name_obj : *obj->tensor_names()) {
-    response.add_tensor_name(tensor_name_obj->str());
+  auto tensor_ids_obj = obj->tensor_ids();
+  for (flatbuffers::uoffset_t i = 0; i < obj->tensor_names()->size(); ++i) {
+    response.add_tensor_name(obj->tensor_names()->Get(i)->str(),
+                             tensor_ids_obj->Get(i));
   }
   response.set_error_message(obj->error_message()->str());
   response.set_devices(
@@ -334,12 +455,26 @@ void MPIResponse::ParseFromBytes(MPIResponse& response, const uint8_t* input) {
 void MPIResponse_SerializeToWire(const MPIResponse& response,
                                  flatbuffers::FlatBufferBuilder& builder,
                                  flatbuffers::Offset<wire::MPIResponse>& obj) {
-  // FlatBuffers must be built bottom-up.
-  auto tensor_names_wire =
-      builder.CreateVectorOfStrings(response.tensor_names());
+  // FlatBuffers must be built bottom-up. Names are only sent for tensors
+  // without an ID, all others share a single empty string.
+  std::vector<flatbuffers::Offset<flatbuffers::String>> tensor_names;
+  tensor_names.reserve(response.tensor_names().size());
+  flatbuffers::Offset<flatbuffers::String> empty_name_wire;
+  for (unsigned int i = 0; i < response.tensor_names().size(); ++i) {
+    if (response.tensor_ids()[i] < 0) {
+      tensor_names.push_back(builder.CreateString(response.tensor_names()[i]));
+    } else {
+      if (empty_name_wire.o == 0) {
+        empty_name_wire = builder.CreateString("");
+      }
+      tensor_names.push_back(empty_name_wire);
+    }
+  }
+  auto tensor_names_wire = builder.CreateVector(tensor_names);
   auto error_message_wire = builder.CreateString(response.error_message());
   auto devices_wire = builder.CreateVector(response.devices());
   auto tensor_sizes_wire = builder.CreateVector(response.tensor_sizes());
+  auto tensor_ids_wire = builder.CreateVector(response.tensor_ids());
 
   wire::MPIResponseBuilder response_builder(builder);
   response_builder.add_response_type(
@@ -348,6 +483,7 @@ void MPIResponse_SerializeToWire(const MPIResponse& response,
   response_builder.add_error_message(error_message_wire);
   response_builder.add_devices(devices_wire);
   response_builder.add_tensor_sizes(tensor_sizes_wire);
+  response_builder.add_tensor_ids(tensor_ids_wire);
   obj = response_builder.Finish();
 }
 
@@ -367,6 +503,10 @@ const std::vector<MPIResponse>& MPIResponseList::responses() const {
   return responses_;
 }
 
+std::vector<MPIResponse>& MPIResponseList::mutable_responses() {
+  return responses_;
+}
+
 void MPIResponseList::set_responses(const std::vector<MPIResponse>& value) {
   responses_ = value;
 }
@@ -375,12 +515,16 @@ bool MPIResponseList::shutdown() const { return shutdown_; }
 
 void MPIResponseList::set_shutdown(bool value) { shutdown_ = value; }
 
+uint64_t MPIResponseList::sequence() const { return sequence_; }
+
+void MPIResponseList::set_sequence(uint64_t value) { sequence_ = value; }
+
 void MPIResponseList::add_response(const MPIResponse& value) {
   responses_.push_back(value);
 }
 
 void MPIResponseList::emplace_response(MPIResponse&& value) {
-  responses_.emplace_back(value);
+  responses_.emplace_back(std::move(value));
 }
 
 void MPIResponseList::ParseFromBytes(MPIResponseList& response_list,
@@ -392,6 +536,7 @@ void MPIResponseList::ParseFromBytes(MPIResponseList& response_list,
     response_list.emplace_response(std::move(response));
   }
   response_list.set_shutdown(obj->shutdown());
+  response_list.set_sequence(obj->sequence());
 }
 
 void MPIResponseList::SerializeToString(const MPIResponseList& response_list,
@@ -410,6 +555,7 @@ void MPIResponseList::SerializeToString(const MPIResponseList& response_list,
   wire::MPIResponseListBuilder response_list_builder(builder);
   response_list_builder.add_responses(responses_wire);
   response_list_builder.add_shutdown(response_list.shutdown());
+  response_list_builder.add_sequence(response_list.sequence());
   auto obj = response_list_builder.Finish();
   builder.Finish(obj);
 
@@ -38,12 +38,32 @@ enum MPIDataType {
 
 const std::string& MPIDataType_Name(MPIDataType value);
 
+// Compression applied by Horovod to an allreduce while the tensor is copied
+// into and out of the fusion buffer.
+enum Compression {
+  NO_COMPRESSION = 0,
+  // Float32 tensors are reduced as float16.
+  FP16_COMPRESSION = 1,
+  // Every rank sends the elements of largest magnitude of float32 tensors,
+  // and keeps the others in a residual added to the tensor at the next step.
+  TOPK_COMPRESSION = 2
+};
+
+const std::string& Compression_Name(Compression value);
+
 // An MPIRequest is a message sent from a rank greater than zero to the
 // coordinator (rank zero), informing the coordinator of an operation that
 // the rank wants to do and the tensor that it wants to apply the operation to.
 class MPIRequest {
 public:
-  enum RequestType { ALLREDUCE = 0, ALLGATHER = 1, BROADCAST = 2 };
+  enum RequestType {
+    ALLREDUCE = 0,
+    ALLGATHER = 1,
+    BROADCAST = 2,
+    REDUCESCATTER = 3,
+    ALLTOALL = 4,
+    SPARSE_ALLREDUCE = 5
+  };
 
   static const std::string& RequestType_Name(RequestType value);
 
@@ -71,6 +91,29 @@ public:
   const std::vector<int64_t>& tensor_shape() const;
   void set_tensor_shape(const std::vector<int64_t>& value);
   void add_tensor_shape(int64_t value);
+  void clear_tensor_shape();
+
+  // ID of the tensor agreed on by all ranks, or -1 if the tensor has no ID
+  // yet. Only the ID is serialized for tensors that have one, so the tensor
+  // name of a parsed request may be empty.
+  int32_t tensor_id() const;
+  void set_tensor_id(int32_t value);
+
+  // Number of dimension zero slices sent to every rank, indexed by the
+  // destination rank. Empty unless request_type is ALLTOALL.
+  const std::vector<int64_t>& tensor_splits() const;
+  void set_tensor_splits(const std::vector<int64_t>& value);
+  void clear_tensor_splits();
+
+  // Number of rows of the dense tensor represented by a sparse allreduce, or
+  // 0 if unknown. Zero unless request_type is SPARSE_ALLREDUCE.
+  int64_t dense_rows() const;
+  void set_dense_rows(int64_t value);
+
+  // Compression of the tensor while it is reduced. NO_COMPRESSION unless
+  // request_type is ALLREDUCE.
+  Compression compression() const;
+  void set_compression(Compression value);
 
   static void ParseFromBytes(MPIRequest& request, const uint8_t* input);
   static void SerializeToString(const MPIRequest& request, std::string& output);
@@ -81,8 +124,12 @@ private:
   MPIDataType tensor_type_ = MPIDataType::HOROVOD_UINT8;
   int32_t root_rank_ = 0;
   int32_t device_ = 0;
+  int32_t tensor_id_ = -1;
   std::string tensor_name_;
   std::vector<int64_t> tensor_shape_;
+  std::vector<int64_t> tensor_splits_;
+  int64_t dense_rows_ = 0;
+  Compression compression_ = NO_COMPRESSION;
 };
 
 class MPIRequestList {
@@ -111,7 +158,15 @@ private:
 // an error message instead.
 class MPIResponse {
 public:
-  enum ResponseType { ALLREDUCE = 0, ALLGATHER = 1, BROADCAST = 2, ERROR = 3 };
+  enum ResponseType {
+    ALLREDUCE = 0,
+    ALLGATHER = 1,
+    BROADCAST = 2,
+    ERROR = 3,
+    REDUCESCATTER = 4,
+    ALLTOALL = 5,
+    SPARSE_ALLREDUCE = 6
+  };
 
   static const std::string& ResponseType_Name(ResponseType value);
 
@@ -122,7 +177,14 @@ public:
   const std::vector<std::string>& tensor_names() const;
   const std::string tensor_names_string() const;
   void set_tensor_names(const std::vector<std::string>& value);
-  void add_tensor_name(const std::string& value);
+  void add_tensor_name(const std::string& value, int32_t tensor_id = -1);
+  void set_tensor_name(int index, const std::string& value);
+
+  // IDs of the tensors, aligned with tensor_names. An ID is -1 for tensors
+  // without an ID yet. Only the ID is serialized for tensors that have one,
+  // so names of a parsed response may be empty.
+  const std::vector<int32_t>& tensor_ids() const;
+  void set_tensor_id(int index, int32_t value);
 
   // Empty unless response_type is ERROR.
   const std::string& error_message() const;
@@ -132,16 +194,22 @@ public:
   void set_devices(const std::vector<int32_t>& value);
   void add_device(int32_t value);
 
-  // Empty unless response_type is ALLGATHER.
-  // These tensor sizes are the dimension zero sizes of all the input matrices,
-  // indexed by the rank.
+  // Empty unless response_type is ALLGATHER, ALLTOALL or SPARSE_ALLREDUCE.
+  // For ALLGATHER and SPARSE_ALLREDUCE, these tensor sizes are the dimension
+  // zero sizes of all the input matrices, indexed by the rank. For ALLTOALL,
+  // they are the splits of all the input matrices, indexed by the sending
+  // rank times the number of ranks plus the receiving rank.
   const std::vector<int64_t>& tensor_sizes() const;
   void set_tensor_sizes(const std::vector<int64_t>& value);
   void add_tensor_size(int64_t value);
 
-  // To fuse multiple allgather responses
+  // To fuse multiple allgather, alltoall or sparse allreduce responses
   void add_allgather_response(const MPIResponse& response);
 
+  // Resets the response to an empty ALLREDUCE. The buffers of its fields and
+  // of the names of its tensors are kept for the next tensors added to it.
+  void clear();
+
   static void ParseFromBytes(MPIResponse& response, const uint8_t* input);
   static void SerializeToString(const MPIResponse& response,
                                 std::string& output);
@@ -149,19 +217,25 @@ public:
 private:
   ResponseType response_type_ = ResponseType::ALLREDUCE;
   std::vector<std::string> tensor_names_;
+  std::vector<int32_t> tensor_ids_;
   std::string error_message_;
   std::vector<int32_t> devices_;
   std::vector<int64_t> tensor_sizes_;
+  // Names removed by clear(), whose buffers are reused by add_tensor_name.
+  std::vector<std::string> spare_tensor_names_;
 };
 
 class MPIResponseList {
 public:
   const std::vector<MPIResponse>& responses() const;
+  std::vector<MPIResponse>& mutable_responses();
   void set_responses(const std::vector<MPIResponse>& value);
   void add_response(const MPIResponse& value);
   void emplace_response(MPIResponse&& value);
   bool shutdown() const;
   void set_shutdown(bool value);
+  uint64_t sequence() const;
+  void set_sequence(uint64_t value);
 
   static void ParseFromBytes(MPIResponseList& response_list,
                              const uint8_t* input);
@@ -171,6 +245,7 @@ public:
 private:
   std::vector<MPIResponse> responses_;
   bool shutdown_ = false;
+  uint64_t sequence_ = 0;
 };
 
 } // namespace common
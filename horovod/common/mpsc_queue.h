@@ -0,0 +1,146 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_MPSC_QUEUE_H
+#define HOROVOD_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace horovod {
+namespace common {
+
+// MPSCQueue is a bounded lock-free queue with multiple producers and a single
+// consumer.
+//
+// Elements live in a ring of cells, which are constructed with the queue and
+// never destroyed while it exists. Producers reserve one or more consecutive
+// cells, fill them in place and publish them, and the consumer processes the
+// published cells in place before popping them. Buffers owned by the elements
+// are therefore reused by the elements filled into the same cells later.
+//
+// Every cell carries a sequence number, which tells producers whether the cell
+// is free in the current lap of the ring and the consumer whether it has been
+// published.
+template <class T> class MPSCQueue {
+public:
+  // Capacity is rounded up to a power of two.
+  explicit MPSCQueue(uint64_t capacity) {
+    capacity_ = 1;
+    while (capacity_ < capacity) {
+      capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    cells_.reset(new Cell[capacity_]);
+    for (uint64_t i = 0; i < capacity_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    tail_.store(0, std::memory_order_relaxed);
+    head_ = 0;
+  }
+
+  uint64_t capacity() const { return capacity_; }
+
+  // Producer interface.
+
+  // Reserves count consecutive cells, waiting for the consumer to pop cells
+  // if the queue is full, and returns the position of the first one. The
+  // count must not exceed the capacity.
+  uint64_t Reserve(uint64_t count) {
+    assert(count > 0 && count <= capacity_);
+    uint64_t position = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      // Cells are popped in order, so all the cells are free once the last
+      // one is.
+      uint64_t last = position + count - 1;
+      uint64_t sequence =
+          cells_[last & mask_].sequence.load(std::memory_order_acquire);
+      auto diff = (int64_t)(sequence - last);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(position, position + count,
+                                        std::memory_order_relaxed)) {
+          return position;
+        }
+      } else if (diff < 0) {
+        // The cell still holds an element of the previous lap.
+        std::this_thread::yield();
+        position = tail_.load(std::memory_order_relaxed);
+      } else {
+        // Another producer reserved the cells first.
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns the element of a reserved cell, to be filled in before the cell
+  // is published.
+  T& At(uint64_t position) { return cells_[position & mask_].value; }
+
+  // Hands the element of a reserved cell over to the consumer.
+  void Publish(uint64_t position) {
+    cells_[position & mask_].sequence.store(position + 1,
+                                            std::memory_order_release);
+  }
+
+  // Consumer interface.
+
+  // Returns whether the cell at the given offset from the head has been
+  // published.
+  bool Ready(uint64_t offset = 0) const {
+    uint64_t position = head_ + offset;
+    return cells_[position & mask_].sequence.load(
+               std::memory_order_acquire) == position + 1;
+  }
+
+  // Returns the element at the given offset from the head, which must have
+  // been published.
+  T& Peek(uint64_t offset = 0) {
+    assert(Ready(offset));
+    return cells_[(head_ + offset) & mask_].value;
+  }
+
+  // Frees the cell at the head for the next lap. The element is left in the
+  // cell.
+  void Pop() {
+    cells_[head_ & mask_].sequence.store(head_ + capacity_,
+                                         std::memory_order_release);
+    ++head_;
+  }
+
+private:
+  struct Cell {
+    std::atomic<uint64_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  uint64_t capacity_;
+  uint64_t mask_;
+
+  // Position of the next cell to reserve, shared by the producers, and of the
+  // next cell to consume, padded onto separate cache lines.
+  char padding0_[64];
+  std::atomic<uint64_t> tail_;
+  char padding1_[64];
+  uint64_t head_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_MPSC_QUEUE_H
@@ -0,0 +1,119 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_OBJECT_POOL_H
+#define HOROVOD_OBJECT_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace horovod {
+namespace common {
+
+// Blocks of a single size, which are kept once freed and handed out again.
+// Blocks may be allocated and freed on different threads.
+class BlockFreeList {
+public:
+  explicit BlockFreeList(std::size_t block_size)
+      : block_size_(std::max(block_size, sizeof(Block))) {}
+
+  void* Pop() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (head_ != nullptr) {
+        Block* block = head_;
+        head_ = block->next;
+        return block;
+      }
+    }
+    return ::operator new(block_size_);
+  }
+
+  void Push(void* ptr) {
+    Block* block = static_cast<Block*>(ptr);
+    std::lock_guard<std::mutex> guard(mutex_);
+    block->next = head_;
+    head_ = block;
+  }
+
+private:
+  struct Block {
+    Block* next;
+  };
+
+  std::size_t block_size_;
+  std::mutex mutex_;
+  Block* head_ = nullptr;
+};
+
+// Allocator of single objects from a free list per type, for objects created
+// and destroyed at a high rate, such as the adapters wrapping the framework
+// tensors and contexts of every submitted operation. Once as many objects as
+// are alive at the same time have been allocated, creating them does not
+// reach the heap.
+template <class T> class PooledAllocator {
+public:
+  using value_type = T;
+
+  PooledAllocator() = default;
+  template <class U> PooledAllocator(const PooledAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    if (n != 1) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(FreeList().Pop());
+  }
+
+  void deallocate(T* ptr, std::size_t n) {
+    if (n != 1) {
+      ::operator delete(ptr);
+      return;
+    }
+    FreeList().Push(ptr);
+  }
+
+  template <class U> bool operator==(const PooledAllocator<U>&) const {
+    return true;
+  }
+  template <class U> bool operator!=(const PooledAllocator<U>&) const {
+    return false;
+  }
+
+private:
+  // Never destroyed, since objects may be freed after static destructors
+  // have run.
+  static BlockFreeList& FreeList() {
+    static BlockFreeList* free_list = new BlockFreeList(sizeof(T));
+    return *free_list;
+  }
+};
+
+// Same as std::make_shared, with the object and its reference counts
+// allocated by a PooledAllocator.
+template <class T, class... Args>
+std::shared_ptr<T> MakePooled(Args&&... args) {
+  return std::allocate_shared<T>(PooledAllocator<T>(),
+                                 std::forward<Args>(args)...);
+}
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_OBJECT_POOL_H
@@ -14,8 +14,10 @@
 // limitations under the License.
 // =============================================================================
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstring>
 #include <queue>
 #include <sstream>
@@ -36,14 +38,23 @@
 #endif
 
 #define OMPI_SKIP_MPICXX
+#include "allreduce_engine.h"
+#include "completion_pool.h"
+#include "fused_datatype_cache.h"
 #include "fusion_buffer_manager.h"
 #include "half.h"
 #include "hashes.h"
 #include "mpi.h"
 #include "mpi_message.h"
+#include "mpsc_queue.h"
 #include "operations.h"
 #include "parameter_manager.h"
+#include "response_cache.h"
+#include "scale_buffer.h"
+#include "sparse_merge.h"
+#include "tensor_name_registry.h"
 #include "timeline.h"
+#include "topk_compression.h"
 #include "logging.h"
 
 /*
@@ -80,8 +91,15 @@ namespace {
 // Table storing Tensors to be reduced, keyed by unique name.
 // This table contains everything necessary to do the reduction.
 struct TensorTableEntry {
-  // Name of the tensor.
+  // Name of the tensor, only held by entries of tensors without an ID. Use
+  // EntryName() for the name of any entry.
   std::string tensor_name;
+  // ID of the tensor, or -1 if its name is not registered yet.
+  int32_t tensor_id = -1;
+  // Name of a tensor with an ID, kept by the tensor registry. Entries refer to
+  // it instead of holding a copy, so that taking them from the tensor table
+  // does not allocate.
+  const std::string* registered_name = nullptr;
   // Operation context.
   std::shared_ptr<OpContext> context;
   // Input tensor.
@@ -96,15 +114,430 @@ struct TensorTableEntry {
   int device = CPU_DEVICE_ID;
   // A callback to call with the status.
   StatusCallback callback;
+  // Group of tensors enqueued together, which are only fused with each other,
+  // or -1.
+  int32_t group_id = -1;
+  // Factors applied to the input of an allreduce before it is reduced, and to
+  // the result.
+  double prescale_factor = 1.0;
+  double postscale_factor = 1.0;
+  // Compression of an allreduce, applied while the tensor is copied into and
+  // out of the buffer it is reduced in.
+  Compression compression = NO_COMPRESSION;
+  // Number of dimension zero slices sent to every rank by an alltoall, or
+  // empty to send the same number to every rank.
+  std::vector<int64_t> splits;
+  // Indices of the rows of a sparse allreduce, whose values are the tensor,
+  // with the context allocating the output indices, and the number of rows
+  // of the dense tensor or 0.
+  std::shared_ptr<Tensor> indices;
+  std::shared_ptr<OpContext> indices_context;
+  std::shared_ptr<Tensor> indices_output;
+  int64_t dense_rows = 0;
 };
-using TensorTable = std::unordered_map<std::string, TensorTableEntry>;
+
+// Return the name of the tensor of an entry.
+const std::string& EntryName(const TensorTableEntry& e) {
+  return e.registered_name != nullptr ? *e.registered_name : e.tensor_name;
+}
+
+// Tensors which have been assigned an ID are stored in a slab indexed by the
+// ID. Tensors submitted before their name was registered are kept by name
+// until the response that assigns their ID arrives.
+class TensorTable {
+public:
+  explicit TensorTable(const TensorNameRegistry& registry)
+      : registry_(registry) {}
+
+  bool Contains(int32_t tensor_id, const std::string& name) const {
+    if (tensor_id < 0) {
+      return pending_.find(name) != pending_.end();
+    }
+    return tensor_id < (int32_t)present_.size() && present_[tensor_id];
+  }
+
+  // Adds the entry of a tensor which is not present to the table, under the
+  // given name. Entries of tensors with an ID refer to the name kept by the
+  // registry, the others hold a copy of the name.
+  void Insert(int32_t tensor_id, const std::string& name,
+              TensorTableEntry&& entry) {
+    if (tensor_id < 0) {
+      auto& pending = pending_[name];
+      pending = std::move(entry);
+      pending.tensor_name = name;
+      pending.tensor_id = -1;
+      pending.registered_name = nullptr;
+    } else {
+      if (tensor_id >= (int32_t)present_.size()) {
+        entries_.resize(tensor_id + 1);
+        present_.resize(tensor_id + 1, false);
+      }
+      auto& slot = entries_[tensor_id];
+      slot = std::move(entry);
+      slot.tensor_name.clear();
+      slot.tensor_id = tensor_id;
+      slot.registered_name = &registry_.Name(tensor_id);
+      present_[tensor_id] = true;
+    }
+    ++size_;
+  }
+
+  // The tensor must be present in the table.
+  TensorTableEntry& Get(int32_t tensor_id, const std::string& name) {
+    if (tensor_id < 0) {
+      auto it = pending_.find(name);
+      assert(it != pending_.end());
+      return it->second;
+    }
+    assert(Contains(tensor_id, name));
+    return entries_[tensor_id];
+  }
+
+  // Removes the tensor from the table and returns its entry.
+  TensorTableEntry Take(int32_t tensor_id, const std::string& name) {
+    TensorTableEntry entry;
+    if (tensor_id < 0) {
+      auto it = pending_.find(name);
+      assert(it != pending_.end());
+      entry = std::move(it->second);
+      pending_.erase(it);
+    } else {
+      assert(Contains(tensor_id, name));
+      std::swap(entry, entries_[tensor_id]);
+      present_[tensor_id] = false;
+    }
+    --size_;
+    return entry;
+  }
+
+  // Moves the entry of a tensor whose name was just registered into the slab.
+  void AssignId(const std::string& name, int32_t tensor_id) {
+    auto it = pending_.find(name);
+    if (it != pending_.end()) {
+      auto entry = std::move(it->second);
+      pending_.erase(it);
+      --size_;
+      Insert(tensor_id, name, std::move(entry));
+    }
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  // Removes all tensors from the table and returns their entries.
+  std::vector<TensorTableEntry> TakeAll() {
+    std::vector<TensorTableEntry> result;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      if (present_[i]) {
+        result.push_back(std::move(entries_[i]));
+      }
+    }
+    for (auto& it : pending_) {
+      result.push_back(std::move(it.second));
+    }
+    entries_.clear();
+    present_.clear();
+    pending_.clear();
+    size_ = 0;
+    return result;
+  }
+
+private:
+  const TensorNameRegistry& registry_;
+  std::vector<TensorTableEntry> entries_;
+  std::vector<bool> present_;
+  std::unordered_map<std::string, TensorTableEntry> pending_;
+  size_t size_ = 0;
+};
+
+// Negotiation state of a single tensor on rank zero. Instead of keeping the
+// requests of all ranks, only the first request is kept, and every following
+// request is validated against it as soon as it arrives.
+struct MessageTableEntry {
+  // Request of the first rank that submitted the tensor.
+  MPIRequest first_request;
+
+  // Bitmap of the ranks that submitted the tensor, and their number.
+  std::vector<uint64_t> ready_ranks;
+  int count = 0;
+
+  // Mismatches found between the first request and requests of other ranks.
+  // Only the first one is reported to the user.
+  std::vector<std::string> mismatches;
+
+  // Devices of the ranks, indexed by rank.
+  std::vector<int32_t> devices;
+
+  // First dimension sizes of the ranks, indexed by rank. Only kept for
+  // allgather and sparse allreduce. For alltoall, the splits of the ranks,
+  // indexed by rank times the number of ranks plus the receiving rank.
+  std::vector<int64_t> tensor_sizes;
+
+  // Time point when the first request arrived.
+  std::chrono::steady_clock::time_point start_at;
+
+  // Node-level responses, indexed by cross rank. Only used on the coordinator
+  // in hierarchical negotiation.
+  std::vector<MPIResponse> node_responses;
+};
+
+// Identifies a tensor in a MessageTable by its ID, or by its name if the
+// name is not registered yet. The name is left empty for tensors with an ID.
+struct MessageTableKey {
+  int32_t tensor_id = -1;
+  std::string name;
+};
+
+MessageTableKey MessageTableKeyOf(const MPIRequest& msg) {
+  MessageTableKey key;
+  key.tensor_id = msg.tensor_id();
+  if (key.tensor_id < 0) {
+    key.name = msg.tensor_name();
+  }
+  return key;
+}
 
 // Table for storing Tensor metadata on rank zero. This is used for error
 // checking, stall checking and size calculations, as well as determining
 // when a reduction is ready to be done (when all nodes are ready to do it).
-using MessageTable = std::unordered_map<
-    std::string,
-    std::tuple<std::vector<MPIRequest>, std::chrono::steady_clock::time_point>>;
+//
+// Like the TensorTable, tensors which have been assigned an ID are stored in
+// a slab indexed by the ID, whose slots keep their buffers for the next
+// negotiation of the tensor, and tensors without an ID are kept by name. All
+// ranks register names at the same point of the same response list, so all
+// requests for a tensor either carry its ID or do not.
+class MessageTable {
+public:
+  bool Contains(const MessageTableKey& key) const {
+    if (key.tensor_id < 0) {
+      return pending_.find(key.name) != pending_.end();
+    }
+    return key.tensor_id < (int32_t)present_.size() && present_[key.tensor_id];
+  }
+
+  // Returns the entry of the tensor, adding an empty entry if the tensor is
+  // not present. Sets inserted to whether it was added.
+  MessageTableEntry& Emplace(const MessageTableKey& key, bool* inserted) {
+    if (key.tensor_id < 0) {
+      auto result = pending_.emplace(key.name, MessageTableEntry());
+      *inserted = result.second;
+      return result.first->second;
+    }
+    if (key.tensor_id >= (int32_t)present_.size()) {
+      entries_.resize(key.tensor_id + 1);
+      present_.resize(key.tensor_id + 1, false);
+    }
+    auto& entry = entries_[key.tensor_id];
+    *inserted = !present_[key.tensor_id];
+    if (*inserted) {
+      entry.ready_ranks.clear();
+      entry.count = 0;
+      entry.mismatches.clear();
+      entry.devices.clear();
+      entry.tensor_sizes.clear();
+      entry.node_responses.clear();
+      present_[key.tensor_id] = true;
+    }
+    return entry;
+  }
+
+  // The tensor must be present in the table.
+  MessageTableEntry& Get(const MessageTableKey& key) {
+    assert(Contains(key));
+    if (key.tensor_id < 0) {
+      return pending_.find(key.name)->second;
+    }
+    return entries_[key.tensor_id];
+  }
+
+  void Erase(const MessageTableKey& key) {
+    if (key.tensor_id < 0) {
+      pending_.erase(key.name);
+    } else if (key.tensor_id < (int32_t)present_.size()) {
+      present_[key.tensor_id] = false;
+    }
+  }
+
+  // Calls f(tensor_id, name, entry) for every tensor of the table. The name
+  // is empty for tensors with an ID.
+  template <typename F> void ForEach(F f) const {
+    static const std::string no_name;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      if (present_[i]) {
+        f((int32_t)i, no_name, entries_[i]);
+      }
+    }
+    for (auto& it : pending_) {
+      f(-1, it.first, it.second);
+    }
+  }
+
+private:
+  std::vector<MessageTableEntry> entries_;
+  std::vector<bool> present_;
+  std::unordered_map<std::string, MessageTableEntry> pending_;
+};
+
+// A tensor submitted by a framework thread, handed over to the background
+// thread through the submission queue.
+struct Submission {
+  MPIRequest message;
+  // The name of the tensor is only held by the request.
+  TensorTableEntry entry;
+  // Number of submissions of the group starting with this one, which are
+  // published in consecutive cells, or 1.
+  uint32_t group_size = 1;
+  // Time point when the tensor was submitted, only set in the event-driven
+  // mode.
+  std::chrono::steady_clock::time_point time;
+};
+
+// Entries of a performed response, whose callbacks are run by a completion
+// thread. The timeline End events of operations performed on the CPU are
+// already written, those of operations still running on the GPU are written by
+// the completion thread once the events are done.
+struct Completion {
+  std::vector<TensorTableEntry> entries;
+  Status status;
+#if HAVE_CUDA
+  // Set if the operation is still running on the GPU, in which case the
+  // completion thread first waits for the events and frees the host buffer.
+  bool on_gpu = false;
+  int device = CPU_DEVICE_ID;
+  void* host_buffer = nullptr;
+  std::queue<std::pair<std::string, cudaEvent_t>> event_queue;
+#endif
+};
+
+// A communicator on which collective operations are performed one at a time,
+// along with the buffers they use. Operations on different lanes run
+// concurrently. Lane 0 uses mpi_comm, and is the only lane performing GPU and
+// hierarchical operations, which use the other communicators of the global
+// state.
+struct CollectiveLane {
+  MPI_Comm comm = MPI_COMM_NULL;
+
+  // Encapsulates the fusion buffers, handles resizing and auto-tuning of buffer
+  // size.
+  FusionBufferManager fusion_buffer;
+
+  // Datatypes describing fused tensors in zero-copy fusion.
+  FusedDatatypeCache fused_datatypes;
+
+  // Receive buffer of native allreduces.
+  std::vector<char> allreduce_scratch;
+
+  // Rows of sparse allreduces which are not fused, since they do not fit in
+  // the fusion buffer, and the merger of their rows.
+  std::vector<char> sparse_buffer;
+  SparseRowMerger sparse_merger;
+
+  // Compressed data of allreduces which are not fused, and the selector of
+  // the elements sent by top-k compression.
+  std::vector<char> compression_buffer;
+  TopkSelector topk_selector;
+
+  // Receive counts and displacements of allgathers, and the sizes and offsets
+  // of the components of every tensor from every rank, with the rows of the
+  // latter two.
+  std::vector<int> allgather_recvcounts;
+  std::vector<int> allgather_displcmnts;
+  std::vector<int64_t> allgather_component_sizes;
+  std::vector<int64_t*> allgather_component_size_rows;
+  std::vector<int64_t> allgather_component_offsets;
+  std::vector<int64_t*> allgather_component_offset_rows;
+};
+
+// A response to perform on a lane, with the entries of its tensors. Both are
+// owned by the background thread, which waits for the task before reusing
+// them.
+struct LaneTask {
+  std::vector<TensorTableEntry>* entries = nullptr;
+  const MPIResponse* response = nullptr;
+  CollectiveLane* lane = nullptr;
+};
+
+// Requests of a group of tensors submitted together, whose input data is not
+// ready yet.
+struct ParkedRequests {
+  uint64_t id;
+  std::vector<MPIRequest> messages;
+  std::vector<std::shared_ptr<ReadyEvent>> ready_events;
+  // Whether some of the events cannot notify and are polled every cycle.
+  bool polled = false;
+};
+
+// State of the negotiation of the requests of one cycle. A single negotiation
+// is reused by all cycles, so that its buffers are kept.
+//
+// All collectives of the flat negotiation are non-blocking and run on a
+// communicator reserved for negotiation, so that the negotiation can make
+// progress while the responses of the previous cycle are being performed.
+// Every rank posts the collectives in the same order.
+struct Negotiation {
+  enum class Stage {
+    // Exchanging the response cache bits of all ranks.
+    CACHE_SYNC,
+    // Collecting the lengths of the request lists on the coordinator. Other
+    // ranks send their request list and receive the length of the response
+    // list in this stage.
+    GATHER,
+    // Collecting the request lists on the coordinator.
+    GATHER_REQUESTS,
+    // Broadcasting the response list.
+    BROADCAST,
+    // Hierarchical negotiation, which uses blocking collectives and therefore
+    // only runs once the negotiation is finished.
+    HIERARCHICAL,
+    DONE
+  };
+
+  Stage stage = Stage::DONE;
+
+  // Sequence number of this negotiation, identical on all ranks.
+  uint64_t sequence = 0;
+
+  // Requests in flight for the current stage.
+  std::vector<MPI_Request> mpi_requests;
+
+  // Requests of this rank which need to be negotiated by the coordinator.
+  std::vector<MPIRequest> message_queue;
+
+  // Flag indicating that the background thread should shut down.
+  bool should_shut_down = false;
+
+  // Whether a response list is received from the coordinator.
+  bool coordinated = false;
+
+  // Response cache state of all ranks.
+  CacheCoordinator cache_coordinator;
+
+  // Requests of this rank which hit the response cache, sorted by cache bit.
+  struct HitMessage {
+    uint32_t bit;
+    // Whether the request still waits for the other ranks.
+    bool pending;
+    MPIRequest message;
+  };
+  std::vector<HitMessage> hit_messages;
+
+  // Responses for tensors found in the response cache of every rank. They
+  // stay in the cache until they have been fused.
+  std::vector<const MPIResponse*> cached_responses;
+
+  // Buffers of the collectives in flight.
+  std::string encoded_message;
+  int message_length = 0;
+  int response_length = 0;
+  std::vector<int> recvcounts;
+  std::vector<int> displcmnts;
+  std::vector<uint8_t> buffer;
+
+  // Only used on the coordinator. Tensors which are ready on all ranks.
+  std::vector<MessageTableKey> ready_to_reduce;
+
+  // Responses negotiated through the coordinator.
+  MPIResponseList response_list;
+};
 
 // The global state required for the MPI ops.
 //
@@ -117,18 +550,59 @@ struct HorovodGlobalState {
   // This ensures that only one background thread is spawned.
   std::atomic_flag initialize_flag = ATOMIC_FLAG_INIT;
 
-  // A mutex that needs to be used whenever MPI operations are done.
+  // A mutex protecting the wake-ups of the background thread.
   std::mutex mutex;
 
+  // Tensors submitted by framework threads, which are moved into the tensor
+  // table and the message queue by the background thread. Framework threads
+  // never take a lock to submit tensors.
+  std::unique_ptr<MPSCQueue<Submission>> submission_queue;
+
+  // Number of framework threads currently submitting tensors.
+  std::atomic_int submitters{0};
+
+  // Everything below is only used by the background thread, unless noted
+  // otherwise.
+
+  // Tensor IDs agreed on by all ranks.
+  TensorNameRegistry tensor_registry;
+
   // Tensors waiting to be allreduced or allgathered.
-  TensorTable tensor_table;
+  TensorTable tensor_table{tensor_registry};
 
   // Queue of MPI requests waiting to be sent to the coordinator node.
-  std::queue<MPIRequest> message_queue;
+  std::vector<MPIRequest> message_queue;
+
+  // Requests the negotiation is done with, which are exchanged with the
+  // requests of the submission queue so that their name and shape buffers
+  // are reused.
+  std::vector<MPIRequest> request_pool;
+
+  // Requests taken from the message queue in the current cycle.
+  std::vector<MPIRequest> cycle_messages;
+
+  // ID of the next group of tensors enqueued together.
+  int32_t next_group_id = 0;
+
+  // Requests of tensors whose input data is not ready yet. They are only
+  // queued for negotiation once the data of their whole group is ready, so
+  // that negotiated responses never wait for data while other tensors could
+  // make progress.
+  std::vector<ParkedRequests> parked_requests;
+  uint64_t next_parked_id = 0;
+
+  // IDs of parked requests whose ready events have notified, pushed by the
+  // threads completing the events. Protected by the mutex.
+  std::vector<uint64_t> notified_parked_ids;
+  std::vector<uint64_t> cycle_notified_ids;
 
   // Background thread running MPI communication.
   std::thread background_thread;
 
+  // Threads running the callbacks of performed operations. If no threads are
+  // started, callbacks run on the background thread.
+  CompletionPool<Completion> completion_pool;
+
   // Whether the background thread should shutdown.
   std::atomic_bool shut_down{false};
 
@@ -136,13 +610,37 @@ struct HorovodGlobalState {
   bool should_finalize = false;
 
   // Only exists on the coordinator node (rank zero). Maintains a count of
-  // how many nodes are ready to allreduce every tensor (keyed by tensor
-  // name) and time point when tensor started allreduce op.
+  // how many nodes are ready to allreduce every tensor (keyed by tensor ID,
+  // or name until it has one) and time point when tensor started allreduce
+  // op.
   std::unique_ptr<MessageTable> message_table;
 
+  // Flag indicating whether requests are first aggregated per node by local
+  // rank zero, so that the coordinator only receives one summary per node.
+  bool hierarchical_negotiation = false;
+
+  // Only exists on local rank zero in hierarchical negotiation. Maintains a
+  // count of how many ranks of this node are ready for every tensor. Requests
+  // are stored with the local rank as the request rank.
+  std::unique_ptr<MessageTable> node_message_table;
+
+  // Only set on the coordinator in hierarchical negotiation. COMM_WORLD ranks
+  // of processes running on every node, indexed by cross rank.
+  std::vector<std::vector<int>> node_ranks;
+
   // Time point when coordinator last checked for stalled tensors.
   std::chrono::steady_clock::time_point last_stall_check;
 
+  // Responses from previous cycles, used to skip negotiation of tensors that
+  // are requested again with the same parameters.
+  ResponseCache response_cache;
+
+  // Time point when each locally cached tensor started waiting for the other
+  // ranks, indexed by tensor ID, or the epoch if it is not waiting. Used to
+  // hand stalled tensors back to the coordinator, so that they are reported
+  // by the stall check.
+  std::vector<std::chrono::steady_clock::time_point> cache_hits_pending_since;
+
   // Flag indicating whether to perform stall tensor check.
   bool perform_stall_check = true;
 
@@ -154,13 +652,78 @@ struct HorovodGlobalState {
 
   ParameterManager param_manager;
 
-  // Encapsulates the fusion buffers, handles resizing and auto-tuning of buffer
-  // size.
-  FusionBufferManager fusion_buffer;
+  // Lanes performing collective operations. Lanes other than lane 0 use
+  // duplicates of mpi_comm. The number of lanes in use is a tunable
+  // parameter, and responses are only dispatched to the threads of the
+  // executor if more than one lane is in use.
+  std::vector<std::unique_ptr<CollectiveLane>> lanes;
+  CompletionPool<LaneTask> lane_executor;
+
+  // Elements dispatched to every lane in the current response list. Only used
+  // by the background thread.
+  std::vector<int64_t> lane_loads;
 
   // Time point when last cycle started.
   std::chrono::steady_clock::time_point last_cycle_start;
 
+  // Flag indicating whether the background thread is woken up by enqueued
+  // tensors instead of running cycles at a fixed interval.
+  bool event_driven_cycle = false;
+
+  // Signalled whenever a tensor is enqueued while the background thread
+  // waits for tensors, used in the event-driven mode.
+  std::condition_variable cycle_cond;
+  std::atomic_bool cycle_waiting{false};
+
+  // Arrival statistics of enqueued tensors, used in the event-driven mode to
+  // size the coalescing window.
+  uint64_t enqueue_count = 0;
+  uint64_t last_cycle_enqueue_count = 0;
+  std::chrono::steady_clock::time_point first_new_enqueue;
+  std::chrono::steady_clock::time_point last_enqueue;
+  double enqueue_interval_us = 0;
+
+  // Current timeout of the background thread while no tensors are in flight.
+  std::chrono::steady_clock::duration idle_backoff =
+      std::chrono::steady_clock::duration::zero();
+
+  // Flag indicating whether the negotiation of a cycle runs while the
+  // responses negotiated in the previous cycle are performed.
+  bool overlap_negotiation = false;
+
+  // Fraction of the rows of the dense tensor above which a sparse allreduce
+  // reduces the dense tensor instead of gathering the rows, or 0 to always
+  // gather them. Must be the same on all ranks.
+  double sparse_density_threshold = 0;
+
+  // Fraction of the elements of a tensor sent by top-k compression. Must be
+  // the same on all ranks.
+  double topk_ratio = 0.01;
+
+  // Residuals of the tensors reduced with top-k compression.
+  TopkResidualStore topk_residuals;
+
+  // Responses negotiated in the last cycle which have not been performed yet.
+  // Only used if negotiation overlaps with execution.
+  MPIResponseList pending_response_list;
+
+  // Responses performed in the current cycle.
+  MPIResponseList cycle_response_list;
+
+  // Entries of the tensors of each response being performed, which lanes
+  // refer to until the background thread waits for them.
+  std::vector<std::vector<TensorTableEntry>> response_entries;
+
+  // Responses the background thread is done with. They are cleared and reused
+  // for the responses fused in later cycles, so that their buffers are kept.
+  std::vector<MPIResponse> response_pool;
+
+  // Negotiation of the current cycle.
+  Negotiation negotiation;
+
+  // Number of negotiations started so far, identical on all ranks.
+  uint64_t negotiation_sequence = 0;
+
   // Whether MPI_Init has been completed on the background thread.
   std::atomic_bool initialization_done{false};
 
@@ -197,6 +760,10 @@ struct HorovodGlobalState {
   // Cross-node communicator for hierarchical allreduce.
   MPI_Comm cross_comm;
 
+  // Duplicate of mpi_comm used by the non-blocking negotiation collectives,
+  // so that they never match collectives performed on mpi_comm.
+  MPI_Comm negotiation_comm;
+
   // MPI Window used for shared memory allgather
   MPI_Win window;
 
@@ -206,6 +773,14 @@ struct HorovodGlobalState {
   // Current shared buffer size
   int64_t shared_buffer_size = 0;
 
+  // MPI Window used for shared memory allreduce, and pointers to the segments
+  // of the local ranks in it.
+  MPI_Win allreduce_window;
+  std::vector<void*> allreduce_segments;
+
+  // Current size of each segment of the shared memory allreduce window.
+  int64_t allreduce_segment_size = 0;
+
 // The CUDA stream used for data transfers and within-allreduce operations.
 // A naive implementation would use the TensorFlow StreamExecutor CUDA
 // stream. However, the allreduce and allgather require doing memory copies
@@ -257,6 +832,14 @@ HorovodGlobalState horovod_global;
 // Stall-check warning time
 #define STALL_WARNING_TIME std::chrono::seconds(60)
 
+// Upper bound of the background thread timeout while idle in the event-driven
+// mode.
+#define IDLE_BACKOFF_MAX std::chrono::milliseconds(100)
+
+// Weight of the latest sample in the moving average of tensor inter-arrival
+// times.
+#define ENQUEUE_INTERVAL_ALPHA 0.25
+
 const Status NOT_INITIALIZED_ERROR = Status::PreconditionError(
     "Horovod has not been initialized; use hvd.init().");
 
@@ -272,272 +855,520 @@ const Status DUPLICATE_NAME_ERROR = Status::InvalidArgument(
     "name as another tensor that is currently being processed.  If you want "
     "to request another tensor, use a different tensor name.");
 
-#define OP_ERROR(entries, error_message)                                       \
-  {                                                                            \
-    for (auto& e : (entries)) {                                                \
-      timeline.End(e.tensor_name, nullptr);                                    \
-      e.callback(Status::UnknownError(error_message));                         \
-    }                                                                          \
-    return;                                                                    \
+// Number of dimension zero slices of a reducescatter input of num_rows slices
+// which are received by rank, and the first of them. The first
+// num_rows % size ranks receive one slice more than the others.
+int64_t ReducescatterRows(int64_t num_rows, int rank, int size) {
+  return num_rows / size + (rank < num_rows % size ? 1 : 0);
+}
+
+int64_t ReducescatterFirstRow(int64_t num_rows, int rank, int size) {
+  return rank * (num_rows / size) + std::min((int64_t)rank, num_rows % size);
+}
+
+// Scaling is applied on CPU while the tensors are copied for the reduction.
+Status CheckScaleFactors(MPIDataType dtype, int device, double prescale_factor,
+                         double postscale_factor) {
+  if (prescale_factor == 1.0 && postscale_factor == 1.0) {
+    return Status::OK();
+  }
+  if (device != CPU_DEVICE_ID) {
+    return Status::InvalidArgument(
+        "Allreduce scale factors are only supported for CPU tensors.");
   }
+  if (dtype == HOROVOD_BOOL) {
+    return Status::InvalidArgument(
+        "Allreduce scale factors are not supported for bool tensors.");
+  }
+  return Status::OK();
+}
 
-// Store the MPIRequest for a name, and return whether the total count of
-// MPIRequests for that tensor is now equal to the MPI size (and thus we are
-// ready to reduce the tensor).
-bool IncrementTensorCount(std::unique_ptr<MessageTable>& message_table,
-                          const MPIRequest& msg, int mpi_size) {
-  auto& name = msg.tensor_name();
-  auto& timeline = horovod_global.timeline;
-  auto table_iter = message_table->find(name);
-  if (table_iter == message_table->end()) {
-    std::vector<MPIRequest> messages = {msg};
-    messages.reserve(static_cast<unsigned long>(mpi_size));
-    auto now = std::chrono::steady_clock::now();
-    message_table->emplace(name, std::make_tuple(std::move(messages), now));
-    table_iter = message_table->find(name);
-    timeline.NegotiateStart(name, msg.request_type());
-  } else {
-    std::vector<MPIRequest>& messages = std::get<0>(table_iter->second);
-    messages.push_back(msg);
+// Compression is applied on CPU while the tensors are copied for the
+// reduction, and only to float32 tensors. Top-k compression sends positions
+// as 32-bit integers.
+Status CheckCompression(const Tensor& tensor, int device,
+                        Compression compression) {
+  if (compression == NO_COMPRESSION) {
+    return Status::OK();
+  }
+  if (device != CPU_DEVICE_ID) {
+    return Status::InvalidArgument(
+        "Allreduce compression is only supported for CPU tensors.");
+  }
+  if (tensor.dtype() != HOROVOD_FLOAT32) {
+    return Status::InvalidArgument(
+        "Allreduce compression " + Compression_Name(compression) +
+        " is only supported for float32 tensors.");
   }
+  if (compression == TOPK_COMPRESSION &&
+      tensor.shape().num_elements() > (int64_t)UINT32_MAX) {
+    return Status::InvalidArgument(
+        "Allreduce compression topk is not supported for tensors of more "
+        "than " + std::to_string(UINT32_MAX) + " elements.");
+  }
+  return Status::OK();
+}
 
-  timeline.NegotiateRankReady(name, msg.request_rank());
+// Set on the threads of the completion pool.
+thread_local bool on_completion_thread = false;
 
-  std::vector<MPIRequest>& messages = std::get<0>(table_iter->second);
-  int count = (int)messages.size();
-  bool ready_to_reduce = count == mpi_size;
-  if (ready_to_reduce) {
-    timeline.NegotiateEnd(name);
+// Write the timeline End events of the entries with the given status.
+void EndTimeline(const std::vector<TensorTableEntry>& entries,
+                 const Status& status) {
+  auto& timeline = horovod_global.timeline;
+  for (auto& e : entries) {
+    timeline.End(e.tensor_id, EntryName(e),
+                 status.ok() ? e.output : nullptr);
   }
-  return ready_to_reduce;
 }
 
-// Once a tensor is ready to be reduced, the coordinator sends an MPIResponse
-// instructing all ranks to start the reduction to all ranks. The MPIResponse
-// also contains error messages in case the submitted MPIRequests were not
-// valid (for example, contained mismatched shapes or types).
-//
-// Constructing the MPIResponse, thus, requires a whole lot of error checking.
-MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
-                                 std::string name) {
-  bool error = false;
-  auto it = message_table->find(name);
-  assert(it != message_table->end());
+// Run the callbacks of the entries with the given status, and clear the
+// entries.
+void RunCallbacks(std::vector<TensorTableEntry>& entries,
+                  const Status& status) {
+  for (auto& e : entries) {
+    e.callback(status);
+  }
+  entries.clear();
+}
+
+// Hand the entries of a performed operation over to the completion pool,
+// which runs their callbacks with the given status. The timeline End events
+// are written first by the calling thread, since other ranks may submit the
+// tensors again as soon as their own callbacks have run, before the pool gets
+// to them. The entries are moved into a pooled task and cleared.
+void CompleteEntries(std::vector<TensorTableEntry>& entries,
+                     const Status& status) {
+  EndTimeline(entries, status);
+  auto& pool = horovod_global.completion_pool;
+  if (!pool.started() || on_completion_thread) {
+    RunCallbacks(entries, status);
+    return;
+  }
+  pool.Submit([&](Completion& completion) {
+    completion.entries.reserve(entries.size());
+    for (auto& e : entries) {
+      completion.entries.push_back(std::move(e));
+    }
+    completion.status = status;
+  });
+  entries.clear();
+}
 
-  std::vector<MPIRequest>& requests = std::get<0>(it->second);
-  assert(requests.size() > 0);
+#define OP_ERROR(entries, error_message)                                       \
+  {                                                                            \
+    CompleteEntries((entries), Status::UnknownError(error_message));           \
+    return;                                                                    \
+  }
 
+// Validate a request against the first request for the same tensor, and
+// return a description of the mismatch, or an empty string if the request is
+// consistent with the first one.
+std::string CheckRequestSignature(const MPIRequest& first,
+                                  const MPIRequest& msg) {
   std::ostringstream error_message_stream;
 
   // Check that all data types of tensors being reduced, gathered or broadcasted
   // are identical.
-  auto data_type = requests[0].tensor_type();
-  for (unsigned int i = 1; i < requests.size(); ++i) {
-    auto request_type = requests[i].tensor_type();
-    if (data_type != request_type) {
-      error = true;
-      error_message_stream << "Mismatched data types: One rank had type "
-                           << MPIDataType_Name(data_type)
-                           << ", but another rank had type "
-                           << MPIDataType_Name(request_type) << ".";
-      break;
-    }
+  if (first.tensor_type() != msg.tensor_type()) {
+    error_message_stream << "Mismatched data types: One rank had type "
+                         << MPIDataType_Name(first.tensor_type())
+                         << ", but another rank had type "
+                         << MPIDataType_Name(msg.tensor_type()) << ".";
+    return error_message_stream.str();
   }
 
   // Check that all requested operations are the same
-  auto message_type = requests[0].request_type();
-  for (unsigned int i = 1; i < requests.size(); ++i) {
-    if (error) {
-      break;
-    }
-
-    auto request_type = requests[i].request_type();
-    if (message_type != request_type) {
-      error = true;
-      error_message_stream << "Mismatched MPI operations: One rank did an "
-                           << MPIRequest::RequestType_Name(message_type)
-                           << ", but another rank did an "
-                           << MPIRequest::RequestType_Name(request_type) << ".";
-      break;
-    }
+  auto message_type = first.request_type();
+  if (message_type != msg.request_type()) {
+    error_message_stream << "Mismatched MPI operations: One rank did an "
+                         << MPIRequest::RequestType_Name(message_type)
+                         << ", but another rank did an "
+                         << MPIRequest::RequestType_Name(msg.request_type())
+                         << ".";
+    return error_message_stream.str();
   }
 
-  // If we are doing an allreduce or broadcast, check that all tensor shapes are
-  // identical.
-  if (message_type == MPIRequest::ALLREDUCE ||
-      message_type == MPIRequest::BROADCAST) {
+  // If we are doing an allreduce, reducescatter or broadcast, check that all
+  // tensor shapes are identical.
+  auto& first_shape = first.tensor_shape();
+  auto& msg_shape = msg.tensor_shape();
+  if ((message_type == MPIRequest::ALLREDUCE ||
+       message_type == MPIRequest::REDUCESCATTER ||
+       message_type == MPIRequest::BROADCAST) &&
+      first_shape != msg_shape) {
     TensorShape tensor_shape;
-    for (auto dim : requests[0].tensor_shape()) {
+    for (auto dim : first_shape) {
       tensor_shape.AddDim(dim);
     }
-    for (unsigned int i = 1; i < requests.size(); ++i) {
-      if (error) {
-        break;
-      }
-
-      TensorShape request_shape;
-      for (auto dim : requests[i].tensor_shape()) {
-        request_shape.AddDim(dim);
-      }
-      if (tensor_shape != request_shape) {
-        error = true;
-        error_message_stream
-            << "Mismatched " << MPIRequest::RequestType_Name(message_type)
-            << " tensor shapes: One rank sent a tensor of shape "
-            << tensor_shape.DebugString()
-            << ", but another rank sent a tensor of shape "
-            << request_shape.DebugString() << ".";
-        break;
-      }
+    TensorShape request_shape;
+    for (auto dim : msg_shape) {
+      request_shape.AddDim(dim);
     }
+    error_message_stream
+        << "Mismatched " << MPIRequest::RequestType_Name(message_type)
+        << " tensor shapes: One rank sent a tensor of shape "
+        << tensor_shape.DebugString()
+        << ", but another rank sent a tensor of shape "
+        << request_shape.DebugString() << ".";
+    return error_message_stream.str();
   }
 
-  // If we are doing an allgather, make sure all but the first dimension are
-  // the same. The first dimension may be different and the output tensor is
-  // the sum of the first dimension. Collect the sizes by rank.
-  std::vector<int64_t> tensor_sizes(requests.size());
-  if (message_type == MPIRequest::ALLGATHER) {
-    TensorShape tensor_shape;
-    for (auto dim : requests[0].tensor_shape()) {
-      tensor_shape.AddDim(dim);
-    }
-
-    if (tensor_shape.dims() == 0) {
-      error = true;
-      error_message_stream << "Rank zero tried to "
-                           << MPIRequest::RequestType_Name(message_type)
-                           << " a rank-zero tensor.";
-    } else {
-      tensor_sizes[requests[0].request_rank()] = tensor_shape.dim_size(0);
+  // If we are doing an allgather, alltoall or sparse allreduce, make sure all
+  // but the first dimension are the same. The first dimension may be
+  // different and the output tensor is the sum of the first dimension.
+  if (message_type == MPIRequest::ALLGATHER ||
+      message_type == MPIRequest::ALLTOALL ||
+      message_type == MPIRequest::SPARSE_ALLREDUCE) {
+    if (first_shape.size() != msg_shape.size()) {
+      error_message_stream
+          << "Mismatched " << MPIRequest::RequestType_Name(message_type)
+          << " tensor shapes: One rank sent a tensor of rank "
+          << first_shape.size() << ", but another rank sent a tensor of rank "
+          << msg_shape.size() << ".";
+      return error_message_stream.str();
     }
 
-    for (unsigned int i = 1; i < requests.size(); ++i) {
-      if (error) {
-        break;
-      }
-
-      TensorShape request_shape;
-      for (auto dim : requests[i].tensor_shape()) {
-        request_shape.AddDim(dim);
-      }
-      if (tensor_shape.dims() != request_shape.dims()) {
-        error = true;
+    for (unsigned int dim = 1; dim < first_shape.size(); ++dim) {
+      if (first_shape[dim] != msg_shape[dim]) {
         error_message_stream
             << "Mismatched " << MPIRequest::RequestType_Name(message_type)
-            << " tensor shapes: One rank sent a tensor of rank "
-            << tensor_shape.dims()
-            << ", but another rank sent a tensor of rank "
-            << request_shape.dims() << ".";
-        break;
+            << " tensor shapes: One rank sent a tensor with dimension " << dim
+            << " equal to " << first_shape[dim]
+            << ", but another rank sent a tensor with dimension " << dim
+            << " equal to " << msg_shape[dim] << ".";
+        return error_message_stream.str();
       }
-
-      bool dim_mismatch = false;
-      for (int dim = 1; dim < tensor_shape.dims(); ++dim) {
-        if (tensor_shape.dim_size(dim) != request_shape.dim_size(dim)) {
-          error = true;
-          error_message_stream
-              << "Mismatched " << MPIRequest::RequestType_Name(message_type)
-              << " tensor shapes: One rank sent a tensor with dimension " << dim
-              << " equal to " << tensor_shape.dim_size(dim)
-              << ", but another rank sent a tensor with dimension " << dim
-              << " equal to " << request_shape.dim_size(dim) << ".";
-          dim_mismatch = true;
-          break;
-        }
-      }
-      if (dim_mismatch) {
-        break;
-      }
-
-      tensor_sizes[requests[i].request_rank()] = request_shape.dim_size(0);
     }
   }
 
   // If we are doing a broadcast, check that all root ranks are identical.
-  if (message_type == MPIRequest::BROADCAST) {
-    int first_root_rank = requests[0].root_rank();
-    for (unsigned int i = 1; i < requests.size(); ++i) {
-      if (error) {
-        break;
-      }
+  if (message_type == MPIRequest::BROADCAST &&
+      first.root_rank() != msg.root_rank()) {
+    error_message_stream
+        << "Mismatched " << MPIRequest::RequestType_Name(message_type)
+        << " root ranks: One rank specified root rank " << first.root_rank()
+        << ", but another rank specified root rank " << msg.root_rank()
+        << ".";
+    return error_message_stream.str();
+  }
 
-      int this_root_rank = requests[i].root_rank();
-      if (first_root_rank != this_root_rank) {
-        error = true;
-        error_message_stream
-            << "Mismatched " << MPIRequest::RequestType_Name(message_type)
-            << " root ranks: One rank specified root rank " << first_root_rank
-            << ", but another rank specified root rank " << this_root_rank
-            << ".";
-        break;
-      }
-    }
+  // If we are doing a sparse allreduce, check that the dense tensors have the
+  // same number of rows, which decides whether they are reduced instead.
+  if (message_type == MPIRequest::SPARSE_ALLREDUCE &&
+      first.dense_rows() != msg.dense_rows()) {
+    error_message_stream
+        << "Mismatched " << MPIRequest::RequestType_Name(message_type)
+        << " dense rows: One rank specified " << first.dense_rows()
+        << " dense rows, but another rank specified " << msg.dense_rows()
+        << ".";
+    return error_message_stream.str();
   }
 
-  bool first_device_is_cpu = requests[0].device() == CPU_DEVICE_ID;
-  for (unsigned int i = 1; i < requests.size(); ++i) {
-    if (error) {
-      break;
-    }
+  // If we are doing an allreduce, check that the tensors are reduced in the
+  // same type.
+  if (first.compression() != msg.compression()) {
+    error_message_stream
+        << "Mismatched " << MPIRequest::RequestType_Name(message_type)
+        << " compression: One rank specified compression "
+        << Compression_Name(first.compression())
+        << ", but another rank specified compression "
+        << Compression_Name(msg.compression()) << ".";
+    return error_message_stream.str();
+  }
+
+  bool first_device_is_cpu = first.device() == CPU_DEVICE_ID;
+  bool this_device_is_cpu = msg.device() == CPU_DEVICE_ID;
+  if (first_device_is_cpu != this_device_is_cpu) {
+    error_message_stream
+        << "Mismatched " << MPIRequest::RequestType_Name(message_type)
+        << " CPU/GPU device selection: One rank specified device "
+        << (first_device_is_cpu ? "CPU" : "GPU")
+        << ", but another rank specified device "
+        << (this_device_is_cpu ? "CPU" : "GPU") << ".";
+    return error_message_stream.str();
+  }
+
+  return "";
+}
 
-    bool this_device_is_cpu = requests[i].device() == CPU_DEVICE_ID;
-    if (first_device_is_cpu != this_device_is_cpu) {
-      error = true;
+// Validate the splits of an alltoall request, and return a description of the
+// error, or an empty string if the splits cover the first dimension of the
+// tensor. Empty splits send the same number of slices to every rank.
+std::string CheckAlltoallSplits(const MPIRequest& msg, int size) {
+  std::ostringstream error_message_stream;
+  auto& splits = msg.tensor_splits();
+  int64_t num_rows = msg.tensor_shape().empty() ? 0 : msg.tensor_shape()[0];
+  if (splits.empty()) {
+    if (num_rows % size != 0) {
       error_message_stream
-          << "Mismatched " << MPIRequest::RequestType_Name(message_type)
-          << " CPU/GPU device selection: One rank specified device "
-          << (first_device_is_cpu ? "CPU" : "GPU")
-          << ", but another rank specified device "
-          << (this_device_is_cpu ? "CPU" : "GPU") << ".";
-      break;
+          << "One rank tried to "
+          << MPIRequest::RequestType_Name(msg.request_type())
+          << " a tensor with dimension 0 equal to " << num_rows
+          << " without splits, which requires dimension 0 to be divisible by "
+             "the number of ranks ("
+          << size << ").";
     }
+    return error_message_stream.str();
   }
-  std::vector<int32_t> devices(requests.size());
-  for (auto& request : requests) {
-    devices[request.request_rank()] = request.device();
+  if ((int)splits.size() != size) {
+    error_message_stream << "One rank specified " << splits.size()
+                         << " splits for " << size << " ranks.";
+    return error_message_stream.str();
   }
-
-  MPIResponse response;
-  response.add_tensor_name(name);
-  if (error) {
-    std::string error_message = error_message_stream.str();
-    response.set_response_type(MPIResponse::ERROR);
-    response.set_error_message(error_message);
-  } else if (message_type == MPIRequest::ALLGATHER) {
-    response.set_response_type(MPIResponse::ALLGATHER);
-    for (auto dim : tensor_sizes) {
-      response.add_tensor_size(dim);
+  int64_t total = 0;
+  for (auto split : splits) {
+    if (split < 0) {
+      error_message_stream << "One rank specified a negative split.";
+      return error_message_stream.str();
     }
-  } else if (message_type == MPIRequest::ALLREDUCE) {
-    response.set_response_type(MPIResponse::ALLREDUCE);
-  } else if (message_type == MPIRequest::BROADCAST) {
-    response.set_response_type(MPIResponse::BROADCAST);
+    total += split;
   }
-  response.set_devices(devices);
+  if (total != num_rows) {
+    error_message_stream << "One rank specified splits which sum to " << total
+                         << ", but the tensor has dimension 0 equal to "
+                         << num_rows << ".";
+  }
+  return error_message_stream.str();
+}
 
-  // Clear all queued up requests for this name. They are now taken care of
-  // by the constructed MPI response.
-  message_table->erase(it);
+// Return the name of the tensor of a request. Requests received from other
+// ranks only carry the ID of tensors which have one.
+const std::string& TensorName(const MPIRequest& msg) {
+  if (msg.tensor_id() >= 0 && msg.tensor_name().empty()) {
+    return horovod_global.tensor_registry.Name(msg.tensor_id());
+  }
+  return msg.tensor_name();
+}
 
-  return response;
+// Return the name of the tensor of a message table key.
+const std::string& TensorName(const MessageTableKey& key) {
+  if (key.tensor_id >= 0) {
+    return horovod_global.tensor_registry.Name(key.tensor_id);
+  }
+  return key.name;
 }
 
-MPI_Datatype GetMPIDataType(const std::shared_ptr<Tensor> tensor) {
-  switch (tensor->dtype()) {
-  case HOROVOD_UINT8:
-    return MPI_UINT8_T;
-  case HOROVOD_INT8:
-    return MPI_INT8_T;
-  case HOROVOD_UINT16:
-    return MPI_UINT16_T;
-  case HOROVOD_INT16:
-    return MPI_INT16_T;
-  case HOROVOD_INT32:
-    return MPI_INT32_T;
-  case HOROVOD_INT64:
-    return MPI_INT64_T;
-  case HOROVOD_FLOAT16:
-    return horovod_global.mpi_float16_t;
+// Record the MPIRequest of one of num_participants participants, identified
+// by the request rank, in the table entry for the tensor. Returns the entry.
+MessageTableEntry& RecordRequest(std::unique_ptr<MessageTable>& message_table,
+                                 const MPIRequest& msg, int num_participants,
+                                 bool* is_first) {
+  auto& name = TensorName(msg);
+  auto& entry = message_table->Emplace(MessageTableKeyOf(msg), is_first);
+  if (*is_first) {
+    entry.first_request = msg;
+    entry.first_request.set_tensor_name(name);
+    entry.ready_ranks.resize((num_participants + 63) / 64, 0);
+    entry.devices.resize(num_participants);
+    entry.start_at = std::chrono::steady_clock::now();
+    if (msg.request_type() == MPIRequest::ALLGATHER ||
+        msg.request_type() == MPIRequest::SPARSE_ALLREDUCE) {
+      entry.tensor_sizes.resize(num_participants);
+    } else if (msg.request_type() == MPIRequest::ALLTOALL) {
+      entry.tensor_sizes.resize((size_t)num_participants *
+                                horovod_global.size);
+    }
+    if (msg.request_type() == MPIRequest::ALLGATHER ||
+        msg.request_type() == MPIRequest::REDUCESCATTER ||
+        msg.request_type() == MPIRequest::ALLTOALL ||
+        msg.request_type() == MPIRequest::SPARSE_ALLREDUCE) {
+      if (msg.tensor_shape().empty()) {
+        entry.mismatches.push_back(
+            "Rank zero tried to " +
+            MPIRequest::RequestType_Name(msg.request_type()) +
+            " a rank-zero tensor.");
+      }
+    }
+  } else {
+    auto mismatch = CheckRequestSignature(entry.first_request, msg);
+    if (!mismatch.empty()) {
+      entry.mismatches.push_back(std::move(mismatch));
+    }
+  }
+
+  int32_t rank = msg.request_rank();
+  if (msg.request_type() == MPIRequest::ALLTOALL && entry.mismatches.empty()) {
+    auto error = CheckAlltoallSplits(msg, horovod_global.size);
+    if (!error.empty()) {
+      entry.mismatches.push_back(std::move(error));
+    }
+  }
+  entry.ready_ranks[rank / 64] |= 1ULL << (rank % 64);
+  ++entry.count;
+  entry.devices[rank] = msg.device();
+  if (!entry.tensor_sizes.empty() && entry.mismatches.empty()) {
+    if (msg.request_type() == MPIRequest::ALLTOALL) {
+      int size = horovod_global.size;
+      for (int rc = 0; rc < size; ++rc) {
+        entry.tensor_sizes[(size_t)rank * size + rc] =
+            msg.tensor_splits().empty() ? msg.tensor_shape()[0] / size
+                                        : msg.tensor_splits()[rc];
+      }
+    } else {
+      entry.tensor_sizes[rank] = msg.tensor_shape()[0];
+    }
+  }
+  return entry;
+}
+
+// Store the MPIRequest for a name, and return whether the total count of
+// MPIRequests for that tensor is now equal to the MPI size (and thus we are
+// ready to reduce the tensor).
+bool IncrementTensorCount(std::unique_ptr<MessageTable>& message_table,
+                          const MPIRequest& msg, int mpi_size) {
+  auto& name = TensorName(msg);
+  auto tensor_id = msg.tensor_id();
+  auto& timeline = horovod_global.timeline;
+  bool is_first;
+  auto& entry = RecordRequest(message_table, msg, mpi_size, &is_first);
+  if (is_first) {
+    timeline.NegotiateStart(tensor_id, name, msg.request_type());
+  }
+
+  timeline.NegotiateRankReady(tensor_id, name, msg.request_rank());
+
+  bool ready_to_reduce = entry.count == mpi_size;
+  if (ready_to_reduce) {
+    timeline.NegotiateEnd(tensor_id, name);
+  }
+  return ready_to_reduce;
+}
+
+// Once a tensor is ready to be reduced, the coordinator sends an MPIResponse
+// instructing all ranks to start the reduction to all ranks. The MPIResponse
+// also contains error messages in case the submitted MPIRequests were not
+// valid (for example, contained mismatched shapes or types). The requests have
+// already been checked against each other as they arrived.
+MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
+                                 const MessageTableKey& key) {
+  auto& entry = message_table->Get(key);
+  auto message_type = entry.first_request.request_type();
+  auto& name = TensorName(key);
+  auto tensor_id = key.tensor_id;
+
+  MPIResponse response;
+  response.add_tensor_name(name, tensor_id);
+  if (!entry.mismatches.empty()) {
+    response.set_response_type(MPIResponse::ERROR);
+    response.set_error_message(entry.mismatches[0]);
+  } else if (message_type == MPIRequest::ALLGATHER) {
+    response.set_response_type(MPIResponse::ALLGATHER);
+    response.set_tensor_sizes(entry.tensor_sizes);
+  } else if (message_type == MPIRequest::ALLREDUCE) {
+    response.set_response_type(MPIResponse::ALLREDUCE);
+  } else if (message_type == MPIRequest::BROADCAST) {
+    response.set_response_type(MPIResponse::BROADCAST);
+  } else if (message_type == MPIRequest::REDUCESCATTER) {
+    response.set_response_type(MPIResponse::REDUCESCATTER);
+  } else if (message_type == MPIRequest::ALLTOALL) {
+    response.set_response_type(MPIResponse::ALLTOALL);
+    response.set_tensor_sizes(entry.tensor_sizes);
+  } else if (message_type == MPIRequest::SPARSE_ALLREDUCE) {
+    response.set_response_type(MPIResponse::SPARSE_ALLREDUCE);
+    response.set_tensor_sizes(entry.tensor_sizes);
+  }
+  response.set_devices(entry.devices);
+
+  // Clear the state kept for this tensor. It is now taken care of by the
+  // constructed MPI response.
+  message_table->Erase(key);
+
+  return response;
+}
+
+// Store the MPIRequest of a rank on this node in the node tensor count table
+// (hierarchical negotiation), and return whether all ranks of the node have
+// requested the tensor. The request rank is replaced by the local rank, so
+// that the node-level MPIResponse is indexed by local rank.
+bool IncrementNodeTensorCount(std::unique_ptr<MessageTable>& node_table,
+                              MPIRequest msg, int local_rank, int local_size) {
+  msg.set_request_rank(local_rank);
+  bool is_first;
+  auto& entry = RecordRequest(node_table, msg, local_size, &is_first);
+  return entry.count == local_size;
+}
+
+// Store the summary of a tensor sent by a node in hierarchical negotiation,
+// and return whether all nodes are now ready. The summary is a request of one
+// of the ranks of the node with the cross rank of the node as request rank.
+bool IncrementNodeCount(HorovodGlobalState& state, const MPIRequest& summary,
+                        const MPIResponse& node_response) {
+  bool ready =
+      IncrementTensorCount(state.message_table, summary, state.cross_size);
+  auto& responses =
+      state.message_table->Get(MessageTableKeyOf(summary)).node_responses;
+  if (responses.empty()) {
+    responses.resize(state.cross_size);
+  }
+  responses[summary.request_rank()] = node_response;
+  return ready;
+}
+
+// Construct the MPIResponse for a tensor negotiated hierarchically. Node
+// summaries are checked against each other like requests of single ranks,
+// while the per-rank devices and allgather sizes, as well as errors between
+// ranks of the same node, come from the node-level responses.
+MPIResponse ConstructHierarchicalMPIResponse(HorovodGlobalState& state,
+                                             const MessageTableKey& key) {
+  std::vector<MPIResponse> node_responses =
+      std::move(state.message_table->Get(key).node_responses);
+  MPIResponse response = ConstructMPIResponse(state.message_table, key);
+
+  if (response.response_type() == MPIResponse::ERROR) {
+    return response;
+  }
+  for (auto& node_response : node_responses) {
+    if (node_response.response_type() == MPIResponse::ERROR) {
+      response.set_response_type(MPIResponse::ERROR);
+      response.set_error_message(node_response.error_message());
+      return response;
+    }
+  }
+
+  std::vector<int32_t> devices(state.size);
+  std::vector<int64_t> tensor_sizes;
+  // Alltoall sizes have a row of splits per rank.
+  int row_size = response.response_type() == MPIResponse::ALLTOALL ? state.size
+                                                                   : 1;
+  if (response.response_type() == MPIResponse::ALLGATHER ||
+      response.response_type() == MPIResponse::ALLTOALL ||
+      response.response_type() == MPIResponse::SPARSE_ALLREDUCE) {
+    tensor_sizes.resize((size_t)state.size * row_size);
+  }
+  for (unsigned int node = 0; node < node_responses.size(); ++node) {
+    auto& ranks = state.node_ranks[node];
+    for (unsigned int i = 0; i < ranks.size(); ++i) {
+      devices[ranks[i]] = node_responses[node].devices()[i];
+      for (int j = 0; !tensor_sizes.empty() && j < row_size; ++j) {
+        tensor_sizes[(size_t)ranks[i] * row_size + j] =
+            node_responses[node].tensor_sizes()[(size_t)i * row_size + j];
+      }
+    }
+  }
+  response.set_devices(devices);
+  if (!tensor_sizes.empty()) {
+    response.set_tensor_sizes(tensor_sizes);
+  }
+  return response;
+}
+
+MPI_Datatype GetMPIDataType(MPIDataType dtype) {
+  switch (dtype) {
+  case HOROVOD_UINT8:
+    return MPI_UINT8_T;
+  case HOROVOD_INT8:
+    return MPI_INT8_T;
+  case HOROVOD_UINT16:
+    return MPI_UINT16_T;
+  case HOROVOD_INT16:
+    return MPI_INT16_T;
+  case HOROVOD_INT32:
+    return MPI_INT32_T;
+  case HOROVOD_INT64:
+    return MPI_INT64_T;
+  case HOROVOD_FLOAT16:
+    return horovod_global.mpi_float16_t;
   case HOROVOD_FLOAT32:
     return MPI_FLOAT;
   case HOROVOD_FLOAT64:
@@ -545,11 +1376,15 @@ MPI_Datatype GetMPIDataType(const std::shared_ptr<Tensor> tensor) {
   case HOROVOD_BOOL:
     return MPI_C_BOOL;
   default:
-    throw std::logic_error("Type " + MPIDataType_Name(tensor->dtype()) +
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
                            " is not supported in MPI mode.");
   }
 }
 
+MPI_Datatype GetMPIDataType(const std::shared_ptr<Tensor> tensor) {
+  return GetMPIDataType(tensor->dtype());
+}
+
 // Return the total byte size of the final allgathered output tensor
 int64_t TotalByteSizeOfAllgatherOutput(const std::vector<int64_t> &tensor_sizes,
                                        const TensorTableEntry entry) {
@@ -574,6 +1409,118 @@ int64_t TotalByteSizeOfAllgatherOutput(const std::vector<int64_t> &tensor_sizes,
   return total_byte_size_of_output;
 }
 
+// Return the byte size of the data an alltoall sends and receives on the rank
+// exchanging the most data, which is the same on every rank. tensor_sizes
+// holds the splits of all ranks.
+int64_t MaxByteSizeOfAlltoallBuffers(const std::vector<int64_t>& tensor_sizes,
+                                     const TensorTableEntry& entry) {
+  int size = horovod_global.size;
+  int64_t max_rows = 0;
+  for (int rc = 0; rc < size; ++rc) {
+    int64_t rows = 0;
+    for (int other = 0; other < size; ++other) {
+      rows += tensor_sizes[(size_t)rc * size + other] +
+              tensor_sizes[(size_t)other * size + rc];
+    }
+    max_rows = std::max(max_rows, rows);
+  }
+  int element_size;
+  MPI_Type_size(GetMPIDataType(entry.tensor), &element_size);
+  int64_t row_size = element_size;
+  for (int i = 1; i < entry.tensor->shape().dims(); ++i) {
+    row_size *= entry.tensor->shape().dim_size(i);
+  }
+  return max_rows * row_size;
+}
+
+// Return the number of elements of a slice of the first dimension of the
+// tensor of the entry.
+int64_t RowElements(const TensorTableEntry& entry) {
+  int64_t row_elements = 1;
+  for (int i = 1; i < entry.tensor->shape().dims(); ++i) {
+    row_elements *= entry.tensor->shape().dim_size(i);
+  }
+  return row_elements;
+}
+
+// Return the type the tensor of an allreduce entry is reduced in.
+MPIDataType ReducedDataType(const TensorTableEntry& entry) {
+  return entry.compression == FP16_COMPRESSION ? HOROVOD_FLOAT16
+                                               : entry.tensor->dtype();
+}
+
+// Return the byte size of the tensor of an allreduce entry in the type it is
+// reduced in.
+int64_t ReducedSize(const TensorTableEntry& entry) {
+  return entry.compression == FP16_COMPRESSION
+             ? entry.tensor->shape().num_elements() * 2
+             : entry.tensor->size();
+}
+
+// Return the byte size of the elements sent by every rank for an allreduce
+// entry with top-k compression.
+int64_t TopkRankBytes(const TensorTableEntry& entry) {
+  return TopkElements(entry.tensor->shape().num_elements(),
+                      horovod_global.topk_ratio) *
+         (int64_t)sizeof(TopkPair);
+}
+
+// Return whether the sparse allreduce of tensor i of a response reduces the
+// dense tensor instead of gathering the rows, which is the case when the rows
+// of all ranks would fill more than the density threshold of the dense
+// tensor. tensor_sizes holds the number of rows of all ranks, and the dense
+// rows are the same on every rank, so the result is too.
+bool SparseAllreduceIsDense(const std::vector<int64_t>& tensor_sizes,
+                            size_t i, const TensorTableEntry& entry) {
+  auto& state = horovod_global;
+  if (state.sparse_density_threshold <= 0 || entry.dense_rows <= 0) {
+    return false;
+  }
+  int64_t rows = 0;
+  for (int rc = 0; rc < state.size; ++rc) {
+    rows += tensor_sizes[i * state.size + rc];
+  }
+  return (double)rows > state.sparse_density_threshold * entry.dense_rows;
+}
+
+// Return the byte size of the buffer of the sparse allreduce of tensor i of a
+// response: the dense tensor, or the rows of all ranks with their indices.
+int64_t SparseAllreduceBytes(const std::vector<int64_t>& tensor_sizes,
+                             size_t i, const TensorTableEntry& entry) {
+  int element_size;
+  MPI_Type_size(GetMPIDataType(entry.tensor), &element_size);
+  int64_t row_bytes = RowElements(entry) * element_size;
+  if (SparseAllreduceIsDense(tensor_sizes, i, entry)) {
+    return entry.dense_rows * row_bytes;
+  }
+  int64_t rows = 0;
+  for (int rc = 0; rc < horovod_global.size; ++rc) {
+    rows += tensor_sizes[i * horovod_global.size + rc];
+  }
+  return rows * ((int64_t)sizeof(int64_t) + row_bytes);
+}
+
+// Return the number of bytes the tensor of a single-tensor response takes in
+// the fusion buffer, which is the same on every rank. Cached responses are
+// fused on every rank, so this must not depend on the inputs of this rank
+// where they differ between ranks.
+int64_t FusionBufferBytes(const MPIResponse& response,
+                          const TensorTableEntry& entry) {
+  if (response.response_type() == MPIResponse::ALLGATHER) {
+    return TotalByteSizeOfAllgatherOutput(response.tensor_sizes(), entry);
+  }
+  if (response.response_type() == MPIResponse::ALLTOALL) {
+    return MaxByteSizeOfAlltoallBuffers(response.tensor_sizes(), entry);
+  }
+  if (response.response_type() == MPIResponse::SPARSE_ALLREDUCE) {
+    return SparseAllreduceBytes(response.tensor_sizes(), 0, entry);
+  }
+  if (entry.compression == TOPK_COMPRESSION) {
+    return TopkRankBytes(entry) * horovod_global.size;
+  }
+  return ReducedSize(entry);
+}
+
 #if HAVE_NCCL
 ncclDataType_t GetNCCLDataType(const std::shared_ptr<Tensor> tensor) {
   switch (tensor->dtype()) {
@@ -610,11 +1557,10 @@ DDL_Type GetDDLDataType(const std::shared_ptr<Tensor> tensor) {
   {                                                                            \
     auto mpi_result = (op);                                                    \
     if (mpi_result != MPI_SUCCESS) {                                           \
-      for (auto& e : (entries)) {                                              \
-        timeline.End(e.tensor_name, nullptr);                                  \
-        e.callback(Status::UnknownError(                                       \
-            std::string(op_name) + " failed, see MPI output for details."));   \
-      }                                                                        \
+      CompleteEntries((entries),                                               \
+                      Status::UnknownError(                                    \
+                          std::string(op_name) +                               \
+                          " failed, see MPI output for details."));            \
       return;                                                                  \
     }                                                                          \
   }
@@ -623,11 +1569,10 @@ DDL_Type GetDDLDataType(const std::shared_ptr<Tensor> tensor) {
   {                                                                            \
     auto cuda_result = (op);                                                   \
     if (cuda_result != cudaSuccess) {                                          \
-      for (auto& e : (entries)) {                                              \
-        timeline.End(e.tensor_name, nullptr);                                  \
-        e.callback(Status::UnknownError(std::string(op_name) + " failed: " +   \
-                                        cudaGetErrorString(cuda_result)));     \
-      }                                                                        \
+      CompleteEntries((entries),                                               \
+                      Status::UnknownError(std::string(op_name) +              \
+                                           " failed: " +                       \
+                                           cudaGetErrorString(cuda_result)));  \
       return;                                                                  \
     }                                                                          \
   }
@@ -636,11 +1581,10 @@ DDL_Type GetDDLDataType(const std::shared_ptr<Tensor> tensor) {
   {                                                                            \
     auto nccl_result = (op);                                                   \
     if (nccl_result != ncclSuccess) {                                          \
-      for (auto& e : (entries)) {                                              \
-        timeline.End(e.tensor_name, nullptr);                                  \
-        e.callback(Status::UnknownError(std::string(op_name) + " failed: " +   \
-                                        ncclGetErrorString(nccl_result)));     \
-      }                                                                        \
+      CompleteEntries((entries),                                               \
+                      Status::UnknownError(std::string(op_name) +              \
+                                           " failed: " +                       \
+                                           ncclGetErrorString(nccl_result)));  \
       return;                                                                  \
     }                                                                          \
   }
@@ -649,10 +1593,8 @@ DDL_Type GetDDLDataType(const std::shared_ptr<Tensor> tensor) {
   {                                                                            \
     auto ddl_result = (op);                                                    \
     if (ddl_result != DDL_SUCCESS) {                                           \
-      for (auto& e : (entries)) {                                              \
-        timeline.End(e.tensor_name, nullptr);                                  \
-        e.callback(Status::UnknownError(std::string(op_name) + " failed."));   \
-      }                                                                        \
+      CompleteEntries((entries),                                               \
+                      Status::UnknownError(std::string(op_name) + " failed."));\
       return;                                                                  \
     }                                                                          \
   }
@@ -725,17 +1667,21 @@ cudaError_t ReleaseCudaEvent(cudaEvent_t event) {
   }
 #endif
 
+// The name of the activity is only converted to a string when the timeline
+// records it.
 #define ACTIVITY_START_ALL(entries, timeline, activity)                        \
   {                                                                            \
-    for (auto& e : (entries)) {                                                \
-      (timeline).ActivityStart(e.tensor_name, activity);                       \
+    if ((timeline).Initialized()) {                                            \
+      for (auto& e : (entries)) {                                              \
+        (timeline).ActivityStart(e.tensor_id, EntryName(e), activity);         \
+      }                                                                        \
     }                                                                          \
   }
 
 #define ACTIVITY_END_ALL(entries, timeline)                                    \
   {                                                                            \
     for (auto& e : (entries)) {                                                \
-      (timeline).ActivityEnd(e.tensor_name);                                   \
+      (timeline).ActivityEnd(e.tensor_id, EntryName(e));                       \
     }                                                                          \
   }
 
@@ -763,99 +1709,435 @@ int64_t TensorFusionThresholdBytes() {
   return proposed_fusion_threshold;
 }
 
-// Process an MPIResponse by doing a reduction, a gather, a broadcast, or
-// raising an error.
-void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
-  std::vector<TensorTableEntry> entries;
-  // Reserve to save re-allocation costs, as we know the size before.
-  entries.reserve(response.tensor_names().size());
-  {
-    // Lock on the tensor table.
-    std::lock_guard<std::mutex> guard(horovod_global.mutex);
-    for (auto& name : response.tensor_names()) {
-      // We should never fail at finding this key in the tensor table.
-      auto iter = tensor_table.find(name);
-      assert(iter != tensor_table.end());
+// Copy the bytes [begin, end) of the tensor of an allreduce entry, in the
+// type it is reduced in, between the entry and buffer_data, which holds these
+// bytes. Inputs are multiplied by the prescale factor and compressed on the
+// way in, and outputs are decompressed and multiplied by the postscale factor
+// on the way out, so that compression needs no other copy of the tensor.
+void CopyEntryRange(const TensorTableEntry& e, void* buffer_data, int64_t begin,
+                    int64_t end, bool to_buffer) {
+  if (e.compression == FP16_COMPRESSION) {
+    int64_t first = begin / 2;
+    int64_t count = (end - begin) / 2;
+    if (to_buffer) {
+      ScaledCopyToFloat16((const float*)e.tensor->data() + first,
+                          (unsigned short*)buffer_data, count,
+                          e.prescale_factor);
+    } else {
+      ScaledCopyFromFloat16((const unsigned short*)buffer_data,
+                            (float*)e.output->data() + first, count,
+                            e.postscale_factor);
+    }
+  } else if (to_buffer) {
+    ScaledCopy((const uint8_t*)e.tensor->data() + begin, buffer_data,
+               end - begin, e.tensor->dtype(), e.prescale_factor);
+  } else {
+    ScaledCopy(buffer_data, (uint8_t*)e.output->data() + begin, end - begin,
+               e.tensor->dtype(), e.postscale_factor);
+  }
+}
+
+// Copy the bytes [begin, end) of the entries, laid out back to back in the
+// type they are reduced in, between the entries and buffer_data, which holds
+// these bytes.
+void CopyFusionBufferRange(const std::vector<TensorTableEntry>& entries,
+                           void* buffer_data, int64_t begin, int64_t end,
+                           bool to_buffer) {
+  int64_t offset = 0;
+  for (auto& e : entries) {
+    int64_t lo = std::max(begin, offset);
+    int64_t hi = std::min(end, offset + ReducedSize(e));
+    if (lo < hi) {
+      CopyEntryRange(e, (uint8_t*)buffer_data + (lo - begin), lo - offset,
+                     hi - offset, to_buffer);
+    }
+    offset += ReducedSize(e);
+    if (offset >= end) {
+      break;
+    }
+  }
+}
+
+// Choose the allreduce algorithm for num_elements elements of dtype on CPU.
+AllreduceAlgorithm ChooseAllreduceAlgorithm(int64_t num_elements,
+                                            MPIDataType dtype) {
+  auto& state = horovod_global;
+  int element_size;
+  MPI_Type_size(GetMPIDataType(dtype), &element_size);
+  return SelectAllreduceAlgorithm(
+      num_elements * element_size, num_elements, dtype, state.size,
+      state.local_size, state.param_manager.AllreduceRecursiveDoublingBytes(),
+      state.param_manager.AllreduceRingBytes());
+}
+
+// Name of the timeline activity of the allreduce algorithm.
+const char* AllreduceActivity(AllreduceAlgorithm algorithm) {
+  switch (algorithm) {
+  case AllreduceAlgorithm::RING:
+    return RING_ALLREDUCE;
+  case AllreduceAlgorithm::RECURSIVE_DOUBLING:
+    return RECURSIVE_DOUBLING_ALLREDUCE;
+  default:
+    return MPI_ALLREDUCE;
+  }
+}
 
-      assert(response.response_type() == MPIResponse::ALLREDUCE ||
-             response.response_type() == MPIResponse::ALLGATHER ||
-             response.response_type() == MPIResponse::BROADCAST ||
-             response.response_type() == MPIResponse::ERROR);
+// Sum num_elements elements of sendbuf over the ranks of the lane into
+// buffer, with the given algorithm. sendbuf may be MPI_IN_PLACE. Returns the
+// first MPI error.
+int PerformAllreduce(AllreduceAlgorithm algorithm, const void* sendbuf,
+                     void* buffer, int64_t num_elements, MPIDataType dtype,
+                     CollectiveLane& lane) {
+  auto datatype = GetMPIDataType(dtype);
+  if (algorithm == AllreduceAlgorithm::MPI) {
+    return MPI_Allreduce(sendbuf, buffer, (int)num_elements, datatype,
+                         dtype == HOROVOD_FLOAT16
+                             ? horovod_global.mpi_float16_sum
+                             : MPI_SUM,
+                         lane.comm);
+  }
+  if (sendbuf != MPI_IN_PLACE) {
+    int element_size;
+    MPI_Type_size(datatype, &element_size);
+    std::memcpy(buffer, sendbuf, (size_t)num_elements * element_size);
+  }
+  if (algorithm == AllreduceAlgorithm::RING) {
+    return RingAllreduce(buffer, num_elements, dtype, datatype, lane.comm,
+                         lane.allreduce_scratch);
+  }
+  return RecursiveDoublingAllreduce(buffer, num_elements, dtype, datatype,
+                                    lane.comm, lane.allreduce_scratch);
+}
 
-      entries.push_back(iter->second);
+// Allreduce fused CPU entries in chunks of about chunk_bytes. Chunk k is
+// reduced with MPI_Iallreduce while chunk k + 1 is copied into the fusion
+// buffer and chunk k - 1 is copied out to the outputs. Returns the first MPI
+// error code, or MPI_SUCCESS.
+int PipelinedFusedAllreduce(const std::vector<TensorTableEntry>& entries,
+                            void* buffer_data, int64_t chunk_bytes,
+                            MPI_Comm comm) {
+  auto dtype = ReducedDataType(entries[0]);
+  auto datatype = GetMPIDataType(dtype);
+  auto op = dtype == HOROVOD_FLOAT16 ? horovod_global.mpi_float16_sum : MPI_SUM;
+  int element_size;
+  MPI_Type_size(datatype, &element_size);
 
-      // Clear the tensor table of this tensor and its callbacks; the rest of
-      // this function takes care of it.
-      tensor_table.erase(iter);
+  // Chunks hold a whole number of elements.
+  chunk_bytes = std::max(chunk_bytes / element_size, (int64_t)1) * element_size;
+  int64_t total_bytes = 0;
+  for (auto& e : entries) {
+    total_bytes += ReducedSize(e);
+  }
+  int64_t num_chunks = (total_bytes + chunk_bytes - 1) / chunk_bytes;
+
+  MPI_Request requests[2];
+  for (int64_t k = 0; k <= num_chunks; ++k) {
+    if (k < num_chunks) {
+      int64_t begin = k * chunk_bytes;
+      int64_t end = std::min(begin + chunk_bytes, total_bytes);
+      CopyFusionBufferRange(entries, (uint8_t*)buffer_data + begin, begin, end,
+                            true);
+      int result = MPI_Iallreduce(
+          MPI_IN_PLACE, (uint8_t*)buffer_data + begin,
+          (int)((end - begin) / element_size), datatype, op, comm,
+          &requests[k % 2]);
+      if (result != MPI_SUCCESS) {
+        return result;
+      }
+    }
+    if (k > 0) {
+      int result = MPI_Wait(&requests[(k - 1) % 2], MPI_STATUS_IGNORE);
+      if (result != MPI_SUCCESS) {
+        return result;
+      }
+      int64_t begin = (k - 1) * chunk_bytes;
+      int64_t end = std::min(begin + chunk_bytes, total_bytes);
+      CopyFusionBufferRange(entries, (uint8_t*)buffer_data + begin, begin, end,
+                            false);
     }
   }
+  return MPI_SUCCESS;
+}
 
-  auto& timeline = horovod_global.timeline;
+// Allreduce CPU entries hierarchically through node shared memory, in segments
+// of at most SHARED_ALLREDUCE_SEGMENT_SIZE bytes. Every local rank copies the
+// segment into its part of a shared window and reduces 1/local_size of it
+// across the node into the part of local rank zero. It then allreduces this
+// slice with the same local rank of the other nodes, and all local ranks copy
+// the result out of the window. Returns the first MPI error code, or
+// MPI_SUCCESS.
+int SharedMemoryAllreduce(const std::vector<TensorTableEntry>& entries) {
+  auto& state = horovod_global;
+  auto dtype = ReducedDataType(entries[0]);
+  auto datatype = GetMPIDataType(dtype);
+  auto op = dtype == HOROVOD_FLOAT16 ? state.mpi_float16_sum : MPI_SUM;
+  int element_size;
+  MPI_Type_size(datatype, &element_size);
+
+  int64_t total_bytes = 0;
   for (auto& e : entries) {
-    timeline.Start(e.tensor_name, response.response_type());
+    total_bytes += ReducedSize(e);
+  }
+  int64_t segment_size =
+      std::min(total_bytes, (int64_t)SHARED_ALLREDUCE_SEGMENT_SIZE);
+
+  // All local ranks see the same sizes, so they reallocate the window
+  // together.
+  if (state.allreduce_segments.empty() ||
+      state.allreduce_segment_size < segment_size) {
+    if (!state.allreduce_segments.empty()) {
+      MPI_Win_free(&state.allreduce_window);
+      state.allreduce_segments.clear();
+    }
+    void* segment;
+    int result = MPI_Win_allocate_shared(segment_size, 1, MPI_INFO_NULL,
+                                         state.local_comm, &segment,
+                                         &state.allreduce_window);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+    for (int i = 0; i < state.local_size; ++i) {
+      MPI_Aint size;
+      int disp_unit;
+      MPI_Win_shared_query(state.allreduce_window, i, &size, &disp_unit,
+                           &segment);
+      state.allreduce_segments.push_back(segment);
+    }
+    state.allreduce_segment_size = segment_size;
   }
 
-  if (entries.size() > 1) {
-    auto first_entry = entries[0];
-    // Note: it is OK for different entries to come from different frameworks
-    // since buffer allocated here is guaranteed to survive at least till the
-    // end of this operation.
-    Status status = horovod_global.fusion_buffer.InitializeBuffer(
-        TensorFusionThresholdBytes(), first_entry.device, first_entry.context,
-        [&]() { ACTIVITY_START_ALL(entries, timeline, INIT_FUSION_BUFFER) },
-        [&]() { ACTIVITY_END_ALL(entries, timeline) });
-    if (!status.ok()) {
-      for (auto& e : entries) {
-        timeline.End(e.tensor_name, nullptr);
-        e.callback(status);
+  auto result_segment = (uint8_t*)state.allreduce_segments[0];
+  for (int64_t begin = 0; begin < total_bytes; begin += segment_size) {
+    int64_t end = std::min(begin + segment_size, total_bytes);
+    CopyFusionBufferRange(entries, state.allreduce_segments[state.local_rank],
+                          begin, end, true);
+    int result = MPI_Barrier(state.local_comm);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+
+    int64_t num_elements = (end - begin) / element_size;
+    int64_t slice_begin =
+        num_elements * state.local_rank / state.local_size * element_size;
+    int slice_count = (int)(num_elements * (state.local_rank + 1) /
+                                state.local_size -
+                            slice_begin / element_size);
+    for (int i = 1; i < state.local_size; ++i) {
+      result = MPI_Reduce_local(
+          (uint8_t*)state.allreduce_segments[i] + slice_begin,
+          result_segment + slice_begin, slice_count, datatype, op);
+      if (result != MPI_SUCCESS) {
+        return result;
       }
-      return;
     }
+    result = MPI_Allreduce(MPI_IN_PLACE, result_segment + slice_begin,
+                           slice_count, datatype, op, state.cross_comm);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+    result = MPI_Barrier(state.local_comm);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+
+    CopyFusionBufferRange(entries, result_segment, begin, end, false);
+
+    // Wait for all local ranks to copy out the result before the window is
+    // reused.
+    result = MPI_Barrier(state.local_comm);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+  }
+  return MPI_SUCCESS;
+}
+
+// Allgather fused CPU entries with MPI_Alltoallw. Derived datatypes describe
+// the inputs of this rank, and the slices of the outputs which receive the
+// data of every rank, so no fusion buffer is needed. Returns the MPI error
+// code.
+int ZeroCopyFusedAllgather(const std::vector<TensorTableEntry>& entries,
+                           int64_t** entry_component_sizes, int element_size,
+                           CollectiveLane& lane) {
+  int size = horovod_global.size;
+
+  // Block lists of the data received from every rank, followed by the block
+  // list of the data sent by this rank.
+  std::vector<BlockList> block_lists(size + 1);
+  for (size_t ec = 0; ec < entries.size(); ++ec) {
+    auto& e = entries[ec];
+    MPI_Aint address;
+    MPI_Get_address(e.tensor->data(), &address);
+    block_lists[size].addresses.push_back(address);
+    block_lists[size].counts.push_back((int)e.tensor->shape().num_elements());
+
+    int64_t offset = 0;
+    for (int rc = 0; rc < size; ++rc) {
+      MPI_Get_address((uint8_t*)e.output->data() + offset * element_size,
+                      &address);
+      block_lists[rc].addresses.push_back(address);
+      block_lists[rc].counts.push_back((int)entry_component_sizes[ec][rc]);
+      offset += entry_component_sizes[ec][rc];
+    }
+  }
+
+  const std::vector<MPI_Datatype>* datatypes;
+  int result = lane.fused_datatypes.Get(GetMPIDataType(entries[0].tensor),
+                                       block_lists, &datatypes);
+  if (result != MPI_SUCCESS) {
+    return result;
   }
 
-  // On GPU data readiness is signalled by ready_event.
-  std::vector<TensorTableEntry> waiting_tensors;
+  std::vector<int> counts(size, 1);
+  std::vector<int> displcmnts(size, 0);
+  std::vector<MPI_Datatype> sendtypes(size, (*datatypes)[size]);
+  return MPI_Alltoallw(MPI_BOTTOM, counts.data(), displcmnts.data(),
+                       sendtypes.data(), MPI_BOTTOM, counts.data(),
+                       displcmnts.data(), datatypes->data(), lane.comm);
+}
+
+// Broadcast fused CPU entries through a derived datatype describing the
+// inputs on the root rank and the outputs on the other ranks. Returns the MPI
+// error code.
+int ZeroCopyFusedBroadcast(const std::vector<TensorTableEntry>& entries,
+                           bool is_root_rank, CollectiveLane& lane) {
+  std::vector<BlockList> block_lists(1);
   for (auto& e : entries) {
-    if (e.ready_event != nullptr) {
-      timeline.ActivityStart(e.tensor_name, WAIT_FOR_DATA);
-      waiting_tensors.push_back(e);
+    MPI_Aint address;
+    MPI_Get_address(is_root_rank ? e.tensor->data() : e.output->data(),
+                    &address);
+    block_lists[0].addresses.push_back(address);
+    block_lists[0].counts.push_back((int)e.tensor->shape().num_elements());
+  }
+
+  const std::vector<MPI_Datatype>* datatypes;
+  int result = lane.fused_datatypes.Get(GetMPIDataType(entries[0].tensor),
+                                       block_lists, &datatypes);
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  return MPI_Bcast(MPI_BOTTOM, 1, (*datatypes)[0], entries[0].root_rank,
+                   lane.comm);
+}
+
+#if HAVE_CUDA
+// Hand the entries of an operation which is still running on the GPU over to
+// the completion pool. The callbacks run once the events are done.
+void CompleteGPUEntries(
+    std::vector<TensorTableEntry>& entries, int device, void* host_buffer,
+    std::queue<std::pair<std::string, cudaEvent_t>>& event_queue) {
+  auto& pool = horovod_global.completion_pool;
+  if (!pool.started()) {
+    // Only happens while the pool is stopped, wait for the events here.
+    auto& timeline = horovod_global.timeline;
+    WAIT_FOR_EVENTS(entries, timeline, event_queue)
+    if (host_buffer != nullptr) {
+      free(host_buffer);
     }
+    EndTimeline(entries, Status::OK());
+    RunCallbacks(entries, Status::OK());
+    return;
   }
-  while (!waiting_tensors.empty()) {
-    for (auto it = waiting_tensors.begin(); it != waiting_tensors.end();) {
-      if (it->ready_event->Ready()) {
-        timeline.ActivityEnd(it->tensor_name);
-        timeline.ActivityStart(it->tensor_name, WAIT_FOR_OTHER_TENSOR_DATA);
-        it = waiting_tensors.erase(it);
-      } else {
-        ++it;
-      }
+  pool.Submit([&](Completion& completion) {
+    completion.entries.reserve(entries.size());
+    for (auto& e : entries) {
+      completion.entries.push_back(std::move(e));
     }
-    std::this_thread::sleep_for(std::chrono::nanoseconds(100));
+    completion.status = Status::OK();
+    completion.on_gpu = true;
+    completion.device = device;
+    completion.host_buffer = host_buffer;
+    completion.event_queue = std::move(event_queue);
+  });
+  entries.clear();
+}
+
+// Wait for the events of an operation on the GPU and free its host buffer.
+// If an event fails, the callbacks run with the error and the entries are
+// cleared.
+void FinishGPUOperation(Completion& completion) {
+  auto& entries = completion.entries;
+  auto& timeline = horovod_global.timeline;
+  CUDA_CHECK(entries, "cudaSetDevice", cudaSetDevice(completion.device))
+  WAIT_FOR_EVENTS(entries, timeline, completion.event_queue)
+  if (completion.host_buffer != nullptr) {
+    free(completion.host_buffer);
+  }
+}
+#endif
+
+// Run a task of the completion pool.
+void RunCompletion(Completion& completion) {
+  on_completion_thread = true;
+#if HAVE_CUDA
+  if (completion.on_gpu) {
+    completion.on_gpu = false;
+    FinishGPUOperation(completion);
+    EndTimeline(completion.entries, completion.status);
+  }
+#endif
+  RunCallbacks(completion.entries, completion.status);
+}
+
+// Return the rows of a zeroed array of num_entries times the number of ranks,
+// whose storage is kept by a lane.
+int64_t** LaneComponentArray(std::vector<int64_t>& storage,
+                             std::vector<int64_t*>& rows, size_t num_entries) {
+  storage.assign(num_entries * horovod_global.size, 0);
+  rows.resize(num_entries);
+  for (size_t ec = 0; ec < num_entries; ++ec) {
+    rows[ec] = storage.data() + ec * horovod_global.size;
   }
+  return rows.data();
+}
+
+// Process an MPIResponse by doing a reduction, a gather, a broadcast, or
+// raising an error.
+void PerformOperation(std::vector<TensorTableEntry>& entries,
+                      const MPIResponse& response, CollectiveLane& lane) {
+  auto& timeline = horovod_global.timeline;
   for (auto& e : entries) {
-    if (e.ready_event != nullptr) {
-      timeline.ActivityEnd(e.tensor_name);
+    timeline.Start(e.tensor_id, EntryName(e), response.response_type());
+  }
+
+  if (entries.size() > 1) {
+    auto& first_entry = entries[0];
+    // Note: it is OK for different entries to come from different frameworks
+    // since buffer allocated here is guaranteed to survive at least till the
+    // end of this operation.
+    Status status = lane.fusion_buffer.InitializeBuffer(
+        TensorFusionThresholdBytes(), first_entry.device, first_entry.context,
+        [&]() { ACTIVITY_START_ALL(entries, timeline, INIT_FUSION_BUFFER) },
+        [&]() { ACTIVITY_END_ALL(entries, timeline) });
+    if (!status.ok()) {
+      CompleteEntries(entries, status);
+      return;
     }
   }
 
+  // Requests are only negotiated once the ready_event of their tensor is
+  // ready, so the input data is ready here.
   Status status;
   if (response.response_type() == MPIResponse::ALLGATHER) {
 
+    // The arrays below are kept by the lane, so that they are only allocated
+    // when they grow.
+
     // Sizes of subcomponents of each entry from all ranks
-    auto** entry_component_sizes = new int64_t*[entries.size()];
+    auto** entry_component_sizes =
+        LaneComponentArray(lane.allgather_component_sizes,
+                           lane.allgather_component_size_rows, entries.size());
 
     // Offset of each subcomponent of every entry in the final buffer after
     // allgatherv
-    auto** entry_component_offsets = new int64_t*[entries.size()];
+    auto** entry_component_offsets = LaneComponentArray(
+        lane.allgather_component_offsets,
+        lane.allgather_component_offset_rows, entries.size());
 
-    auto* recvcounts = new int[horovod_global.size]();
-    auto* displcmnts = new int[horovod_global.size]();
-
-    for (size_t ec = 0; ec < entries.size(); ++ec) {
-      entry_component_sizes[ec] = new int64_t[horovod_global.size]();
-      entry_component_offsets[ec] = new int64_t[horovod_global.size]();
-    }
+    lane.allgather_recvcounts.assign(horovod_global.size, 0);
+    lane.allgather_displcmnts.assign(horovod_global.size, 0);
+    auto* recvcounts = lane.allgather_recvcounts.data();
+    auto* displcmnts = lane.allgather_displcmnts.data();
 
     auto& first_entry = entries[0];
 
@@ -890,8 +2172,8 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
 
       status = e.context->AllocateOutput(output_shape, &e.output);
       if (!status.ok()) {
-        timeline.End(e.tensor_name, nullptr);
-        e.callback(status);
+        // The other entries are fused with this one and fail as well.
+        CompleteEntries(entries, status);
         return;
       }
     }
@@ -992,7 +2274,7 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
                (size_t)(entry_component_sizes[ec][horovod_global.rank] *
                         element_size));
       }
-      MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(horovod_global.mpi_comm));
+      MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(lane.comm));
       ACTIVITY_END_ALL(entries, timeline)
 
       // Perform the cross-node allgather. If the cluster is homogeneous all
@@ -1006,7 +2288,7 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
                                  GetMPIDataType(first_entry.tensor),
                                  horovod_global.cross_comm))
       }
-      MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(horovod_global.mpi_comm));
+      MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(lane.comm));
       ACTIVITY_END_ALL(entries, timeline)
 
       // Copy memory out of the fusion buffer.
@@ -1023,7 +2305,7 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
           copy_offset += entry_component_size * element_size;
         }
       }
-      MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(horovod_global.mpi_comm));
+      MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(lane.comm));
       ACTIVITY_END_ALL(entries, timeline)
 
       // Free the buffers
@@ -1034,8 +2316,15 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
 #endif
       // Data is at the CPU and hierarchical allgather is disabled, or
       // Data is at the GPU and HOROVOD_GPU_ALLGATHER == MPI
-      if (entries.size() > 1) {
-        auto& buffer = horovod_global.fusion_buffer.GetBuffer(
+      if (entries.size() > 1 && first_entry.device == CPU_DEVICE_ID &&
+          horovod_global.param_manager.ZeroCopyFusion()) {
+        ACTIVITY_START_ALL(entries, timeline, MPI_ALLGATHER)
+        MPI_CHECK(entries, "MPI_Alltoallw",
+                  ZeroCopyFusedAllgather(entries, entry_component_sizes,
+                                         element_size, lane))
+        ACTIVITY_END_ALL(entries, timeline)
+      } else if (entries.size() > 1) {
+        auto& buffer = lane.fusion_buffer.GetBuffer(
             first_entry.device, first_entry.context->framework());
         auto buffer_data = buffer->AccessData(first_entry.context);
 
@@ -1061,7 +2350,7 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
                                  GetMPIDataType(first_entry.tensor),
                                  (void*)buffer_data, recvcounts, displcmnts,
                                  GetMPIDataType(first_entry.tensor),
-                                 horovod_global.mpi_comm))
+                                 lane.comm))
         ACTIVITY_END_ALL(entries, timeline)
 
         ACTIVITY_START_ALL(entries, timeline, MEMCPY_OUT_FUSION_BUFFER)
@@ -1089,28 +2378,15 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
                            GetMPIDataType(first_entry.tensor),
                            (void*)first_entry.output->data(), recvcounts,
                            displcmnts, GetMPIDataType(first_entry.tensor),
-                           horovod_global.mpi_comm))
+                           lane.comm))
         ACTIVITY_END_ALL(entries, timeline)
       }
 
-      delete[] recvcounts;
-      delete[] displcmnts;
-
-      for (size_t ec = 0; ec < entries.size(); ++ec) {
-        delete[] entry_component_sizes[ec];
-        delete[] entry_component_offsets[ec];
-      }
-      delete[] entry_component_sizes;
-      delete[] entry_component_offsets;
-
 #if HOROVOD_GPU_ALLGATHER != 'M' // 'M' stands for MPI
     }
 #endif
 
-    for (auto& e : entries) {
-      timeline.End(e.tensor_name, e.output);
-      e.callback(Status::OK());
-    }
+    CompleteEntries(entries, Status::OK());
 
   } else if (response.response_type() == MPIResponse::ALLREDUCE) {
     auto& first_entry = entries[0];
@@ -1165,7 +2441,7 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
         } else {
           nccl_rank = horovod_global.rank;
           nccl_size = horovod_global.size;
-          nccl_id_bcast_comm = horovod_global.mpi_comm;
+          nccl_id_bcast_comm = lane.comm;
         }
 
         ncclUniqueId nccl_id;
@@ -1185,7 +2461,7 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
 
         // Barrier helps NCCL to synchronize after initialization and avoid
         // deadlock that we've been seeing without it.
-        MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(horovod_global.mpi_comm));
+        MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(lane.comm));
 
         ACTIVITY_END_ALL(entries, timeline)
       }
@@ -1220,7 +2496,7 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
       size_t buffer_len;
       if (entries.size() > 1) {
         // Access the fusion buffer.
-        auto& buffer = horovod_global.fusion_buffer.GetBuffer(
+        auto& buffer = lane.fusion_buffer.GetBuffer(
             first_entry.device, first_entry.context->framework());
         buffer_data =
             const_cast<void*>(buffer->AccessData(first_entry.context));
@@ -1467,30 +2743,113 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
       // blocking cudaStreamSynchronize() in this thread.
       RECORD_EVENT(entries, event_queue, "", stream)
 
-      // TODO: use thread pool or single thread for callbacks
-      std::thread finalizer_thread([entries, first_entry, host_buffer, response,
-                                    event_queue, &timeline]() mutable {
-        CUDA_CHECK(entries, "cudaSetDevice", cudaSetDevice(first_entry.device))
-
-        WAIT_FOR_EVENTS(entries, timeline, event_queue)
-
-        if (host_buffer != nullptr) {
-          free(host_buffer);
-        }
-
-        for (auto& e : entries) {
-          timeline.End(e.tensor_name, e.output);
-          e.callback(Status::OK());
-        }
-      });
-      finalizer_thread.detach();
+      // A completion thread waits for the events before running the
+      // callbacks.
+      CompleteGPUEntries(entries, first_entry.device, host_buffer,
+                         event_queue);
       return;
     }
 #endif
 
-    if (entries.size() > 1) {
+    int64_t chunk_bytes = horovod_global.param_manager.AllreduceChunkBytes();
+    int64_t total_size = 0;
+    for (auto& e : entries) {
+      total_size += ReducedSize(e);
+    }
+    auto dtype = ReducedDataType(first_entry);
+
+    if (first_entry.compression == TOPK_COMPRESSION) {
+      // Every rank selects the elements of largest magnitude of its tensors
+      // and their residuals, which are gathered from all ranks and summed
+      // into the outputs. Fused tensors are gathered in the fusion buffer.
+      int size = horovod_global.size;
+      int rank = horovod_global.rank;
+      int64_t rank_bytes = 0;
+      for (auto& e : entries) {
+        rank_bytes += TopkRankBytes(e);
+      }
+      uint8_t* buffer_data;
+      if (entries.size() > 1) {
+        auto& buffer = lane.fusion_buffer.GetBuffer(
+            first_entry.device, first_entry.context->framework());
+        buffer_data = (uint8_t*)buffer->AccessData(first_entry.context);
+      } else {
+        lane.compression_buffer.resize((size_t)(rank_bytes * size));
+        buffer_data = (uint8_t*)lane.compression_buffer.data();
+      }
+
+      ACTIVITY_START_ALL(entries, timeline, TOPK_SELECT)
+      auto pairs = (TopkPair*)(buffer_data + rank * rank_bytes);
+      for (size_t i = 0; i < entries.size(); ++i) {
+        auto& e = entries[i];
+        int64_t num_elements = e.tensor->shape().num_elements();
+        int64_t k = TopkElements(num_elements, horovod_global.topk_ratio);
+        auto residual = horovod_global.topk_residuals.Get(
+            response.tensor_ids()[i], num_elements);
+        TopkStats stats;
+        lane.topk_selector.Select((const float*)e.tensor->data(),
+                                  e.prescale_factor, *residual, k, pairs,
+                                  &stats);
+        pairs += k;
+        timeline.ActivityEnd(
+            e.tensor_id, EntryName(e),
+            {{"compression_ratio", (double)e.tensor->size() / TopkRankBytes(e)},
+             {"gradient_norm", stats.gradient_norm},
+             {"residual_norm", stats.residual_norm}});
+      }
+
+      ACTIVITY_START_ALL(entries, timeline, MPI_ALLGATHER)
+      MPI_CHECK(entries, "MPI_Allgather",
+                MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, buffer_data,
+                              (int)rank_bytes, MPI_BYTE, lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
+
+      // Every rank sums the elements of all ranks in the same order.
+      ACTIVITY_START_ALL(entries, timeline, TOPK_SCATTER)
+      int64_t offset = 0;
+      for (auto& e : entries) {
+        int64_t num_elements = e.tensor->shape().num_elements();
+        int64_t k = TopkElements(num_elements, horovod_global.topk_ratio);
+        auto output = (float*)e.output->data();
+        std::memset(output, 0, (size_t)e.output->size());
+        for (int rc = 0; rc < size; ++rc) {
+          auto rank_pairs =
+              (const TopkPair*)(buffer_data + rc * rank_bytes + offset);
+          for (int64_t j = 0; j < k; ++j) {
+            output[rank_pairs[j].index] += rank_pairs[j].value;
+          }
+        }
+        if (e.postscale_factor != 1.0) {
+          ScaleBuffer(output, output, num_elements, HOROVOD_FLOAT32,
+                      e.postscale_factor);
+        }
+        offset += k * (int64_t)sizeof(TopkPair);
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+    } else if (first_entry.device == CPU_DEVICE_ID &&
+               horovod_global.is_homogeneous &&
+               horovod_global.param_manager.HierarchicalAllreduce()) {
+      // Reduce within the node through shared memory, and across nodes over
+      // cross_comm.
+      ACTIVITY_START_ALL(entries, timeline, SHARED_MEMORY_ALLREDUCE)
+      MPI_CHECK(entries, "MPI_Allreduce", SharedMemoryAllreduce(entries))
+      ACTIVITY_END_ALL(entries, timeline)
+    } else if (entries.size() > 1 && first_entry.device == CPU_DEVICE_ID &&
+               chunk_bytes > 0 && total_size > chunk_bytes) {
+      // Overlap the copies into and out of the fusion buffer with the
+      // allreduce.
+      auto& buffer = lane.fusion_buffer.GetBuffer(
+          first_entry.device, first_entry.context->framework());
+      auto buffer_data = buffer->AccessData(first_entry.context);
+
+      ACTIVITY_START_ALL(entries, timeline, MPI_PIPELINED_ALLREDUCE)
+      MPI_CHECK(entries, "MPI_Iallreduce",
+                PipelinedFusedAllreduce(entries, (void*)buffer_data,
+                                        chunk_bytes, lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
+    } else if (entries.size() > 1) {
       // Access the fusion buffer.
-      auto& buffer = horovod_global.fusion_buffer.GetBuffer(
+      auto& buffer = lane.fusion_buffer.GetBuffer(
           first_entry.device, first_entry.context->framework());
       auto buffer_data = buffer->AccessData(first_entry.context);
 
@@ -1508,12 +2867,11 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
                          horovod_global.streams[first_entry.device]))
         } else {
 #endif
-          std::memcpy(buffer_data_at_offset, e.tensor->data(),
-                      (size_t)e.tensor->size());
+          CopyEntryRange(e, buffer_data_at_offset, 0, ReducedSize(e), true);
 #if HAVE_CUDA
         }
 #endif
-        offset += e.tensor->size();
+        offset += ReducedSize(e);
       }
 #if HAVE_CUDA
       if (on_gpu) {
@@ -1524,19 +2882,17 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
 #endif
       ACTIVITY_END_ALL(entries, timeline)
 
-      ACTIVITY_START_ALL(entries, timeline, MPI_ALLREDUCE)
       int64_t num_elements = 0;
       for (auto& e : entries) {
         num_elements += e.tensor->shape().num_elements();
       }
+      auto algorithm = first_entry.device != CPU_DEVICE_ID
+                           ? AllreduceAlgorithm::MPI
+                           : ChooseAllreduceAlgorithm(num_elements, dtype);
+      ACTIVITY_START_ALL(entries, timeline, AllreduceActivity(algorithm))
       MPI_CHECK(entries, "MPI_Allreduce",
-                MPI_Allreduce(MPI_IN_PLACE, (void*)buffer_data,
-                              (int)num_elements,
-                              GetMPIDataType(first_entry.tensor),
-                              first_entry.tensor->dtype() == HOROVOD_FLOAT16
-                                  ? horovod_global.mpi_float16_sum
-                                  : MPI_SUM,
-                              horovod_global.mpi_comm))
+                PerformAllreduce(algorithm, MPI_IN_PLACE, (void*)buffer_data,
+                                 num_elements, dtype, lane))
       ACTIVITY_END_ALL(entries, timeline)
 
       // Copy memory out of the fusion buffer.
@@ -1553,12 +2909,11 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
                          horovod_global.streams[first_entry.device]))
         } else {
 #endif
-          std::memcpy((void*)e.output->data(), buffer_data_at_offset,
-                      (size_t)e.tensor->size());
+          CopyEntryRange(e, buffer_data_at_offset, 0, ReducedSize(e), false);
 #if HAVE_CUDA
         }
 #endif
-        offset += e.tensor->size();
+        offset += ReducedSize(e);
       }
 #if HAVE_CUDA
       if (on_gpu) {
@@ -1568,67 +2923,575 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
       }
 #endif
       ACTIVITY_END_ALL(entries, timeline)
+    } else if (first_entry.compression != NO_COMPRESSION) {
+      // Reduce the compressed tensor in a buffer of the lane, from which it
+      // is decompressed into the output.
+      auto& e = first_entry;
+      int64_t num_elements = e.tensor->shape().num_elements();
+      lane.compression_buffer.resize((size_t)total_size);
+      auto buffer_data = (void*)lane.compression_buffer.data();
+
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_IN_FUSION_BUFFER)
+      CopyEntryRange(e, buffer_data, 0, total_size, true);
+      ACTIVITY_END_ALL(entries, timeline)
+
+      auto algorithm = ChooseAllreduceAlgorithm(num_elements, dtype);
+      ACTIVITY_START_ALL(entries, timeline, AllreduceActivity(algorithm))
+      MPI_CHECK(entries, "MPI_Allreduce",
+                PerformAllreduce(algorithm, MPI_IN_PLACE, buffer_data,
+                                 num_elements, dtype, lane))
+      ACTIVITY_END_ALL(entries, timeline)
+
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_OUT_FUSION_BUFFER)
+      CopyEntryRange(e, buffer_data, 0, total_size, false);
+      ACTIVITY_END_ALL(entries, timeline)
     } else {
       auto& e = first_entry;
-      ACTIVITY_START_ALL(entries, timeline, MPI_ALLREDUCE)
       const void* sendbuf = e.tensor->data() == e.output->data()
                                 ? MPI_IN_PLACE
                                 : e.tensor->data();
+      if (e.prescale_factor != 1.0) {
+        // Scale the input into the output, which is then reduced in place.
+        ScaleBuffer(e.tensor->data(), (void*)e.output->data(),
+                    e.tensor->shape().num_elements(), e.tensor->dtype(),
+                    e.prescale_factor);
+        sendbuf = MPI_IN_PLACE;
+      }
+      auto algorithm =
+          e.device != CPU_DEVICE_ID
+              ? AllreduceAlgorithm::MPI
+              : ChooseAllreduceAlgorithm(e.tensor->shape().num_elements(),
+                                         e.tensor->dtype());
+      ACTIVITY_START_ALL(entries, timeline, AllreduceActivity(algorithm))
       MPI_CHECK(entries, "MPI_Allreduce",
-                MPI_Allreduce(sendbuf, (void*)e.output->data(),
-                              (int)e.tensor->shape().num_elements(),
-                              GetMPIDataType(e.tensor),
-                              first_entry.tensor->dtype() == HOROVOD_FLOAT16
-                                  ? horovod_global.mpi_float16_sum
-                                  : MPI_SUM,
-                              horovod_global.mpi_comm))
+                PerformAllreduce(algorithm, sendbuf, (void*)e.output->data(),
+                                 e.tensor->shape().num_elements(),
+                                 e.tensor->dtype(), lane))
       ACTIVITY_END_ALL(entries, timeline)
+      if (e.postscale_factor != 1.0) {
+        ScaleBuffer(e.output->data(), (void*)e.output->data(),
+                    e.tensor->shape().num_elements(), e.tensor->dtype(),
+                    e.postscale_factor);
+      }
     }
 
-    for (auto& e : entries) {
-      timeline.End(e.tensor_name, e.output);
-      e.callback(Status::OK());
-    }
+    CompleteEntries(entries, Status::OK());
   } else if (response.response_type() == MPIResponse::BROADCAST) {
-    assert(entries.size() == 1);
-    auto e = entries[0];
+    auto& first_entry = entries[0];
+    bool is_root_rank = horovod_global.rank == first_entry.root_rank;
+
+    if (entries.size() > 1 && horovod_global.param_manager.ZeroCopyFusion()) {
+      ACTIVITY_START_ALL(entries, timeline, MPI_BCAST)
+      MPI_CHECK(entries, "MPI_Bcast",
+                ZeroCopyFusedBroadcast(entries, is_root_rank, lane))
+      ACTIVITY_END_ALL(entries, timeline)
+    } else if (entries.size() > 1) {
+      // Fused broadcasts are on CPU and share the root rank and data type.
+      // The root rank packs its tensors into the fusion buffer, which is then
+      // unpacked into the outputs on the other ranks.
+      auto& buffer = lane.fusion_buffer.GetBuffer(
+          first_entry.device, first_entry.context->framework());
+      auto buffer_data = buffer->AccessData(first_entry.context);
+
+      if (is_root_rank) {
+        ACTIVITY_START_ALL(entries, timeline, MEMCPY_IN_FUSION_BUFFER)
+        int64_t offset = 0;
+        for (auto& e : entries) {
+          void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
+          std::memcpy(buffer_data_at_offset, e.tensor->data(),
+                      (size_t)e.tensor->size());
+          offset += e.tensor->size();
+        }
+        ACTIVITY_END_ALL(entries, timeline)
+      }
+
+      ACTIVITY_START_ALL(entries, timeline, MPI_BCAST)
+      int64_t num_elements = 0;
+      for (auto& e : entries) {
+        num_elements += e.tensor->shape().num_elements();
+      }
+      MPI_CHECK(entries, "MPI_Bcast",
+                MPI_Bcast((void*)buffer_data, (int)num_elements,
+                          GetMPIDataType(first_entry.tensor),
+                          first_entry.root_rank, lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
+
+      if (!is_root_rank) {
+        ACTIVITY_START_ALL(entries, timeline, MEMCPY_OUT_FUSION_BUFFER)
+        int64_t offset = 0;
+        for (auto& e : entries) {
+          void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
+          std::memcpy((void*)e.output->data(), buffer_data_at_offset,
+                      (size_t)e.tensor->size());
+          offset += e.tensor->size();
+        }
+        ACTIVITY_END_ALL(entries, timeline)
+      }
+    } else {
+      auto& e = first_entry;
+
+      // On root rank, MPI_Bcast sends data, on other ranks it receives data.
+      void* data_ptr;
+      if (is_root_rank) {
+        data_ptr = (void*)e.tensor->data();
+      } else {
+        data_ptr = (void*)e.output->data();
+      }
+
+      ACTIVITY_START_ALL(entries, timeline, MPI_BCAST)
+      MPI_CHECK(entries, "MPI_Bcast",
+                MPI_Bcast(data_ptr, (int)e.tensor->shape().num_elements(),
+                          GetMPIDataType(e.tensor), e.root_rank,
+                          lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
+    }
+
+    CompleteEntries(entries, Status::OK());
+  } else if (response.response_type() == MPIResponse::REDUCESCATTER) {
+    auto& first_entry = entries[0];
+    int size = horovod_global.size;
+    int rank = horovod_global.rank;
+    auto datatype = GetMPIDataType(first_entry.tensor);
+    int element_size;
+    MPI_Type_size(datatype, &element_size);
+
+    // Every rank receives the sum of its share of the first dimension of all
+    // tensors.
+    std::vector<int> recvcounts(size, 0);
+    std::vector<int64_t> slice_sizes(entries.size());
+    ACTIVITY_START_ALL(entries, timeline, ALLOCATE_OUTPUT)
+    for (size_t ec = 0; ec < entries.size(); ++ec) {
+      auto& e = entries[ec];
+      TensorShape single_slice_shape;
+      for (int i = 1; i < e.tensor->shape().dims(); ++i) {
+        single_slice_shape.AddDim(e.tensor->shape().dim_size(i));
+      }
+      slice_sizes[ec] = single_slice_shape.num_elements();
+      int64_t num_rows = e.tensor->shape().dim_size(0);
+      for (int rc = 0; rc < size; ++rc) {
+        recvcounts[rc] +=
+            (int)(ReducescatterRows(num_rows, rc, size) * slice_sizes[ec]);
+      }
+
+      TensorShape output_shape;
+      output_shape.AddDim(ReducescatterRows(num_rows, rank, size));
+      output_shape.AppendShape(single_slice_shape);
+      status = e.context->AllocateOutput(output_shape, &e.output);
+      if (!status.ok()) {
+        // The other entries are fused with this one and fail as well.
+        CompleteEntries(entries, status);
+        return;
+      }
+    }
+    ACTIVITY_END_ALL(entries, timeline)
+
+    auto op = first_entry.tensor->dtype() == HOROVOD_FLOAT16
+                  ? horovod_global.mpi_float16_sum
+                  : MPI_SUM;
+    if (entries.size() > 1) {
+      // Fused reducescatters are on CPU. The share of every rank of all
+      // tensors is packed together in the fusion buffer, ordered by rank.
+      auto& buffer = lane.fusion_buffer.GetBuffer(
+          first_entry.device, first_entry.context->framework());
+      auto buffer_data = buffer->AccessData(first_entry.context);
+
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_IN_FUSION_BUFFER)
+      int64_t offset = 0;
+      for (int rc = 0; rc < size; ++rc) {
+        for (size_t ec = 0; ec < entries.size(); ++ec) {
+          auto& e = entries[ec];
+          int64_t num_rows = e.tensor->shape().dim_size(0);
+          int64_t row_bytes = slice_sizes[ec] * element_size;
+          int64_t bytes = ReducescatterRows(num_rows, rc, size) * row_bytes;
+          std::memcpy((uint8_t*)buffer_data + offset,
+                      (const uint8_t*)e.tensor->data() +
+                          ReducescatterFirstRow(num_rows, rc, size) *
+                              row_bytes,
+                      (size_t)bytes);
+          offset += bytes;
+        }
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+
+      ACTIVITY_START_ALL(entries, timeline, MPI_REDUCESCATTER)
+      MPI_CHECK(entries, "MPI_Reduce_scatter",
+                MPI_Reduce_scatter(MPI_IN_PLACE, (void*)buffer_data,
+                                   recvcounts.data(), datatype, op,
+                                   lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
 
-    // On root rank, MPI_Bcast sends data, on other ranks it receives data.
-    void* data_ptr;
-    if (horovod_global.rank == e.root_rank) {
-      data_ptr = (void*)e.tensor->data();
+      // The result of this rank is at the start of the fusion buffer.
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_OUT_FUSION_BUFFER)
+      offset = 0;
+      for (auto& e : entries) {
+        std::memcpy((void*)e.output->data(), (uint8_t*)buffer_data + offset,
+                    (size_t)e.output->size());
+        offset += e.output->size();
+      }
+      ACTIVITY_END_ALL(entries, timeline)
     } else {
-      data_ptr = (void*)e.output->data();
+      ACTIVITY_START_ALL(entries, timeline, MPI_REDUCESCATTER)
+      MPI_CHECK(entries, "MPI_Reduce_scatter",
+                MPI_Reduce_scatter(first_entry.tensor->data(),
+                                   (void*)first_entry.output->data(),
+                                   recvcounts.data(), datatype, op,
+                                   lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
     }
 
-    ACTIVITY_START_ALL(entries, timeline, MPI_BCAST)
-    MPI_CHECK(entries, "MPI_Bcast",
-              MPI_Bcast(data_ptr, (int)e.tensor->shape().num_elements(),
-                        GetMPIDataType(e.tensor), e.root_rank,
-                        horovod_global.mpi_comm))
+    CompleteEntries(entries, Status::OK());
+  } else if (response.response_type() == MPIResponse::ALLTOALL) {
+    auto& first_entry = entries[0];
+    int size = horovod_global.size;
+    int rank = horovod_global.rank;
+    size_t matrix_size = (size_t)size * size;
+    auto& splits = response.tensor_sizes();
+    auto datatype = GetMPIDataType(first_entry.tensor);
+    int element_size;
+    MPI_Type_size(datatype, &element_size);
+
+    // Element counts sent to and received from every rank, over all tensors.
+    std::vector<int> sendcounts(size, 0);
+    std::vector<int> recvcounts(size, 0);
+    std::vector<int64_t> slice_sizes(entries.size());
+    ACTIVITY_START_ALL(entries, timeline, ALLOCATE_OUTPUT)
+    for (size_t ec = 0; ec < entries.size(); ++ec) {
+      auto& e = entries[ec];
+      TensorShape single_slice_shape;
+      for (int i = 1; i < e.tensor->shape().dims(); ++i) {
+        single_slice_shape.AddDim(e.tensor->shape().dim_size(i));
+      }
+      slice_sizes[ec] = single_slice_shape.num_elements();
+      auto* entry_splits = &splits[ec * matrix_size];
+      int64_t output_rows = 0;
+      for (int rc = 0; rc < size; ++rc) {
+        sendcounts[rc] +=
+            (int)(entry_splits[(size_t)rank * size + rc] * slice_sizes[ec]);
+        recvcounts[rc] +=
+            (int)(entry_splits[(size_t)rc * size + rank] * slice_sizes[ec]);
+        output_rows += entry_splits[(size_t)rc * size + rank];
+      }
+
+      // The output holds the slices received from every rank, ordered by
+      // rank.
+      TensorShape output_shape;
+      output_shape.AddDim(output_rows);
+      output_shape.AppendShape(single_slice_shape);
+      status = e.context->AllocateOutput(output_shape, &e.output);
+      if (!status.ok()) {
+        // The other entries are fused with this one and fail as well.
+        CompleteEntries(entries, status);
+        return;
+      }
+    }
     ACTIVITY_END_ALL(entries, timeline)
 
-    timeline.End(e.tensor_name, e.output);
-    e.callback(Status::OK());
+    std::vector<int> sdispls(size, 0);
+    std::vector<int> rdispls(size, 0);
+    for (int rc = 1; rc < size; ++rc) {
+      sdispls[rc] = sdispls[rc - 1] + sendcounts[rc - 1];
+      rdispls[rc] = rdispls[rc - 1] + recvcounts[rc - 1];
+    }
+
+    if (entries.size() > 1) {
+      // Fused alltoalls are on CPU. The slices sent to every rank are packed
+      // together at the start of the fusion buffer, ordered by rank, and the
+      // slices received from every rank follow them.
+      auto& buffer = lane.fusion_buffer.GetBuffer(
+          first_entry.device, first_entry.context->framework());
+      auto send_data = (uint8_t*)buffer->AccessData(first_entry.context);
+      auto recv_data = send_data + ((int64_t)sdispls[size - 1] +
+                                    sendcounts[size - 1]) *
+                                       element_size;
+
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_IN_FUSION_BUFFER)
+      std::vector<int64_t> entry_offsets(entries.size(), 0);
+      int64_t offset = 0;
+      for (int rc = 0; rc < size; ++rc) {
+        for (size_t ec = 0; ec < entries.size(); ++ec) {
+          int64_t bytes = splits[ec * matrix_size + (size_t)rank * size + rc] *
+                          slice_sizes[ec] * element_size;
+          std::memcpy(send_data + offset,
+                      (const uint8_t*)entries[ec].tensor->data() +
+                          entry_offsets[ec],
+                      (size_t)bytes);
+          entry_offsets[ec] += bytes;
+          offset += bytes;
+        }
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+
+      ACTIVITY_START_ALL(entries, timeline, MPI_ALLTOALL)
+      MPI_CHECK(entries, "MPI_Alltoallv",
+                MPI_Alltoallv(send_data, sendcounts.data(), sdispls.data(),
+                              datatype, recv_data, recvcounts.data(),
+                              rdispls.data(), datatype, lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
+
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_OUT_FUSION_BUFFER)
+      entry_offsets.assign(entries.size(), 0);
+      offset = 0;
+      for (int rc = 0; rc < size; ++rc) {
+        for (size_t ec = 0; ec < entries.size(); ++ec) {
+          int64_t bytes = splits[ec * matrix_size + (size_t)rc * size + rank] *
+                          slice_sizes[ec] * element_size;
+          std::memcpy((uint8_t*)entries[ec].output->data() + entry_offsets[ec],
+                      recv_data + offset, (size_t)bytes);
+          entry_offsets[ec] += bytes;
+          offset += bytes;
+        }
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+    } else {
+      ACTIVITY_START_ALL(entries, timeline, MPI_ALLTOALL)
+      MPI_CHECK(entries, "MPI_Alltoallv",
+                MPI_Alltoallv(first_entry.tensor->data(), sendcounts.data(),
+                              sdispls.data(), datatype,
+                              (void*)first_entry.output->data(),
+                              recvcounts.data(), rdispls.data(), datatype,
+                              lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
+    }
+
+    CompleteEntries(entries, Status::OK());
+  } else if (response.response_type() == MPIResponse::SPARSE_ALLREDUCE) {
+    auto& first_entry = entries[0];
+    int size = horovod_global.size;
+    int rank = horovod_global.rank;
+    auto& sizes = response.tensor_sizes();
+    auto dtype = first_entry.tensor->dtype();
+    int element_size;
+    MPI_Type_size(GetMPIDataType(dtype), &element_size);
+    std::vector<int64_t> row_elements(entries.size());
+    int64_t total_bytes = 0;
+    for (size_t ec = 0; ec < entries.size(); ++ec) {
+      row_elements[ec] = RowElements(entries[ec]);
+      total_bytes += SparseAllreduceBytes(sizes, ec, entries[ec]);
+    }
+
+    // Fused sparse allreduces are on CPU, and either all gather their rows or
+    // all reduce their dense tensors.
+    uint8_t* buffer_data;
+    if (entries.size() > 1) {
+      auto& buffer = lane.fusion_buffer.GetBuffer(
+          first_entry.device, first_entry.context->framework());
+      buffer_data = (uint8_t*)buffer->AccessData(first_entry.context);
+    } else {
+      lane.sparse_buffer.resize((size_t)total_bytes);
+      buffer_data = (uint8_t*)lane.sparse_buffer.data();
+    }
+
+    // Errors of single tensors, which do not fail the tensors fused with them.
+    std::vector<Status> statuses(entries.size());
+    auto index_at = [](const TensorTableEntry& e, int64_t row) {
+      return e.indices->dtype() == HOROVOD_INT32
+                 ? (int64_t)((const int32_t*)e.indices->data())[row]
+                 : ((const int64_t*)e.indices->data())[row];
+    };
+    auto index_error = [](const TensorTableEntry& e, int64_t index) {
+      return Status::InvalidArgument(
+          "Sparse allreduce of " + EntryName(e) + " has index " +
+          std::to_string(index) + ", outside of the " +
+          std::to_string(e.dense_rows) + " rows of the dense tensor.");
+    };
+
+    if (!SparseAllreduceIsDense(sizes, 0, first_entry)) {
+      // The block of every rank holds, for every tensor, the indices of its
+      // rows as int64, followed by the rows.
+      std::vector<int> recvcounts(size, 0);
+      std::vector<int> displs(size, 0);
+      for (int rc = 0; rc < size; ++rc) {
+        for (size_t ec = 0; ec < entries.size(); ++ec) {
+          recvcounts[rc] +=
+              (int)(sizes[ec * size + rc] *
+                    ((int64_t)sizeof(int64_t) + row_elements[ec] * element_size));
+        }
+        if (rc > 0) {
+          displs[rc] = displs[rc - 1] + recvcounts[rc - 1];
+        }
+      }
+
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_IN_FUSION_BUFFER)
+      auto block = buffer_data + displs[rank];
+      for (auto& e : entries) {
+        int64_t num_rows = e.tensor->shape().dim_size(0);
+        for (int64_t row = 0; row < num_rows; ++row) {
+          int64_t index = index_at(e, row);
+          std::memcpy(block, &index, sizeof(index));
+          block += sizeof(index);
+        }
+        std::memcpy(block, e.tensor->data(), (size_t)e.tensor->size());
+        block += e.tensor->size();
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+
+      ACTIVITY_START_ALL(entries, timeline, MPI_ALLGATHER)
+      MPI_CHECK(entries, "MPI_Allgatherv",
+                MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, buffer_data,
+                               recvcounts.data(), displs.data(), MPI_BYTE,
+                               lane.comm))
+      ACTIVITY_END_ALL(entries, timeline)
+
+      // Every rank has the same rows, so an index out of range fails the
+      // tensor on every rank.
+      ACTIVITY_START_ALL(entries, timeline, MERGE_SPARSE_ROWS)
+      std::vector<int64_t> block_offsets(displs.begin(), displs.end());
+      std::vector<int64_t> indices;
+      std::vector<const void*> rows;
+      for (size_t ec = 0; ec < entries.size(); ++ec) {
+        auto& e = entries[ec];
+        int64_t row_bytes = row_elements[ec] * element_size;
+        indices.clear();
+        rows.clear();
+        for (int rc = 0; rc < size; ++rc) {
+          int64_t num_rows = sizes[ec * size + rc];
+          auto index_data = buffer_data + block_offsets[rc];
+          auto row_data = index_data + num_rows * sizeof(int64_t);
+          for (int64_t row = 0; row < num_rows; ++row) {
+            int64_t index;
+            std::memcpy(&index, index_data + row * sizeof(int64_t),
+                        sizeof(index));
+            if (statuses[ec].ok() &&
+                (index < 0 || (e.dense_rows > 0 && index >= e.dense_rows))) {
+              statuses[ec] = index_error(e, index);
+            }
+            indices.push_back(index);
+            rows.push_back(row_data + row * row_bytes);
+          }
+          block_offsets[rc] +=
+              num_rows * ((int64_t)sizeof(int64_t) + row_bytes);
+        }
+        if (!statuses[ec].ok()) {
+          continue;
+        }
+
+        int64_t num_unique = lane.sparse_merger.Sort(indices);
+        TensorShape output_shape;
+        output_shape.AddDim(num_unique);
+        for (int i = 1; i < e.tensor->shape().dims(); ++i) {
+          output_shape.AddDim(e.tensor->shape().dim_size(i));
+        }
+        TensorShape indices_shape;
+        indices_shape.AddDim(num_unique);
+        statuses[ec] = e.context->AllocateOutput(output_shape, &e.output);
+        if (statuses[ec].ok()) {
+          statuses[ec] = e.indices_context->AllocateOutput(indices_shape,
+                                                           &e.indices_output);
+        }
+        if (statuses[ec].ok()) {
+          lane.sparse_merger.Merge(rows, row_elements[ec], row_bytes, dtype,
+                                   (void*)e.output->data(),
+                                   (void*)e.indices_output->data(),
+                                   e.indices->dtype());
+        }
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+    } else {
+      // Every rank adds its rows to zeroed dense tensors, which are then
+      // reduced. Only this rank sees its indices, so an index out of range
+      // fails the tensor on this rank, and its row is left out.
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_IN_FUSION_BUFFER)
+      std::memset(buffer_data, 0, (size_t)total_bytes);
+      int64_t offset = 0;
+      for (size_t ec = 0; ec < entries.size(); ++ec) {
+        auto& e = entries[ec];
+        int64_t row_bytes = row_elements[ec] * element_size;
+        int64_t num_rows = e.tensor->shape().dim_size(0);
+        for (int64_t row = 0; row < num_rows; ++row) {
+          int64_t index = index_at(e, row);
+          if (index < 0 || index >= e.dense_rows) {
+            if (statuses[ec].ok()) {
+              statuses[ec] = index_error(e, index);
+            }
+            continue;
+          }
+          SumBuffer((const uint8_t*)e.tensor->data() + row * row_bytes,
+                    buffer_data + offset + index * row_bytes,
+                    row_elements[ec], dtype);
+        }
+        offset += e.dense_rows * row_bytes;
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+
+      int64_t num_elements = total_bytes / element_size;
+      auto algorithm = ChooseAllreduceAlgorithm(num_elements, dtype);
+      ACTIVITY_START_ALL(entries, timeline, AllreduceActivity(algorithm))
+      MPI_CHECK(entries, "MPI_Allreduce",
+                PerformAllreduce(algorithm, MPI_IN_PLACE, buffer_data,
+                                 num_elements, dtype, lane))
+      ACTIVITY_END_ALL(entries, timeline)
+
+      // The output holds all the rows of the dense tensor.
+      ACTIVITY_START_ALL(entries, timeline, MEMCPY_OUT_FUSION_BUFFER)
+      offset = 0;
+      for (size_t ec = 0; ec < entries.size(); ++ec) {
+        auto& e = entries[ec];
+        int64_t dense_bytes = e.dense_rows * row_elements[ec] * element_size;
+        if (statuses[ec].ok()) {
+          TensorShape output_shape;
+          output_shape.AddDim(e.dense_rows);
+          for (int i = 1; i < e.tensor->shape().dims(); ++i) {
+            output_shape.AddDim(e.tensor->shape().dim_size(i));
+          }
+          TensorShape indices_shape;
+          indices_shape.AddDim(e.dense_rows);
+          statuses[ec] = e.context->AllocateOutput(output_shape, &e.output);
+          if (statuses[ec].ok()) {
+            statuses[ec] = e.indices_context->AllocateOutput(
+                indices_shape, &e.indices_output);
+          }
+        }
+        if (statuses[ec].ok()) {
+          std::memcpy((void*)e.output->data(), buffer_data + offset,
+                      (size_t)dense_bytes);
+          for (int64_t row = 0; row < e.dense_rows; ++row) {
+            if (e.indices->dtype() == HOROVOD_INT32) {
+              ((int32_t*)e.indices_output->data())[row] = (int32_t)row;
+            } else {
+              ((int64_t*)e.indices_output->data())[row] = row;
+            }
+          }
+        }
+        offset += dense_bytes;
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+    }
+
+    // Complete the failed tensors on their own.
+    std::vector<TensorTableEntry> completed;
+    for (size_t ec = 0; ec < entries.size(); ++ec) {
+      if (statuses[ec].ok()) {
+        completed.push_back(std::move(entries[ec]));
+      } else {
+        std::vector<TensorTableEntry> failed;
+        failed.push_back(std::move(entries[ec]));
+        CompleteEntries(failed, statuses[ec]);
+      }
+    }
+    entries.clear();
+    CompleteEntries(completed, Status::OK());
   } else if (response.response_type() == MPIResponse::ERROR) {
     assert(entries.size() == 1);
-    auto e = entries[0];
-
-    status = Status::PreconditionError(response.error_message());
-    timeline.End(e.tensor_name, nullptr);
-    e.callback(status);
+    CompleteEntries(entries,
+                    Status::PreconditionError(response.error_message()));
   }
 }
 
 // Report Tensors that were submitted to be reduced, gathered or broadcasted by
 // some ranks but not others and are waiting for long time to get processed.
-void CheckForStalledTensors(HorovodGlobalState& state) {
+// Report tensors of a tensor count table which are waiting for a subset of
+// participants. participant_ranks maps the request rank stored in the table to
+// the COMM_WORLD ranks it stands for.
+void CheckForStalledTensors(
+    const MessageTable& message_table,
+    const std::vector<std::vector<int>>& participant_ranks) {
   bool preamble = false;
   auto now = std::chrono::steady_clock::now();
-  for (auto& m : *state.message_table) {
-    auto tensor_name = m.first;
-    std::vector<MPIRequest>& messages = std::get<0>(m.second);
-    std::chrono::steady_clock::time_point start_at = std::get<1>(m.second);
+  message_table.ForEach([&](int32_t tensor_id, const std::string& name,
+                            const MessageTableEntry& entry) {
+    auto& tensor_name =
+        tensor_id >= 0 ? horovod_global.tensor_registry.Name(tensor_id) : name;
+    std::chrono::steady_clock::time_point start_at = entry.start_at;
 
     if (now - start_at > STALL_WARNING_TIME) {
       std::stringstream message;
@@ -1648,26 +3511,51 @@ void CheckForStalledTensors(HorovodGlobalState& state) {
       }
       message << tensor_name;
       message << " [missing ranks:";
-      std::unordered_set<int32_t> ready_ranks;
+      std::vector<int> missing_ranks;
+      for (int32_t i = 0; i < (int32_t)participant_ranks.size(); ++i) {
+        if ((entry.ready_ranks[i / 64] & (1ULL << (i % 64))) == 0) {
+          missing_ranks.insert(missing_ranks.end(), participant_ranks[i].begin(),
+                               participant_ranks[i].end());
+        }
+      }
+      std::sort(missing_ranks.begin(), missing_ranks.end());
       bool missing_preamble = false;
-      for (auto msg_iter = messages.begin(); msg_iter != messages.end();
-           ++msg_iter) {
-        ready_ranks.insert(msg_iter->request_rank());
-      }
-      for (int32_t rank = 0; rank < state.size; ++rank) {
-        if (ready_ranks.find(rank) == ready_ranks.end()) {
-          if (!missing_preamble) {
-            message << " ";
-            missing_preamble = true;
-          } else {
-            message << ", ";
-          }
-          message << rank;
+      for (auto rank : missing_ranks) {
+        if (!missing_preamble) {
+          message << " ";
+          missing_preamble = true;
+        } else {
+          message << ", ";
         }
+        message << rank;
       }
       message << "]";
       LOG(WARNING) << message.str();
     }
+  });
+}
+
+void CheckForStalledTensors(HorovodGlobalState& state) {
+  if (!state.hierarchical_negotiation) {
+    std::vector<std::vector<int>> participant_ranks;
+    for (int rank = 0; rank < state.size; ++rank) {
+      participant_ranks.push_back({rank});
+    }
+    CheckForStalledTensors(*state.message_table, participant_ranks);
+    return;
+  }
+
+  // Tensors may stall either on a node, waiting for some of its ranks, or on
+  // the coordinator, waiting for whole nodes.
+  if (state.local_rank == 0) {
+    std::vector<std::vector<int>> participant_ranks;
+    for (auto rank : state.local_comm_ranks) {
+      participant_ranks.push_back({rank});
+    }
+    CheckForStalledTensors(*state.node_message_table, participant_ranks);
+  }
+  if (state.rank == RANK_ZERO) {
+    CheckForStalledTensors(*state.message_table, state.node_ranks);
   }
 }
 
@@ -1692,6 +3580,7 @@ void CheckForStalledTensors(HorovodGlobalState& state) {
 //      otherwise we may end up dispatching many blocked threads and never make
 //      progress if we have a thread pool limit.
 bool RunLoopOnce(HorovodGlobalState& state, bool is_coordinator);
+void FailSubmissions(HorovodGlobalState& state);
 void BackgroundThreadLoop(HorovodGlobalState& state) {
   // Initialize MPI if it was not initialized. This must happen on the
   // background thread, since not all MPI implementations support being called
@@ -1739,9 +3628,10 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
     }
     MPI_Group_free(&world_group);
     MPI_Group_free(&work_group);
-  } else if (!state.mpi_comm) {
+  } else if (!state.mpi_comm || state.mpi_comm == MPI_COMM_NULL) {
     // No ranks were given and no communicator provided to horovod_init() so use
-    // MPI_COMM_WORLD
+    // MPI_COMM_WORLD. The communicator of a previous initialization has been
+    // freed by the shutdown.
     MPI_Comm_dup(MPI_COMM_WORLD, &(horovod_global.mpi_comm));
   }
 
@@ -1816,6 +3706,7 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   state.cross_size = cross_size;
   state.local_comm = local_comm;
   state.cross_comm = cross_comm;
+  MPI_Comm_dup(state.mpi_comm, &state.negotiation_comm);
   state.mpi_float16_t = mpi_float16_t;
   state.mpi_float16_sum = mpi_float16_sum;
   state.mpi_threads_supported = (provided == MPI_THREAD_MULTIPLE);
@@ -1850,13 +3741,134 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
                                        true);
   }
 
-  // Disable stall check.
-  auto horovod_stall_check_disable = std::getenv(HOROVOD_STALL_CHECK_DISABLE);
-  if (horovod_stall_check_disable != nullptr &&
-      std::strtol(horovod_stall_check_disable, nullptr, 10) > 0) {
+  // Set the chunk size of pipelined CPU allreduce, disabled by default.
+  state.param_manager.SetAllreduceChunkBytes(0);
+  auto horovod_allreduce_chunk_size = std::getenv(HOROVOD_ALLREDUCE_CHUNK_SIZE);
+  if (horovod_allreduce_chunk_size != nullptr) {
+    int64_t chunk_bytes = std::strtol(horovod_allreduce_chunk_size, nullptr, 10);
+    state.param_manager.SetAllreduceChunkBytes(chunk_bytes, true);
+  }
+
+  // Set the crossover points of the native allreduce algorithms, disabled by
+  // default.
+  state.param_manager.SetAllreduceRecursiveDoublingBytes(0);
+  auto horovod_allreduce_recursive_doubling_threshold =
+      std::getenv(HOROVOD_ALLREDUCE_RECURSIVE_DOUBLING_THRESHOLD);
+  if (horovod_allreduce_recursive_doubling_threshold != nullptr) {
+    int64_t threshold = std::strtol(
+        horovod_allreduce_recursive_doubling_threshold, nullptr, 10);
+    state.param_manager.SetAllreduceRecursiveDoublingBytes(threshold, true);
+  }
+  state.param_manager.SetAllreduceRingBytes(0);
+  auto horovod_allreduce_ring_threshold =
+      std::getenv(HOROVOD_ALLREDUCE_RING_THRESHOLD);
+  if (horovod_allreduce_ring_threshold != nullptr) {
+    int64_t threshold =
+        std::strtol(horovod_allreduce_ring_threshold, nullptr, 10);
+    state.param_manager.SetAllreduceRingBytes(threshold, true);
+  }
+
+  // Move fused CPU allgathers and broadcasts through derived datatypes
+  // instead of the fusion buffer. Tuned if the variable is not set.
+  state.param_manager.SetZeroCopyFusion(false);
+  auto horovod_zero_copy_fusion = std::getenv(HOROVOD_ZERO_COPY_FUSION);
+  if (horovod_zero_copy_fusion != nullptr) {
+    bool value = std::strtol(horovod_zero_copy_fusion, nullptr, 10) > 0;
+    state.param_manager.SetZeroCopyFusion(value, true);
+  }
+
+  // Disable stall check.
+  auto horovod_stall_check_disable = std::getenv(HOROVOD_STALL_CHECK_DISABLE);
+  if (horovod_stall_check_disable != nullptr &&
+      std::strtol(horovod_stall_check_disable, nullptr, 10) > 0) {
     state.perform_stall_check = false;
   }
 
+  // Wake up the background thread on enqueued tensors instead of running
+  // cycles at a fixed interval.
+  auto horovod_event_driven_cycle = std::getenv(HOROVOD_EVENT_DRIVEN_CYCLE);
+  if (horovod_event_driven_cycle != nullptr &&
+      std::strtol(horovod_event_driven_cycle, nullptr, 10) > 0) {
+    state.event_driven_cycle = true;
+  }
+
+  // Negotiate the next cycle while performing the responses of this one.
+  auto horovod_overlap_negotiation = std::getenv(HOROVOD_OVERLAP_NEGOTIATION);
+  if (horovod_overlap_negotiation != nullptr &&
+      std::strtol(horovod_overlap_negotiation, nullptr, 10) > 0) {
+    state.overlap_negotiation = true;
+  }
+
+  // Set the fraction of the elements sent by top-k compression.
+  auto horovod_topk_ratio = std::getenv(HOROVOD_TOPK_RATIO);
+  if (horovod_topk_ratio != nullptr) {
+    double ratio = std::strtod(horovod_topk_ratio, nullptr);
+    if (ratio > 0) {
+      state.topk_ratio = std::min(ratio, 1.0);
+    }
+  }
+
+  // Set the number of tensors whose top-k compression residuals are kept.
+  uint32_t topk_residual_capacity = 4096;
+  auto horovod_topk_residual_capacity =
+      std::getenv(HOROVOD_TOPK_RESIDUAL_CAPACITY);
+  if (horovod_topk_residual_capacity != nullptr) {
+    topk_residual_capacity =
+        (uint32_t)std::strtol(horovod_topk_residual_capacity, nullptr, 10);
+  }
+  state.topk_residuals.set_capacity(topk_residual_capacity);
+
+  // Set the density above which sparse allreduces reduce the dense tensor.
+  auto horovod_sparse_density_threshold =
+      std::getenv(HOROVOD_SPARSE_DENSITY_THRESHOLD);
+  if (horovod_sparse_density_threshold != nullptr) {
+    state.sparse_density_threshold = std::max(
+        0.0, std::strtod(horovod_sparse_density_threshold, nullptr));
+  }
+
+  // Set the capacity of the response cache. Must be the same on all ranks,
+  // zero disables the cache.
+  uint32_t cache_capacity = 1024;
+  auto horovod_cache_capacity = std::getenv(HOROVOD_CACHE_CAPACITY);
+  if (horovod_cache_capacity != nullptr) {
+    cache_capacity =
+        (uint32_t)std::strtol(horovod_cache_capacity, nullptr, 10);
+  }
+  state.response_cache.set_capacity(cache_capacity);
+
+  // Set the number of tensors which can be submitted before the background
+  // thread takes them. Framework threads wait while the queue is full.
+  uint64_t submission_queue_capacity = 16384;
+  auto horovod_submission_queue_capacity =
+      std::getenv(HOROVOD_SUBMISSION_QUEUE_CAPACITY);
+  if (horovod_submission_queue_capacity != nullptr) {
+    submission_queue_capacity = std::max(
+        1L, std::strtol(horovod_submission_queue_capacity, nullptr, 10));
+  }
+  state.submission_queue.reset(
+      new MPSCQueue<Submission>(submission_queue_capacity));
+
+  // Start the threads running the callbacks of performed operations. With
+  // zero threads, callbacks run on the background thread. The background
+  // thread waits while the queue of a thread is full.
+  int completion_threads = 2;
+  auto horovod_completion_threads = std::getenv(HOROVOD_COMPLETION_THREADS);
+  if (horovod_completion_threads != nullptr) {
+    completion_threads = std::max(
+        0, (int)std::strtol(horovod_completion_threads, nullptr, 10));
+  }
+  uint64_t completion_queue_capacity = 1024;
+  auto horovod_completion_queue_capacity =
+      std::getenv(HOROVOD_COMPLETION_QUEUE_CAPACITY);
+  if (horovod_completion_queue_capacity != nullptr) {
+    completion_queue_capacity = std::max(
+        1L, std::strtol(horovod_completion_queue_capacity, nullptr, 10));
+  }
+  if (completion_threads > 0) {
+    state.completion_pool.Start(completion_threads, completion_queue_capacity,
+                                RunCompletion);
+  }
+
   // Set flag for hierarchical allgather. Ignore if Horovod is running on a
   // single node.
   auto horovod_hierarchical_allgather =
@@ -1878,11 +3890,6 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
     state.param_manager.SetHierarchicalAllreduce(value, true);
   }
 
-#if HOROVOD_GPU_ALLREDUCE != 'N' && HOROVOD_GPU_ALLREDUCE != 'D'
-  // Hierarchical allreduce is not supported without NCCL or DDL
-  state.param_manager.SetHierarchicalAllreduce(false, true);
-#endif
-
   // Issue warning if hierarchical allreduce is enabled in heterogeneous cluster
   if (is_coordinator &&
       (state.param_manager.HierarchicalAllreduce() ||
@@ -1908,11 +3915,80 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
     state.param_manager.SetAutoTuning(true);
   }
 
+  // Set the number of collective operations performed concurrently. Every
+  // lane beyond the first has its own duplicate of mpi_comm, which requires
+  // MPI_THREAD_MULTIPLE. When auto-tuning, lanes are created for the largest
+  // number tried.
+  state.param_manager.SetConcurrentCollectives(1);
+  int num_lanes = state.param_manager.IsAutoTuning() ? 4 : 1;
+  auto horovod_concurrent_collectives =
+      std::getenv(HOROVOD_CONCURRENT_COLLECTIVES);
+  if (horovod_concurrent_collectives != nullptr) {
+    num_lanes = std::max(
+        1, (int)std::strtol(horovod_concurrent_collectives, nullptr, 10));
+    state.param_manager.SetConcurrentCollectives(num_lanes, true);
+  }
+  if (provided < MPI_THREAD_MULTIPLE) {
+    num_lanes = 1;
+    state.param_manager.SetConcurrentCollectives(1, true);
+  }
+  for (int i = 0; i < num_lanes; ++i) {
+    state.lanes.emplace_back(new CollectiveLane());
+    if (i == 0) {
+      state.lanes[i]->comm = state.mpi_comm;
+    } else {
+      MPI_Comm_dup(state.mpi_comm, &state.lanes[i]->comm);
+    }
+  }
+  state.lane_loads.resize(state.lanes.size());
+  if (num_lanes > 1) {
+    state.lane_executor.Start(num_lanes, 1024, [](LaneTask& task) {
+      PerformOperation(*task.entries, *task.response, *task.lane);
+      task.entries->clear();
+    });
+  }
+
   // Initialize the tensor count table. No tensors are available yet.
   if (is_coordinator) {
     state.message_table = std::unique_ptr<MessageTable>(new MessageTable());
   }
 
+  // Set flag for hierarchical negotiation. Ignore if Horovod is running on a
+  // single node.
+  auto horovod_hierarchical_negotiation =
+      std::getenv(HOROVOD_HIERARCHICAL_NEGOTIATION);
+  if (horovod_hierarchical_negotiation != nullptr &&
+      std::strtol(horovod_hierarchical_negotiation, nullptr, 10) > 0 &&
+      size != local_size) {
+    state.hierarchical_negotiation = true;
+  }
+
+  // Local rank zero of every node aggregates the requests of its node, and
+  // the coordinator needs to know which ranks each node summary stands for.
+  if (state.hierarchical_negotiation && local_rank == 0) {
+    state.node_message_table =
+        std::unique_ptr<MessageTable>(new MessageTable());
+
+    std::vector<int> node_sizes(is_coordinator ? cross_size : 0);
+    MPI_Gather(&local_size, 1, MPI_INT, node_sizes.data(), 1, MPI_INT,
+               RANK_ZERO, cross_comm);
+    std::vector<int> displcmnts(node_sizes.size());
+    int total_size = 0;
+    for (unsigned int i = 0; i < node_sizes.size(); ++i) {
+      displcmnts[i] = total_size;
+      total_size += node_sizes[i];
+    }
+    std::vector<int> all_ranks((size_t)total_size);
+    MPI_Gatherv(local_comm_ranks.data(), local_size, MPI_INT, all_ranks.data(),
+                node_sizes.data(), displcmnts.data(), MPI_INT, RANK_ZERO,
+                cross_comm);
+    for (unsigned int i = 0; i < node_sizes.size(); ++i) {
+      state.node_ranks.emplace_back(all_ranks.begin() + displcmnts[i],
+                                    all_ranks.begin() + displcmnts[i] +
+                                        node_sizes[i]);
+    }
+  }
+
   // Signal that initialization is completed.
   state.initialization_done = true;
 
@@ -1939,19 +4015,29 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   //  }
   //#endif
 
+  // Finish the operations in flight and run the callbacks of the performed
+  // operations.
+  state.lane_executor.Stop();
+  state.completion_pool.Stop();
+
   // Notify all outstanding operations that Horovod has been shut down
   // and clear up the tensor table and message queue.
+  FailSubmissions(state);
   std::vector<StatusCallback> callbacks;
+  for (auto& e : state.tensor_table.TakeAll()) {
+    callbacks.emplace_back(e.callback);
+  }
+  state.tensor_registry.Clear();
+  state.topk_residuals.Clear();
+  state.message_queue.clear();
+  state.parked_requests.clear();
   {
     std::lock_guard<std::mutex> guard(state.mutex);
-    for (auto& e : state.tensor_table) {
-      callbacks.emplace_back(e.second.callback);
-    }
-    state.tensor_table.clear();
-    while (!state.message_queue.empty()) {
-      state.message_queue.pop();
-    }
+    state.notified_parked_ids.clear();
   }
+  state.response_cache.clear();
+  state.cache_hits_pending_since.clear();
+  state.pending_response_list = MPIResponseList();
   for (auto& cb : callbacks) {
     cb(SHUT_DOWN_ERROR);
   }
@@ -1961,6 +4047,20 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
     horovod_global.shared_buffer = nullptr;
   }
 
+  if (!horovod_global.allreduce_segments.empty()) {
+    MPI_Win_free(&horovod_global.allreduce_window);
+    horovod_global.allreduce_segments.clear();
+  }
+
+  for (size_t i = 0; i < horovod_global.lanes.size(); ++i) {
+    auto& lane = *horovod_global.lanes[i];
+    lane.fused_datatypes.Clear();
+    if (i > 0 && lane.comm != MPI_COMM_NULL) {
+      MPI_Comm_free(&lane.comm);
+    }
+  }
+  horovod_global.lanes.clear();
+
   if (horovod_global.mpi_comm != MPI_COMM_NULL &&
       horovod_global.mpi_comm != MPI_COMM_WORLD) {
     MPI_Comm_free(&horovod_global.mpi_comm);
@@ -1974,6 +4074,10 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
     MPI_Comm_free(&horovod_global.cross_comm);
   }
 
+  if (horovod_global.negotiation_comm != MPI_COMM_NULL) {
+    MPI_Comm_free(&horovod_global.negotiation_comm);
+  }
+
   if (horovod_global.mpi_float16_t != MPI_DATATYPE_NULL) {
     MPI_Type_free(&horovod_global.mpi_float16_t);
   }
@@ -1998,385 +4102,1418 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   }
 }
 
-// The coordinator currently follows a master-worker paradigm. Rank zero acts
-// as the master (the "coordinator"), whereas all other ranks are simply
-// workers. Each rank runs its own background thread which progresses in ticks.
-// In each tick, the following actions happen:
-//
-//      a) The workers send an MPIRequest to the coordinator, indicating what
-//      they would like to do (which tensor they would like to gather and
-//      reduce, as well as their shape and type). They repeat this for every
-//      tensor that they would like to operate on.
-//
-//      b) The workers send an empty "DONE" message to the coordinator to
-//      indicate that there are no more tensors they wish to operate on.
-//
-//      c) The coordinator receives the MPIRequests from the workers, as well
-//      as from its own TensorFlow ops, and stores them in a request table. The
-//      coordinator continues to receive MPIRequest messages until it has
-//      received MPI_SIZE number of empty "DONE" messages.
-//
-//      d) The coordinator finds all tensors that are ready to be reduced,
-//      gathered, or all operations that result in an error. For each of those,
-//      it sends an MPIResponse to all the workers. When no more MPIResponses
-//      are available, it sends a "DONE" response to the workers. If the process
-//      is being shutdown, it instead sends a "SHUTDOWN" response.
-//
-//      e) The workers listen for MPIResponse messages, processing each one by
-//      doing the required reduce or gather, until they receive a "DONE"
-//      response from the coordinator. At that point, the tick ends.
-//      If instead of "DONE" they receive "SHUTDOWN", they exit their background
-//      loop.
-bool RunLoopOnce(HorovodGlobalState& state, bool is_coordinator) {
-  // This delay determines thread frequency and MPI message latency
-  auto start_time = std::chrono::steady_clock::now();
-  auto sleep_duration = state.last_cycle_start +
-                        std::chrono::microseconds(
-                            long(state.param_manager.CycleTimeMs() * 1000.)) -
-                        start_time;
-  if (sleep_duration > std::chrono::steady_clock::duration::zero()) {
-    std::this_thread::sleep_for(sleep_duration);
+// Return a cleared response from the response pool, or a new one if the pool
+// is empty.
+MPIResponse TakePooledResponse(HorovodGlobalState& state) {
+  if (state.response_pool.empty()) {
+    return MPIResponse();
   }
-  state.last_cycle_start = std::chrono::steady_clock::now();
+  MPIResponse response = std::move(state.response_pool.back());
+  state.response_pool.pop_back();
+  return response;
+}
 
-  if (state.mark_cycles_in_timeline) {
-    // Mark start of the new cycle.
-    state.timeline.MarkCycleStart();
+// Return the responses of a response list the background thread is done with
+// to the response pool, and clear the list. The pool keeps at most as many
+// responses as the list holds, so that responses received from the
+// coordinator in every cycle do not grow it without bound.
+void RecycleResponses(HorovodGlobalState& state,
+                      MPIResponseList& response_list) {
+  auto& responses = response_list.mutable_responses();
+  for (auto& response : responses) {
+    if (state.response_pool.size() >= responses.size()) {
+      break;
+    }
+    response.clear();
+    state.response_pool.push_back(std::move(response));
   }
+  responses.clear();
+  response_list.set_shutdown(false);
+}
 
-  // Copy the data structures from global state under this lock.
-  // However, don't keep the lock for the rest of the loop, so that
-  // enqueued stream callbacks can continue.
-  std::queue<MPIRequest> message_queue;
-  {
-    std::lock_guard<std::mutex> guard(state.mutex);
-    while (!state.message_queue.empty()) {
-      MPIRequest message = state.message_queue.front();
-      state.message_queue.pop();
-      message_queue.push(message);
+// Fuse the given single-tensor responses, in order, into as few responses as
+// the fusion threshold allows and append them to the response list. Requires
+// the tensors to be present in the tensor table of this rank. The given
+// responses are only read, fused responses are built in responses taken from
+// the response pool. The list of responses is cleared.
+void FuseResponses(std::vector<const MPIResponse*>& responses,
+                   HorovodGlobalState& state, MPIResponseList& response_list) {
+  for (size_t next = 0; next < responses.size(); ++next) {
+    if (responses[next] == nullptr) {
+      // Already fused into an earlier response.
+      continue;
+    }
+    auto& first_response = *responses[next];
+    assert(first_response.tensor_names().size() == 1);
+    responses[next] = nullptr;
+
+    auto response = TakePooledResponse(state);
+    response.set_response_type(first_response.response_type());
+    response.add_tensor_name(first_response.tensor_names()[0],
+                             first_response.tensor_ids()[0]);
+    response.set_error_message(first_response.error_message());
+    response.set_devices(first_response.devices());
+    for (auto size : first_response.tensor_sizes()) {
+      response.add_tensor_size(size);
     }
+
+    int64_t tensor_size = 0;
+    if (response.response_type() == MPIResponse::ResponseType::ALLREDUCE ||
+        ((response.response_type() == MPIResponse::ResponseType::BROADCAST ||
+          response.response_type() ==
+              MPIResponse::ResponseType::REDUCESCATTER) &&
+         response.devices()[0] == CPU_DEVICE_ID)) {
+      // Attempt to add more responses to this fused response. Broadcasts and
+      // reducescatters are only fused on CPU, broadcasts with broadcasts from
+      // the same root rank.
+      auto& entry = state.tensor_table.Get(response.tensor_ids()[0],
+                                           response.tensor_names()[0]);
+      tensor_size = FusionBufferBytes(response, entry);
+
+      int64_t skipped_size = 0;
+      for (size_t i = next + 1; i < responses.size(); ++i) {
+        if (responses[i] == nullptr) {
+          continue;
+        }
+        auto& new_response = *responses[i];
+        assert(new_response.tensor_names().size() == 1);
+        auto& new_entry = state.tensor_table.Get(
+            new_response.tensor_ids()[0], new_response.tensor_names()[0]);
+        // Cached responses are fused on every rank, so the look ahead must
+        // count the same size everywhere, which the input of an allgather
+        // does not have.
+        int64_t new_tensor_size = FusionBufferBytes(new_response, new_entry);
+
+        if (response.response_type() == new_response.response_type() &&
+            response.devices() == new_response.devices() &&
+            entry.tensor->dtype() == new_entry.tensor->dtype() &&
+            entry.root_rank == new_entry.root_rank &&
+            entry.group_id == new_entry.group_id &&
+            entry.compression == new_entry.compression &&
+            tensor_size + new_tensor_size <= TensorFusionThresholdBytes()) {
+          // These tensors will fuse together well.
+          tensor_size += new_tensor_size;
+          response.add_tensor_name(new_response.tensor_names()[0],
+                                   new_response.tensor_ids()[0]);
+          responses[i] = nullptr;
+        } else {
+          // In general, don't try to fuse additional tensors since they are usually
+          // computed in order of requests and skipping tensors may mean
+          // that the batch will have to wait longer while skipped tensors
+          // could be reduced at that time. However, mixed-precision training may yield
+          // requests of various dtype in a mixed-up sequence causing breakups
+          // in fusion. To counter this some look ahead is allowed. Skipped
+          // responses stay in place and start the next fused responses.
+
+          skipped_size += new_tensor_size;
+          if (tensor_size + skipped_size > TensorFusionThresholdBytes()) {
+            break;
+          }
+        }
+      }
+
+    } else if (response.response_type() ==
+                   MPIResponse::ResponseType::ALLGATHER ||
+               ((response.response_type() ==
+                     MPIResponse::ResponseType::ALLTOALL ||
+                 response.response_type() ==
+                     MPIResponse::ResponseType::SPARSE_ALLREDUCE) &&
+                response.devices()[0] == CPU_DEVICE_ID)) {
+      // Attempt to add more responses to this fused response. Alltoalls and
+      // sparse allreduces are only fused on CPU, alltoalls need room for the
+      // data they send and receive, and sparse allreduces are only fused with
+      // those which also gather their rows, or also reduce the dense tensor.
+      auto& entry = state.tensor_table.Get(response.tensor_ids()[0],
+                                           response.tensor_names()[0]);
+
+      // This is size of first dimension.
+      int64_t total_byte_size_of_output = FusionBufferBytes(response, entry);
+
+      int64_t skipped_size = 0;
+      for (size_t i = next + 1; i < responses.size(); ++i) {
+        if (responses[i] == nullptr) {
+          continue;
+        }
+        auto& new_response = *responses[i];
+        assert(new_response.tensor_names().size() == 1);
+        auto& new_entry = state.tensor_table.Get(
+            new_response.tensor_ids()[0], new_response.tensor_names()[0]);
+
+        int64_t new_total_byte_size_of_output =
+            FusionBufferBytes(new_response, new_entry);
+
+        if (response.response_type() == new_response.response_type() &&
+            response.devices() == new_response.devices() &&
+            entry.tensor->dtype() == new_entry.tensor->dtype() &&
+            SparseAllreduceIsDense(response.tensor_sizes(), 0, entry) ==
+                SparseAllreduceIsDense(new_response.tensor_sizes(), 0,
+                                       new_entry) &&
+            total_byte_size_of_output + new_total_byte_size_of_output <=
+                TensorFusionThresholdBytes()) {
+
+          // These tensors will fuse together well.
+          total_byte_size_of_output += new_total_byte_size_of_output;
+          response.add_allgather_response(new_response);
+          responses[i] = nullptr;
+
+        } else {
+          // In general, don't try to fuse additional tensors since they are usually
+          // computed in order of requests and skipping tensors may mean
+          // that the batch will have to wait longer while skipped tensors
+          // could be reduced at that time. However, mixed-precision training may yield
+          // requests of various dtype in a mixed-up sequence causing breakups
+          // in fusion. To counter this some look ahead is allowed. Skipped
+          // responses stay in place and start the next fused responses.
+
+          skipped_size += new_total_byte_size_of_output;
+          if (total_byte_size_of_output + skipped_size >
+              TensorFusionThresholdBytes()) {
+            break;
+          }
+        }
+      }
+
+    }
+
+    response_list.emplace_response(std::move(response));
+    LOG(DEBUG) << "Created response of size " << tensor_size;
   }
+  responses.clear();
+}
 
-  if (!message_queue.empty()) {
-    LOG(DEBUG, state.rank) << "Sent " << message_queue.size() << " messages";
+// Same as above, for responses constructed by the coordinator.
+void FuseResponses(const std::vector<MPIResponse>& responses,
+                   HorovodGlobalState& state, MPIResponseList& response_list) {
+  std::vector<const MPIResponse*> pointers;
+  pointers.reserve(responses.size());
+  for (auto& response : responses) {
+    pointers.push_back(&response);
   }
+  FuseResponses(pointers, state, response_list);
+}
 
-  // Flag indicating that the background thread should shut down.
-  bool should_shut_down = state.shut_down;
+// Return the type of the requests a response other than ERROR answers. The
+// values of the two enums differ after ERROR.
+MPIRequest::RequestType RequestTypeOf(MPIResponse::ResponseType response_type) {
+  switch (response_type) {
+  case MPIResponse::ALLREDUCE:
+    return MPIRequest::ALLREDUCE;
+  case MPIResponse::ALLGATHER:
+    return MPIRequest::ALLGATHER;
+  case MPIResponse::BROADCAST:
+    return MPIRequest::BROADCAST;
+  case MPIResponse::REDUCESCATTER:
+    return MPIRequest::REDUCESCATTER;
+  case MPIResponse::ALLTOALL:
+    return MPIRequest::ALLTOALL;
+  case MPIResponse::SPARSE_ALLREDUCE:
+    return MPIRequest::SPARSE_ALLREDUCE;
+  default:
+    throw std::logic_error("No request type for response type " +
+                           MPIResponse::ResponseType_Name(response_type) + ".");
+  }
+}
 
-  // Collect all tensors that are ready to be reduced. Record them in the
-  // tensor count table (rank zero) or send them to rank zero to be
-  // recorded (everyone else).
-  std::vector<std::string> ready_to_reduce;
-  if (is_coordinator) {
-    while (!message_queue.empty()) {
-      // Pop the first available message message
-      MPIRequest message = message_queue.front();
-      message_queue.pop();
+// Store the responses negotiated through the coordinator in the response
+// cache. Fused responses are split back into single-tensor responses, and each
+// is stored along with the parameters of this rank's request for the tensor,
+// which are used to validate future requests. Must be called on every rank,
+// with the same response list, before the responses are performed.
+void CacheResponses(HorovodGlobalState& state,
+                    const MPIResponseList& response_list) {
+  for (auto& response : response_list.responses()) {
+    if (response.response_type() == MPIResponse::ERROR) {
+      continue;
+    }
+
+    auto& names = response.tensor_names();
+    auto& tensor_ids = response.tensor_ids();
+    for (size_t i = 0; i < names.size(); ++i) {
+      auto& entry = state.tensor_table.Get(tensor_ids[i], names[i]);
+
+      MPIResponse cached_response;
+      cached_response.set_response_type(response.response_type());
+      cached_response.add_tensor_name(names[i], tensor_ids[i]);
+      cached_response.set_devices(response.devices());
+      if (response.response_type() == MPIResponse::ALLGATHER ||
+          response.response_type() == MPIResponse::SPARSE_ALLREDUCE) {
+        for (int rc = 0; rc < state.size; ++rc) {
+          cached_response.add_tensor_size(
+              response.tensor_sizes()[i * state.size + rc]);
+        }
+      } else if (response.response_type() == MPIResponse::ALLTOALL) {
+        size_t matrix_size = (size_t)state.size * state.size;
+        for (size_t j = 0; j < matrix_size; ++j) {
+          cached_response.add_tensor_size(
+              response.tensor_sizes()[i * matrix_size + j]);
+        }
+      }
+
+      MPIRequest message;
+      message.set_request_rank(state.rank);
+      message.set_request_type(RequestTypeOf(response.response_type()));
+      message.set_tensor_name(names[i]);
+      message.set_tensor_id(tensor_ids[i]);
+      message.set_tensor_type(entry.tensor->dtype());
+      message.set_root_rank(entry.root_rank);
+      message.set_device(entry.device);
+      auto shape = entry.tensor->shape();
+      for (int d = 0; d < shape.dims(); ++d) {
+        message.add_tensor_shape(shape.dim_size(d));
+      }
+      message.set_tensor_splits(entry.splits);
+      message.set_dense_rows(entry.dense_rows);
+      message.set_compression(entry.compression);
+
+      state.response_cache.put(cached_response, message);
+    }
+  }
+}
 
-      bool reduce =
-          IncrementTensorCount(state.message_table, message, state.size);
-      if (reduce) {
-        ready_to_reduce.push_back(message.tensor_name());
+// Register the tensors of the response list which do not have an ID yet, and
+// fill in the names of tensors which were sent by ID only. Must be called on
+// every rank, with the same response list, so that all ranks assign the same
+// IDs.
+void AssignTensorIds(HorovodGlobalState& state, MPIResponseList& response_list) {
+  for (auto& response : response_list.mutable_responses()) {
+    for (int i = 0; i < (int)response.tensor_ids().size(); ++i) {
+      auto tensor_id = response.tensor_ids()[i];
+      if (tensor_id < 0) {
+        auto& name = response.tensor_names()[i];
+        tensor_id = state.tensor_registry.Register(name);
+        state.tensor_table.AssignId(name, tensor_id);
+        response.set_tensor_id(i, tensor_id);
+      } else if (response.tensor_names()[i].empty()) {
+        response.set_tensor_name(i, state.tensor_registry.Name(tensor_id));
       }
     }
+  }
+}
+
+// Log the tensors of a response list sent by the coordinator.
+void TraceReadyResponses(const MPIResponseList& response_list) {
+  if (!response_list.responses().empty()) {
+    std::string tensors_ready;
+    for (auto r : response_list.responses()) {
+      tensors_ready += r.tensor_names_string() + "; " ;
+    }
+    LOG(TRACE) << "Sending ready responses as " << tensors_ready;
+  }
+}
+
+// Send the response list from the coordinator to all other ranks. On ranks
+// other than the coordinator, response_list is overwritten with the received
+// list.
+void BroadcastResponseList(HorovodGlobalState& state,
+                           MPIResponseList& response_list) {
+  if (state.rank == RANK_ZERO) {
+    TraceReadyResponses(response_list);
 
-    // Rank zero has put all its own tensors in the tensor count table.
-    // Now, it should count all the tensors that are coming from other
-    // ranks at this tick.
+    // Notify all nodes which tensors we'd like to reduce at this step.
+    std::string encoded_response;
+    MPIResponseList::SerializeToString(response_list, encoded_response);
+    int encoded_response_length = (int)encoded_response.length() + 1;
+    MPI_Bcast(&encoded_response_length, 1, MPI_INT, RANK_ZERO, state.mpi_comm);
+    MPI_Bcast((void*)encoded_response.c_str(), encoded_response_length,
+              MPI_BYTE, RANK_ZERO, state.mpi_comm);
+  } else {
+    int msg_length;
+    MPI_Bcast(&msg_length, 1, MPI_INT, RANK_ZERO, state.mpi_comm);
+    auto buffer = new uint8_t[msg_length];
+    MPI_Bcast(buffer, msg_length, MPI_BYTE, RANK_ZERO, state.mpi_comm);
+    MPIResponseList::ParseFromBytes(response_list, buffer);
+    delete[] buffer;
+  }
+}
 
-    // 1. Get message lengths from every rank.
-    auto recvcounts = new int[state.size];
-    recvcounts[0] = 0;
-    MPI_Gather(MPI_IN_PLACE, 1, MPI_INT, recvcounts, 1, MPI_INT, RANK_ZERO,
-               state.mpi_comm);
+// Two-level negotiation. Every rank sends its requests to local rank zero,
+// which counts them per node. Once all ranks of the node requested a tensor,
+// local rank zero checks the requests against each other and sends a single
+// summary of the tensor to the coordinator over the cross communicator. The
+// coordinator thus handles one message and one request per node instead of
+// per rank. The final responses are broadcast to all ranks as usual.
+//
+// A node summary consists of a request of one of the ranks of the node (with
+// the cross rank as request rank) and the node-level MPIResponse, which holds
+// the devices and allgather sizes of the ranks of the node, or an error.
+void NegotiateHierarchically(HorovodGlobalState& state,
+                             std::vector<MPIRequest>& message_queue,
+                             bool& should_shut_down,
+                             MPIResponseList& response_list) {
+  // 1. Collect requests of this node on local rank zero.
+  MPIRequestList message_list;
+  message_list.set_shutdown(should_shut_down);
+  for (auto& message : message_queue) {
+    message_list.add_request(message);
+    state.request_pool.push_back(std::move(message));
+  }
+  message_queue.clear();
 
-    // 2. Compute displacements.
-    auto displcmnts = new int[state.size];
+  if (state.local_rank != 0) {
+    std::string encoded_message;
+    MPIRequestList::SerializeToString(message_list, encoded_message);
+    int encoded_message_length = (int)encoded_message.length() + 1;
+    MPI_Gather(&encoded_message_length, 1, MPI_INT, nullptr, 1, MPI_INT, 0,
+               state.local_comm);
+    MPI_Gatherv((void*)encoded_message.c_str(), encoded_message_length,
+                MPI_BYTE, nullptr, nullptr, nullptr, MPI_BYTE, 0,
+                state.local_comm);
+  } else {
+    std::vector<int> recvcounts(state.local_size);
+    MPI_Gather(MPI_IN_PLACE, 1, MPI_INT, recvcounts.data(), 1, MPI_INT, 0,
+               state.local_comm);
+    std::vector<int> displcmnts(state.local_size);
     size_t total_size = 0;
-    for (int i = 0; i < state.size; ++i) {
+    for (int i = 0; i < state.local_size; ++i) {
+      displcmnts[i] = (int)total_size;
+      total_size += recvcounts[i];
+    }
+    std::vector<uint8_t> buffer(total_size);
+    MPI_Gatherv(nullptr, 0, MPI_BYTE, buffer.data(), recvcounts.data(),
+                displcmnts.data(), MPI_BYTE, 0, state.local_comm);
+
+    // 2. Count requests per node and summarize tensors ready on this node.
+    std::vector<MessageTableKey> node_ready;
+    bool node_shut_down = should_shut_down;
+    for (int i = 0; i < state.local_size; ++i) {
+      MPIRequestList received_message_list;
       if (i == 0) {
-        displcmnts[i] = 0;
+        received_message_list = std::move(message_list);
       } else {
-        displcmnts[i] = recvcounts[i - 1] + displcmnts[i - 1];
+        MPIRequestList::ParseFromBytes(received_message_list,
+                                       buffer.data() + displcmnts[i]);
+        node_shut_down |= received_message_list.shutdown();
+      }
+      for (auto& received_message : received_message_list.requests()) {
+        if (IncrementNodeTensorCount(state.node_message_table,
+                                     received_message, i, state.local_size)) {
+          node_ready.push_back(MessageTableKeyOf(received_message));
+        }
       }
-      total_size += recvcounts[i];
     }
 
-    // 3. Collect messages from every rank.
-    auto buffer = new uint8_t[total_size];
-    MPI_Gatherv(nullptr, 0, MPI_BYTE, buffer, recvcounts, displcmnts, MPI_BYTE,
-                RANK_ZERO, state.mpi_comm);
-
-    // 4. Process messages.
-    for (int i = 1; i < state.size; ++i) {
-      auto rank_buffer_ptr = buffer + displcmnts[i];
-      MPIRequestList received_message_list;
-      MPIRequestList::ParseFromBytes(received_message_list, rank_buffer_ptr);
-      for (auto& received_message : received_message_list.requests()) {
-        auto& received_name = received_message.tensor_name();
+    MPIRequestList summary_list;
+    MPIResponseList node_response_list;
+    summary_list.set_shutdown(node_shut_down);
+    for (auto& key : node_ready) {
+      MPIRequest summary = state.node_message_table->Get(key).first_request;
+      summary.set_request_rank(state.cross_rank);
+      summary_list.add_request(summary);
+      node_response_list.add_response(
+          ConstructMPIResponse(state.node_message_table, key));
+    }
 
-        bool reduce = IncrementTensorCount(state.message_table,
-                                           received_message, state.size);
-        if (reduce) {
-          ready_to_reduce.push_back(received_name);
+    // 3. Collect node summaries on the coordinator.
+    if (state.rank != RANK_ZERO) {
+      std::string encoded_summaries;
+      std::string encoded_responses;
+      MPIRequestList::SerializeToString(summary_list, encoded_summaries);
+      MPIResponseList::SerializeToString(node_response_list, encoded_responses);
+      int lengths[2] = {(int)encoded_summaries.length() + 1,
+                        (int)encoded_responses.length() + 1};
+      std::vector<uint8_t> encoded_node(lengths[0] + lengths[1]);
+      memcpy(encoded_node.data(), encoded_summaries.c_str(), lengths[0]);
+      memcpy(encoded_node.data() + lengths[0], encoded_responses.c_str(),
+             lengths[1]);
+      MPI_Gather(lengths, 2, MPI_INT, nullptr, 2, MPI_INT, RANK_ZERO,
+                 state.cross_comm);
+      MPI_Gatherv(encoded_node.data(), (int)encoded_node.size(), MPI_BYTE,
+                  nullptr, nullptr, nullptr, MPI_BYTE, RANK_ZERO,
+                  state.cross_comm);
+    } else {
+      std::vector<int> lengths(2 * state.cross_size);
+      MPI_Gather(MPI_IN_PLACE, 2, MPI_INT, lengths.data(), 2, MPI_INT,
+                 RANK_ZERO, state.cross_comm);
+      std::vector<int> node_lengths(state.cross_size);
+      std::vector<int> node_displcmnts(state.cross_size);
+      size_t total_node_size = 0;
+      for (int i = 0; i < state.cross_size; ++i) {
+        node_lengths[i] = i == 0 ? 0 : lengths[2 * i] + lengths[2 * i + 1];
+        node_displcmnts[i] = (int)total_node_size;
+        total_node_size += node_lengths[i];
+      }
+      std::vector<uint8_t> node_buffer(total_node_size);
+      MPI_Gatherv(nullptr, 0, MPI_BYTE, node_buffer.data(),
+                  node_lengths.data(), node_displcmnts.data(), MPI_BYTE,
+                  RANK_ZERO, state.cross_comm);
+
+      // 4. Count node summaries and construct responses for tensors ready on
+      // all nodes.
+      std::vector<MessageTableKey> ready_to_reduce;
+      for (int i = 0; i < state.cross_size; ++i) {
+        MPIRequestList received_summary_list;
+        MPIResponseList received_response_list;
+        if (i == 0) {
+          received_summary_list = std::move(summary_list);
+          received_response_list = std::move(node_response_list);
+        } else {
+          auto node_ptr = node_buffer.data() + node_displcmnts[i];
+          MPIRequestList::ParseFromBytes(received_summary_list, node_ptr);
+          MPIResponseList::ParseFromBytes(received_response_list,
+                                          node_ptr + lengths[2 * i]);
+        }
+        auto& summaries = received_summary_list.requests();
+        auto& node_responses = received_response_list.responses();
+        for (unsigned int j = 0; j < summaries.size(); ++j) {
+          if (IncrementNodeCount(state, summaries[j], node_responses[j])) {
+            ready_to_reduce.push_back(MessageTableKeyOf(summaries[j]));
+          }
+        }
+        if (received_summary_list.shutdown()) {
+          should_shut_down = true;
         }
       }
-      if (received_message_list.shutdown()) {
-        // Received SHUTDOWN request from one of the workers.
-        should_shut_down = true;
+
+      std::vector<MPIResponse> responses;
+      for (auto& key : ready_to_reduce) {
+        responses.push_back(ConstructHierarchicalMPIResponse(state, key));
       }
+      response_list.set_shutdown(should_shut_down);
+      FuseResponses(responses, state, response_list);
     }
+  }
 
-    // 5. Free buffers.
-    delete[] recvcounts;
-    delete[] displcmnts;
-    delete[] buffer;
-
-    // At this point, rank zero should have a fully updated tensor count
-    // table and should know all the tensors that need to be reduced or
-    // gathered, and everyone else should have sent all their information
-    // to rank zero. We can now do reductions and gathers; rank zero will
-    // choose which ones and in what order, and will notify the other ranks
-    // before doing each reduction.
-    std::deque<MPIResponse> responses;
-    for (auto& tensor_name : ready_to_reduce) {
-      MPIResponse response =
-          ConstructMPIResponse(state.message_table, tensor_name);
-      responses.push_back(std::move(response));
-    }
-
-    MPIResponseList response_list;
-    response_list.set_shutdown(should_shut_down);
-    {
-      // Protect access to tensor table.
-      std::lock_guard<std::mutex> guard(horovod_global.mutex);
-      while (!responses.empty()) {
-
-        auto response = responses.front();
-        assert(response.tensor_names().size() == 1);
-        responses.pop_front();
-        int64_t tensor_size = 0;
-        if (response.response_type() == MPIResponse::ResponseType::ALLREDUCE) {
-          // Attempt to add more responses to this fused response.
-          auto& entry = state.tensor_table[response.tensor_names()[0]];
-          tensor_size = entry.tensor->size();
-
-          std::deque<MPIResponse> skipped_responses;
-          int64_t skipped_size = 0;
-          while (!responses.empty()) {
-            auto new_response = responses.front();
-            assert(new_response.tensor_names().size() == 1);
-            auto& new_entry =
-                state.tensor_table[new_response.tensor_names()[0]];
-            int64_t new_tensor_size = new_entry.tensor->size();
-
-            if (response.response_type() == new_response.response_type() &&
-                response.devices() == new_response.devices() &&
-                entry.tensor->dtype() == new_entry.tensor->dtype() &&
-                tensor_size + new_tensor_size <= TensorFusionThresholdBytes()) {
-              // These tensors will fuse together well.
-              tensor_size += new_tensor_size;
-              response.add_tensor_name(new_response.tensor_names()[0]);
-              responses.pop_front();
-            } else {
-              // In general, don't try to fuse additional tensors since they are usually
-              // computed in order of requests and skipping tensors may mean
-              // that the batch will have to wait longer while skipped tensors
-              // could be reduced at that time. However, mixed-precision training may yield
-              // requests of various dtype in a mixed-up sequence causing breakups
-              // in fusion. To counter this some look ahead is allowed.
-
-              skipped_size += new_tensor_size;
-              if (tensor_size + skipped_size <= TensorFusionThresholdBytes()) {
-                // Skip response and look ahead for more to fuse.
-                skipped_responses.push_back(std::move(responses.front()));
-                responses.pop_front();
-              } else {
-                break;
-              }
-            }
-          }
+  // 5. Notify all ranks which tensors we'd like to reduce at this step.
+  BroadcastResponseList(state, response_list);
+  if (response_list.shutdown()) {
+    should_shut_down = true;
+  }
+}
 
-          // Replace any skipped responses.
-          while (!skipped_responses.empty()) {
-            responses.push_front(std::move(skipped_responses.back()));
-            skipped_responses.pop_back();
-          }
+// Reserve count consecutive cells of the submission queue, waiting for the
+// background thread if the queue is full. Returns false without reserving any
+// cell if Horovod has been shut down.
+bool ReserveSubmissions(HorovodGlobalState& state, uint32_t count,
+                        uint64_t& position) {
+  // The background thread only fails the remaining submissions on shutdown
+  // once no thread is submitting anymore.
+  ++state.submitters;
+  if (state.shut_down) {
+    --state.submitters;
+    return false;
+  }
+  position = state.submission_queue->Reserve(count);
+  return true;
+}
 
-        } else if (response.response_type() ==
-                   MPIResponse::ResponseType::ALLGATHER) {
-          // Attempt to add more responses to this fused response.
-          auto& entry = state.tensor_table[response.tensor_names()[0]];
+// Fill in the request of a reserved submission and reset its entry, whose
+// tensors and callback are filled in by the caller. The request and the entry
+// are copied and moved out of the cell by the background thread, so that the
+// buffers of the request stay in the cell for the next submissions.
+void FillSubmission(HorovodGlobalState& state, Submission& submission,
+                    MPIRequest::RequestType request_type,
+                    const std::string& name, const Tensor& tensor,
+                    int device) {
+  auto& message = submission.message;
+  message.set_request_rank(state.rank);
+  message.set_request_type(request_type);
+  message.set_tensor_name(name);
+  message.set_tensor_type(tensor.dtype());
+  message.set_root_rank(0);
+  message.set_device(device);
+  message.clear_tensor_shape();
+  auto shape = tensor.shape();
+  for (int i = 0; i < shape.dims(); ++i) {
+    message.add_tensor_shape(shape.dim_size(i));
+  }
+  message.clear_tensor_splits();
+  message.set_dense_rows(0);
+  message.set_compression(NO_COMPRESSION);
+  auto& entry = submission.entry;
+  entry.output.reset();
+  entry.root_rank = 0;
+  entry.device = device;
+  entry.prescale_factor = 1.0;
+  entry.postscale_factor = 1.0;
+  entry.splits.clear();
+  entry.indices.reset();
+  entry.indices_context.reset();
+  entry.indices_output.reset();
+  entry.dense_rows = 0;
+  entry.compression = NO_COMPRESSION;
+  submission.group_size = 1;
+  if (state.event_driven_cycle) {
+    submission.time = std::chrono::steady_clock::now();
+  }
+}
 
-          // This is size of first dimension.
-          int64_t total_byte_size_of_output =
-              TotalByteSizeOfAllgatherOutput(response.tensor_sizes(), entry);
+// Publish reserved submissions, and wake up the background thread if it waits
+// for tensors.
+void PublishSubmissions(HorovodGlobalState& state, uint64_t position,
+                        uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i) {
+    state.submission_queue->Publish(position + i);
+  }
+  --state.submitters;
+  // Pairs with the fence in WaitForSubmissions: either the background thread
+  // sees the submissions before it sleeps, or this thread sees it waiting.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (state.cycle_waiting) {
+    std::lock_guard<std::mutex> guard(state.mutex);
+    state.cycle_cond.notify_all();
+  }
+}
 
-          std::deque<MPIResponse> skipped_responses;
-          int64_t skipped_size = 0;
-          while (!responses.empty()) {
+// Record the arrival of a tensor for the event-driven background loop.
+// Tensors submitted concurrently may be drained out of order.
+void RecordEnqueue(HorovodGlobalState& state,
+                   std::chrono::steady_clock::time_point time) {
+  if (state.enqueue_count == state.last_cycle_enqueue_count) {
+    state.first_new_enqueue = time;
+  }
+  if (state.enqueue_count > 0) {
+    double interval_us = std::max(
+        0., (double)std::chrono::duration_cast<std::chrono::microseconds>(
+                time - state.last_enqueue)
+                .count());
+    state.enqueue_interval_us =
+        ENQUEUE_INTERVAL_ALPHA * interval_us +
+        (1 - ENQUEUE_INTERVAL_ALPHA) * state.enqueue_interval_us;
+  }
+  state.last_enqueue = std::max(state.last_enqueue, time);
+  ++state.enqueue_count;
+}
 
-            auto new_response = responses.front();
-            assert(new_response.tensor_names().size() == 1);
-            auto& new_entry =
-                state.tensor_table[new_response.tensor_names()[0]];
+// Queue the requests of parked tensors whose input data has become ready. The
+// events of the parked requests which notified since the last call are taken
+// from the notified IDs, and polled events are checked every time.
+void ReleaseParkedRequests(HorovodGlobalState& state) {
+  if (state.parked_requests.empty()) {
+    return;
+  }
+  auto& notified = state.cycle_notified_ids;
+  {
+    std::lock_guard<std::mutex> guard(state.mutex);
+    std::swap(notified, state.notified_parked_ids);
+  }
+  std::sort(notified.begin(), notified.end());
 
-            int64_t new_total_byte_size_of_output =
-                TotalByteSizeOfAllgatherOutput(new_response.tensor_sizes(),
-                                               new_entry);
+  auto now = std::chrono::steady_clock::now();
+  auto it = state.parked_requests.begin();
+  while (it != state.parked_requests.end()) {
+    if ((!it->polled &&
+         !std::binary_search(notified.begin(), notified.end(), it->id)) ||
+        !std::all_of(it->ready_events.begin(), it->ready_events.end(),
+                     [](const std::shared_ptr<ReadyEvent>& event) {
+                       return event->Ready();
+                     })) {
+      ++it;
+      continue;
+    }
+    for (auto& message : it->messages) {
+      if (state.event_driven_cycle) {
+        RecordEnqueue(state, now);
+      }
+      state.message_queue.push_back(std::move(message));
+    }
+    it = state.parked_requests.erase(it);
+  }
+  notified.clear();
+}
 
-            if (response.response_type() == new_response.response_type() &&
-                response.devices() == new_response.devices() &&
-                entry.tensor->dtype() == new_entry.tensor->dtype() &&
-                total_byte_size_of_output + new_total_byte_size_of_output <=
-                    TensorFusionThresholdBytes()) {
+// Move the tensors published in the submission queue into the tensor table
+// and the message queue. Tensors whose name is already in the tensor table
+// fail with DUPLICATE_NAME_ERROR, and so does the rest of their group. A group
+// is only taken once all its tensors are published, so that it is negotiated
+// in a single cycle. Groups with input data which is not ready yet are parked
+// instead of queued.
+void DrainSubmissions(HorovodGlobalState& state) {
+  auto& queue = *state.submission_queue;
+  while (queue.Ready()) {
+    uint32_t group_size = queue.Peek().group_size;
+    // The cells of a group are published in order.
+    if (group_size > 1 && !queue.Ready(group_size - 1)) {
+      break;
+    }
 
-              // These tensors will fuse together well.
-              total_byte_size_of_output += new_total_byte_size_of_output;
-              response.add_allgather_response(new_response);
-              responses.pop_front();
+    bool duplicate = false;
+    bool ready = true;
+    for (uint32_t i = 0; i < group_size; ++i) {
+      auto& submission = queue.Peek(i);
+      auto& name = submission.message.tensor_name();
+      int32_t tensor_id = state.tensor_registry.Lookup(name);
+      if (state.tensor_table.Contains(tensor_id, name)) {
+        duplicate = true;
+      }
+      submission.message.set_tensor_id(tensor_id);
+      auto& ready_event = submission.entry.ready_event;
+      if (ready_event != nullptr && !ready_event->Ready()) {
+        ready = false;
+      }
+    }
 
-            } else {
-              // In general, don't try to fuse additional tensors since they are usually
-              // computed in order of requests and skipping tensors may mean
-              // that the batch will have to wait longer while skipped tensors
-              // could be reduced at that time. However, mixed-precision training may yield
-              // requests of various dtype in a mixed-up sequence causing breakups
-              // in fusion. To counter this some look ahead is allowed.
-
-              skipped_size += new_total_byte_size_of_output;
-              if (total_byte_size_of_output + skipped_size <=
-                      TensorFusionThresholdBytes()) {
-                // Skip response and look ahead for more to fuse.
-                skipped_responses.push_back(std::move(responses.front()));
-                responses.pop_front();
-              } else {
-                break;
-              }
-            }
-          }
+    int32_t group_id = group_size > 1 ? state.next_group_id++ : -1;
+    ParkedRequests* parked = nullptr;
+    if (!ready && !duplicate) {
+      state.parked_requests.emplace_back();
+      parked = &state.parked_requests.back();
+      parked->id = state.next_parked_id++;
+    }
+    for (uint32_t i = 0; i < group_size; ++i) {
+      auto& submission = queue.Peek();
+      if (duplicate) {
+        TensorTableEntry entry;
+        std::swap(entry, submission.entry);
+        queue.Pop();
+        entry.callback(DUPLICATE_NAME_ERROR);
+        continue;
+      }
 
-          // Replace any skipped responses.
-          while (!skipped_responses.empty()) {
-            responses.push_front(std::move(skipped_responses.back()));
-            skipped_responses.pop_back();
-          }
+      if (state.event_driven_cycle && parked == nullptr) {
+        RecordEnqueue(state, submission.time);
+      }
+      // The request is copied into one the background thread is done with,
+      // so that neither needs to allocate.
+      auto& messages =
+          parked == nullptr ? state.message_queue : parked->messages;
+      if (state.request_pool.empty()) {
+        messages.emplace_back();
+      } else {
+        messages.push_back(std::move(state.request_pool.back()));
+        state.request_pool.pop_back();
+      }
+      auto& message = messages.back();
+      message = submission.message;
+      submission.entry.group_id = group_id;
+      if (parked != nullptr && submission.entry.ready_event != nullptr) {
+        parked->ready_events.push_back(submission.entry.ready_event);
+      }
+      state.tensor_table.Insert(message.tensor_id(), message.tensor_name(),
+                                std::move(submission.entry));
+      queue.Pop();
+    }
 
+    if (parked != nullptr) {
+      // The events may notify right away, the notified ID is only taken by
+      // ReleaseParkedRequests.
+      uint64_t id = parked->id;
+      bool polled = false;
+      for (auto& ready_event : parked->ready_events) {
+        if (!ready_event->NotifyWhenReady([&state, id]() {
+              std::lock_guard<std::mutex> guard(state.mutex);
+              state.notified_parked_ids.push_back(id);
+              state.cycle_cond.notify_all();
+            })) {
+          polled = true;
         }
+      }
+      parked->polled = polled;
+    }
+  }
+  ReleaseParkedRequests(state);
+}
+
+// Fail the remaining submissions once Horovod has been shut down.
+void FailSubmissions(HorovodGlobalState& state) {
+  auto& queue = *state.submission_queue;
+  for (;;) {
+    bool quiescent = state.submitters == 0;
+    while (queue.Ready()) {
+      TensorTableEntry entry;
+      std::swap(entry, queue.Peek().entry);
+      queue.Pop();
+      entry.callback(SHUT_DOWN_ERROR);
+    }
+    if (quiescent) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+}
+
+// Wait on the cycle condition until a tensor is submitted, Horovod is shut
+// down or the deadline passes. Returns false if the deadline passed.
+bool WaitForSubmissions(HorovodGlobalState& state,
+                        std::unique_lock<std::mutex>& lock,
+                        std::chrono::steady_clock::time_point deadline) {
+  state.cycle_waiting = true;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  bool woken = state.cycle_cond.wait_until(lock, deadline, [&state]() {
+    return state.submission_queue->Ready() ||
+           !state.notified_parked_ids.empty() || state.shut_down;
+  });
+  state.cycle_waiting = false;
+  return woken;
+}
+
+// Wait until the next cycle should start.
+//
+// By default, cycles start every CycleTimeMs(). In the event-driven mode, the
+// background thread is woken up as soon as a tensor is enqueued, and then
+// keeps waiting only while more tensors are expected shortly, which is
+// estimated from the recent inter-arrival times. The wait is bounded by
+// CycleTimeMs() after the first new tensor arrived. If no tensors are in
+// flight at all, the thread backs off exponentially up to IDLE_BACKOFF_MAX.
+// This is safe since no collective can complete without this rank enqueueing
+// a tensor first, which wakes the thread up.
+void WaitForNextCycle(HorovodGlobalState& state) {
+  auto cycle_time = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::microseconds(long(state.param_manager.CycleTimeMs() * 1000.)));
+
+  if (!state.event_driven_cycle) {
+    // This delay determines thread frequency and MPI message latency
+    auto start_time = std::chrono::steady_clock::now();
+    auto sleep_duration = state.last_cycle_start + cycle_time - start_time;
+    if (sleep_duration > std::chrono::steady_clock::duration::zero()) {
+      std::this_thread::sleep_for(sleep_duration);
+    }
+    state.last_cycle_start = std::chrono::steady_clock::now();
+    return;
+  }
 
-        response_list.add_response(response);
-        LOG(DEBUG) << "Created response of size " << tensor_size;
+  DrainSubmissions(state);
+  auto new_requests = [&state]() {
+    return state.enqueue_count != state.last_cycle_enqueue_count ||
+           state.shut_down;
+  };
+
+  if (!new_requests()) {
+    {
+      std::unique_lock<std::mutex> lock(state.mutex);
+      if (state.tensor_table.empty()) {
+        bool woken = WaitForSubmissions(
+            state, lock, std::chrono::steady_clock::now() + state.idle_backoff);
+        state.idle_backoff =
+            woken ? cycle_time
+                  : std::min(std::max(state.idle_backoff * 2, cycle_time),
+                             std::chrono::steady_clock::duration(IDLE_BACKOFF_MAX));
+      } else {
+        // Tensors are waiting for other ranks, keep the regular cadence.
+        WaitForSubmissions(state, lock, state.last_cycle_start + cycle_time);
       }
     }
+    DrainSubmissions(state);
+  }
 
-    if (!response_list.responses().empty()) {
-      std::string tensors_ready;
-      for (auto r : response_list.responses()) {
-        tensors_ready += r.tensor_names_string() + "; " ;
+  if (new_requests()) {
+    // Coalesce tensors arriving in a burst. Tensors arriving further apart
+    // than the cycle time are negotiated right away.
+    auto deadline = state.first_new_enqueue + cycle_time;
+    while (!state.shut_down) {
+      auto window = std::chrono::steady_clock::duration::zero();
+      if (2 * state.enqueue_interval_us <
+          state.param_manager.CycleTimeMs() * 1000.) {
+        window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::microseconds(long(2 * state.enqueue_interval_us)));
       }
-      LOG(TRACE) << "Sending ready responses as " << tensors_ready;
+      auto until = std::min(state.last_enqueue + window, deadline);
+      if (std::chrono::steady_clock::now() >= until) {
+        break;
+      }
+      {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        WaitForSubmissions(state, lock, until);
+      }
+      DrainSubmissions(state);
     }
+  }
 
-    // Notify all nodes which tensors we'd like to reduce at this step.
-    std::string encoded_response;
-    MPIResponseList::SerializeToString(response_list, encoded_response);
-    int encoded_response_length = (int)encoded_response.length() + 1;
-    MPI_Bcast(&encoded_response_length, 1, MPI_INT, RANK_ZERO, state.mpi_comm);
-    MPI_Bcast((void*)encoded_response.c_str(), encoded_response_length,
-              MPI_BYTE, RANK_ZERO, state.mpi_comm);
+  state.last_cycle_enqueue_count = state.enqueue_count;
+  state.last_cycle_start = std::chrono::steady_clock::now();
+}
 
-    std::vector<std::string> tensor_names;
-    int64_t total_tensor_size = 0;
-    if (state.param_manager.IsAutoTuning()) {
-      for (auto& response : response_list.responses()) {
-        if (response.response_type() == MPIResponse::ResponseType::ALLREDUCE) {
-          for (auto& tensor_name : response.tensor_names()) {
-            tensor_names.push_back(tensor_name);
-            auto& entry = state.tensor_table[tensor_name];
-            total_tensor_size += entry.tensor->size();
-          }
+// Complete the MPI requests of the current stage of the negotiation. Unless
+// wait is set, returns false instead of blocking if they are still in flight.
+bool CompleteNegotiationStage(Negotiation& negotiation, bool wait) {
+  auto& requests = negotiation.mpi_requests;
+  if (wait) {
+    MPI_Waitall((int)requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+  } else {
+    int flag;
+    MPI_Testall((int)requests.size(), requests.data(), &flag,
+                MPI_STATUSES_IGNORE);
+    if (!flag) {
+      return false;
+    }
+  }
+  requests.clear();
+  return true;
+}
+
+// Returns the time point when the cached tensor started waiting for the other
+// ranks, which is now if it was not waiting yet.
+std::chrono::steady_clock::time_point
+CacheHitPendingSince(HorovodGlobalState& state, int32_t tensor_id,
+                     std::chrono::steady_clock::time_point now) {
+  auto& pending_since = state.cache_hits_pending_since;
+  if (tensor_id >= (int32_t)pending_since.size()) {
+    pending_since.resize(tensor_id + 1);
+  }
+  if (pending_since[tensor_id] == std::chrono::steady_clock::time_point()) {
+    pending_since[tensor_id] = now;
+  }
+  return pending_since[tensor_id];
+}
+
+void ClearCacheHitPending(HorovodGlobalState& state, int32_t tensor_id) {
+  if (tensor_id >= 0 &&
+      tensor_id < (int32_t)state.cache_hits_pending_since.size()) {
+    state.cache_hits_pending_since[tensor_id] =
+        std::chrono::steady_clock::time_point();
+  }
+}
+
+// Start negotiating the requests left in the queue through the coordinator.
+void StartCoordination(HorovodGlobalState& state, Negotiation& negotiation) {
+  negotiation.coordinated = true;
+  if (state.hierarchical_negotiation) {
+    negotiation.stage = Negotiation::Stage::HIERARCHICAL;
+    return;
+  }
+
+  auto& message_queue = negotiation.message_queue;
+  MPI_Request request;
+  if (state.rank == RANK_ZERO) {
+    // Record own tensors in the tensor count table.
+    for (auto& message : message_queue) {
+      if (IncrementTensorCount(state.message_table, message, state.size)) {
+        negotiation.ready_to_reduce.push_back(MessageTableKeyOf(message));
+      }
+      state.request_pool.push_back(std::move(message));
+    }
+    message_queue.clear();
+
+    // Get message lengths from every rank.
+    negotiation.recvcounts.assign(state.size, 0);
+    MPI_Igather(MPI_IN_PLACE, 1, MPI_INT, negotiation.recvcounts.data(), 1,
+                MPI_INT, RANK_ZERO, state.negotiation_comm, &request);
+    negotiation.mpi_requests.push_back(request);
+  } else {
+    MPIRequestList message_list;
+    message_list.set_shutdown(negotiation.should_shut_down);
+    for (auto& message : message_queue) {
+      message_list.add_request(message);
+      state.request_pool.push_back(std::move(message));
+    }
+    message_queue.clear();
+    MPIRequestList::SerializeToString(message_list,
+                                      negotiation.encoded_message);
+    negotiation.message_length = (int)negotiation.encoded_message.length() + 1;
+    MPI_Igather(&negotiation.message_length, 1, MPI_INT, nullptr, 1, MPI_INT,
+                RANK_ZERO, state.negotiation_comm, &request);
+    negotiation.mpi_requests.push_back(request);
+    MPI_Igatherv((void*)negotiation.encoded_message.c_str(),
+                 negotiation.message_length, MPI_BYTE, nullptr, nullptr,
+                 nullptr, MPI_BYTE, RANK_ZERO, state.negotiation_comm,
+                 &request);
+    negotiation.mpi_requests.push_back(request);
+    MPI_Ibcast(&negotiation.response_length, 1, MPI_INT, RANK_ZERO,
+               state.negotiation_comm, &request);
+    negotiation.mpi_requests.push_back(request);
+  }
+  negotiation.stage = Negotiation::Stage::GATHER;
+}
+
+// Process the exchanged response cache bits. Tensors which hit the cache on
+// every rank are served from the cache, the rest of the requests is
+// negotiated through the coordinator if any rank has uncached requests.
+void FinishCacheSync(HorovodGlobalState& state, Negotiation& negotiation) {
+  auto& cache_coordinator = negotiation.cache_coordinator;
+  auto& hit_messages = negotiation.hit_messages;
+  cache_coordinator.finish_sync();
+
+  auto find_hit = [&hit_messages](uint32_t bit) {
+    return std::lower_bound(hit_messages.begin(), hit_messages.end(), bit,
+                            [](const Negotiation::HitMessage& hit,
+                               uint32_t bit) { return hit.bit < bit; });
+  };
+
+  // Erase responses invalidated by any rank. Requests for them which hit the
+  // cache on this rank have to be negotiated through the coordinator.
+  for (auto bit : cache_coordinator.invalid_bits()) {
+    state.response_cache.erase_response(bit);
+    auto it = find_hit(bit);
+    if (it != hit_messages.end() && it->bit == bit) {
+      ClearCacheHitPending(state, it->message.tensor_id());
+      negotiation.message_queue.push_back(std::move(it->message));
+      it->pending = false;
+    }
+  }
+
+  for (auto bit : cache_coordinator.cache_hits()) {
+    auto it = find_hit(bit);
+    assert(it != hit_messages.end() && it->bit == bit && it->pending);
+    ClearCacheHitPending(state, it->message.tensor_id());
+    state.request_pool.push_back(std::move(it->message));
+    it->pending = false;
+    negotiation.cached_responses.push_back(
+        &state.response_cache.get_response(bit));
+  }
+
+  // Remaining cache hits are not yet ready on all ranks, retry them in the
+  // next cycle.
+  for (auto& hit : hit_messages) {
+    if (hit.pending) {
+      state.message_queue.push_back(std::move(hit.message));
+    }
+  }
+  hit_messages.clear();
+
+  negotiation.should_shut_down = cache_coordinator.should_shut_down();
+  if (cache_coordinator.uncached_in_queue()) {
+    StartCoordination(state, negotiation);
+  } else {
+    negotiation.stage = Negotiation::Stage::DONE;
+  }
+}
+
+// Move the flat negotiation to its next stage once the collectives of the
+// current stage have completed.
+void AdvanceCoordination(HorovodGlobalState& state, Negotiation& negotiation) {
+  MPI_Request request;
+  switch (negotiation.stage) {
+  case Negotiation::Stage::GATHER:
+    if (state.rank == RANK_ZERO) {
+      // Compute displacements and collect messages from every rank.
+      negotiation.displcmnts.resize(state.size);
+      size_t total_size = 0;
+      for (int i = 0; i < state.size; ++i) {
+        negotiation.displcmnts[i] = (int)total_size;
+        total_size += negotiation.recvcounts[i];
+      }
+      negotiation.buffer.resize(total_size);
+      MPI_Igatherv(nullptr, 0, MPI_BYTE, negotiation.buffer.data(),
+                   negotiation.recvcounts.data(),
+                   negotiation.displcmnts.data(), MPI_BYTE, RANK_ZERO,
+                   state.negotiation_comm, &request);
+      negotiation.mpi_requests.push_back(request);
+      negotiation.stage = Negotiation::Stage::GATHER_REQUESTS;
+    } else {
+      negotiation.buffer.resize(negotiation.response_length);
+      MPI_Ibcast(negotiation.buffer.data(), negotiation.response_length,
+                 MPI_BYTE, RANK_ZERO, state.negotiation_comm, &request);
+      negotiation.mpi_requests.push_back(request);
+      negotiation.stage = Negotiation::Stage::BROADCAST;
+    }
+    break;
+
+  case Negotiation::Stage::GATHER_REQUESTS: {
+    // Process messages of the other ranks.
+    for (int i = 1; i < state.size; ++i) {
+      MPIRequestList received_message_list;
+      MPIRequestList::ParseFromBytes(
+          received_message_list,
+          negotiation.buffer.data() + negotiation.displcmnts[i]);
+      for (auto& received_message : received_message_list.requests()) {
+        if (IncrementTensorCount(state.message_table, received_message,
+                                 state.size)) {
+          negotiation.ready_to_reduce.push_back(
+              MessageTableKeyOf(received_message));
         }
       }
+      if (received_message_list.shutdown()) {
+        // Received SHUTDOWN request from one of the workers.
+        negotiation.should_shut_down = true;
+      }
     }
 
-    // Perform the collective operation. All nodes should end up performing
-    // the same operation.
-    for (auto& response : response_list.responses()) {
-      LOG(TRACE, state.rank) << "Performing " << response.tensor_names_string();
-      LOG(DEBUG, state.rank) << "Processing " << response.tensor_names().size() << " tensors";
-      PerformOperation(state.tensor_table, response);
-      LOG(TRACE, state.rank) << "Finished performing " << response.tensor_names_string();
+    // The coordinator now knows all the tensors that need to be reduced or
+    // gathered. It chooses which ones and in what order, and notifies the
+    // other ranks.
+    std::vector<MPIResponse> responses;
+    for (auto& key : negotiation.ready_to_reduce) {
+      responses.push_back(ConstructMPIResponse(state.message_table, key));
+    }
+    auto& response_list = negotiation.response_list;
+    response_list.set_shutdown(negotiation.should_shut_down);
+    response_list.set_sequence(negotiation.sequence);
+    FuseResponses(responses, state, response_list);
+    TraceReadyResponses(response_list);
+
+    MPIResponseList::SerializeToString(response_list,
+                                       negotiation.encoded_message);
+    negotiation.response_length =
+        (int)negotiation.encoded_message.length() + 1;
+    MPI_Ibcast(&negotiation.response_length, 1, MPI_INT, RANK_ZERO,
+               state.negotiation_comm, &request);
+    negotiation.mpi_requests.push_back(request);
+    MPI_Ibcast((void*)negotiation.encoded_message.c_str(),
+               negotiation.response_length, MPI_BYTE, RANK_ZERO,
+               state.negotiation_comm, &request);
+    negotiation.mpi_requests.push_back(request);
+    negotiation.stage = Negotiation::Stage::BROADCAST;
+    break;
+  }
+
+  case Negotiation::Stage::BROADCAST:
+    if (state.rank != RANK_ZERO) {
+      MPIResponseList::ParseFromBytes(negotiation.response_list,
+                                      negotiation.buffer.data());
+    }
+    negotiation.stage = Negotiation::Stage::DONE;
+    break;
+
+  default:
+    assert(false);
+  }
+}
+
+// Start the negotiation of the requests popped from the message queue in this
+// cycle. The requests are moved out of the queue, which is left empty.
+void StartNegotiation(HorovodGlobalState& state,
+                      std::vector<MPIRequest>& message_queue,
+                      bool should_shut_down, Negotiation& negotiation) {
+  negotiation.sequence = state.negotiation_sequence++;
+  negotiation.should_shut_down = should_shut_down;
+  negotiation.coordinated = false;
+  negotiation.cached_responses.clear();
+  negotiation.ready_to_reduce.clear();
+  RecycleResponses(state, negotiation.response_list);
+
+  if (state.response_cache.capacity() == 0) {
+    for (auto& message : message_queue) {
+      negotiation.message_queue.push_back(std::move(message));
     }
+    message_queue.clear();
+    StartCoordination(state, negotiation);
+    return;
+  }
 
-    // Check for stalled tensors.
-    if (state.perform_stall_check &&
-        std::chrono::steady_clock::now() - state.last_stall_check >
-            STALL_WARNING_TIME) {
-      CheckForStalledTensors(state);
-      state.last_stall_check = std::chrono::steady_clock::now();
+  auto now = std::chrono::steady_clock::now();
+  auto& cache_coordinator = negotiation.cache_coordinator;
+  cache_coordinator.reset(state.response_cache.num_active_bits());
+  for (auto& message : message_queue) {
+    auto cache_state = state.response_cache.cached(message);
+    if (cache_state == ResponseCache::CacheState::HIT) {
+      uint32_t bit = state.response_cache.peek_cache_bit(message.tensor_id());
+      auto pending_since = CacheHitPendingSince(state, message.tensor_id(), now);
+      if (state.perform_stall_check &&
+          now - pending_since > STALL_WARNING_TIME) {
+        // The tensor has been waiting for other ranks for too long.
+        // Invalidate it, so that it is negotiated by the coordinator which
+        // will report the missing ranks.
+        cache_coordinator.record_invalid_bit(bit);
+        ClearCacheHitPending(state, message.tensor_id());
+        negotiation.message_queue.push_back(std::move(message));
+      } else {
+        cache_coordinator.record_hit(bit);
+        negotiation.hit_messages.push_back(
+            Negotiation::HitMessage{bit, true, std::move(message)});
+      }
+    } else {
+      if (cache_state == ResponseCache::CacheState::INVALID) {
+        uint32_t bit =
+            state.response_cache.peek_cache_bit(message.tensor_id());
+        cache_coordinator.record_invalid_bit(bit);
+      }
+      ClearCacheHitPending(state, message.tensor_id());
+      negotiation.message_queue.push_back(std::move(message));
+    }
+  }
+  message_queue.clear();
+  std::sort(negotiation.hit_messages.begin(), negotiation.hit_messages.end(),
+            [](const Negotiation::HitMessage& a,
+               const Negotiation::HitMessage& b) { return a.bit < b.bit; });
+  cache_coordinator.set_should_shut_down(should_shut_down);
+  cache_coordinator.set_uncached_in_queue(!negotiation.message_queue.empty());
+
+  MPI_Request request;
+  cache_coordinator.start_sync(state.negotiation_comm, &request);
+  negotiation.mpi_requests.push_back(request);
+  negotiation.stage = Negotiation::Stage::CACHE_SYNC;
+}
+
+// Advance the negotiation as far as possible without blocking, or until it is
+// complete if wait is set. Returns whether the negotiation is complete.
+bool ProgressNegotiation(HorovodGlobalState& state, Negotiation& negotiation,
+                         bool wait) {
+  while (negotiation.stage != Negotiation::Stage::DONE) {
+    if (negotiation.stage == Negotiation::Stage::HIERARCHICAL) {
+      // Runs at the same point on all ranks, once nothing else is in flight.
+      if (!wait) {
+        return false;
+      }
+      negotiation.response_list.set_sequence(negotiation.sequence);
+      NegotiateHierarchically(state, negotiation.message_queue,
+                              negotiation.should_shut_down,
+                              negotiation.response_list);
+      negotiation.stage = Negotiation::Stage::DONE;
+      break;
+    }
+    if (!CompleteNegotiationStage(negotiation, wait)) {
+      return false;
+    }
+    if (negotiation.stage == Negotiation::Stage::CACHE_SYNC) {
+      FinishCacheSync(state, negotiation);
+    } else {
+      AdvanceCoordination(state, negotiation);
+    }
+  }
+  return true;
+}
+
+// Wait for the negotiation to complete and fill the empty response list with
+// the responses to perform on this rank: the responses served from the
+// response cache, followed by the responses sent by the coordinator.
+void FinishNegotiation(HorovodGlobalState& state, Negotiation& negotiation,
+                       MPIResponseList& response_list) {
+  ProgressNegotiation(state, negotiation, true);
+
+  auto& negotiated_list = negotiation.response_list;
+  if (negotiation.coordinated) {
+    if (negotiated_list.sequence() != negotiation.sequence) {
+      // The ranks no longer agree on the order of the responses, so none of
+      // them can be performed. Shutting down fails the outstanding entries.
+      LOG(ERROR, state.rank)
+          << "Received response list " << negotiated_list.sequence()
+          << " from the coordinator while negotiating "
+          << negotiation.sequence << ", shutting down.";
+      negotiation.should_shut_down = true;
+      return;
     }
+    if (negotiated_list.shutdown()) {
+      negotiation.should_shut_down = true;
+    }
+  }
 
-    if (state.param_manager.IsAutoTuning()) {
-      state.param_manager.Update(tensor_names, total_tensor_size);
+  AssignTensorIds(state, negotiated_list);
+
+  if (state.response_cache.capacity() > 0) {
+    // Cached responses go first, they are fused locally on every rank in the
+    // same order.
+    FuseResponses(negotiation.cached_responses, state, response_list);
+    CacheResponses(state, negotiated_list);
+    for (auto& response : negotiated_list.mutable_responses()) {
+      response_list.emplace_response(std::move(response));
     }
   } else {
-    std::string encoded_message;
-    MPIRequestList message_list;
-    message_list.set_shutdown(should_shut_down);
-    while (!message_queue.empty()) {
-      message_list.add_request(message_queue.front());
-      message_queue.pop();
+    std::swap(response_list, negotiated_list);
+  }
+  response_list.set_sequence(negotiation.sequence);
+}
+
+// Take the entries of the tensors of the response from the tensor table; the
+// operation performing the response takes care of them.
+void TakeEntries(TensorTable& tensor_table, const MPIResponse& response,
+                 std::vector<TensorTableEntry>& entries) {
+  auto& names = response.tensor_names();
+  auto& tensor_ids = response.tensor_ids();
+  for (size_t i = 0; i < names.size(); ++i) {
+    assert(response.response_type() == MPIResponse::ALLREDUCE ||
+           response.response_type() == MPIResponse::ALLGATHER ||
+           response.response_type() == MPIResponse::BROADCAST ||
+           response.response_type() == MPIResponse::REDUCESCATTER ||
+           response.response_type() == MPIResponse::ALLTOALL ||
+           response.response_type() == MPIResponse::SPARSE_ALLREDUCE ||
+           response.response_type() == MPIResponse::ERROR);
+    entries.push_back(tensor_table.Take(tensor_ids[i], names[i]));
+  }
+}
+
+// Choose the lane performing the response, out of the first num_lanes. GPU
+// and hierarchical operations use communicators other than those of the lanes
+// and always run on lane 0. Other responses go to the lane with the fewest
+// elements dispatched so far, counted the same way on every rank so that all
+// ranks perform the response on the same communicator.
+size_t AssignLane(HorovodGlobalState& state, const MPIResponse& response,
+                  const std::vector<TensorTableEntry>& entries,
+                  int num_lanes) {
+  int64_t elements = 0;
+  bool pinned = false;
+  if (!entries.empty() && response.response_type() != MPIResponse::ERROR) {
+    pinned = entries[0].device != CPU_DEVICE_ID;
+    if (response.response_type() == MPIResponse::ALLREDUCE) {
+      pinned |= state.param_manager.HierarchicalAllreduce();
+    } else if (response.response_type() == MPIResponse::ALLGATHER) {
+      pinned |= state.param_manager.HierarchicalAllgather();
     }
-    MPIRequestList::SerializeToString(message_list, encoded_message);
-    int encoded_message_length = (int)encoded_message.length() + 1;
-    MPI_Gather(&encoded_message_length, 1, MPI_INT, nullptr, 1, MPI_INT,
-               RANK_ZERO, state.mpi_comm);
-    MPI_Gatherv((void*)encoded_message.c_str(), encoded_message_length,
-                MPI_BYTE, nullptr, nullptr, nullptr, MPI_BYTE, RANK_ZERO,
-                state.mpi_comm);
+  }
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto shape = entries[i].tensor->shape();
+    if (response.response_type() == MPIResponse::ALLGATHER ||
+        response.response_type() == MPIResponse::ALLTOALL ||
+        response.response_type() == MPIResponse::SPARSE_ALLREDUCE) {
+      // The first dimension differs between ranks, the response has all of
+      // them, and all the splits of alltoalls.
+      size_t num_sizes = response.tensor_sizes().size() / entries.size();
+      int64_t rows = 0;
+      for (size_t j = 0; j < num_sizes; ++j) {
+        rows += response.tensor_sizes()[i * num_sizes + j];
+      }
+      int64_t row_elements = 1;
+      for (int d = 1; d < shape.dims(); ++d) {
+        row_elements *= shape.dim_size(d);
+      }
+      elements += rows * row_elements;
+    } else if (response.response_type() != MPIResponse::ERROR) {
+      elements += shape.num_elements();
+    }
+  }
 
-    int msg_length;
-    MPI_Bcast(&msg_length, 1, MPI_INT, RANK_ZERO, state.mpi_comm);
-    auto buffer = new uint8_t[msg_length];
-    MPI_Bcast(buffer, msg_length, MPI_BYTE, RANK_ZERO, state.mpi_comm);
-    MPIResponseList response_list;
-    MPIResponseList::ParseFromBytes(response_list, buffer);
-    delete[] buffer;
+  size_t lane = 0;
+  if (!pinned) {
+    for (int i = 1; i < num_lanes; ++i) {
+      if (state.lane_loads[i] < state.lane_loads[lane]) {
+        lane = i;
+      }
+    }
+  }
+  state.lane_loads[lane] += elements;
+  return lane;
+}
 
-    std::vector<std::string> tensor_names;
-    int64_t total_tensor_size = 0;
-    if (state.param_manager.IsAutoTuning()) {
-      for (auto& response : response_list.responses()) {
-        if (response.response_type() == MPIResponse::ResponseType::ALLREDUCE) {
-          for (auto& tensor_name : response.tensor_names()) {
-            tensor_names.push_back(tensor_name);
-            auto& entry = state.tensor_table[tensor_name];
-            total_tensor_size += entry.tensor->size();
-          }
+// Perform the collective operations of the response list. All nodes should
+// end up performing the same operations. If a negotiation is given, it makes
+// progress between operations.
+void PerformResponses(HorovodGlobalState& state,
+                      const MPIResponseList& response_list,
+                      Negotiation* negotiation) {
+  std::vector<int32_t> tensor_ids;
+  int64_t total_tensor_size = 0;
+  if (state.param_manager.IsAutoTuning()) {
+    for (auto& response : response_list.responses()) {
+      if (response.response_type() == MPIResponse::ResponseType::ALLREDUCE) {
+        for (size_t i = 0; i < response.tensor_names().size(); ++i) {
+          tensor_ids.push_back(response.tensor_ids()[i]);
+          auto& entry = state.tensor_table.Get(response.tensor_ids()[i],
+                                               response.tensor_names()[i]);
+          total_tensor_size += entry.tensor->size();
         }
       }
     }
+  }
 
-    // Perform the collective operation. All nodes should end up performing
-    // the same operation.
-    for (auto& response : response_list.responses()) {
-      LOG(TRACE, state.rank) << "Performing " << response.tensor_names_string();
-      LOG(DEBUG, state.rank) << "Processing " << response.tensor_names().size() << " tensors";
-      PerformOperation(state.tensor_table, response);
+  int num_lanes = std::min((int)state.lanes.size(),
+                           state.param_manager.ConcurrentCollectives());
+  std::fill(state.lane_loads.begin(), state.lane_loads.end(), 0);
+  auto& responses = response_list.responses();
+  auto& response_entries = state.response_entries;
+  if (response_entries.size() < responses.size()) {
+    response_entries.resize(responses.size());
+  }
+  for (size_t r = 0; r < responses.size(); ++r) {
+    auto& response = responses[r];
+    auto& entries = response_entries[r];
+    LOG(TRACE, state.rank) << "Performing " << response.tensor_names_string();
+    LOG(DEBUG, state.rank) << "Processing " << response.tensor_names().size() << " tensors";
+    TakeEntries(state.tensor_table, response, entries);
+    if (num_lanes > 1) {
+      auto lane = AssignLane(state, response, entries, num_lanes);
+      state.lane_executor.Submit(lane, [&](LaneTask& task) {
+        task.entries = &entries;
+        task.response = &response;
+        task.lane = state.lanes[lane].get();
+      });
+    } else {
+      PerformOperation(entries, response, *state.lanes[0]);
+      entries.clear();
       LOG(TRACE, state.rank) << "Finished performing " << response.tensor_names_string();
     }
+    if (negotiation != nullptr) {
+      ProgressNegotiation(state, *negotiation, false);
+    }
+  }
+  if (num_lanes > 1) {
+    // The parameters used by the operations must not change while they run.
+    state.lane_executor.Wait();
+  }
+
+  if (state.param_manager.IsAutoTuning()) {
+    state.param_manager.Update(tensor_ids, total_tensor_size);
+  }
+}
 
-    if (state.param_manager.IsAutoTuning()) {
-      state.param_manager.Update(tensor_names, total_tensor_size);
+// The coordinator currently follows a master-worker paradigm. Rank zero acts
+// as the master (the "coordinator"), whereas all other ranks are simply
+// workers. Each rank runs its own background thread which progresses in ticks.
+// In each tick, the following actions happen:
+//
+//      a) The workers send an MPIRequest to the coordinator, indicating what
+//      they would like to do (which tensor they would like to gather and
+//      reduce, as well as their shape and type). They repeat this for every
+//      tensor that they would like to operate on.
+//
+//      b) The workers send an empty "DONE" message to the coordinator to
+//      indicate that there are no more tensors they wish to operate on.
+//
+//      c) The coordinator receives the MPIRequests from the workers, as well
+//      as from its own TensorFlow ops, and stores them in a request table. The
+//      coordinator continues to receive MPIRequest messages until it has
+//      received MPI_SIZE number of empty "DONE" messages.
+//
+//      d) The coordinator finds all tensors that are ready to be reduced,
+//      gathered, or all operations that result in an error. For each of those,
+//      it sends an MPIResponse to all the workers. When no more MPIResponses
+//      are available, it sends a "DONE" response to the workers. If the process
+//      is being shutdown, it instead sends a "SHUTDOWN" response.
+//
+//      e) The workers listen for MPIResponse messages, processing each one by
+//      doing the required reduce or gather, until they receive a "DONE"
+//      response from the coordinator. At that point, the tick ends.
+//      If instead of "DONE" they receive "SHUTDOWN", they exit their background
+//      loop.
+//
+// If the response cache is enabled, every rank first checks its requests
+// against the cache. Cache hits and invalidated entries are exchanged between
+// all ranks with a single bitwise allreduce, along with the shutdown flag and
+// whether any rank has uncached requests. Tensors that hit the cache on every
+// rank are performed using the cached responses, and steps a) to e) only take
+// place if at least one rank has requests that missed the cache.
+//
+// The negotiation uses non-blocking collectives. If negotiation overlaps with
+// execution, the responses negotiated in a cycle are performed in the next
+// one, while the requests of that cycle are being negotiated. Every response
+// list carries the sequence number of its negotiation, so all ranks perform
+// the lists in the same order.
+bool RunLoopOnce(HorovodGlobalState& state, bool is_coordinator) {
+  if (state.pending_response_list.responses().empty()) {
+    WaitForNextCycle(state);
+  } else {
+    // Responses negotiated in the last cycle are waiting to be performed.
+    state.last_cycle_start = std::chrono::steady_clock::now();
+  }
+
+  if (state.mark_cycles_in_timeline) {
+    // Mark start of the new cycle.
+    state.timeline.MarkCycleStart();
+  }
+
+  // Take the requests submitted since the last cycle.
+  DrainSubmissions(state);
+  auto& message_queue = state.cycle_messages;
+  std::swap(message_queue, state.message_queue);
+  for (auto& message : message_queue) {
+    if (message.tensor_id() < 0) {
+      // The ID may have been assigned after the tensor was submitted.
+      message.set_tensor_id(
+          state.tensor_registry.Lookup(message.tensor_name()));
     }
+  }
 
-    if (response_list.shutdown()) {
-      should_shut_down = true;
+  if (!message_queue.empty()) {
+    LOG(DEBUG, state.rank) << "Sent " << message_queue.size() << " messages";
+  }
+
+  auto& negotiation = state.negotiation;
+  StartNegotiation(state, message_queue, state.shut_down, negotiation);
+
+  auto& response_list = state.cycle_response_list;
+  if (state.overlap_negotiation) {
+    std::swap(response_list, state.pending_response_list);
+    PerformResponses(state, response_list, &negotiation);
+    RecycleResponses(state, response_list);
+    FinishNegotiation(state, negotiation, state.pending_response_list);
+    if (negotiation.should_shut_down) {
+      PerformResponses(state, state.pending_response_list, nullptr);
+      RecycleResponses(state, state.pending_response_list);
     }
+  } else {
+    FinishNegotiation(state, negotiation, response_list);
+    PerformResponses(state, response_list, nullptr);
+    RecycleResponses(state, response_list);
+  }
+
+  // Check for stalled tensors.
+  if ((is_coordinator ||
+       (state.hierarchical_negotiation && state.local_rank == 0)) &&
+      state.perform_stall_check &&
+      std::chrono::steady_clock::now() - state.last_stall_check >
+          STALL_WARNING_TIME) {
+    CheckForStalledTensors(state);
+    state.last_stall_check = std::chrono::steady_clock::now();
   }
 
-  return !should_shut_down;
+  return !negotiation.should_shut_down;
 }
 
 // Start Horovod background thread. Ensure that this is
@@ -2423,7 +5560,11 @@ void horovod_init_comm(MPI_Comm comm) {
 
 void horovod_shutdown() {
   if (horovod_global.background_thread.joinable()) {
-    horovod_global.shut_down = true;
+    {
+      std::lock_guard<std::mutex> guard(horovod_global.mutex);
+      horovod_global.shut_down = true;
+    }
+    horovod_global.cycle_cond.notify_all();
     horovod_global.background_thread.join();
     // Reset the initialization flag to allow restarting with horovod_init(...)
     horovod_global.initialize_flag.clear();
@@ -2474,40 +5615,104 @@ Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> output,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
-                              StatusCallback callback) {
-  MPIRequest message;
-  message.set_request_rank(horovod_global.rank);
-  message.set_tensor_name(name);
-  message.set_tensor_type(tensor->dtype());
-  message.set_device(device);
-  message.set_request_type(MPIRequest::ALLREDUCE);
-  for (int i = 0; i < tensor->shape().dims(); ++i) {
-    message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
-  }
-
-  TensorTableEntry e;
-  e.tensor_name = name;
-  e.context = context;
-  e.tensor = tensor;
-  e.output = output;
-  e.ready_event = ready_event;
-  e.device = device;
-  e.callback = callback;
-
-  std::lock_guard<std::mutex> guard(horovod_global.mutex);
-  if (horovod_global.shut_down) {
-    return SHUT_DOWN_ERROR;
+                              StatusCallback callback, double prescale_factor,
+                              double postscale_factor,
+                              Compression compression) {
+  auto status = CheckScaleFactors(tensor->dtype(), device, prescale_factor,
+                                  postscale_factor);
+  if (status.ok()) {
+    status = CheckCompression(*tensor, device, compression);
+  }
+  if (!status.ok()) {
+    return status;
   }
-  if (horovod_global.tensor_table.find(name) !=
-      horovod_global.tensor_table.end()) {
-    return DUPLICATE_NAME_ERROR;
+
+  uint64_t position;
+  if (!ReserveSubmissions(horovod_global, 1, position)) {
+    return SHUT_DOWN_ERROR;
   }
-  horovod_global.tensor_table.emplace(name, std::move(e));
-  horovod_global.message_queue.push(message);
+  auto& submission = horovod_global.submission_queue->At(position);
+  FillSubmission(horovod_global, submission, MPIRequest::ALLREDUCE, name,
+                 *tensor, device);
+  auto& e = submission.entry;
+  e.context = std::move(context);
+  e.tensor = std::move(tensor);
+  e.output = std::move(output);
+  e.ready_event = std::move(ready_event);
+  e.callback = std::move(callback);
+  e.prescale_factor = prescale_factor;
+  e.postscale_factor = postscale_factor;
+  e.compression = compression;
+  submission.message.set_compression(compression);
+  PublishSubmissions(horovod_global, position, 1);
   LOG(TRACE, horovod_global.rank) << "Enqueued " << name;
   return Status::OK();
 }
 
+// MPI must be initialized and the background thread must be running before
+// this function is called.
+Status EnqueueTensorAllreduces(
+    const std::vector<std::shared_ptr<OpContext>>& contexts,
+    const std::vector<std::shared_ptr<Tensor>>& tensors,
+    const std::vector<std::shared_ptr<Tensor>>& outputs,
+    const std::vector<std::shared_ptr<ReadyEvent>>& ready_events,
+    const std::vector<std::string>& names, const int device,
+    const std::vector<StatusCallback>& callbacks, double prescale_factor,
+    double postscale_factor, Compression compression) {
+  if (tensors.size() > horovod_global.submission_queue->capacity()) {
+    return Status::InvalidArgument(
+        "Cannot enqueue a group of " + std::to_string(tensors.size()) +
+        " tensors, which is more than the submission queue capacity (" +
+        std::to_string(horovod_global.submission_queue->capacity()) +
+        "). Set " HOROVOD_SUBMISSION_QUEUE_CAPACITY " to a larger value.");
+  }
+  std::unordered_set<std::string> group_names;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto status = CheckScaleFactors(tensors[i]->dtype(), device,
+                                    prescale_factor, postscale_factor);
+    if (status.ok()) {
+      status = CheckCompression(*tensors[i], device, compression);
+    }
+    if (!status.ok()) {
+      return status;
+    }
+    if (!group_names.insert(names[i]).second) {
+      return DUPLICATE_NAME_ERROR;
+    }
+  }
+  if (tensors.empty()) {
+    return Status::OK();
+  }
+
+  // The group is published in consecutive cells, which the background thread
+  // takes in a single cycle, so that it is negotiated at once on every rank.
+  auto count = (uint32_t)tensors.size();
+  uint64_t position;
+  if (!ReserveSubmissions(horovod_global, count, position)) {
+    return SHUT_DOWN_ERROR;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    auto& submission = horovod_global.submission_queue->At(position + i);
+    FillSubmission(horovod_global, submission, MPIRequest::ALLREDUCE,
+                   names[i], *tensors[i], device);
+    auto& e = submission.entry;
+    e.context = contexts[i];
+    e.tensor = tensors[i];
+    e.output = outputs[i];
+    e.ready_event = ready_events[i];
+    e.callback = callbacks[i];
+    e.prescale_factor = prescale_factor;
+    e.postscale_factor = postscale_factor;
+    e.compression = compression;
+    submission.message.set_compression(compression);
+  }
+  horovod_global.submission_queue->At(position).group_size = count;
+  PublishSubmissions(horovod_global, position, count);
+  LOG(TRACE, horovod_global.rank)
+      << "Enqueued a group of " << tensors.size() << " tensors";
+  return Status::OK();
+}
+
 // MPI must be initialized and the background thread must be running before
 // this function is called.
 Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
@@ -2515,34 +5720,121 @@ Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
                               StatusCallback callback) {
-  MPIRequest message;
-  message.set_request_rank(horovod_global.rank);
-  message.set_tensor_name(name);
-  message.set_tensor_type(tensor->dtype());
-  message.set_device(device);
-  message.set_request_type(MPIRequest::ALLGATHER);
-  for (int i = 0; i < tensor->shape().dims(); ++i) {
-    message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
+  uint64_t position;
+  if (!ReserveSubmissions(horovod_global, 1, position)) {
+    return SHUT_DOWN_ERROR;
   }
+  auto& submission = horovod_global.submission_queue->At(position);
+  FillSubmission(horovod_global, submission, MPIRequest::ALLGATHER, name,
+                 *tensor, device);
+  auto& e = submission.entry;
+  e.context = std::move(context);
+  e.tensor = std::move(tensor);
+  e.ready_event = std::move(ready_event);
+  e.callback = std::move(callback);
+  PublishSubmissions(horovod_global, position, 1);
+  LOG(TRACE, horovod_global.rank) << "Enqueued " << name;
+  return Status::OK();
+}
 
-  TensorTableEntry e;
-  e.tensor_name = name;
-  e.context = context;
-  e.tensor = tensor;
-  e.ready_event = ready_event;
-  e.device = device;
-  e.callback = callback;
+// MPI must be initialized and the background thread must be running before
+// this function is called.
+Status EnqueueTensorReducescatter(std::shared_ptr<OpContext> context,
+                                  std::shared_ptr<Tensor> tensor,
+                                  std::shared_ptr<ReadyEvent> ready_event,
+                                  const std::string name, const int device,
+                                  StatusCallback callback) {
+  uint64_t position;
+  if (!ReserveSubmissions(horovod_global, 1, position)) {
+    return SHUT_DOWN_ERROR;
+  }
+  auto& submission = horovod_global.submission_queue->At(position);
+  FillSubmission(horovod_global, submission, MPIRequest::REDUCESCATTER, name,
+                 *tensor, device);
+  auto& e = submission.entry;
+  e.context = std::move(context);
+  e.tensor = std::move(tensor);
+  e.ready_event = std::move(ready_event);
+  e.callback = std::move(callback);
+  PublishSubmissions(horovod_global, position, 1);
+  LOG(TRACE, horovod_global.rank) << "Enqueued " << name;
+  return Status::OK();
+}
 
-  std::lock_guard<std::mutex> guard(horovod_global.mutex);
-  if (horovod_global.shut_down) {
+// MPI must be initialized and the background thread must be running before
+// this function is called.
+Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
+                             std::shared_ptr<Tensor> tensor,
+                             const std::vector<int64_t>& splits,
+                             std::shared_ptr<ReadyEvent> ready_event,
+                             const std::string name, const int device,
+                             StatusCallback callback) {
+  uint64_t position;
+  if (!ReserveSubmissions(horovod_global, 1, position)) {
     return SHUT_DOWN_ERROR;
   }
-  if (horovod_global.tensor_table.find(name) !=
-      horovod_global.tensor_table.end()) {
-    return DUPLICATE_NAME_ERROR;
+  auto& submission = horovod_global.submission_queue->At(position);
+  FillSubmission(horovod_global, submission, MPIRequest::ALLTOALL, name,
+                 *tensor, device);
+  submission.message.set_tensor_splits(splits);
+  auto& e = submission.entry;
+  e.context = std::move(context);
+  e.tensor = std::move(tensor);
+  e.splits = splits;
+  e.ready_event = std::move(ready_event);
+  e.callback = std::move(callback);
+  PublishSubmissions(horovod_global, position, 1);
+  LOG(TRACE, horovod_global.rank) << "Enqueued " << name;
+  return Status::OK();
+}
+
+// MPI must be initialized and the background thread must be running before
+// this function is called.
+Status EnqueueTensorSparseAllreduce(std::shared_ptr<OpContext> context,
+                                    std::shared_ptr<OpContext> indices_context,
+                                    std::shared_ptr<Tensor> indices,
+                                    std::shared_ptr<Tensor> values,
+                                    int64_t dense_rows,
+                                    std::shared_ptr<ReadyEvent> ready_event,
+                                    const std::string name, const int device,
+                                    StatusCallback callback) {
+  if (indices->dtype() != HOROVOD_INT32 && indices->dtype() != HOROVOD_INT64) {
+    return Status::InvalidArgument("Indices of sparse allreduce of " + name +
+                                   " must be int32 or int64.");
   }
-  horovod_global.tensor_table.emplace(name, std::move(e));
-  horovod_global.message_queue.push(message);
+  if (values->shape().dims() < 1 || indices->shape().dims() != 1 ||
+      indices->shape().dim_size(0) != values->shape().dim_size(0)) {
+    return Status::InvalidArgument(
+        "Sparse allreduce of " + name +
+        " requires one index for every row of the values.");
+  }
+  if (!IsSummable(values->dtype())) {
+    return Status::InvalidArgument("Sparse allreduce of " + name +
+                                   " does not support values of type " +
+                                   MPIDataType_Name(values->dtype()) + ".");
+  }
+  if (device != CPU_DEVICE_ID) {
+    return Status::InvalidArgument("Sparse allreduce of " + name +
+                                   " requires CPU tensors.");
+  }
+
+  uint64_t position;
+  if (!ReserveSubmissions(horovod_global, 1, position)) {
+    return SHUT_DOWN_ERROR;
+  }
+  auto& submission = horovod_global.submission_queue->At(position);
+  FillSubmission(horovod_global, submission, MPIRequest::SPARSE_ALLREDUCE,
+                 name, *values, device);
+  submission.message.set_dense_rows(dense_rows);
+  auto& e = submission.entry;
+  e.context = std::move(context);
+  e.indices_context = std::move(indices_context);
+  e.indices = std::move(indices);
+  e.tensor = std::move(values);
+  e.dense_rows = dense_rows;
+  e.ready_event = std::move(ready_event);
+  e.callback = std::move(callback);
+  PublishSubmissions(horovod_global, position, 1);
   LOG(TRACE, horovod_global.rank) << "Enqueued " << name;
   return Status::OK();
 }
@@ -2555,37 +5847,22 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
                               StatusCallback callback) {
-  MPIRequest message;
-  message.set_request_rank(horovod_global.rank);
-  message.set_tensor_name(name);
-  message.set_tensor_type(tensor->dtype());
-  message.set_root_rank(root_rank);
-  message.set_device(device);
-  message.set_request_type(MPIRequest::BROADCAST);
-  for (int i = 0; i < tensor->shape().dims(); ++i) {
-    message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
-  }
-
-  TensorTableEntry e;
-  e.tensor_name = name;
-  e.context = context;
-  e.tensor = tensor;
-  e.output = output;
-  e.root_rank = root_rank;
-  e.ready_event = ready_event;
-  e.device = device;
-  e.callback = callback;
-
-  std::lock_guard<std::mutex> guard(horovod_global.mutex);
-  if (horovod_global.shut_down) {
+  uint64_t position;
+  if (!ReserveSubmissions(horovod_global, 1, position)) {
     return SHUT_DOWN_ERROR;
   }
-  if (horovod_global.tensor_table.find(name) !=
-      horovod_global.tensor_table.end()) {
-    return DUPLICATE_NAME_ERROR;
-  }
-  horovod_global.tensor_table.emplace(name, std::move(e));
-  horovod_global.message_queue.push(message);
+  auto& submission = horovod_global.submission_queue->At(position);
+  FillSubmission(horovod_global, submission, MPIRequest::BROADCAST, name,
+                 *tensor, device);
+  submission.message.set_root_rank(root_rank);
+  auto& e = submission.entry;
+  e.context = std::move(context);
+  e.tensor = std::move(tensor);
+  e.output = std::move(output);
+  e.root_rank = root_rank;
+  e.ready_event = std::move(ready_event);
+  e.callback = std::move(callback);
+  PublishSubmissions(horovod_global, position, 1);
   LOG(TRACE, horovod_global.rank) << "Enqueued " << name;
   return Status::OK();
 }
@@ -27,8 +27,6 @@ namespace common {
 
 // Activity names, see Horovod Timeline for more details.
 #define INIT_FUSION_BUFFER "INIT_FUSION_BUFFER"
-#define WAIT_FOR_DATA "WAIT_FOR_DATA"
-#define WAIT_FOR_OTHER_TENSOR_DATA "WAIT_FOR_OTHER_TENSOR_DATA"
 #define ALLOCATE_OUTPUT "ALLOCATE_OUTPUT"
 #define MPI_CROSS_ALLGATHER "MPI_CROSS_ALLGATHER"
 #define MPI_ALLGATHER "MPI_ALLGATHER"
@@ -38,10 +36,19 @@ namespace common {
 #define MEMCPY_IN_HOST_BUFFER "MEMCPY_IN_HOST_BUFFER"
 #define MEMCPY_IN_SHARED_BUFFER "MEMCPY_IN_SHARED_BUFFER"
 #define MPI_ALLREDUCE "MPI_ALLREDUCE"
+#define MPI_PIPELINED_ALLREDUCE "MPI_PIPELINED_ALLREDUCE"
+#define SHARED_MEMORY_ALLREDUCE "SHARED_MEMORY_ALLREDUCE"
+#define RING_ALLREDUCE "RING_ALLREDUCE"
+#define RECURSIVE_DOUBLING_ALLREDUCE "RECURSIVE_DOUBLING_ALLREDUCE"
 #define MEMCPY_OUT_HOST_BUFFER "MEMCPY_OUT_HOST_BUFFER"
 #define NCCL_ALLREDUCE "NCCL_ALLREDUCE"
 #define MEMCPY_OUT_FUSION_BUFFER "MEMCPY_OUT_FUSION_BUFFER"
 #define MPI_BCAST "MPI_BCAST"
+#define MPI_REDUCESCATTER "MPI_REDUCESCATTER"
+#define MPI_ALLTOALL "MPI_ALLTOALL"
+#define MERGE_SPARSE_ROWS "MERGE_SPARSE_ROWS"
+#define TOPK_SELECT "TOPK_SELECT"
+#define TOPK_SCATTER "TOPK_SCATTER"
 #define NCCL_REDUCESCATTER "NCCL_REDUCESCATTER"
 #define NCCL_ALLGATHER "NCCL_ALLGATHER"
 #define NCCL_REDUCE "NCCL_REDUCE"
@@ -53,6 +60,10 @@ namespace common {
 // allreduce size is always a multiple of FUSION_BUFFER_ATOMIC_UNIT
 #define FUSION_BUFFER_ATOMIC_UNIT 64
 
+// Maximum number of bytes each local rank places in shared memory at a time in
+// hierarchical allreduce of CPU tensors.
+#define SHARED_ALLREDUCE_SEGMENT_SIZE (64 * 1024 * 1024)
+
 // Horovod knobs.
 #define HOROVOD_MPI_THREADS_DISABLE "HOROVOD_MPI_THREADS_DISABLE"
 #define HOROVOD_TIMELINE "HOROVOD_TIMELINE"
@@ -61,9 +72,24 @@ namespace common {
 #define HOROVOD_AUTOTUNE_LOG "HOROVOD_AUTOTUNE_LOG"
 #define HOROVOD_FUSION_THRESHOLD "HOROVOD_FUSION_THRESHOLD"
 #define HOROVOD_CYCLE_TIME "HOROVOD_CYCLE_TIME"
+#define HOROVOD_ALLREDUCE_CHUNK_SIZE "HOROVOD_ALLREDUCE_CHUNK_SIZE"
+#define HOROVOD_ALLREDUCE_RECURSIVE_DOUBLING_THRESHOLD "HOROVOD_ALLREDUCE_RECURSIVE_DOUBLING_THRESHOLD"
+#define HOROVOD_ALLREDUCE_RING_THRESHOLD "HOROVOD_ALLREDUCE_RING_THRESHOLD"
+#define HOROVOD_ZERO_COPY_FUSION "HOROVOD_ZERO_COPY_FUSION"
+#define HOROVOD_EVENT_DRIVEN_CYCLE "HOROVOD_EVENT_DRIVEN_CYCLE"
+#define HOROVOD_OVERLAP_NEGOTIATION "HOROVOD_OVERLAP_NEGOTIATION"
 #define HOROVOD_STALL_CHECK_DISABLE "HOROVOD_STALL_CHECK_DISABLE"
 #define HOROVOD_HIERARCHICAL_ALLREDUCE "HOROVOD_HIERARCHICAL_ALLREDUCE"
 #define HOROVOD_HIERARCHICAL_ALLGATHER "HOROVOD_HIERARCHICAL_ALLGATHER"
+#define HOROVOD_HIERARCHICAL_NEGOTIATION "HOROVOD_HIERARCHICAL_NEGOTIATION"
+#define HOROVOD_CACHE_CAPACITY "HOROVOD_CACHE_CAPACITY"
+#define HOROVOD_SUBMISSION_QUEUE_CAPACITY "HOROVOD_SUBMISSION_QUEUE_CAPACITY"
+#define HOROVOD_COMPLETION_THREADS "HOROVOD_COMPLETION_THREADS"
+#define HOROVOD_COMPLETION_QUEUE_CAPACITY "HOROVOD_COMPLETION_QUEUE_CAPACITY"
+#define HOROVOD_CONCURRENT_COLLECTIVES "HOROVOD_CONCURRENT_COLLECTIVES"
+#define HOROVOD_SPARSE_DENSITY_THRESHOLD "HOROVOD_SPARSE_DENSITY_THRESHOLD"
+#define HOROVOD_TOPK_RATIO "HOROVOD_TOPK_RATIO"
+#define HOROVOD_TOPK_RESIDUAL_CAPACITY "HOROVOD_TOPK_RESIDUAL_CAPACITY"
 
 // A callback to call after the MPI communication completes. Since the
 // allreduce and allgather ops are asynchronous, this callback is what resumes
@@ -105,12 +131,33 @@ int horovod_local_size();
 int horovod_mpi_threads_supported();
 }
 
+// The input is multiplied by prescale_factor before it is reduced, and the
+// result by postscale_factor, while the tensor is copied into and out of the
+// fusion buffer. Scale factors other than one are only supported for CPU
+// tensors. With FP16_COMPRESSION, a float32 CPU tensor is cast to float16 in
+// the same copy and reduced as float16, which halves the data sent.
 Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
                               std::shared_ptr<Tensor> output,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
-                              StatusCallback callback);
+                              StatusCallback callback,
+                              double prescale_factor = 1.0,
+                              double postscale_factor = 1.0,
+                              Compression compression = NO_COMPRESSION);
+
+// Enqueues the allreduces of a group of tensors at once. Tensors of a group
+// are only fused with each other, in order, in as few fused operations as the
+// fusion threshold allows. All ranks must group the same tensors together.
+// The scale factors and compression apply to every tensor of the group.
+Status EnqueueTensorAllreduces(
+    const std::vector<std::shared_ptr<OpContext>>& contexts,
+    const std::vector<std::shared_ptr<Tensor>>& tensors,
+    const std::vector<std::shared_ptr<Tensor>>& outputs,
+    const std::vector<std::shared_ptr<ReadyEvent>>& ready_events,
+    const std::vector<std::string>& names, const int device,
+    const std::vector<StatusCallback>& callbacks, double prescale_factor = 1.0,
+    double postscale_factor = 1.0, Compression compression = NO_COMPRESSION);
 
 Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
@@ -118,6 +165,44 @@ Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
                               const std::string name, const int device,
                               StatusCallback callback);
 
+// The output holds the sum over all ranks of the share of this rank of the
+// first dimension of the tensor. The first dimension is split as evenly as
+// possible, with the first ranks receiving one more slice if it is not
+// divisible by the number of ranks.
+Status EnqueueTensorReducescatter(std::shared_ptr<OpContext> context,
+                                  std::shared_ptr<Tensor> tensor,
+                                  std::shared_ptr<ReadyEvent> ready_event,
+                                  const std::string name, const int device,
+                                  StatusCallback callback);
+
+// Sends splits[i] consecutive slices of the first dimension of the tensor to
+// rank i, in order, and receives the slices sent by every rank into the
+// output, ordered by rank. Empty splits send the same number of slices to
+// every rank.
+Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
+                             std::shared_ptr<Tensor> tensor,
+                             const std::vector<int64_t>& splits,
+                             std::shared_ptr<ReadyEvent> ready_event,
+                             const std::string name, const int device,
+                             StatusCallback callback);
+
+// Sums the sparse tensor whose rows values[i] have indices indices[i] over all
+// ranks. The indices (int32 or int64) are allocated through indices_context
+// and the values through context. The output holds every index present on any
+// rank once, in increasing order, with the sum of its rows. dense_rows is the
+// number of rows of the dense tensor, or 0 if unknown. If it is known and the
+// rows of all ranks would fill more than HOROVOD_SPARSE_DENSITY_THRESHOLD of
+// the dense tensor, the dense tensor is reduced instead, and the output holds
+// all of its rows. Only CPU tensors are supported.
+Status EnqueueTensorSparseAllreduce(std::shared_ptr<OpContext> context,
+                                    std::shared_ptr<OpContext> indices_context,
+                                    std::shared_ptr<Tensor> indices,
+                                    std::shared_ptr<Tensor> values,
+                                    int64_t dense_rows,
+                                    std::shared_ptr<ReadyEvent> ready_event,
+                                    const std::string name, const int device,
+                                    StatusCallback callback);
+
 Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
                               std::shared_ptr<Tensor> output, int root_rank,
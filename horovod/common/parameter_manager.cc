@@ -41,6 +41,14 @@ Eigen::VectorXd CreateVector(double x1, double x2) {
 ParameterManager::ParameterManager() :
     hierarchical_allreduce_(CategoricalParameter<bool>(std::vector<bool>{false, true})),
     hierarchical_allgather_(CategoricalParameter<bool>(std::vector<bool>{false, true})),
+    allreduce_chunk_bytes_(CategoricalParameter<int64_t>(
+      std::vector<int64_t>{0, 1 * 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024})),
+    concurrent_collectives_(CategoricalParameter<int32_t>(std::vector<int32_t>{1, 2, 4})),
+    allreduce_recursive_doubling_bytes_(CategoricalParameter<int64_t>(
+      std::vector<int64_t>{0, 4 * 1024, 64 * 1024})),
+    allreduce_ring_bytes_(CategoricalParameter<int64_t>(
+      std::vector<int64_t>{0, 1 * 1024 * 1024, 16 * 1024 * 1024})),
+    zero_copy_fusion_(CategoricalParameter<bool>(std::vector<bool>{false, true})),
     joint_params_(BayesianParameter(
       std::vector<BayesianVariableConfig>{
         { BayesianVariable::fusion_buffer_threshold_mb, std::pair<double, double>(0, 64) },
@@ -51,7 +59,10 @@ ParameterManager::ParameterManager() :
         CreateVector(16, 25),
         CreateVector(8, 10)
       })),
-    parameter_chain_(std::vector<ITunableParameter*>{&joint_params_, &hierarchical_allreduce_, &hierarchical_allgather_}),
+    parameter_chain_(std::vector<ITunableParameter*>{&joint_params_, &hierarchical_allreduce_, &hierarchical_allgather_,
+                                                     &allreduce_chunk_bytes_, &concurrent_collectives_,
+                                                     &allreduce_recursive_doubling_bytes_, &allreduce_ring_bytes_,
+                                                     &zero_copy_fusion_}),
     active_(false),
     warmup_remaining_(WARMUPS),
     sample_(0),
@@ -62,16 +73,22 @@ ParameterManager::ParameterManager() :
 }
 
 void ParameterManager::CreateMpiTypes() {
-  const int nitems = 5;
-  int blocklengths[5] = {1, 1, 1, 1, 1};
-  MPI_Datatype types[5] = {MPI_CXX_BOOL, MPI_CXX_BOOL, MPI_DOUBLE, MPI_DOUBLE, MPI_CXX_BOOL};
+  const int nitems = 10;
+  int blocklengths[10] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+  MPI_Datatype types[10] = {MPI_CXX_BOOL, MPI_CXX_BOOL, MPI_DOUBLE, MPI_DOUBLE, MPI_INT64_T, MPI_INT32_T,
+                            MPI_INT64_T, MPI_INT64_T, MPI_CXX_BOOL, MPI_CXX_BOOL};
 
-  MPI_Aint offsets[5];
+  MPI_Aint offsets[10];
   offsets[0] = offsetof(Params, hierarchical_allreduce);
   offsets[1] = offsetof(Params, hierarchical_allgather);
   offsets[2] = offsetof(Params, tensor_fusion_threshold);
   offsets[3] = offsetof(Params, cycle_time);
-  offsets[4] = offsetof(Params, active);
+  offsets[4] = offsetof(Params, allreduce_chunk_bytes);
+  offsets[5] = offsetof(Params, concurrent_collectives);
+  offsets[6] = offsetof(Params, allreduce_recursive_doubling_bytes);
+  offsets[7] = offsetof(Params, allreduce_ring_bytes);
+  offsets[8] = offsetof(Params, zero_copy_fusion);
+  offsets[9] = offsetof(Params, active);
 
   MPI_Type_create_struct(nitems, blocklengths, offsets, types, &mpi_params_type_);
   MPI_Type_commit(&mpi_params_type_);
@@ -88,12 +105,12 @@ void ParameterManager::Initialize(int32_t rank, int32_t root_rank, MPI_Comm mpi_
   root_rank_ = root_rank;
   mpi_comm_ = mpi_comm;
   if (rank_ == root_rank) {
-    LOG(INFO) << "Autotuner: Tunable params [hierarchical_allreduce,hierarchical_allgather,cycle_time_ms,tensor_fusion_threshold] score";
+    LOG(INFO) << "Autotuner: Tunable params [hierarchical_allreduce,hierarchical_allgather,cycle_time_ms,tensor_fusion_threshold,allreduce_chunk_bytes,concurrent_collectives,recursive_doubling_bytes,ring_bytes,zero_copy_fusion] score";
   }
   if (rank_ == root_rank && !file_name.empty()) {
     file_.open(file_name, std::ios::out | std::ios::trunc);
     if (file_.good()) {
-      file_ << "hierarchical_allreduce,hierarchical_allgather,cycle_time_ms,tensor_fusion_threshold,score" << std::endl;
+      file_ << "hierarchical_allreduce,hierarchical_allgather,cycle_time_ms,tensor_fusion_threshold,allreduce_chunk_bytes,concurrent_collectives,recursive_doubling_bytes,ring_bytes,zero_copy_fusion,score" << std::endl;
       writing_ = true;
     }
   }
@@ -142,13 +159,56 @@ void ParameterManager::SetCycleTimeMs(double value, bool fixed) {
   joint_params_.SetValue(cycle_time_ms, value, fixed);
 }
 
-void ParameterManager::Update(const std::vector<std::string>& tensor_names, int64_t bytes) {
+int64_t ParameterManager::AllreduceChunkBytes() const {
+  return active_ ? allreduce_chunk_bytes_.Value() : allreduce_chunk_bytes_.BestValue();
+}
+
+void ParameterManager::SetAllreduceChunkBytes(int64_t chunk_bytes, bool fixed) {
+  allreduce_chunk_bytes_.SetValue(chunk_bytes, fixed);
+}
+
+int32_t ParameterManager::ConcurrentCollectives() const {
+  return active_ ? concurrent_collectives_.Value() : concurrent_collectives_.BestValue();
+}
+
+void ParameterManager::SetConcurrentCollectives(int32_t value, bool fixed) {
+  concurrent_collectives_.SetValue(value, fixed);
+}
+
+int64_t ParameterManager::AllreduceRecursiveDoublingBytes() const {
+  return active_ ? allreduce_recursive_doubling_bytes_.Value() : allreduce_recursive_doubling_bytes_.BestValue();
+}
+
+void ParameterManager::SetAllreduceRecursiveDoublingBytes(int64_t threshold, bool fixed) {
+  allreduce_recursive_doubling_bytes_.SetValue(threshold, fixed);
+}
+
+int64_t ParameterManager::AllreduceRingBytes() const {
+  return active_ ? allreduce_ring_bytes_.Value() : allreduce_ring_bytes_.BestValue();
+}
+
+void ParameterManager::SetAllreduceRingBytes(int64_t threshold, bool fixed) {
+  allreduce_ring_bytes_.SetValue(threshold, fixed);
+}
+
+bool ParameterManager::ZeroCopyFusion() const {
+  return active_ ? zero_copy_fusion_.Value() : zero_copy_fusion_.BestValue();
+}
+
+void ParameterManager::SetZeroCopyFusion(bool value, bool fixed) {
+  zero_copy_fusion_.SetValue(value, fixed);
+}
+
+void ParameterManager::Update(const std::vector<int32_t>& tensor_ids, int64_t bytes) {
   if (!active_) {
     return;
   }
 
-  for (const std::string& tensor_name : tensor_names) {
-    int32_t cycle = tensor_counts_[tensor_name]++;
+  for (int32_t tensor_id : tensor_ids) {
+    if (tensor_id >= (int32_t)tensor_counts_.size()) {
+      tensor_counts_.resize(tensor_id + 1, 0);
+    }
+    int32_t cycle = tensor_counts_[tensor_id]++;
     if (cycle >= (sample_ + 1) * CYCLES_PER_SAMPLE) {
       auto now = std::chrono::steady_clock::now();
       double duration = std::chrono::duration_cast<std::chrono::microseconds>(now - last_sample_start_).count();
@@ -221,12 +281,22 @@ void ParameterManager::SyncParams() {
       params.hierarchical_allgather = hierarchical_allgather_.Value();
       params.tensor_fusion_threshold = joint_params_.Value(fusion_buffer_threshold_mb);
       params.cycle_time = joint_params_.Value(cycle_time_ms);
+      params.allreduce_chunk_bytes = allreduce_chunk_bytes_.Value();
+      params.concurrent_collectives = concurrent_collectives_.Value();
+      params.allreduce_recursive_doubling_bytes = allreduce_recursive_doubling_bytes_.Value();
+      params.allreduce_ring_bytes = allreduce_ring_bytes_.Value();
+      params.zero_copy_fusion = zero_copy_fusion_.Value();
     } else {
       // Tuning has completed, so send the best value.
       params.hierarchical_allreduce = hierarchical_allreduce_.BestValue();
       params.hierarchical_allgather = hierarchical_allgather_.BestValue();
       params.tensor_fusion_threshold = joint_params_.BestValue(fusion_buffer_threshold_mb);
       params.cycle_time = joint_params_.BestValue(cycle_time_ms);
+      params.allreduce_chunk_bytes = allreduce_chunk_bytes_.BestValue();
+      params.concurrent_collectives = concurrent_collectives_.BestValue();
+      params.allreduce_recursive_doubling_bytes = allreduce_recursive_doubling_bytes_.BestValue();
+      params.allreduce_ring_bytes = allreduce_ring_bytes_.BestValue();
+      params.zero_copy_fusion = zero_copy_fusion_.BestValue();
     }
 
     params.active = active_;
@@ -241,6 +311,11 @@ void ParameterManager::SyncParams() {
     hierarchical_allgather_.SetValue(params.hierarchical_allgather, true);
     joint_params_.SetValue(fusion_buffer_threshold_mb, params.tensor_fusion_threshold, true);
     joint_params_.SetValue(cycle_time_ms, params.cycle_time, true);
+    allreduce_chunk_bytes_.SetValue(params.allreduce_chunk_bytes, true);
+    concurrent_collectives_.SetValue(params.concurrent_collectives, true);
+    allreduce_recursive_doubling_bytes_.SetValue(params.allreduce_recursive_doubling_bytes, true);
+    allreduce_ring_bytes_.SetValue(params.allreduce_ring_bytes, true);
+    zero_copy_fusion_.SetValue(params.zero_copy_fusion, true);
     active_ = params.active;
   }
 }
@@ -248,7 +323,7 @@ void ParameterManager::SyncParams() {
 void ParameterManager::Reset() {
   total_bytes_ = 0;
   last_sample_start_ = std::chrono::steady_clock::now();
-  tensor_counts_.clear();
+  std::fill(tensor_counts_.begin(), tensor_counts_.end(), 0);
   sample_ = 0;
 }
 
@@ -258,13 +333,23 @@ void ParameterManager::LogParameters(double score) {
               << hierarchical_allreduce_.Value() << ", "
               << hierarchical_allgather_.Value() << ", "
               << joint_params_.Value(cycle_time_ms) << " ms, "
-              << joint_params_.Value(fusion_buffer_threshold_mb) << " mb] "
+              << joint_params_.Value(fusion_buffer_threshold_mb) << " mb, "
+              << allreduce_chunk_bytes_.Value() << " bytes, "
+              << concurrent_collectives_.Value() << " concurrent, "
+              << allreduce_recursive_doubling_bytes_.Value() << " bytes, "
+              << allreduce_ring_bytes_.Value() << " bytes, "
+              << zero_copy_fusion_.Value() << "] "
               << score;
     if (writing_ && file_.good()) {
       file_ << hierarchical_allreduce_.Value() << ","
             << hierarchical_allgather_.Value() << ","
             << joint_params_.Value(cycle_time_ms) << ","
             << joint_params_.Value(fusion_buffer_threshold_mb) << ","
+            << allreduce_chunk_bytes_.Value() << ","
+            << concurrent_collectives_.Value() << ","
+            << allreduce_recursive_doubling_bytes_.Value() << ","
+            << allreduce_ring_bytes_.Value() << ","
+            << zero_copy_fusion_.Value() << ","
             << score
             << std::endl;
     }
@@ -277,13 +362,23 @@ void ParameterManager::LogBestParameters() {
               << hierarchical_allreduce_.BestValue() << ", "
               << hierarchical_allgather_.BestValue() << ", "
               << joint_params_.BestValue(cycle_time_ms) << " ms, "
-              << joint_params_.BestValue(fusion_buffer_threshold_mb) << " mb] "
+              << joint_params_.BestValue(fusion_buffer_threshold_mb) << " mb, "
+              << allreduce_chunk_bytes_.BestValue() << " bytes, "
+              << concurrent_collectives_.BestValue() << " concurrent, "
+              << allreduce_recursive_doubling_bytes_.BestValue() << " bytes, "
+              << allreduce_ring_bytes_.BestValue() << " bytes, "
+              << zero_copy_fusion_.BestValue() << "] "
               << hierarchical_allreduce_.BestScore();
     if (writing_ && file_.good()) {
       file_ << hierarchical_allreduce_.BestValue() << ","
             << hierarchical_allgather_.BestValue() << ","
             << joint_params_.BestValue(cycle_time_ms) << ","
             << joint_params_.BestValue(fusion_buffer_threshold_mb) << ","
+            << allreduce_chunk_bytes_.BestValue() << ","
+            << concurrent_collectives_.BestValue() << ","
+            << allreduce_recursive_doubling_bytes_.BestValue() << ","
+            << allreduce_ring_bytes_.BestValue() << ","
+            << zero_copy_fusion_.BestValue() << ","
             << hierarchical_allreduce_.BestScore()
             << std::endl;
     }
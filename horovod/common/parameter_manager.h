@@ -62,7 +62,8 @@ public:
     return active_;
   }
 
-  // Do hierarchical allreduce with MPI + NCCL.
+  // Do hierarchical allreduce, with MPI + NCCL on GPU, or through node shared
+  // memory on CPU.
   bool HierarchicalAllreduce() const;
   void SetHierarchicalAllreduce(bool value, bool fixed=false);
 
@@ -80,13 +81,36 @@ public:
   double CycleTimeMs() const;
   void SetCycleTimeMs(double cycle_time_ms, bool fixed=false);
 
+  // Size of the chunks in which fused CPU allreduces are pipelined. Zero
+  // disables pipelining.
+  int64_t AllreduceChunkBytes() const;
+  void SetAllreduceChunkBytes(int64_t chunk_bytes, bool fixed=false);
+
+  // Number of collective operations which may be performed concurrently, each
+  // on its own communicator.
+  int32_t ConcurrentCollectives() const;
+  void SetConcurrentCollectives(int32_t value, bool fixed=false);
+
+  // Crossover points of the native allreduce algorithms. CPU allreduces
+  // smaller than the recursive doubling threshold use recursive doubling,
+  // those of at least the ring threshold use the ring. Zero disables either.
+  int64_t AllreduceRecursiveDoublingBytes() const;
+  void SetAllreduceRecursiveDoublingBytes(int64_t threshold, bool fixed=false);
+  int64_t AllreduceRingBytes() const;
+  void SetAllreduceRingBytes(int64_t threshold, bool fixed=false);
+
+  // Move fused CPU allgathers and broadcasts through derived datatypes
+  // instead of the fusion buffer.
+  bool ZeroCopyFusion() const;
+  void SetZeroCopyFusion(bool value, bool fixed=false);
+
   // Observes that the given tensors have been processed (e.g., allreduced) over the given number of microseconds.
   //
   // Args:
-  //  tensor_names: The names of the tensors that have been processed.
+  //  tensor_ids: The IDs of the tensors that have been processed.
   //  bytes: The number of bytes that were processed per worker.
   //  microseconds: The number of microseconds taken to process the bytes on this worker.
-  void Update(const std::vector<std::string>& tensor_names, int64_t bytes);
+  void Update(const std::vector<int32_t>& tensor_ids, int64_t bytes);
 
 private:
   // Adjusts the parameter values based on the last observed score.
@@ -202,6 +226,11 @@ private:
 
   CategoricalParameter<bool> hierarchical_allreduce_;
   CategoricalParameter<bool> hierarchical_allgather_;
+  CategoricalParameter<int64_t> allreduce_chunk_bytes_;
+  CategoricalParameter<int32_t> concurrent_collectives_;
+  CategoricalParameter<int64_t> allreduce_recursive_doubling_bytes_;
+  CategoricalParameter<int64_t> allreduce_ring_bytes_;
+  CategoricalParameter<bool> zero_copy_fusion_;
   BayesianParameter joint_params_;
 
   std::vector<ITunableParameter*> parameter_chain_;
@@ -214,7 +243,8 @@ private:
 
   int64_t total_bytes_;
   std::chrono::steady_clock::time_point last_sample_start_;
-  std::unordered_map<std::string, int32_t> tensor_counts_;
+  // Number of times each tensor has been processed, indexed by tensor ID.
+  std::vector<int32_t> tensor_counts_;
 
   int32_t rank_;
   int32_t root_rank_;
@@ -226,6 +256,11 @@ private:
     bool hierarchical_allgather;
     double tensor_fusion_threshold;
     double cycle_time;
+    int64_t allreduce_chunk_bytes;
+    int32_t concurrent_collectives;
+    int64_t allreduce_recursive_doubling_bytes;
+    int64_t allreduce_ring_bytes;
+    bool zero_copy_fusion;
     bool active;
   };
 
@@ -0,0 +1,233 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <cassert>
+
+#include "response_cache.h"
+
+namespace horovod {
+namespace common {
+
+#define BITS_PER_WORD 64
+
+// Status flags stored (inverted) in the first word of the bit vector.
+#define SHOULD_SHUT_DOWN_BIT 0
+#define UNCACHED_IN_QUEUE_BIT 1
+
+namespace {
+
+bool SameParameters(const MPIRequest& a, const MPIRequest& b) {
+  return a.request_type() == b.request_type() &&
+         a.tensor_type() == b.tensor_type() && a.device() == b.device() &&
+         a.root_rank() == b.root_rank() &&
+         a.tensor_shape() == b.tensor_shape() &&
+         a.tensor_splits() == b.tensor_splits() &&
+         a.dense_rows() == b.dense_rows() &&
+         a.compression() == b.compression();
+}
+
+} // namespace
+
+void ResponseCache::set_capacity(uint32_t capacity) {
+  clear();
+  capacity_ = capacity;
+}
+
+uint32_t ResponseCache::capacity() const { return capacity_; }
+
+uint32_t ResponseCache::num_active_bits() const {
+  return (uint32_t)entries_.size();
+}
+
+ResponseCache::CacheState
+ResponseCache::cached(const MPIRequest& message) const {
+  auto id = message.tensor_id();
+  if (id < 0 || id >= (int32_t)id_to_bit_.size() || id_to_bit_[id] < 0) {
+    return CacheState::MISS;
+  }
+  auto& entry = entries_[id_to_bit_[id]];
+  return SameParameters(entry.request, message) ? CacheState::HIT
+                                                : CacheState::INVALID;
+}
+
+void ResponseCache::put(const MPIResponse& response,
+                        const MPIRequest& message) {
+  if (capacity_ == 0) {
+    return;
+  }
+  assert(response.tensor_ids().size() == 1 && response.tensor_ids()[0] >= 0);
+  auto id = response.tensor_ids()[0];
+
+  // Replace an existing response for the same tensor in place.
+  if (id >= (int32_t)id_to_bit_.size()) {
+    id_to_bit_.resize(id + 1, -1);
+  }
+  if (id_to_bit_[id] >= 0) {
+    erase_response((uint32_t)id_to_bit_[id]);
+  }
+
+  uint32_t bit;
+  if (!free_bits_.empty()) {
+    bit = free_bits_.back();
+    free_bits_.pop_back();
+  } else if (entries_.size() < capacity_) {
+    bit = (uint32_t)entries_.size();
+    entries_.emplace_back();
+  } else {
+    // Cache is full, evict the least recently used response.
+    bit = lru_.back();
+    erase_response(bit);
+    free_bits_.pop_back();
+  }
+
+  auto& entry = entries_[bit];
+  entry.response = response;
+  entry.request = message;
+  lru_.push_front(bit);
+  entry.lru_iter = lru_.begin();
+  entry.valid = true;
+  id_to_bit_[id] = bit;
+}
+
+const MPIResponse& ResponseCache::get_response(uint32_t cache_bit) {
+  assert(cache_bit < entries_.size() && entries_[cache_bit].valid);
+  auto& entry = entries_[cache_bit];
+  lru_.splice(lru_.begin(), lru_, entry.lru_iter);
+  return entry.response;
+}
+
+uint32_t ResponseCache::peek_cache_bit(int32_t tensor_id) const {
+  assert(tensor_id >= 0 && tensor_id < (int32_t)id_to_bit_.size() &&
+         id_to_bit_[tensor_id] >= 0);
+  return (uint32_t)id_to_bit_[tensor_id];
+}
+
+void ResponseCache::erase_response(uint32_t cache_bit) {
+  assert(cache_bit < entries_.size());
+  auto& entry = entries_[cache_bit];
+  if (!entry.valid) {
+    return;
+  }
+  id_to_bit_[entry.response.tensor_ids()[0]] = -1;
+  lru_.erase(entry.lru_iter);
+  entry.response = MPIResponse();
+  entry.request = MPIRequest();
+  entry.valid = false;
+  free_bits_.push_back(cache_bit);
+}
+
+void ResponseCache::clear() {
+  entries_.clear();
+  free_bits_.clear();
+  lru_.clear();
+  id_to_bit_.clear();
+}
+
+CacheCoordinator::CacheCoordinator(uint32_t num_active_bits) {
+  reset(num_active_bits);
+}
+
+void CacheCoordinator::reset(uint32_t num_active_bits) {
+  num_active_bits_ = num_active_bits;
+  num_words_ = (num_active_bits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  bitvector_.assign(1 + 2 * num_words_, 0);
+  // Inverted fields start out as "not set".
+  bitvector_[0] = ~0ULL;
+  for (uint32_t i = 0; i < num_words_; ++i) {
+    bitvector_[1 + num_words_ + i] = ~0ULL;
+  }
+  cache_hits_.clear();
+  invalid_bits_.clear();
+  should_shut_down_ = false;
+  uncached_in_queue_ = false;
+  synced_ = false;
+}
+
+void CacheCoordinator::record_hit(uint32_t bit) {
+  assert(bit < num_active_bits_);
+  bitvector_[1 + bit / BITS_PER_WORD] |= 1ULL << (bit % BITS_PER_WORD);
+}
+
+void CacheCoordinator::record_invalid_bit(uint32_t bit) {
+  assert(bit < num_active_bits_);
+  bitvector_[1 + num_words_ + bit / BITS_PER_WORD] &=
+      ~(1ULL << (bit % BITS_PER_WORD));
+}
+
+void CacheCoordinator::set_should_shut_down(bool value) {
+  if (value) {
+    bitvector_[0] &= ~(1ULL << SHOULD_SHUT_DOWN_BIT);
+  }
+}
+
+void CacheCoordinator::set_uncached_in_queue(bool value) {
+  if (value) {
+    bitvector_[0] &= ~(1ULL << UNCACHED_IN_QUEUE_BIT);
+  }
+}
+
+void CacheCoordinator::sync(MPI_Comm comm) {
+  MPI_Request request;
+  start_sync(comm, &request);
+  MPI_Wait(&request, MPI_STATUS_IGNORE);
+  finish_sync();
+}
+
+void CacheCoordinator::start_sync(MPI_Comm comm, MPI_Request* request) {
+  assert(!synced_);
+  MPI_Iallreduce(MPI_IN_PLACE, bitvector_.data(), (int)bitvector_.size(),
+                 MPI_UINT64_T, MPI_BAND, comm, request);
+}
+
+void CacheCoordinator::finish_sync() {
+  assert(!synced_);
+
+  should_shut_down_ = (bitvector_[0] & (1ULL << SHOULD_SHUT_DOWN_BIT)) == 0;
+  uncached_in_queue_ = (bitvector_[0] & (1ULL << UNCACHED_IN_QUEUE_BIT)) == 0;
+
+  for (uint32_t bit = 0; bit < num_active_bits_; ++bit) {
+    uint64_t mask = 1ULL << (bit % BITS_PER_WORD);
+    if (bitvector_[1 + bit / BITS_PER_WORD] & mask) {
+      cache_hits_.push_back(bit);
+    }
+    if ((bitvector_[1 + num_words_ + bit / BITS_PER_WORD] & mask) == 0) {
+      invalid_bits_.push_back(bit);
+    }
+  }
+  synced_ = true;
+}
+
+const std::vector<uint32_t>& CacheCoordinator::cache_hits() const {
+  assert(synced_);
+  return cache_hits_;
+}
+
+const std::vector<uint32_t>& CacheCoordinator::invalid_bits() const {
+  assert(synced_);
+  return invalid_bits_;
+}
+
+bool CacheCoordinator::should_shut_down() const {
+  assert(synced_);
+  return should_shut_down_;
+}
+
+bool CacheCoordinator::uncached_in_queue() const {
+  assert(synced_);
+  return uncached_in_queue_;
+}
+
+} // namespace common
+} // namespace horovod
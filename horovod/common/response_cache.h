@@ -0,0 +1,146 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_RESPONSE_CACHE_H
+#define HOROVOD_RESPONSE_CACHE_H
+
+#include <list>
+#include <vector>
+
+#define OMPI_SKIP_MPICXX
+#include "mpi.h"
+#include "mpi_message.h"
+
+namespace horovod {
+namespace common {
+
+// ResponseCache stores single-tensor MPIResponses constructed in previous
+// cycles, so that a tensor requested again with the same parameters can skip
+// the full negotiation through the coordinator.
+//
+// Every rank holds its own copy of the cache. Each cached response occupies a
+// slot, and the index of that slot (the "cache bit") identifies the tensor in
+// the bit vectors exchanged by CacheCoordinator. All modifications to the
+// cache (put, erase and LRU updates) are driven by information which is
+// identical on every rank, so the caches stay consistent across ranks without
+// any additional communication.
+class ResponseCache {
+public:
+  enum CacheState { MISS = 0, HIT = 1, INVALID = 2 };
+
+  void set_capacity(uint32_t capacity);
+  uint32_t capacity() const;
+
+  // Number of cache bits handed out so far. Bits are never renumbered, so this
+  // is also the number of bits that need to be exchanged between ranks.
+  uint32_t num_active_bits() const;
+
+  // Returns HIT if a response for the tensor is cached and was created for a
+  // request with identical parameters, INVALID if the tensor is cached with
+  // different parameters, and MISS otherwise. Tensors without an ID are never
+  // cached.
+  CacheState cached(const MPIRequest& message) const;
+
+  // Stores a single-tensor response together with the local request it
+  // answers. Evicts the least recently used response if the cache is full.
+  // The tensor must have an ID.
+  void put(const MPIResponse& response, const MPIRequest& message);
+
+  // Returns the response cached under the given bit and marks it as the most
+  // recently used one.
+  const MPIResponse& get_response(uint32_t cache_bit);
+
+  // Returns the cache bit of a tensor that is known to be cached.
+  uint32_t peek_cache_bit(int32_t tensor_id) const;
+
+  void erase_response(uint32_t cache_bit);
+
+  void clear();
+
+private:
+  struct CacheEntry {
+    MPIResponse response;
+    MPIRequest request;
+    std::list<uint32_t>::iterator lru_iter;
+    bool valid = false;
+  };
+
+  uint32_t capacity_ = 0;
+
+  // Cached entries, indexed by cache bit.
+  std::vector<CacheEntry> entries_;
+
+  // Bits of erased entries, available for reuse.
+  std::vector<uint32_t> free_bits_;
+
+  // Cache bits ordered from the most to the least recently used.
+  std::list<uint32_t> lru_;
+
+  // Cache bits indexed by tensor ID, -1 for tensors that are not cached.
+  std::vector<int64_t> id_to_bit_;
+};
+
+// CacheCoordinator collects the cache state of this rank for one cycle and
+// synchronizes it with all other ranks using a single MPI_Allreduce(MPI_BAND).
+//
+// Hit bits survive the reduction only if the tensor was a cache hit on every
+// rank. Invalid bits and status flags are stored inverted, so that the bitwise
+// AND yields whether they were set on any rank.
+class CacheCoordinator {
+public:
+  explicit CacheCoordinator(uint32_t num_active_bits = 0);
+
+  // Starts over for a new cycle with the given number of active bits. The
+  // buffers of the bit vector and of the synced bits are kept.
+  void reset(uint32_t num_active_bits);
+
+  void record_hit(uint32_t bit);
+  void record_invalid_bit(uint32_t bit);
+  void set_should_shut_down(bool value);
+  void set_uncached_in_queue(bool value);
+
+  void sync(MPI_Comm comm);
+
+  // Non-blocking variant of sync(). finish_sync() must be called once the
+  // request has completed.
+  void start_sync(MPI_Comm comm, MPI_Request* request);
+  void finish_sync();
+
+  // Valid after sync(). Bits are sorted in ascending order, so every rank
+  // processes them in the same order.
+  const std::vector<uint32_t>& cache_hits() const;
+  const std::vector<uint32_t>& invalid_bits() const;
+  bool should_shut_down() const;
+  bool uncached_in_queue() const;
+
+private:
+  uint32_t num_active_bits_ = 0;
+  uint32_t num_words_ = 0;
+
+  // Layout: one status word, followed by num_words_ words of hit bits and
+  // num_words_ words of inverted invalid bits.
+  std::vector<uint64_t> bitvector_;
+
+  std::vector<uint32_t> cache_hits_;
+  std::vector<uint32_t> invalid_bits_;
+  bool should_shut_down_ = false;
+  bool uncached_in_queue_ = false;
+  bool synced_ = false;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_RESPONSE_CACHE_H
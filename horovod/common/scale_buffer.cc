@@ -0,0 +1,256 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if __AVX__ && __F16C__
+#include <immintrin.h>
+#endif
+#if __AVX512F__
+#include <cpuid.h>
+#endif
+
+#include "half.h"
+#include "scale_buffer.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+template <typename T>
+void ScaleInteger(const T* src, T* dst, int64_t num_elements, double factor) {
+  double divisor = 1.0 / factor;
+  if (divisor >= 1.0 && divisor == std::floor(divisor)) {
+    auto int_divisor = (int64_t)divisor;
+    for (int64_t i = 0; i < num_elements; ++i) {
+      dst[i] = (T)(src[i] / int_divisor);
+    }
+  } else {
+    for (int64_t i = 0; i < num_elements; ++i) {
+      dst[i] = (T)(src[i] * factor);
+    }
+  }
+}
+
+void ScaleFloat(const float* src, float* dst, int64_t num_elements,
+                double factor) {
+  auto float_factor = (float)factor;
+  int64_t i = 0;
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    __m256 factor_m256 = _mm256_set1_ps(float_factor);
+    for (; i < (num_elements / 8) * 8; i += 8) {
+      _mm256_storeu_ps(dst + i,
+                       _mm256_mul_ps(_mm256_loadu_ps(src + i), factor_m256));
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    dst[i] = src[i] * float_factor;
+  }
+}
+
+void ScaleDouble(const double* src, double* dst, int64_t num_elements,
+                 double factor) {
+  int64_t i = 0;
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    __m256d factor_m256d = _mm256_set1_pd(factor);
+    for (; i < (num_elements / 4) * 4; i += 4) {
+      _mm256_storeu_pd(dst + i,
+                       _mm256_mul_pd(_mm256_loadu_pd(src + i), factor_m256d));
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    dst[i] = src[i] * factor;
+  }
+}
+
+void ScaleFloat16(const unsigned short* src, unsigned short* dst,
+                  int64_t num_elements, double factor) {
+  auto float_factor = (float)factor;
+  int64_t i = 0;
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    __m256 factor_m256 = _mm256_set1_ps(float_factor);
+    for (; i < (num_elements / 8) * 8; i += 8) {
+      __m256 src_m256 = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)(src + i)));
+      __m128i dst_m128i =
+          _mm256_cvtps_ph(_mm256_mul_ps(src_m256, factor_m256), 0);
+      _mm_storeu_si128((__m128i*)(dst + i), dst_m128i);
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    float value;
+    HalfBits2Float(const_cast<unsigned short*>(src + i), &value);
+    value *= float_factor;
+    Float2HalfBits(&value, dst + i);
+  }
+}
+
+#if __AVX512F__
+// Query CPUID to determine AVX-512 runtime support.
+bool is_avx512f() {
+  static bool initialized = false;
+  static bool result = false;
+  if (!initialized) {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+      result = (ebx & bit_AVX512F) != 0;
+    }
+    initialized = true;
+  }
+  return result;
+}
+#endif
+
+} // namespace
+
+void ScaleBuffer(const void* src, void* dst, int64_t num_elements,
+                 MPIDataType dtype, double factor) {
+  switch (dtype) {
+  case HOROVOD_UINT8:
+    ScaleInteger((const uint8_t*)src, (uint8_t*)dst, num_elements, factor);
+    break;
+  case HOROVOD_INT8:
+    ScaleInteger((const int8_t*)src, (int8_t*)dst, num_elements, factor);
+    break;
+  case HOROVOD_UINT16:
+    ScaleInteger((const uint16_t*)src, (uint16_t*)dst, num_elements, factor);
+    break;
+  case HOROVOD_INT16:
+    ScaleInteger((const int16_t*)src, (int16_t*)dst, num_elements, factor);
+    break;
+  case HOROVOD_INT32:
+    ScaleInteger((const int32_t*)src, (int32_t*)dst, num_elements, factor);
+    break;
+  case HOROVOD_INT64:
+    ScaleInteger((const int64_t*)src, (int64_t*)dst, num_elements, factor);
+    break;
+  case HOROVOD_FLOAT16:
+    ScaleFloat16((const unsigned short*)src, (unsigned short*)dst,
+                 num_elements, factor);
+    break;
+  case HOROVOD_FLOAT32:
+    ScaleFloat((const float*)src, (float*)dst, num_elements, factor);
+    break;
+  case HOROVOD_FLOAT64:
+    ScaleDouble((const double*)src, (double*)dst, num_elements, factor);
+    break;
+  default:
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
+                           " cannot be scaled.");
+  }
+}
+
+void ScaledCopy(const void* src, void* dst, int64_t num_bytes,
+                MPIDataType dtype, double factor) {
+  if (factor == 1.0) {
+    if (src != dst) {
+      std::memcpy(dst, src, (size_t)num_bytes);
+    }
+    return;
+  }
+  int element_size;
+  switch (dtype) {
+  case HOROVOD_UINT8:
+  case HOROVOD_INT8:
+  case HOROVOD_BOOL:
+    element_size = 1;
+    break;
+  case HOROVOD_UINT16:
+  case HOROVOD_INT16:
+  case HOROVOD_FLOAT16:
+    element_size = 2;
+    break;
+  case HOROVOD_INT32:
+  case HOROVOD_FLOAT32:
+    element_size = 4;
+    break;
+  default:
+    element_size = 8;
+    break;
+  }
+  ScaleBuffer(src, dst, num_bytes / element_size, dtype, factor);
+}
+
+void ScaledCopyToFloat16(const float* src, unsigned short* dst,
+                         int64_t num_elements, double factor) {
+  auto float_factor = (float)factor;
+  int64_t i = 0;
+#if __AVX512F__
+  if (is_avx512f()) {
+    __m512 factor_m512 = _mm512_set1_ps(float_factor);
+    for (; i < (num_elements / 16) * 16; i += 16) {
+      __m256i dst_m256i = _mm512_cvtps_ph(
+          _mm512_mul_ps(_mm512_loadu_ps(src + i), factor_m512),
+          _MM_FROUND_TO_NEAREST_INT);
+      _mm256_storeu_si256((__m256i*)(dst + i), dst_m256i);
+    }
+  }
+#endif
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    __m256 factor_m256 = _mm256_set1_ps(float_factor);
+    for (; i < (num_elements / 8) * 8; i += 8) {
+      __m128i dst_m128i = _mm256_cvtps_ph(
+          _mm256_mul_ps(_mm256_loadu_ps(src + i), factor_m256), 0);
+      _mm_storeu_si128((__m128i*)(dst + i), dst_m128i);
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    float value = src[i] * float_factor;
+    Float2HalfBits(&value, dst + i);
+  }
+}
+
+void ScaledCopyFromFloat16(const unsigned short* src, float* dst,
+                           int64_t num_elements, double factor) {
+  auto float_factor = (float)factor;
+  int64_t i = 0;
+#if __AVX512F__
+  if (is_avx512f()) {
+    __m512 factor_m512 = _mm512_set1_ps(float_factor);
+    for (; i < (num_elements / 16) * 16; i += 16) {
+      __m512 src_m512 =
+          _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)(src + i)));
+      _mm512_storeu_ps(dst + i, _mm512_mul_ps(src_m512, factor_m512));
+    }
+  }
+#endif
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    __m256 factor_m256 = _mm256_set1_ps(float_factor);
+    for (; i < (num_elements / 8) * 8; i += 8) {
+      __m256 src_m256 =
+          _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i)));
+      _mm256_storeu_ps(dst + i, _mm256_mul_ps(src_m256, factor_m256));
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    HalfBits2Float(const_cast<unsigned short*>(src + i), dst + i);
+    dst[i] *= float_factor;
+  }
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,53 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_SCALE_BUFFER_H
+#define HOROVOD_SCALE_BUFFER_H
+
+#include <stdint.h>
+
+#include "mpi_message.h"
+
+namespace horovod {
+namespace common {
+
+// Writes num_elements elements of src multiplied by factor to dst, which may
+// be the same buffer as src. Floating point types are scaled with AVX when
+// the CPU supports it, and float16 is scaled in float32. Integers are divided
+// by the reciprocal of the factor when it is a whole number, which keeps
+// averages of integer tensors exact and truncates like integer division.
+void ScaleBuffer(const void* src, void* dst, int64_t num_elements,
+                 MPIDataType dtype, double factor);
+
+// Copies num_bytes bytes from src to dst, multiplied by factor unless it is
+// one.
+void ScaledCopy(const void* src, void* dst, int64_t num_bytes,
+                MPIDataType dtype, double factor);
+
+// Converts num_elements float32 elements of src multiplied by factor to
+// float16 in dst, rounding to nearest even. Uses AVX-512 when it is compiled
+// in and supported by the CPU, and F16C otherwise.
+void ScaledCopyToFloat16(const float* src, unsigned short* dst,
+                         int64_t num_elements, double factor);
+
+// Converts num_elements float16 elements of src to float32 in dst, multiplied
+// by factor.
+void ScaledCopyFromFloat16(const unsigned short* src, float* dst,
+                           int64_t num_elements, double factor);
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_SCALE_BUFFER_H
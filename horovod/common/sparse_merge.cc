@@ -0,0 +1,118 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <cstring>
+
+#include "allreduce_engine.h"
+#include "sparse_merge.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+// Bits of the index sorted by every pass of the radix sort. The counts of a
+// pass fit in the L1 cache.
+const int RADIX_BITS = 11;
+const int64_t RADIX_BUCKETS = 1 << RADIX_BITS;
+
+// Below this number of rows, a comparison sort is faster than the passes of
+// the radix sort.
+const size_t COMPARISON_SORT_ROWS = 256;
+
+// Rows ahead of the current one whose data is prefetched while merging.
+const size_t PREFETCH_DISTANCE = 4;
+
+} // namespace
+
+int64_t SparseRowMerger::Sort(const std::vector<int64_t>& indices) {
+  size_t num_rows = indices.size();
+  sorted_.resize(num_rows);
+  int64_t max_index = 0;
+  for (size_t i = 0; i < num_rows; ++i) {
+    sorted_[i] = std::make_pair(indices[i], (int64_t)i);
+    max_index = std::max(max_index, indices[i]);
+  }
+
+  if (num_rows < COMPARISON_SORT_ROWS) {
+    // Pairs compare by index, then by position.
+    std::sort(sorted_.begin(), sorted_.end());
+  } else {
+    // Least significant digit first. Every pass is stable, so rows with the
+    // same index stay in the order of their positions.
+    scratch_.resize(num_rows);
+    std::vector<int64_t> counts(RADIX_BUCKETS);
+    for (int shift = 0;
+         shift < 64 && (shift == 0 || (max_index >> shift) > 0);
+         shift += RADIX_BITS) {
+      std::fill(counts.begin(), counts.end(), 0);
+      for (auto& row : sorted_) {
+        ++counts[(row.first >> shift) & (RADIX_BUCKETS - 1)];
+      }
+      int64_t offset = 0;
+      for (auto& count : counts) {
+        int64_t bucket_rows = count;
+        count = offset;
+        offset += bucket_rows;
+      }
+      for (auto& row : sorted_) {
+        scratch_[counts[(row.first >> shift) & (RADIX_BUCKETS - 1)]++] = row;
+      }
+      sorted_.swap(scratch_);
+    }
+  }
+
+  num_unique_ = 0;
+  for (size_t i = 0; i < num_rows; ++i) {
+    if (i == 0 || sorted_[i].first != sorted_[i - 1].first) {
+      ++num_unique_;
+    }
+  }
+  return num_unique_;
+}
+
+void SparseRowMerger::Merge(const std::vector<const void*>& rows,
+                            int64_t row_elements, int64_t row_bytes,
+                            MPIDataType dtype, void* values,
+                            void* unique_indices,
+                            MPIDataType index_dtype) const {
+  int64_t u = -1;
+  uint8_t* output_row = nullptr;
+  for (size_t i = 0; i < sorted_.size(); ++i) {
+#if defined(__GNUC__)
+    if (i + PREFETCH_DISTANCE < sorted_.size()) {
+      __builtin_prefetch(rows[sorted_[i + PREFETCH_DISTANCE].second]);
+    }
+#endif
+    auto index = sorted_[i].first;
+    auto row = rows[sorted_[i].second];
+    if (i == 0 || index != sorted_[i - 1].first) {
+      ++u;
+      if (index_dtype == HOROVOD_INT32) {
+        ((int32_t*)unique_indices)[u] = (int32_t)index;
+      } else {
+        ((int64_t*)unique_indices)[u] = index;
+      }
+      output_row = (uint8_t*)values + u * row_bytes;
+      std::memcpy(output_row, row, (size_t)row_bytes);
+    } else {
+      SumBuffer(row, output_row, row_elements, dtype);
+    }
+  }
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,58 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_SPARSE_MERGE_H
+#define HOROVOD_SPARSE_MERGE_H
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "mpi_message.h"
+
+namespace horovod {
+namespace common {
+
+// Sums the rows of sparse tensors gathered from all ranks which have the same
+// index. Only the indices and the positions of the rows are sorted, with a
+// radix sort, and every row is then read once and added to its output row,
+// which is written in order. The buffers are kept across tensors.
+class SparseRowMerger {
+public:
+  // Sort the indices of the rows, which must not be negative, and return the
+  // number of distinct ones. Rows with the same index keep the order they are
+  // given in, so that every rank sums them in the same order and gets the
+  // same result.
+  int64_t Sort(const std::vector<int64_t>& indices);
+
+  // Write the distinct indices of the last sort in increasing order to
+  // unique_indices, as index_dtype (HOROVOD_INT32 or HOROVOD_INT64), and the
+  // sum of the rows of every index to values. rows[i] points to the row of
+  // indices[i], row_elements elements of dtype taking row_bytes bytes.
+  void Merge(const std::vector<const void*>& rows, int64_t row_elements,
+             int64_t row_bytes, MPIDataType dtype, void* values,
+             void* unique_indices, MPIDataType index_dtype) const;
+
+private:
+  // Indices and positions of the rows, sorted by index and position.
+  std::vector<std::pair<int64_t, int64_t>> sorted_;
+  std::vector<std::pair<int64_t, int64_t>> scratch_;
+  int64_t num_unique_ = 0;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_SPARSE_MERGE_H
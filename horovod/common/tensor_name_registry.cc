@@ -0,0 +1,52 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <cassert>
+
+#include "tensor_name_registry.h"
+
+namespace horovod {
+namespace common {
+
+int32_t TensorNameRegistry::Lookup(const std::string& name) const {
+  auto it = ids_.find(name);
+  return it != ids_.end() ? it->second : -1;
+}
+
+int32_t TensorNameRegistry::Register(const std::string& name) {
+  auto it = ids_.find(name);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  auto id = (int32_t)names_.size();
+  names_.push_back(name);
+  ids_.emplace(name, id);
+  return id;
+}
+
+const std::string& TensorNameRegistry::Name(int32_t id) const {
+  assert(id >= 0 && id < (int32_t)names_.size());
+  return names_[id];
+}
+
+int32_t TensorNameRegistry::size() const { return (int32_t)names_.size(); }
+
+void TensorNameRegistry::Clear() {
+  names_.clear();
+  ids_.clear();
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,60 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_TENSOR_NAME_REGISTRY_H
+#define HOROVOD_TENSOR_NAME_REGISTRY_H
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace horovod {
+namespace common {
+
+// TensorNameRegistry interns tensor names into dense 32-bit IDs, starting
+// from zero.
+//
+// Names are registered in the order in which tensors appear in the response
+// lists broadcast by the coordinator. Since every rank processes the same
+// response lists in the same order, all ranks assign the same IDs to the same
+// tensors without exchanging them.
+class TensorNameRegistry {
+public:
+  // Returns the ID of the tensor, or -1 if the name is not registered.
+  int32_t Lookup(const std::string& name) const;
+
+  // Returns the ID of the tensor, registering the name if necessary.
+  int32_t Register(const std::string& name);
+
+  // Returns the name of a registered tensor, which stays in place until the
+  // registry is cleared.
+  const std::string& Name(int32_t id) const;
+
+  int32_t size() const;
+
+  void Clear();
+
+private:
+  // Names indexed by ID. References to the names stay valid while more names
+  // are registered.
+  std::deque<std::string> names_;
+
+  std::unordered_map<std::string, int32_t> ids_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_TENSOR_NAME_REGISTRY_H
@@ -181,79 +181,126 @@ void Timeline::WriteMarker(const std::string& name) {
   writer_.EnqueueWriteMarker(name, ts_micros);
 }
 
-void Timeline::NegotiateStart(const std::string& tensor_name,
+TimelineState& Timeline::State(int32_t tensor_id,
+                               const std::string& tensor_name) {
+  if (tensor_id < 0) {
+    return pending_tensor_states_[tensor_name];
+  }
+  if (tensor_id >= (int32_t)tensor_states_.size()) {
+    tensor_states_.resize(tensor_id + 1, TimelineState::UNKNOWN);
+  }
+  return tensor_states_[tensor_id];
+}
+
+void Timeline::ClearState(int32_t tensor_id, const std::string& tensor_name) {
+  if (tensor_id < 0) {
+    pending_tensor_states_.erase(tensor_name);
+  } else if (tensor_id < (int32_t)tensor_states_.size()) {
+    tensor_states_[tensor_id] = TimelineState::UNKNOWN;
+  }
+}
+
+void Timeline::NegotiateStart(int32_t tensor_id,
+                              const std::string& tensor_name,
                               const MPIRequest::RequestType request_type) {
   if (!initialized_) {
     return;
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
-  assert(tensor_states_[tensor_name] == TimelineState::UNKNOWN);
+  auto& state = State(tensor_id, tensor_name);
+  assert(state == TimelineState::UNKNOWN);
   auto event_category =
       "NEGOTIATE_" + MPIRequest::RequestType_Name(request_type);
   WriteEvent(tensor_name, 'B', event_category);
-  tensor_states_[tensor_name] = TimelineState::NEGOTIATING;
+  state = TimelineState::NEGOTIATING;
 }
 
-void Timeline::NegotiateRankReady(const std::string& tensor_name,
+void Timeline::NegotiateRankReady(int32_t tensor_id,
+                                  const std::string& tensor_name,
                                   const int rank) {
   if (!initialized_) {
     return;
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
-  assert(tensor_states_[tensor_name] == TimelineState::NEGOTIATING);
+  assert(State(tensor_id, tensor_name) == TimelineState::NEGOTIATING);
   WriteEvent(tensor_name, 'X', rank_strings_[rank]);
 }
 
-void Timeline::NegotiateEnd(const std::string& tensor_name) {
+void Timeline::NegotiateEnd(int32_t tensor_id,
+                            const std::string& tensor_name) {
   if (!initialized_) {
     return;
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
-  assert(tensor_states_[tensor_name] == TimelineState::NEGOTIATING);
+  assert(State(tensor_id, tensor_name) == TimelineState::NEGOTIATING);
   WriteEvent(tensor_name, 'E');
-  tensor_states_.erase(tensor_name);
+  ClearState(tensor_id, tensor_name);
 }
 
-void Timeline::Start(const std::string& tensor_name,
+void Timeline::Start(int32_t tensor_id, const std::string& tensor_name,
                      const MPIResponse::ResponseType response_type) {
   if (!initialized_) {
     return;
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
-  assert(tensor_states_[tensor_name] == TimelineState::UNKNOWN);
+  auto& state = State(tensor_id, tensor_name);
+  assert(state == TimelineState::UNKNOWN);
   auto event_category = MPIResponse::ResponseType_Name(response_type);
   WriteEvent(tensor_name, 'B', event_category);
-  tensor_states_[tensor_name] = TimelineState::TOP_LEVEL;
+  state = TimelineState::TOP_LEVEL;
 }
 
-void Timeline::ActivityStart(const std::string& tensor_name,
+void Timeline::ActivityStart(int32_t tensor_id, const std::string& tensor_name,
                              const std::string& activity) {
   if (!initialized_) {
     return;
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
-  assert(tensor_states_[tensor_name] == TimelineState::TOP_LEVEL);
+  auto& state = State(tensor_id, tensor_name);
+  assert(state == TimelineState::TOP_LEVEL);
   WriteEvent(tensor_name, 'B', activity);
-  tensor_states_[tensor_name] = TimelineState::ACTIVITY;
+  state = TimelineState::ACTIVITY;
 }
 
-void Timeline::ActivityEnd(const std::string& tensor_name) {
+void Timeline::ActivityEnd(int32_t tensor_id, const std::string& tensor_name) {
   if (!initialized_) {
     return;
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
-  assert(tensor_states_[tensor_name] == TimelineState::ACTIVITY);
+  auto& state = State(tensor_id, tensor_name);
+  assert(state == TimelineState::ACTIVITY);
   WriteEvent(tensor_name, 'E');
-  tensor_states_[tensor_name] = TimelineState::TOP_LEVEL;
+  state = TimelineState::TOP_LEVEL;
+}
+
+void Timeline::ActivityEnd(
+    int32_t tensor_id, const std::string& tensor_name,
+    const std::vector<std::pair<std::string, double>>& values) {
+  if (!initialized_) {
+    return;
+  }
+
+  std::stringstream args;
+  for (auto& value : values) {
+    if (args.tellp() > 0) {
+      args << ", ";
+    }
+    args << "\"" << value.first << "\": " << value.second;
+  }
+  std::lock_guard<std::recursive_mutex> guard(mutex_);
+  auto& state = State(tensor_id, tensor_name);
+  assert(state == TimelineState::ACTIVITY);
+  WriteEvent(tensor_name, 'E', "", args.str());
+  state = TimelineState::TOP_LEVEL;
 }
 
-void Timeline::End(const std::string& tensor_name,
+void Timeline::End(int32_t tensor_id, const std::string& tensor_name,
                    const std::shared_ptr<Tensor> tensor) {
   if (!initialized_) {
     return;
@@ -262,8 +309,8 @@ void Timeline::End(const std::string& tensor_name,
   std::lock_guard<std::recursive_mutex> guard(mutex_);
 
   // Pop out of current state, if applicable.
-  if (tensor_states_[tensor_name] == TimelineState::ACTIVITY) {
-    ActivityEnd(tensor_name);
+  if (State(tensor_id, tensor_name) == TimelineState::ACTIVITY) {
+    ActivityEnd(tensor_id, tensor_name);
   }
 
   std::stringstream args;
@@ -272,6 +319,7 @@ void Timeline::End(const std::string& tensor_name,
     args << ", \"shape\": \"" << tensor->shape().DebugString() << "\"";
   }
   WriteEvent(tensor_name, 'E', "", args.str());
+  ClearState(tensor_id, tensor_name);
 }
 
 void Timeline::MarkCycleStart() {
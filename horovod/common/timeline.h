@@ -76,23 +76,35 @@ enum TimelineState { UNKNOWN, NEGOTIATING, TOP_LEVEL, ACTIVITY };
 
 // Writes timeline in Chrome Tracing format. Timeline spec is from:
 // https://github.com/catapult-project/catapult/tree/master/tracing
+//
+// Tensors are identified by their ID, or by their name if it is not
+// registered yet (tensor_id < 0).
 class Timeline {
 public:
   void Initialize(std::string file_name, unsigned int horovod_size);
   inline bool Initialized() const { return initialized_; }
-  void NegotiateStart(const std::string& tensor_name,
+  void NegotiateStart(int32_t tensor_id, const std::string& tensor_name,
                       MPIRequest::RequestType request_type);
-  void NegotiateRankReady(const std::string& tensor_name, int rank);
-  void NegotiateEnd(const std::string& tensor_name);
-  void Start(const std::string& tensor_name,
+  void NegotiateRankReady(int32_t tensor_id, const std::string& tensor_name,
+                          int rank);
+  void NegotiateEnd(int32_t tensor_id, const std::string& tensor_name);
+  void Start(int32_t tensor_id, const std::string& tensor_name,
              MPIResponse::ResponseType response_type);
-  void ActivityStart(const std::string& tensor_name,
+  void ActivityStart(int32_t tensor_id, const std::string& tensor_name,
                      const std::string& activity);
-  void ActivityEnd(const std::string& tensor_name);
-  void End(const std::string& tensor_name, std::shared_ptr<Tensor> tensor);
+  void ActivityEnd(int32_t tensor_id, const std::string& tensor_name);
+  // Ends the activity and records the given values in its arguments.
+  void ActivityEnd(int32_t tensor_id, const std::string& tensor_name,
+                   const std::vector<std::pair<std::string, double>>& values);
+  void End(int32_t tensor_id, const std::string& tensor_name,
+           std::shared_ptr<Tensor> tensor);
   void MarkCycleStart();
 
 private:
+  // Returns the state of the tensor, UNKNOWN if it has none.
+  TimelineState& State(int32_t tensor_id, const std::string& tensor_name);
+  void ClearState(int32_t tensor_id, const std::string& tensor_name);
+
   long TimeSinceStartMicros() const;
   void WriteEvent(const std::string& tensor_name, char phase,
                   const std::string& op_name = "",
@@ -112,8 +124,10 @@ private:
   // A mutex that guards timeline state from concurrent access.
   std::recursive_mutex mutex_;
 
-  // Current state of each tensor in the timeline.
-  std::unordered_map<std::string, TimelineState> tensor_states_;
+  // Current state of each tensor in the timeline, indexed by ID, and of
+  // tensors without an ID by name.
+  std::vector<TimelineState> tensor_states_;
+  std::unordered_map<std::string, TimelineState> pending_tensor_states_;
 
   // Map of ranks to their string representations.
   // std::to_string() is very slow.
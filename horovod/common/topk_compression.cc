@@ -0,0 +1,179 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+#if __AVX__ && __F16C__
+#include <immintrin.h>
+#endif
+
+#include "half.h"
+#include "topk_compression.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+// Magnitudes sampled to estimate the threshold. Smaller tensors are not
+// sampled, and all their elements are candidates.
+const int64_t TOPK_SAMPLES = 4096;
+
+// Collect the positions of the elements of data whose magnitude is at least
+// threshold into candidates, in increasing order, and return their number.
+int64_t CollectCandidates(const float* data, int64_t num_elements,
+                          float threshold, uint32_t* candidates) {
+  int64_t count = 0;
+  int64_t i = 0;
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    // Most blocks of 8 elements hold no candidate, and are skipped after a
+    // single comparison.
+    __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 threshold_m256 = _mm256_set1_ps(threshold);
+    for (; i < (num_elements / 8) * 8; i += 8) {
+      __m256 magnitude = _mm256_and_ps(_mm256_loadu_ps(data + i), abs_mask);
+      int mask = _mm256_movemask_ps(
+          _mm256_cmp_ps(magnitude, threshold_m256, _CMP_GE_OQ));
+      while (mask != 0) {
+        candidates[count++] = (uint32_t)(i + __builtin_ctz(mask));
+        mask &= mask - 1;
+      }
+    }
+  }
+#endif
+  for (; i < num_elements; ++i) {
+    candidates[count] = (uint32_t)i;
+    count += std::fabs(data[i]) >= threshold ? 1 : 0;
+  }
+  return count;
+}
+
+} // namespace
+
+int64_t TopkElements(int64_t num_elements, double ratio) {
+  auto k = (int64_t)std::ceil(ratio * (double)num_elements);
+  return std::min(num_elements, std::max(k, (int64_t)1));
+}
+
+void TopkResidualStore::set_capacity(uint32_t capacity) {
+  Clear();
+  std::lock_guard<std::mutex> guard(mutex_);
+  capacity_ = capacity;
+}
+
+std::shared_ptr<std::vector<float>>
+TopkResidualStore::Get(int32_t tensor_id, int64_t num_elements) {
+  assert(tensor_id >= 0);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (capacity_ == 0) {
+    return std::make_shared<std::vector<float>>((size_t)num_elements, 0.0f);
+  }
+  if (tensor_id >= (int32_t)residuals_.size()) {
+    residuals_.resize(tensor_id + 1);
+  }
+  auto& residual = residuals_[tensor_id];
+  if (residual.values != nullptr) {
+    lru_.splice(lru_.begin(), lru_, residual.lru_iter);
+  } else {
+    if (lru_.size() >= capacity_) {
+      residuals_[lru_.back()].values.reset();
+      lru_.pop_back();
+    }
+    residual.values = std::make_shared<std::vector<float>>();
+    lru_.push_front(tensor_id);
+    residual.lru_iter = lru_.begin();
+  }
+  if ((int64_t)residual.values->size() != num_elements) {
+    residual.values->assign((size_t)num_elements, 0.0f);
+  }
+  return residual.values;
+}
+
+void TopkResidualStore::Clear() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  residuals_.clear();
+  lru_.clear();
+}
+
+void TopkSelector::Select(const float* input, double scale,
+                          std::vector<float>& residual, int64_t k,
+                          TopkPair* pairs, TopkStats* stats) {
+  auto num_elements = (int64_t)residual.size();
+  auto data = residual.data();
+  auto float_scale = (float)scale;
+  double sum_squares = 0;
+  for (int64_t i = 0; i < num_elements; ++i) {
+    data[i] += float_scale * input[i];
+    sum_squares += (double)data[i] * data[i];
+  }
+
+  // Keep about twice the fraction of the sample that is sent, so that the
+  // threshold is below the k-th largest magnitude with high probability.
+  float threshold = 0;
+  if (k < num_elements && num_elements > 4 * TOPK_SAMPLES) {
+    int64_t stride = num_elements / TOPK_SAMPLES;
+    sample_.resize(TOPK_SAMPLES);
+    for (int64_t j = 0; j < TOPK_SAMPLES; ++j) {
+      sample_[j] = std::fabs(data[j * stride]);
+    }
+    int64_t kept =
+        std::min(TOPK_SAMPLES, 2 * (k * TOPK_SAMPLES / num_elements) + 8);
+    std::nth_element(sample_.begin(), sample_.begin() + (kept - 1),
+                     sample_.end(), std::greater<float>());
+    threshold = sample_[kept - 1];
+  }
+
+  candidates_.resize((size_t)num_elements);
+  int64_t count = 0;
+  if (threshold > 0) {
+    count = CollectCandidates(data, num_elements, threshold,
+                              candidates_.data());
+  }
+  if (count < k) {
+    // The estimate was too high, every element is a candidate.
+    std::iota(candidates_.begin(), candidates_.end(), 0);
+    count = num_elements;
+  }
+  if (count > k) {
+    auto by_magnitude = [data](uint32_t a, uint32_t b) {
+      float magnitude_a = std::fabs(data[a]);
+      float magnitude_b = std::fabs(data[b]);
+      return magnitude_a > magnitude_b ||
+             (magnitude_a == magnitude_b && a < b);
+    };
+    std::nth_element(candidates_.begin(), candidates_.begin() + (k - 1),
+                     candidates_.begin() + count, by_magnitude);
+    std::sort(candidates_.begin(), candidates_.begin() + k);
+  }
+
+  double selected_squares = 0;
+  for (int64_t j = 0; j < k; ++j) {
+    auto index = candidates_[j];
+    pairs[j].index = index;
+    pairs[j].value = data[index];
+    selected_squares += (double)data[index] * data[index];
+    data[index] = 0;
+  }
+  stats->gradient_norm = std::sqrt(sum_squares);
+  stats->residual_norm = std::sqrt(std::max(0.0, sum_squares - selected_squares));
+}
+
+} // namespace common
+} // namespace horovod
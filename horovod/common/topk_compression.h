@@ -0,0 +1,102 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_TOPK_COMPRESSION_H
+#define HOROVOD_TOPK_COMPRESSION_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+// An element sent by top-k compression: its position in the tensor and its
+// value.
+struct TopkPair {
+  uint32_t index;
+  float value;
+};
+
+// Return the number of elements sent by top-k compression for a tensor of
+// num_elements elements, a fraction ratio of them, at least one.
+int64_t TopkElements(int64_t num_elements, double ratio);
+
+// Residuals of the tensors reduced with top-k compression, which hold the part
+// of every tensor not sent yet, and are added to it at the next step. They are
+// kept by tensor ID, and looked up concurrently by the lanes performing
+// different tensors. At most capacity residuals are kept, the least recently
+// used one is dropped to make room for another.
+class TopkResidualStore {
+public:
+  // Zero disables error feedback, every lookup then returns a new residual.
+  void set_capacity(uint32_t capacity);
+
+  // Return the residual of the tensor, which is reset to zeros if the tensor
+  // has none yet or had a different number of elements. The residual of a
+  // tensor is only used by one operation at a time, and stays valid while it
+  // is used even if the store drops it meanwhile.
+  std::shared_ptr<std::vector<float>> Get(int32_t tensor_id,
+                                          int64_t num_elements);
+
+  // Drop all residuals, when Horovod is shut down.
+  void Clear();
+
+private:
+  struct Residual {
+    std::shared_ptr<std::vector<float>> values;
+    std::list<int32_t>::iterator lru_iter;
+  };
+
+  std::mutex mutex_;
+  uint32_t capacity_ = 0;
+  // Residuals indexed by tensor ID.
+  std::vector<Residual> residuals_;
+  // IDs of the tensors with a residual, most recently used first.
+  std::list<int32_t> lru_;
+};
+
+// Norms of a tensor compressed by a TopkSelector.
+struct TopkStats {
+  // Norm of the tensor and the previous residual.
+  double gradient_norm = 0;
+  // Norm of the new residual, which is left out.
+  double residual_norm = 0;
+};
+
+// Selects the elements of largest magnitude of tensors. A threshold is
+// estimated from a sample of the magnitudes, so that a single vectorizable
+// pass over the tensor collects a few more candidates than needed, among which
+// the largest are then selected exactly. The buffers are kept across tensors.
+class TopkSelector {
+public:
+  // Add input multiplied by scale to residual, which holds num_elements
+  // elements, then write the k elements of largest magnitude of the sum to
+  // pairs in increasing order of position, and leave the other elements in
+  // residual. Of elements of equal magnitude, the first ones are selected.
+  void Select(const float* input, double scale, std::vector<float>& residual,
+              int64_t k, TopkPair* pairs, TopkStats* stats);
+
+private:
+  std::vector<float> sample_;
+  std::vector<uint32_t> candidates_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_TOPK_COMPRESSION_H
@@ -70,12 +70,38 @@ inline const char *EnumNameMPIDataType(MPIDataType e) {
   return EnumNamesMPIDataType()[index];
 }
 
+enum Compression {
+  Compression_NONE = 0,
+  Compression_FP16 = 1,
+  Compression_TOPK = 2,
+  Compression_MIN = Compression_NONE,
+  Compression_MAX = Compression_TOPK
+};
+
+inline const char **EnumNamesCompression() {
+  static const char *names[] = {
+    "NONE",
+    "FP16",
+    "TOPK",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNameCompression(Compression e) {
+  const size_t index = static_cast<int>(e);
+  return EnumNamesCompression()[index];
+}
+
 enum MPIRequestType {
   MPIRequestType_ALLREDUCE = 0,
   MPIRequestType_ALLGATHER = 1,
   MPIRequestType_BROADCAST = 2,
+  MPIRequestType_REDUCESCATTER = 3,
+  MPIRequestType_ALLTOALL = 4,
+  MPIRequestType_SPARSE_ALLREDUCE = 5,
   MPIRequestType_MIN = MPIRequestType_ALLREDUCE,
-  MPIRequestType_MAX = MPIRequestType_BROADCAST
+  MPIRequestType_MAX = MPIRequestType_SPARSE_ALLREDUCE
 };
 
 inline const char **EnumNamesMPIRequestType() {
@@ -83,6 +109,9 @@ inline const char **EnumNamesMPIRequestType() {
     "ALLREDUCE",
     "ALLGATHER",
     "BROADCAST",
+    "REDUCESCATTER",
+    "ALLTOALL",
+    "SPARSE_ALLREDUCE",
     nullptr
   };
   return names;
@@ -98,8 +127,11 @@ enum MPIResponseType {
   MPIResponseType_ALLGATHER = 1,
   MPIResponseType_BROADCAST = 2,
   MPIResponseType_ERROR = 3,
+  MPIResponseType_REDUCESCATTER = 4,
+  MPIResponseType_ALLTOALL = 5,
+  MPIResponseType_SPARSE_ALLREDUCE = 6,
   MPIResponseType_MIN = MPIResponseType_ALLREDUCE,
-  MPIResponseType_MAX = MPIResponseType_ERROR
+  MPIResponseType_MAX = MPIResponseType_SPARSE_ALLREDUCE
 };
 
 inline const char **EnumNamesMPIResponseType() {
@@ -108,6 +140,9 @@ inline const char **EnumNamesMPIResponseType() {
     "ALLGATHER",
     "BROADCAST",
     "ERROR",
+    "REDUCESCATTER",
+    "ALLTOALL",
+    "SPARSE_ALLREDUCE",
     nullptr
   };
   return names;
@@ -126,7 +161,11 @@ struct MPIRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_TENSOR_NAME = 10,
     VT_ROOT_RANK = 12,
     VT_DEVICE = 14,
-    VT_TENSOR_SHAPE = 16
+    VT_TENSOR_SHAPE = 16,
+    VT_TENSOR_ID = 18,
+    VT_TENSOR_SPLITS = 20,
+    VT_DENSE_ROWS = 22,
+    VT_COMPRESSION = 24
   };
   int32_t request_rank() const {
     return GetField<int32_t>(VT_REQUEST_RANK, 0);
@@ -149,6 +188,18 @@ struct MPIRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::Vector<int64_t> *tensor_shape() const {
     return GetPointer<const flatbuffers::Vector<int64_t> *>(VT_TENSOR_SHAPE);
   }
+  int32_t tensor_id() const {
+    return GetField<int32_t>(VT_TENSOR_ID, -1);
+  }
+  const flatbuffers::Vector<int64_t> *tensor_splits() const {
+    return GetPointer<const flatbuffers::Vector<int64_t> *>(VT_TENSOR_SPLITS);
+  }
+  int64_t dense_rows() const {
+    return GetField<int64_t>(VT_DENSE_ROWS, 0);
+  }
+  Compression compression() const {
+    return static_cast<Compression>(GetField<int8_t>(VT_COMPRESSION, 0));
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<int32_t>(verifier, VT_REQUEST_RANK) &&
@@ -160,6 +211,11 @@ struct MPIRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<int32_t>(verifier, VT_DEVICE) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_TENSOR_SHAPE) &&
            verifier.Verify(tensor_shape()) &&
+           VerifyField<int32_t>(verifier, VT_TENSOR_ID) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_TENSOR_SPLITS) &&
+           verifier.Verify(tensor_splits()) &&
+           VerifyField<int64_t>(verifier, VT_DENSE_ROWS) &&
+           VerifyField<int8_t>(verifier, VT_COMPRESSION) &&
            verifier.EndTable();
   }
 };
@@ -188,13 +244,25 @@ struct MPIRequestBuilder {
   void add_tensor_shape(flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape) {
     fbb_.AddOffset(MPIRequest::VT_TENSOR_SHAPE, tensor_shape);
   }
+  void add_tensor_id(int32_t tensor_id) {
+    fbb_.AddElement<int32_t>(MPIRequest::VT_TENSOR_ID, tensor_id, -1);
+  }
+  void add_tensor_splits(flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_splits) {
+    fbb_.AddOffset(MPIRequest::VT_TENSOR_SPLITS, tensor_splits);
+  }
+  void add_dense_rows(int64_t dense_rows) {
+    fbb_.AddElement<int64_t>(MPIRequest::VT_DENSE_ROWS, dense_rows, 0);
+  }
+  void add_compression(Compression compression) {
+    fbb_.AddElement<int8_t>(MPIRequest::VT_COMPRESSION, static_cast<int8_t>(compression), 0);
+  }
   MPIRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
   }
   MPIRequestBuilder &operator=(const MPIRequestBuilder &);
   flatbuffers::Offset<MPIRequest> Finish() {
-    const auto end = fbb_.EndTable(start_, 7);
+    const auto end = fbb_.EndTable(start_, 11);
     auto o = flatbuffers::Offset<MPIRequest>(end);
     return o;
   }
@@ -208,8 +276,15 @@ inline flatbuffers::Offset<MPIRequest> CreateMPIRequest(
     flatbuffers::Offset<flatbuffers::String> tensor_name = 0,
     int32_t root_rank = 0,
     int32_t device = 0,
-    flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape = 0,
+    int32_t tensor_id = -1,
+    flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_splits = 0,
+    int64_t dense_rows = 0,
+    Compression compression = Compression_NONE) {
   MPIRequestBuilder builder_(_fbb);
+  builder_.add_dense_rows(dense_rows);
+  builder_.add_tensor_splits(tensor_splits);
+  builder_.add_tensor_id(tensor_id);
   builder_.add_tensor_shape(tensor_shape);
   builder_.add_device(device);
   builder_.add_root_rank(root_rank);
@@ -217,6 +292,7 @@ inline flatbuffers::Offset<MPIRequest> CreateMPIRequest(
   builder_.add_request_rank(request_rank);
   builder_.add_tensor_type(tensor_type);
   builder_.add_request_type(request_type);
+  builder_.add_compression(compression);
   return builder_.Finish();
 }
 
@@ -228,7 +304,11 @@ inline flatbuffers::Offset<MPIRequest> CreateMPIRequestDirect(
     const char *tensor_name = nullptr,
     int32_t root_rank = 0,
     int32_t device = 0,
-    const std::vector<int64_t> *tensor_shape = nullptr) {
+    const std::vector<int64_t> *tensor_shape = nullptr,
+    int32_t tensor_id = -1,
+    const std::vector<int64_t> *tensor_splits = nullptr,
+    int64_t dense_rows = 0,
+    Compression compression = Compression_NONE) {
   return horovod::common::wire::CreateMPIRequest(
       _fbb,
       request_rank,
@@ -237,7 +317,11 @@ inline flatbuffers::Offset<MPIRequest> CreateMPIRequestDirect(
       tensor_name ? _fbb.CreateString(tensor_name) : 0,
       root_rank,
       device,
-      tensor_shape ? _fbb.CreateVector<int64_t>(*tensor_shape) : 0);
+      tensor_shape ? _fbb.CreateVector<int64_t>(*tensor_shape) : 0,
+      tensor_id,
+      tensor_splits ? _fbb.CreateVector<int64_t>(*tensor_splits) : 0,
+      dense_rows,
+      compression);
 }
 
 struct MPIRequestList FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
@@ -308,7 +392,8 @@ struct MPIResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_TENSOR_NAMES = 6,
     VT_ERROR_MESSAGE = 8,
     VT_DEVICES = 10,
-    VT_TENSOR_SIZES = 12
+    VT_TENSOR_SIZES = 12,
+    VT_TENSOR_IDS = 14
   };
   MPIResponseType response_type() const {
     return static_cast<MPIResponseType>(GetField<int8_t>(VT_RESPONSE_TYPE, 0));
@@ -325,6 +410,9 @@ struct MPIResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::Vector<int64_t> *tensor_sizes() const {
     return GetPointer<const flatbuffers::Vector<int64_t> *>(VT_TENSOR_SIZES);
   }
+  const flatbuffers::Vector<int32_t> *tensor_ids() const {
+    return GetPointer<const flatbuffers::Vector<int32_t> *>(VT_TENSOR_IDS);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<int8_t>(verifier, VT_RESPONSE_TYPE) &&
@@ -337,6 +425,8 @@ struct MPIResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            verifier.Verify(devices()) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_TENSOR_SIZES) &&
            verifier.Verify(tensor_sizes()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_TENSOR_IDS) &&
+           verifier.Verify(tensor_ids()) &&
            verifier.EndTable();
   }
 };
@@ -359,13 +449,16 @@ struct MPIResponseBuilder {
   void add_tensor_sizes(flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_sizes) {
     fbb_.AddOffset(MPIResponse::VT_TENSOR_SIZES, tensor_sizes);
   }
+  void add_tensor_ids(flatbuffers::Offset<flatbuffers::Vector<int32_t>> tensor_ids) {
+    fbb_.AddOffset(MPIResponse::VT_TENSOR_IDS, tensor_ids);
+  }
   MPIResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
   }
   MPIResponseBuilder &operator=(const MPIResponseBuilder &);
   flatbuffers::Offset<MPIResponse> Finish() {
-    const auto end = fbb_.EndTable(start_, 5);
+    const auto end = fbb_.EndTable(start_, 6);
     auto o = flatbuffers::Offset<MPIResponse>(end);
     return o;
   }
@@ -377,8 +470,10 @@ inline flatbuffers::Offset<MPIResponse> CreateMPIResponse(
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> tensor_names = 0,
     flatbuffers::Offset<flatbuffers::String> error_message = 0,
     flatbuffers::Offset<flatbuffers::Vector<int32_t>> devices = 0,
-    flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_sizes = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_sizes = 0,
+    flatbuffers::Offset<flatbuffers::Vector<int32_t>> tensor_ids = 0) {
   MPIResponseBuilder builder_(_fbb);
+  builder_.add_tensor_ids(tensor_ids);
   builder_.add_tensor_sizes(tensor_sizes);
   builder_.add_devices(devices);
   builder_.add_error_message(error_message);
@@ -393,20 +488,23 @@ inline flatbuffers::Offset<MPIResponse> CreateMPIResponseDirect(
     const std::vector<flatbuffers::Offset<flatbuffers::String>> *tensor_names = nullptr,
     const char *error_message = nullptr,
     const std::vector<int32_t> *devices = nullptr,
-    const std::vector<int64_t> *tensor_sizes = nullptr) {
+    const std::vector<int64_t> *tensor_sizes = nullptr,
+    const std::vector<int32_t> *tensor_ids = nullptr) {
   return horovod::common::wire::CreateMPIResponse(
       _fbb,
       response_type,
       tensor_names ? _fbb.CreateVector<flatbuffers::Offset<flatbuffers::String>>(*tensor_names) : 0,
       error_message ? _fbb.CreateString(error_message) : 0,
       devices ? _fbb.CreateVector<int32_t>(*devices) : 0,
-      tensor_sizes ? _fbb.CreateVector<int64_t>(*tensor_sizes) : 0);
+      tensor_sizes ? _fbb.CreateVector<int64_t>(*tensor_sizes) : 0,
+      tensor_ids ? _fbb.CreateVector<int32_t>(*tensor_ids) : 0);
 }
 
 struct MPIResponseList FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum {
     VT_RESPONSES = 4,
-    VT_SHUTDOWN = 6
+    VT_SHUTDOWN = 6,
+    VT_SEQUENCE = 8
   };
   const flatbuffers::Vector<flatbuffers::Offset<MPIResponse>> *responses() const {
     return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<MPIResponse>> *>(VT_RESPONSES);
@@ -414,12 +512,16 @@ struct MPIResponseList FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   bool shutdown() const {
     return GetField<uint8_t>(VT_SHUTDOWN, 0) != 0;
   }
+  uint64_t sequence() const {
+    return GetField<uint64_t>(VT_SEQUENCE, 0);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_RESPONSES) &&
            verifier.Verify(responses()) &&
            verifier.VerifyVectorOfTables(responses()) &&
            VerifyField<uint8_t>(verifier, VT_SHUTDOWN) &&
+           VerifyField<uint64_t>(verifier, VT_SEQUENCE) &&
            verifier.EndTable();
   }
 };
@@ -433,13 +535,16 @@ struct MPIResponseListBuilder {
   void add_shutdown(bool shutdown) {
     fbb_.AddElement<uint8_t>(MPIResponseList::VT_SHUTDOWN, static_cast<uint8_t>(shutdown), 0);
   }
+  void add_sequence(uint64_t sequence) {
+    fbb_.AddElement<uint64_t>(MPIResponseList::VT_SEQUENCE, sequence, 0);
+  }
   MPIResponseListBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
   }
   MPIResponseListBuilder &operator=(const MPIResponseListBuilder &);
   flatbuffers::Offset<MPIResponseList> Finish() {
-    const auto end = fbb_.EndTable(start_, 2);
+    const auto end = fbb_.EndTable(start_, 3);
     auto o = flatbuffers::Offset<MPIResponseList>(end);
     return o;
   }
@@ -448,8 +553,10 @@ struct MPIResponseListBuilder {
 inline flatbuffers::Offset<MPIResponseList> CreateMPIResponseList(
     flatbuffers::FlatBufferBuilder &_fbb,
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<MPIResponse>>> responses = 0,
-    bool shutdown = false) {
+    bool shutdown = false,
+    uint64_t sequence = 0) {
   MPIResponseListBuilder builder_(_fbb);
+  builder_.add_sequence(sequence);
   builder_.add_responses(responses);
   builder_.add_shutdown(shutdown);
   return builder_.Finish();
@@ -458,11 +565,13 @@ inline flatbuffers::Offset<MPIResponseList> CreateMPIResponseList(
 inline flatbuffers::Offset<MPIResponseList> CreateMPIResponseListDirect(
     flatbuffers::FlatBufferBuilder &_fbb,
     const std::vector<flatbuffers::Offset<MPIResponse>> *responses = nullptr,
-    bool shutdown = false) {
+    bool shutdown = false,
+    uint64_t sequence = 0) {
   return horovod::common::wire::CreateMPIResponseList(
       _fbb,
       responses ? _fbb.CreateVector<flatbuffers::Offset<MPIResponse>>(*responses) : 0,
-      shutdown);
+      shutdown,
+      sequence);
 }
 
 }  // namespace wire
@@ -18,6 +18,7 @@
 #endif
 
 #include "adapter.h"
+#include "../common/object_pool.h"
 #include "cuda_util.h"
 #include "tensor_util.h"
 
@@ -114,7 +115,7 @@ Status MXOpContext<T>::AllocateOutput(TensorShape shape,
   }
   TensorUtil::ResizeNd(output_, shape.dims(), shape_array);
   delete[] shape_array;
-  *tensor = std::make_shared<MXTensor<T>>(output_);
+  *tensor = MakePooled<MXTensor<T>>(output_);
   return Status::OK();
 }
 
@@ -14,7 +14,9 @@
 // =============================================================================
 
 #include <atomic>
+#include <mutex>
 
+#include "../common/object_pool.h"
 #include "../common/operations.h"
 #include "adapter.h"
 #include "cuda_util.h"
@@ -48,36 +50,131 @@ inline void InvokeCompleteCallback(Callback on_complete, const Status& status) {
   }
 }
 
+// Completes an engine operation once all the tensors of a group are reduced,
+// with the first error reported for any of them.
+class GroupCompletion {
+public:
+  GroupCompletion(int num_tensors, Callback on_complete)
+      : remaining_(num_tensors), on_complete_(on_complete) {}
+
+  void TensorDone(const Status& status) {
+    if (!status.ok()) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (status_.ok()) {
+        status_ = status;
+      }
+    }
+    if (remaining_.fetch_sub(1) == 1) {
+      InvokeCompleteCallback(on_complete_, status_);
+    }
+  }
+
+private:
+  std::atomic_int remaining_;
+  Callback on_complete_;
+  std::mutex mutex_;
+  Status status_;
+};
+
 void DoAllreduce(NDArray* tensor, NDArray* output, const std::string& name,
-                 Callback on_complete) {
+                 double postscale_factor, Callback on_complete) {
   ThrowIfError(common::CheckInitialized());
 
   auto device = TensorUtil::GetDevice(tensor);
-  auto hvd_tensor = std::make_shared<MXTensor<NDArray>>(tensor);
-  auto hvd_context = std::make_shared<MXOpContext<NDArray>>(device, output);
-  auto hvd_output = std::make_shared<MXTensor<NDArray>>(output);
+  auto hvd_tensor = MakePooled<MXTensor<NDArray>>(tensor);
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(device, output);
+  auto hvd_output = MakePooled<MXTensor<NDArray>>(output);
 
   auto enqueue_result =
       EnqueueTensorAllreduce(hvd_context, hvd_tensor, hvd_output, nullptr,
                              name, device,
                              [on_complete](const Status& status) {
                                InvokeCompleteCallback(on_complete, status);
-                             });
+                             },
+                             1.0, postscale_factor);
+  ThrowIfError(enqueue_result);
+}
+
+void DoGroupedAllreduce(const std::vector<NDArray*>& tensors,
+                        const std::vector<NDArray*>& outputs,
+                        const std::vector<std::string>& names,
+                        double postscale_factor, Callback on_complete) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = TensorUtil::GetDevice(tensors[0]);
+  auto completion =
+      MakePooled<GroupCompletion>((int)tensors.size(), on_complete);
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<std::shared_ptr<Tensor>> hvd_tensors;
+  std::vector<std::shared_ptr<Tensor>> hvd_outputs;
+  std::vector<std::shared_ptr<ReadyEvent>> ready_events;
+  std::vector<StatusCallback> callbacks;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    hvd_contexts.push_back(
+        MakePooled<MXOpContext<NDArray>>(device, outputs[i]));
+    hvd_tensors.push_back(MakePooled<MXTensor<NDArray>>(tensors[i]));
+    hvd_outputs.push_back(MakePooled<MXTensor<NDArray>>(outputs[i]));
+    ready_events.push_back(nullptr);
+    callbacks.push_back([completion](const Status& status) {
+      completion->TensorDone(status);
+    });
+  }
+
+  auto enqueue_result = EnqueueTensorAllreduces(
+      hvd_contexts, hvd_tensors, hvd_outputs, ready_events, names, device,
+      callbacks, 1.0, postscale_factor);
   ThrowIfError(enqueue_result);
 }
 
 #if HAVE_CUDA
+void DoGroupedAllreduceCudaOnCPU(const std::vector<NDArray*>& tensors,
+                                 const std::vector<NDArray*>& outputs,
+                                 const std::vector<std::string>& names,
+                                 double postscale_factor,
+                                 Callback on_complete) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto completion =
+      MakePooled<GroupCompletion>((int)tensors.size(), on_complete);
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<std::shared_ptr<Tensor>> hvd_cpu_buffers;
+  std::vector<std::shared_ptr<ReadyEvent>> ready_events;
+  std::vector<StatusCallback> callbacks;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    // Make async copy of input tensor to CPU tensor and record completion
+    // event.
+    auto hvd_cpu_buffer = MakePooled<MXTemporaryBuffer<NDArray>>(
+        CPU_DEVICE_ID, tensors[i]->dtype());
+    TensorUtil::AsyncCopyCudaToCPU(tensors[i], hvd_cpu_buffer->tensor());
+    hvd_contexts.push_back(MakePooled<MXOpContext<NDArray>>(
+        CPU_DEVICE_ID, hvd_cpu_buffer->tensor()));
+    hvd_cpu_buffers.push_back(hvd_cpu_buffer);
+    ready_events.push_back(MakePooled<MXReadyEvent<NDArray>>(tensors[i]));
+    auto output = outputs[i];
+    callbacks.push_back(
+        [hvd_cpu_buffer, output, completion](const Status& status) {
+          TensorUtil::CopyCPUToCuda(hvd_cpu_buffer->tensor(), output);
+          completion->TensorDone(status);
+        });
+  }
+
+  auto enqueue_result = EnqueueTensorAllreduces(
+      hvd_contexts, hvd_cpu_buffers, hvd_cpu_buffers, ready_events, names,
+      CPU_DEVICE_ID, callbacks, 1.0, postscale_factor);
+  ThrowIfError(enqueue_result);
+}
+
 void DoAllreduceCudaOnCPU(NDArray* tensor, NDArray* output, std::string& name,
-                          Callback on_complete) {
+                          double postscale_factor, Callback on_complete) {
   ThrowIfError(common::CheckInitialized());
 
   // Make async copy of input tensor to CPU tensor and record completion event.
-  auto hvd_cpu_buffer = std::make_shared<MXTemporaryBuffer<NDArray>>(
+  auto hvd_cpu_buffer = MakePooled<MXTemporaryBuffer<NDArray>>(
       CPU_DEVICE_ID, tensor->dtype());
   TensorUtil::AsyncCopyCudaToCPU(tensor, hvd_cpu_buffer->tensor());
-  auto hvd_context = std::make_shared<MXOpContext<NDArray>>(
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(
       CPU_DEVICE_ID, hvd_cpu_buffer->tensor());
-  auto ready_event = std::make_shared<MXReadyEvent<NDArray>>(tensor);
+  auto ready_event = MakePooled<MXReadyEvent<NDArray>>(tensor);
 
   auto enqueue_result = EnqueueTensorAllreduce(
       hvd_context, hvd_cpu_buffer, hvd_cpu_buffer, ready_event,
@@ -85,7 +182,8 @@ void DoAllreduceCudaOnCPU(NDArray* tensor, NDArray* output, std::string& name,
       [hvd_cpu_buffer, output, on_complete](const Status& status) {
         TensorUtil::CopyCPUToCuda(hvd_cpu_buffer->tensor(), output);
         InvokeCompleteCallback(on_complete, status);
-      });
+      },
+      1.0, postscale_factor);
   ThrowIfError(enqueue_result);
 }
 #endif
@@ -95,8 +193,8 @@ void DoAllgather(NDArray* tensor, NDArray* output, std::string& name,
   ThrowIfError(common::CheckInitialized());
 
   auto device = TensorUtil::GetDevice(tensor);
-  auto hvd_tensor = std::make_shared<MXTensor<NDArray>>(tensor);
-  auto hvd_context = std::make_shared<MXOpContext<NDArray>>(device, output);
+  auto hvd_tensor = MakePooled<MXTensor<NDArray>>(tensor);
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(device, output);
 
   auto enqueue_result =
       EnqueueTensorAllgather(hvd_context, hvd_tensor, nullptr,
@@ -113,14 +211,14 @@ void DoAllgatherCudaOnCPU(NDArray* tensor, NDArray* output, std::string& name,
   ThrowIfError(common::CheckInitialized());
 
   // Make async copy of input tensor to CPU tensor and record completion event.
-  auto hvd_cpu_tensor = std::make_shared<MXTemporaryBuffer<NDArray>>(
+  auto hvd_cpu_tensor = MakePooled<MXTemporaryBuffer<NDArray>>(
       CPU_DEVICE_ID, tensor->dtype());
   TensorUtil::AsyncCopyCudaToCPU(tensor, hvd_cpu_tensor->tensor());
-  auto ready_event = std::make_shared<MXReadyEvent<NDArray>>(tensor);
+  auto ready_event = MakePooled<MXReadyEvent<NDArray>>(tensor);
 
-  auto hvd_cpu_output = std::make_shared<MXTemporaryBuffer<NDArray>>(
+  auto hvd_cpu_output = MakePooled<MXTemporaryBuffer<NDArray>>(
       CPU_DEVICE_ID, output->dtype());
-  auto hvd_context = std::make_shared<MXOpContext<NDArray>>(
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(
       CPU_DEVICE_ID, hvd_cpu_output->tensor());
 
   auto enqueue_result = EnqueueTensorAllgather(
@@ -134,20 +232,110 @@ void DoAllgatherCudaOnCPU(NDArray* tensor, NDArray* output, std::string& name,
 }
 #endif
 
+void DoReducescatter(NDArray* tensor, NDArray* output, std::string& name,
+                     Callback on_complete) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = TensorUtil::GetDevice(tensor);
+  auto hvd_tensor = MakePooled<MXTensor<NDArray>>(tensor);
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(device, output);
+
+  auto enqueue_result =
+      EnqueueTensorReducescatter(hvd_context, hvd_tensor, nullptr,
+                                 name, device,
+                                 [on_complete](const Status& status) {
+                                   InvokeCompleteCallback(on_complete, status);
+                                 });
+  ThrowIfError(enqueue_result);
+}
+
+void DoAlltoall(NDArray* tensor, NDArray* output,
+                const std::vector<int64_t>& splits, std::string& name,
+                Callback on_complete) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = TensorUtil::GetDevice(tensor);
+  auto hvd_tensor = MakePooled<MXTensor<NDArray>>(tensor);
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(device, output);
+
+  auto enqueue_result =
+      EnqueueTensorAlltoall(hvd_context, hvd_tensor, splits, nullptr,
+                            name, device,
+                            [on_complete](const Status& status) {
+                              InvokeCompleteCallback(on_complete, status);
+                            });
+  ThrowIfError(enqueue_result);
+}
+
+#if HAVE_CUDA
+// Reducescatter and alltoall are only performed on CPU, so GPU tensors always
+// go through CPU buffers.
+void DoReducescatterCudaOnCPU(NDArray* tensor, NDArray* output,
+                              std::string& name, Callback on_complete) {
+  ThrowIfError(common::CheckInitialized());
+
+  // Make async copy of input tensor to CPU tensor and record completion event.
+  auto hvd_cpu_tensor = MakePooled<MXTemporaryBuffer<NDArray>>(
+      CPU_DEVICE_ID, tensor->dtype());
+  TensorUtil::AsyncCopyCudaToCPU(tensor, hvd_cpu_tensor->tensor());
+  auto ready_event = MakePooled<MXReadyEvent<NDArray>>(tensor);
+
+  auto hvd_cpu_output = MakePooled<MXTemporaryBuffer<NDArray>>(
+      CPU_DEVICE_ID, output->dtype());
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(
+      CPU_DEVICE_ID, hvd_cpu_output->tensor());
+
+  auto enqueue_result = EnqueueTensorReducescatter(
+      hvd_context, hvd_cpu_tensor, ready_event,
+      name, CPU_DEVICE_ID,
+      [hvd_cpu_output, output, on_complete](const Status& status) {
+        TensorUtil::CopyCPUToCuda(hvd_cpu_output->tensor(), output);
+        InvokeCompleteCallback(on_complete, status);
+      });
+  ThrowIfError(enqueue_result);
+}
+
+void DoAlltoallCudaOnCPU(NDArray* tensor, NDArray* output,
+                         const std::vector<int64_t>& splits,
+                         std::string& name, Callback on_complete) {
+  ThrowIfError(common::CheckInitialized());
+
+  // Make async copy of input tensor to CPU tensor and record completion event.
+  auto hvd_cpu_tensor = MakePooled<MXTemporaryBuffer<NDArray>>(
+      CPU_DEVICE_ID, tensor->dtype());
+  TensorUtil::AsyncCopyCudaToCPU(tensor, hvd_cpu_tensor->tensor());
+  auto ready_event = MakePooled<MXReadyEvent<NDArray>>(tensor);
+
+  auto hvd_cpu_output = MakePooled<MXTemporaryBuffer<NDArray>>(
+      CPU_DEVICE_ID, output->dtype());
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(
+      CPU_DEVICE_ID, hvd_cpu_output->tensor());
+
+  auto enqueue_result = EnqueueTensorAlltoall(
+      hvd_context, hvd_cpu_tensor, splits, ready_event,
+      name, CPU_DEVICE_ID,
+      [hvd_cpu_output, output, on_complete](const Status& status) {
+        TensorUtil::CopyCPUToCuda(hvd_cpu_output->tensor(), output);
+        InvokeCompleteCallback(on_complete, status);
+      });
+  ThrowIfError(enqueue_result);
+}
+#endif
+
 void DoBroadcast(NDArray* tensor, NDArray* output, int root_rank,
                  std::string& name, Callback on_complete) {
   ThrowIfError(common::CheckInitialized());
 
   auto device = TensorUtil::GetDevice(tensor);
-  auto hvd_tensor = std::make_shared<MXTensor<NDArray>>(tensor);
-  auto hvd_context = std::make_shared<MXOpContext<NDArray>>(device, output);
+  auto hvd_tensor = MakePooled<MXTensor<NDArray>>(tensor);
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(device, output);
   std::shared_ptr<Tensor> hvd_output = nullptr;
   if (horovod_rank() == root_rank) {
     if (tensor != output) {
       TensorUtil::Copy(output, tensor);
     }
   } else {
-    hvd_output = std::make_shared<MXTensor<NDArray>>(output);
+    hvd_output = MakePooled<MXTensor<NDArray>>(output);
   }
 
   auto enqueue_result = EnqueueTensorBroadcast(
@@ -164,10 +352,10 @@ void DoBroadcastCudaOnCPU(
     std::shared_ptr<MXTemporaryBuffer<NDArray>>& hvd_cpu_buffer, int root_rank,
     std::string& name, Callback on_complete) {
   // Make async copy of input tensor to CPU tensor and record completion event.
-  auto hvd_context = std::make_shared<MXOpContext<NDArray>>(
+  auto hvd_context = MakePooled<MXOpContext<NDArray>>(
       CPU_DEVICE_ID, hvd_cpu_buffer->tensor());
   auto ready_event =
-      std::make_shared<MXReadyEvent<NDArray>>(hvd_cpu_buffer->tensor());
+      MakePooled<MXReadyEvent<NDArray>>(hvd_cpu_buffer->tensor());
 
   auto enqueue_result = EnqueueTensorBroadcast(
       hvd_context, hvd_cpu_buffer, hvd_cpu_buffer, root_rank, ready_event,
@@ -184,17 +372,26 @@ extern "C" int horovod_mxnet_allreduce_async(NDArray* input, NDArray* output,
   MX_API_BEGIN();
 
   std::string op_name = GetOpName("allreduce", name);
-  auto allreduce_async_fn = [input, output,
-                             op_name](RunContext rctx,
-                                      Callback on_complete) mutable {
-    DoAllreduce(input, output, op_name, on_complete);
+#if HAVE_CUDA && !HOROVOD_GPU_ALLREDUCE
+  bool reduce_on_cpu = true;
+#else
+  bool reduce_on_cpu = TensorUtil::GetDevice(input) == CPU_DEVICE_ID;
+#endif
+  // Horovod averages tensors reduced on CPU while copying the result out of
+  // the fusion buffer, instead of a separate division of the output.
+  double postscale_factor =
+      average && reduce_on_cpu ? 1.0 / horovod_size() : 1.0;
+  auto allreduce_async_fn = [input, output, op_name, postscale_factor](
+                                RunContext rctx, Callback on_complete) mutable {
+    DoAllreduce(input, output, op_name, postscale_factor, on_complete);
   };
 
 #if HAVE_CUDA
   auto allreduce_async_cpu_fn =
-      [input, output, op_name](RunContext rctx,
-                               Callback on_complete) mutable {
-        DoAllreduceCudaOnCPU(input, output, op_name, on_complete);
+      [input, output, op_name, postscale_factor](
+          RunContext rctx, Callback on_complete) mutable {
+        DoAllreduceCudaOnCPU(input, output, op_name, postscale_factor,
+                             on_complete);
       };
 #endif
 
@@ -224,13 +421,72 @@ extern "C" int horovod_mxnet_allreduce_async(NDArray* input, NDArray* output,
   }
 #endif
 
-  if (average) {
+  if (average && !reduce_on_cpu) {
     *output /= horovod_size();
   }
 
   MX_API_END();
 }
 
+extern "C" int horovod_mxnet_grouped_allreduce_async(NDArray** inputs,
+                                                     NDArray** outputs,
+                                                     int num_tensors,
+                                                     char* name, bool average) {
+  MX_API_BEGIN();
+
+  std::vector<NDArray*> input_list(inputs, inputs + num_tensors);
+  std::vector<NDArray*> output_list(outputs, outputs + num_tensors);
+  std::string op_name = GetOpName("allreduce", name);
+  std::vector<std::string> names;
+  std::vector<Engine::VarHandle> const_vars;
+  std::vector<Engine::VarHandle> mutable_vars;
+  for (int i = 0; i < num_tensors; ++i) {
+    names.push_back(op_name + "." + std::to_string(i));
+    // Inputs reduced in-place are only mutable.
+    if (inputs[i]->var() != outputs[i]->var()) {
+      const_vars.push_back(inputs[i]->var());
+    }
+    mutable_vars.push_back(outputs[i]->var());
+  }
+
+#if HAVE_CUDA && !HOROVOD_GPU_ALLREDUCE
+  bool reduce_on_cpu = true;
+#else
+  bool reduce_on_cpu = TensorUtil::GetDevice(inputs[0]) == CPU_DEVICE_ID;
+#endif
+  double postscale_factor =
+      average && reduce_on_cpu ? 1.0 / horovod_size() : 1.0;
+
+  // The whole group is a single engine operation, so that all its tensors are
+  // enqueued together once they are all ready.
+#if HAVE_CUDA && !HOROVOD_GPU_ALLREDUCE
+  auto grouped_allreduce_async_fn =
+      [input_list, output_list, names, postscale_factor](
+          RunContext rctx, Callback on_complete) mutable {
+        DoGroupedAllreduceCudaOnCPU(input_list, output_list, names,
+                                    postscale_factor, on_complete);
+      };
+#else
+  auto grouped_allreduce_async_fn =
+      [input_list, output_list, names, postscale_factor](
+          RunContext rctx, Callback on_complete) mutable {
+        DoGroupedAllreduce(input_list, output_list, names, postscale_factor,
+                           on_complete);
+      };
+#endif
+  Engine::Get()->PushAsync(grouped_allreduce_async_fn, inputs[0]->ctx(),
+                           const_vars, mutable_vars, FnProperty::kNormal, 0,
+                           "HorovodGroupedAllreduce");
+
+  if (average && !reduce_on_cpu) {
+    for (int i = 0; i < num_tensors; ++i) {
+      *outputs[i] /= horovod_size();
+    }
+  }
+
+  MX_API_END();
+}
+
 extern "C" int horovod_mxnet_allgather_async(NDArray* input, NDArray* output,
                                              char* name) {
   MX_API_BEGIN();
@@ -279,6 +535,74 @@ extern "C" int horovod_mxnet_allgather_async(NDArray* input, NDArray* output,
   MX_API_END();
 }
 
+extern "C" int horovod_mxnet_reducescatter_async(NDArray* input,
+                                                 NDArray* output, char* name,
+                                                 bool average) {
+  MX_API_BEGIN();
+
+  std::string op_name = GetOpName("reducescatter", name);
+#if HAVE_CUDA
+  auto reducescatter_async_fn =
+      [input, output, op_name](RunContext rctx,
+                               Callback on_complete) mutable {
+        if (TensorUtil::GetDevice(input) == CPU_DEVICE_ID) {
+          DoReducescatter(input, output, op_name, on_complete);
+        } else {
+          DoReducescatterCudaOnCPU(input, output, op_name, on_complete);
+        }
+      };
+#else
+  auto reducescatter_async_fn =
+      [input, output, op_name](RunContext rctx,
+                               Callback on_complete) mutable {
+        DoReducescatter(input, output, op_name, on_complete);
+      };
+#endif
+
+  Engine::Get()->PushAsync(reducescatter_async_fn, input->ctx(),
+                           {input->var()}, {output->var()},
+                           FnProperty::kNormal, 0, "HorovodReducescatter");
+
+  if (average) {
+    *output /= horovod_size();
+  }
+
+  MX_API_END();
+}
+
+extern "C" int horovod_mxnet_alltoall_async(NDArray* input, NDArray* output,
+                                            char* name, int64_t* splits,
+                                            int num_splits) {
+  MX_API_BEGIN();
+
+  std::string op_name = GetOpName("alltoall", name);
+  std::vector<int64_t> split_list(splits, splits + num_splits);
+#if HAVE_CUDA
+  auto alltoall_async_fn =
+      [input, output, split_list, op_name](RunContext rctx,
+                                           Callback on_complete) mutable {
+        if (TensorUtil::GetDevice(input) == CPU_DEVICE_ID) {
+          DoAlltoall(input, output, split_list, op_name, on_complete);
+        } else {
+          DoAlltoallCudaOnCPU(input, output, split_list, op_name,
+                              on_complete);
+        }
+      };
+#else
+  auto alltoall_async_fn =
+      [input, output, split_list, op_name](RunContext rctx,
+                                           Callback on_complete) mutable {
+        DoAlltoall(input, output, split_list, op_name, on_complete);
+      };
+#endif
+
+  Engine::Get()->PushAsync(alltoall_async_fn, input->ctx(), {input->var()},
+                           {output->var()}, FnProperty::kNormal, 0,
+                           "HorovodAlltoall");
+
+  MX_API_END();
+}
+
 extern "C" int horovod_mxnet_broadcast_async(NDArray* input, NDArray* output,
                                              int root_rank, char* name) {
   MX_API_BEGIN();
@@ -293,7 +617,7 @@ extern "C" int horovod_mxnet_broadcast_async(NDArray* input, NDArray* output,
 #if HAVE_CUDA && HOROVOD_GPU_BROADCAST != 'M'
   ThrowIfError(common::CheckInitialized());
   // Make async copy of input tensor to CPU tensor and record completion event.
-  auto hvd_cpu_buffer = std::make_shared<MXTemporaryBuffer<NDArray>>(
+  auto hvd_cpu_buffer = MakePooled<MXTemporaryBuffer<NDArray>>(
       CPU_DEVICE_ID, input->dtype());
   TensorUtil::AsyncCopyCudaToCPU(input, hvd_cpu_buffer->tensor());
   auto broadcast_async_cpu_fn =
@@ -33,8 +33,18 @@ typedef ::mxnet::Engine::CallbackOnComplete Callback;
 
 extern "C" int horovod_mxnet_allreduce_async(NDArray* tensor, NDArray* output,
                                              char* name, bool average);
+extern "C" int horovod_mxnet_grouped_allreduce_async(NDArray** inputs,
+                                                     NDArray** outputs,
+                                                     int num_tensors,
+                                                     char* name, bool average);
 extern "C" int horovod_mxnet_allgather_async(NDArray* tensor, NDArray* output,
                                              char* name);
+extern "C" int horovod_mxnet_reducescatter_async(NDArray* tensor,
+                                                 NDArray* output, char* name,
+                                                 bool average);
+extern "C" int horovod_mxnet_alltoall_async(NDArray* tensor, NDArray* output,
+                                            char* name, int64_t* splits,
+                                            int num_splits);
 extern "C" int horovod_mxnet_broadcast_async(NDArray* tensor, NDArray* output,
                                              int root_rank, char* name);
 
@@ -111,6 +111,69 @@ def allreduce_(tensor, average=True, name=None):
     return tensor
 
 
+def _grouped_allreduce(tensors, outputs, average, name):
+    num_tensors = len(tensors)
+    c_in = (ctypes.c_void_p * num_tensors)(*[t.handle for t in tensors])
+    c_out = (ctypes.c_void_p * num_tensors)(*[t.handle for t in outputs])
+    if isinstance(name, string_types):
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_grouped_allreduce_async(
+            c_in, c_out, ctypes.c_int(num_tensors), c_str(name),
+            ctypes.c_bool(average)))
+    else:
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_grouped_allreduce_async(
+            c_in, c_out, ctypes.c_int(num_tensors), name,
+            ctypes.c_bool(average)))
+
+
+def grouped_allreduce(tensors, average=True, name=None):
+    """
+    A function that performs averaging or summation of a group of input
+    tensors over all the Horovod processes. The input tensors are not modified.
+
+    The tensors of a group are submitted together and reduced in as few fused
+    operations as possible, instead of being fused with whichever tensors
+    happen to be ready at the same time. All processes must group the same
+    tensors in the same order. The tensors must be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to average and sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reduction operation. The tensors of the group are
+              named after it.
+
+    Returns:
+        A list of tensors of the same shapes and types as `tensors`, averaged
+        or summed across all processes.
+    """
+    outputs = [mx.nd.zeros(shape=tensor.shape, ctx=tensor.context,
+                           dtype=tensor.dtype) for tensor in tensors]
+    if tensors:
+        _grouped_allreduce(tensors, outputs, average, name)
+    return outputs
+
+
+def grouped_allreduce_(tensors, average=True, name=None):
+    """
+    A function that performs in-place averaging or summation of a group of
+    input tensors over all the Horovod processes.
+
+    See `grouped_allreduce()` for the requirements on the group.
+
+    Arguments:
+        tensors: A list of tensors to average and sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reduction operation.
+
+    Returns:
+        A list of the input tensors, averaged or summed across all processes.
+    """
+    if tensors:
+        _grouped_allreduce(tensors, tensors, average, name)
+    return tensors
+
+
 def allgather(tensor, name=None):
     """
     A function that concatenates the input tensor with the same input tensor on
@@ -148,6 +211,79 @@ def allgather(tensor, name=None):
     return output
 
 
+def reducescatter(tensor, average=True, name=None):
+    """
+    A function that performs averaging or summation of the input tensor over
+    all the Horovod processes, and scatters the result along the first
+    dimension. The input tensor is not modified.
+
+    The tensor type and shape must be the same on all Horovod processes for a
+    given name. The first dimension does not need to be divisible by the
+    number of processes: the first processes receive one slice more than the
+    others.
+
+    Arguments:
+        tensor: A tensor to average or sum and scatter.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reducescatter operation.
+
+    Returns:
+        A tensor of the same type as `tensor`, holding the slices of the
+        reduced tensor assigned to this process.
+    """
+    assert(isinstance(tensor, mx.nd.NDArray))
+    output = mx.nd.zeros(shape=tensor.shape, ctx=tensor.context,
+                         dtype=tensor.dtype)
+    c_in = tensor.handle
+    c_out = output.handle
+    if isinstance(name, string_types):
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_reducescatter_async(
+            c_in, c_out, c_str(name), ctypes.c_bool(average)))
+    else:
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_reducescatter_async(
+            c_in, c_out, name, ctypes.c_bool(average)))
+    return output
+
+
+def alltoall(tensor, splits=None, name=None):
+    """
+    A function that scatters slices of the input tensor to all Horovod
+    processes and gathers the slices sent by them. The input tensor is not
+    modified.
+
+    The slices are taken along the first dimension: `splits[i]` slices are
+    sent to process `i`, in order. If `splits` is not provided, the first
+    dimension must be divisible by the number of processes and the tensor is
+    split evenly. The input tensors on the different processes must have the
+    same rank and shape, except for the first dimension.
+
+    Arguments:
+        tensor: A tensor to distribute.
+        splits: A list with the number of slices to send to every process,
+                defaults to even splits.
+        name: A name of the alltoall operation.
+
+    Returns:
+        A tensor of the same type as `tensor`, holding the slices received
+        from all processes concatenated in rank order on dimension zero.
+    """
+    assert(isinstance(tensor, mx.nd.NDArray))
+    output = mx.nd.zeros(shape=tensor.shape, ctx=tensor.context,
+                         dtype=tensor.dtype)
+    c_in = tensor.handle
+    c_out = output.handle
+    splits = list(splits) if splits is not None else []
+    c_splits = (ctypes.c_int64 * len(splits))(*splits)
+    if isinstance(name, string_types):
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_alltoall_async(
+            c_in, c_out, c_str(name), c_splits, ctypes.c_int(len(splits))))
+    else:
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_alltoall_async(
+            c_in, c_out, name, c_splits, ctypes.c_int(len(splits))))
+    return output
+
+
 def broadcast(tensor, root_rank, name=None):
     """
     A function that broadcasts the input tensor on root rank to the same input
@@ -36,6 +36,9 @@ check_extension('horovod.tensorflow', 'HOROVOD_WITH_TENSORFLOW', __file__, 'mpi_
 
 from horovod.tensorflow.compression import Compression
 from horovod.tensorflow.mpi_ops import allgather, broadcast, _allreduce
+from horovod.tensorflow.mpi_ops import _grouped_allreduce
+from horovod.tensorflow.mpi_ops import reducescatter, alltoall
+from horovod.tensorflow.mpi_ops import sparse_allreduce
 from horovod.tensorflow.mpi_ops import init, shutdown
 from horovod.tensorflow.mpi_ops import size, local_size, rank, local_rank
 from horovod.tensorflow.mpi_ops import mpi_threads_supported
@@ -43,14 +46,39 @@ from horovod.tensorflow.util import _executing_eagerly
 
 import tensorflow as tf
 
+def _reduced_on_cpu(tensor, device):
+    """Returns whether the tensor is reduced on CPU, where Horovod can cast and
+    scale it while copying it for the reduction."""
+    device = device or tensor.device
+    return (bool(device) and
+            (tf.DeviceSpec.from_string(device).device_type or '').upper() == 'CPU')
+
+
+def _compressed_in_core(tensor, device, compression):
+    """Returns whether Horovod casts the tensor to float16 while copying it for
+    the reduction, instead of in a separate cast. This is only done for float32
+    tensors placed on CPU."""
+    return (compression is Compression.fp16 and
+            tensor.dtype.base_dtype == tf.float32 and
+            _reduced_on_cpu(tensor, device))
+
+
+def _averaged_in_core(tensor, device, average):
+    """Returns whether Horovod averages the tensor while copying the sum out of
+    the reduction, instead of in a separate division. This is only done for
+    floating point tensors placed on CPU."""
+    return (average and tensor.dtype.is_floating and
+            _reduced_on_cpu(tensor, device))
+
+
 def allreduce(tensor, average=True, device_dense='', device_sparse='',
               compression=Compression.none):
     """Perform an allreduce on a tf.Tensor or tf.IndexedSlices.
 
     This function performs a bandwidth-optimal ring allreduce on the input
-    tensor. If the input is an tf.IndexedSlices, the function instead does an
-    allgather on the values and the indices, effectively doing an allreduce on
-    the represented tensor.
+    tensor. If the input is an tf.IndexedSlices, the function instead does a
+    sparse allreduce on the values and the indices, which sums rows with the
+    same index inside Horovod and returns every index once.
 
     Arguments:
         tensor: tf.Tensor, tf.Variable, or tf.IndexedSlices to reduce.
@@ -63,7 +91,9 @@ def allreduce(tensor, average=True, device_dense='', device_sparse='',
                        if Horovod was built with HOROVOD_GPU_ALLGATHER.
         compression: Compression algorithm used to reduce the amount of data
                      sent and received by each worker node.  Defaults to not
-                     using compression.
+                     using compression. Float32 tensors placed on CPU and
+                     compressed to 16-bit are cast by Horovod while they are
+                     copied for the reduction.
 
     Returns:
         A tensor of the same shape and type as `tensor`, summed across all
@@ -71,12 +101,19 @@ def allreduce(tensor, average=True, device_dense='', device_sparse='',
     """
     if isinstance(tensor, tf.IndexedSlices):
         with tf.device(device_sparse):
-            # For IndexedSlices, do two allgathers instead of an allreduce.
+            # For IndexedSlices, gather the rows of all processes and sum the
+            # rows with the same index. The number of rows of the dense tensor
+            # lets Horovod reduce it instead once it is dense enough.
             horovod_size = tf.cast(size(), tensor.values.dtype)
-            values = allgather(tensor.values)
-            indices = allgather(tensor.indices)
-
-            # To make this operation into an average, divide allgathered values by
+            dense_rows = 0
+            if tensor.dense_shape is not None:
+                dense_rows = tf.cast(tensor.dense_shape[0], tf.int64)
+            # Sparse allreduce is only implemented on CPU.
+            with tf.device('/cpu:0'):
+                values, indices = sparse_allreduce(tensor.values,
+                                                   tensor.indices, dense_rows)
+
+            # To make this operation into an average, divide summed values by
             # the Horovod size.
             new_values = tf.div(values, horovod_size) if average else values
         return tf.IndexedSlices(new_values, indices,
@@ -84,14 +121,79 @@ def allreduce(tensor, average=True, device_dense='', device_sparse='',
     else:
         with tf.device(device_dense):
             horovod_size = tf.cast(size(), dtype=tensor.dtype)
-            tensor_compressed, ctx = compression.compress(tensor)
-            summed_tensor_compressed = _allreduce(tensor_compressed)
-            summed_tensor = compression.decompress(summed_tensor_compressed, ctx)
+            if _compressed_in_core(tensor, device_dense, compression):
+                averaged_in_core = _averaged_in_core(tensor, device_dense,
+                                                     average)
+                summed_tensor = _allreduce(
+                    tensor, compressed=True,
+                    postscale_factor=1.0 / size() if averaged_in_core else 1.0)
+            else:
+                tensor_compressed, ctx = compression.compress(tensor)
+                averaged_in_core = _averaged_in_core(tensor_compressed,
+                                                     device_dense, average)
+                summed_tensor_compressed = _allreduce(
+                    tensor_compressed,
+                    postscale_factor=1.0 / size() if averaged_in_core else 1.0)
+                summed_tensor = compression.decompress(summed_tensor_compressed,
+                                                       ctx)
+            # Horovod rejects scale factors for GPU tensors, whose sum is
+            # divided here instead.
             new_tensor = (tf.div(summed_tensor, horovod_size)
-                          if average else summed_tensor)
+                          if average and not averaged_in_core else summed_tensor)
         return new_tensor
 
 
+def grouped_allreduce(tensors, average=True, device_dense='',
+                      compression=Compression.none):
+    """Perform an allreduce on a list of dense tf.Tensors at once.
+
+    Tensors of the same type are enqueued together, negotiated as a unit and
+    only fused with each other, in order, in as few fused operations as the
+    fusion threshold allows. All ranks must group the same tensors together.
+
+    Arguments:
+        tensors: List of tf.Tensor or tf.Variable to reduce.
+                 The shapes of the inputs must be identical across all ranks.
+        average: If True, computes the average over all ranks.
+                 Otherwise, computes the sum over all ranks.
+        device_dense: Device to be used for the tensors. Uses GPU by default
+                      if Horovod was built with HOROVOD_GPU_ALLREDUCE.
+        compression: Compression algorithm used to reduce the amount of data
+                     sent and received by each worker node.  Defaults to not
+                     using compression.
+
+    Returns:
+        A list of tensors of the same shapes and types as `tensors`, summed
+        across all processes.
+    """
+    results = [None] * len(tensors)
+    with tf.device(device_dense):
+        compressed = [compression.compress(tensor) for tensor in tensors]
+
+        # Each group holds the tensors of a single type.
+        indices_by_dtype = {}
+        for i, (tensor_compressed, _) in enumerate(compressed):
+            indices_by_dtype.setdefault(tensor_compressed.dtype, []).append(i)
+
+        for indices in indices_by_dtype.values():
+            # Horovod averages the group if all of its tensors are on CPU.
+            averaged_in_core = all(
+                _averaged_in_core(compressed[i][0], device_dense, average)
+                for i in indices)
+            postscale_factor = 1.0 / size() if averaged_in_core else 1.0
+            summed = _grouped_allreduce([compressed[i][0] for i in indices],
+                                        postscale_factor=postscale_factor)
+            for i, summed_tensor_compressed in zip(indices, summed):
+                tensor = tensors[i]
+                summed_tensor = compression.decompress(summed_tensor_compressed,
+                                                       compressed[i][1])
+                if average and not averaged_in_core:
+                    horovod_size = tf.cast(size(), dtype=tensor.dtype)
+                    summed_tensor = tf.div(summed_tensor, horovod_size)
+                results[i] = summed_tensor
+    return results
+
+
 def broadcast_global_variables(root_rank):
     """Broadcasts all global variables from root rank to all other processes.
 
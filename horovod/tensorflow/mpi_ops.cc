@@ -14,7 +14,9 @@
 // limitations under the License.
 // =============================================================================
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include <unordered_map>
@@ -30,6 +32,7 @@
 #endif
 
 #define OMPI_SKIP_MPICXX
+#include "../common/object_pool.h"
 #include "../common/operations.h"
 
 using namespace tensorflow;
@@ -109,7 +112,8 @@ protected:
 
 class TFOpContext : public common::OpContext {
 public:
-  TFOpContext(OpKernelContext* context);
+  // Outputs are allocated as output output_index of the kernel.
+  TFOpContext(OpKernelContext* context, int output_index = 0);
   virtual common::Status AllocatePersistent(
       int64_t size, std::shared_ptr<common::PersistentBuffer>* tensor) override;
   virtual common::Status
@@ -120,6 +124,7 @@ public:
 
 private:
   OpKernelContext* context_ = nullptr;
+  int output_index_ = 0;
 };
 
 #if HAVE_CUDA
@@ -209,7 +214,8 @@ const void* TFTensor::data() const { return (const void*)tensor_.tensor_data().d
 
 int64_t TFTensor::size() const { return (int64_t)tensor_.tensor_data().size(); }
 
-TFOpContext::TFOpContext(OpKernelContext* context) : context_(context) {}
+TFOpContext::TFOpContext(OpKernelContext* context, int output_index)
+    : context_(context), output_index_(output_index) {}
 
 common::Status TFOpContext::AllocatePersistent(
     int64_t size, std::shared_ptr<common::PersistentBuffer>* tensor) {
@@ -229,9 +235,9 @@ TFOpContext::AllocateOutput(common::TensorShape shape,
     tf_shape.AddDim(shape.dim_size(idx));
   }
   Tensor* tf_tensor;
-  Status status = context_->allocate_output(0, tf_shape, &tf_tensor);
+  Status status = context_->allocate_output(output_index_, tf_shape, &tf_tensor);
   if (status.ok()) {
-    *tensor = std::make_shared<TFTensor>(*tf_tensor);
+    *tensor = common::MakePooled<TFTensor>(*tf_tensor);
   }
 #if HAVE_CUDA
   // On GPU allocation is asynchronous, we need to wait for it to
@@ -276,7 +282,11 @@ common::ReadyEvent* RecordReadyEvent(OpKernelContext* context) {
 class HorovodAllreduceOp : public AsyncOpKernel {
 public:
   explicit HorovodAllreduceOp(OpKernelConstruction* context)
-      : AsyncOpKernel(context) {}
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("compression", &compression_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("postscale_factor", &postscale_factor_));
+  }
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
@@ -290,17 +300,22 @@ public:
         context, context->allocate_output(0, tensor.shape(), &output), done);
     // ReadyEvent makes sure input tensor is ready, and output is allocated.
     auto ready_event = std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context));
-    auto hvd_context = std::make_shared<TFOpContext>(context);
-    auto hvd_tensor = std::make_shared<TFTensor>(tensor);
-    auto hvd_output = std::make_shared<TFTensor>(*output);
+    auto hvd_context = common::MakePooled<TFOpContext>(context);
+    auto hvd_tensor = common::MakePooled<TFTensor>(tensor);
+    auto hvd_output = common::MakePooled<TFTensor>(*output);
     auto enqueue_result = EnqueueTensorAllreduce(
         hvd_context, hvd_tensor, hvd_output, ready_event, node_name, device,
         [context, done](const common::Status& status) {
           context->SetStatus(ConvertStatus(status));
           done();
-        });
+        },
+        1.0, postscale_factor_, (common::Compression)compression_);
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
   }
+
+private:
+  int compression_;
+  float postscale_factor_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("HorovodAllreduce").Device(DEVICE_CPU),
@@ -312,6 +327,8 @@ REGISTER_KERNEL_BUILDER(Name("HorovodAllreduce").Device(DEVICE_GPU),
 
 REGISTER_OP("HorovodAllreduce")
     .Attr("T: {int32, int64, float16, float32, float64}")
+    .Attr("compression: int = 0")
+    .Attr("postscale_factor: float = 1.0")
     .Input("tensor: T")
     .Output("sum: T")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
@@ -325,12 +342,115 @@ Tensors are reduced with other tensors that have the same node name for the
 allreduce.
 
 Arguments
-    tensor:     A tensor to reduce.
+    tensor:       A tensor to reduce.
+    compression:  1 to cast a float32 CPU tensor to float16 while it is copied
+                  for the reduction, 0 to reduce it as is.
+    postscale_factor:  Factor the sum of a CPU tensor is multiplied by while it
+                       is copied out of the reduction, e.g. 1 / size to average.
 
 Output
     sum:    A tensor with the same shape as `tensor`, summed across all MPI processes.
 )doc");
 
+class HorovodGroupedAllreduceOp : public AsyncOpKernel {
+public:
+  explicit HorovodGroupedAllreduceOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_tensors", &num_tensors_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("postscale_factor", &postscale_factor_));
+  }
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
+                         done);
+
+    auto node_name = name();
+    auto device = GetDeviceID(context);
+    // All inputs are ready once the event recorded for the op is.
+    auto ready_event = std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context));
+    auto hvd_context = common::MakePooled<TFOpContext>(context);
+
+    // The op is done once the last tensor of the group is reduced.
+    struct GroupState {
+      std::atomic_int remaining;
+      std::mutex mutex;
+    };
+    auto group_state = common::MakePooled<GroupState>();
+    group_state->remaining = num_tensors_;
+
+    std::vector<std::shared_ptr<common::OpContext>> hvd_contexts(num_tensors_,
+                                                                 hvd_context);
+    std::vector<std::shared_ptr<common::ReadyEvent>> ready_events(num_tensors_,
+                                                                  ready_event);
+    std::vector<std::shared_ptr<common::Tensor>> hvd_tensors;
+    std::vector<std::shared_ptr<common::Tensor>> hvd_outputs;
+    std::vector<std::string> names;
+    std::vector<common::StatusCallback> callbacks;
+    for (int i = 0; i < num_tensors_; ++i) {
+      auto tensor = context->input(i);
+      Tensor* output;
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(i, tensor.shape(), &output), done);
+      hvd_tensors.push_back(common::MakePooled<TFTensor>(tensor));
+      hvd_outputs.push_back(common::MakePooled<TFTensor>(*output));
+      names.push_back(node_name + "_" + std::to_string(i));
+      callbacks.push_back(
+          [context, done, group_state](const common::Status& status) {
+            if (!status.ok()) {
+              std::lock_guard<std::mutex> guard(group_state->mutex);
+              context->SetStatus(ConvertStatus(status));
+            }
+            if (group_state->remaining.fetch_sub(1) == 1) {
+              done();
+            }
+          });
+    }
+    auto enqueue_result = EnqueueTensorAllreduces(
+        hvd_contexts, hvd_tensors, hvd_outputs, ready_events, names, device,
+        callbacks, 1.0, postscale_factor_);
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+
+private:
+  int num_tensors_;
+  float postscale_factor_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("HorovodGroupedAllreduce").Device(DEVICE_CPU),
+                        HorovodGroupedAllreduceOp);
+#if HOROVOD_GPU_ALLREDUCE
+REGISTER_KERNEL_BUILDER(Name("HorovodGroupedAllreduce").Device(DEVICE_GPU),
+                        HorovodGroupedAllreduceOp);
+#endif
+
+REGISTER_OP("HorovodGroupedAllreduce")
+    .Attr("T: {int32, int64, float16, float32, float64}")
+    .Attr("num_tensors: int >= 1")
+    .Attr("postscale_factor: float = 1.0")
+    .Input("tensors: num_tensors * T")
+    .Output("sums: num_tensors * T")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      for (int i = 0; i < c->num_inputs(); ++i) {
+        c->set_output(i, c->input(i));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform an MPI Allreduce on a group of tensors, which are negotiated together
+and only fused with each other. All other processes must reduce the same group
+of tensors with the same node name.
+
+Arguments
+    tensors:    Tensors to reduce.
+    postscale_factor:  Factor the sums of CPU tensors are multiplied by while
+                       they are copied out of the reduction, e.g. 1 / size to
+                       average.
+
+Output
+    sums:    Tensors with the same shapes as `tensors`, summed across all MPI processes.
+)doc");
+
 class HorovodAllgatherOp : public AsyncOpKernel {
 public:
   explicit HorovodAllgatherOp(OpKernelConstruction* context)
@@ -347,8 +467,8 @@ public:
     // output for allgather, since shape of result is only known after all
     // ranks make a request.
     auto ready_event = std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context));
-    auto hvd_context = std::make_shared<TFOpContext>(context);
-    auto hvd_tensor = std::make_shared<TFTensor>(tensor);
+    auto hvd_context = common::MakePooled<TFOpContext>(context);
+    auto hvd_tensor = common::MakePooled<TFTensor>(tensor);
     auto enqueue_result = EnqueueTensorAllgather(
         hvd_context, hvd_tensor, ready_event, node_name, device,
         [context, done](const common::Status& status) {
@@ -390,6 +510,203 @@ Output
     gathered:    A tensor with the same shape as `tensor` except for the first dimension.
 )doc");
 
+class HorovodReducescatterOp : public AsyncOpKernel {
+public:
+  explicit HorovodReducescatterOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
+                         done);
+
+    auto node_name = name();
+    auto device = GetDeviceID(context);
+    auto tensor = context->input(0);
+    // The output is allocated once the response is received, like the output
+    // of allgather.
+    auto ready_event = std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context));
+    auto hvd_context = common::MakePooled<TFOpContext>(context);
+    auto hvd_tensor = common::MakePooled<TFTensor>(tensor);
+    auto enqueue_result = EnqueueTensorReducescatter(
+        hvd_context, hvd_tensor, ready_event, node_name, device,
+        [context, done](const common::Status& status) {
+          context->SetStatus(ConvertStatus(status));
+          done();
+        });
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("HorovodReducescatter").Device(DEVICE_CPU),
+                        HorovodReducescatterOp);
+
+REGISTER_OP("HorovodReducescatter")
+    .Attr("T: {int32, int64, float16, float32, float64}")
+    .Input("tensor: T")
+    .Output("sum: T")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(
+          c->ReplaceDim(c->input(0), 0, c->UnknownDim(), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform an MPI Reduce_scatter on a tensor. All other processes that do a
+reducescatter on a tensor with the same name must have the same dimension for
+that tensor. The first dimension is split as evenly as possible between the
+processes, and each process receives the sum of its part.
+
+Arguments
+    tensor:     A tensor to reduce.
+
+Output
+    sum:    A tensor with the same shape as `tensor` except for the first dimension,
+            holding the part of this process of `tensor` summed across all MPI processes.
+)doc");
+
+class HorovodAlltoallOp : public AsyncOpKernel {
+public:
+  explicit HorovodAlltoallOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
+                         done);
+
+    auto node_name = name();
+    auto device = GetDeviceID(context);
+    auto tensor = context->input(0);
+    auto splits_tensor = context->input(1);
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVector(splits_tensor.shape()),
+        errors::InvalidArgument("splits must be a vector."), done);
+    std::vector<int64_t> splits;
+    auto splits_flat = splits_tensor.flat<int32>();
+    for (int i = 0; i < splits_flat.size(); ++i) {
+      splits.push_back(splits_flat(i));
+    }
+    // The output is allocated once the response is received, like the output
+    // of allgather.
+    auto ready_event = std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context));
+    auto hvd_context = common::MakePooled<TFOpContext>(context);
+    auto hvd_tensor = common::MakePooled<TFTensor>(tensor);
+    auto enqueue_result = EnqueueTensorAlltoall(
+        hvd_context, hvd_tensor, splits, ready_event, node_name, device,
+        [context, done](const common::Status& status) {
+          context->SetStatus(ConvertStatus(status));
+          done();
+        });
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("HorovodAlltoall").Device(DEVICE_CPU),
+                        HorovodAlltoallOp);
+
+REGISTER_OP("HorovodAlltoall")
+    .Attr(
+        "T: {uint8, int8, uint16, int16, int32, int64, float16, float32, float64, bool}")
+    .Input("tensor: T")
+    .Input("splits: int32")
+    .Output("output: T")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(
+          c->ReplaceDim(c->input(0), 0, c->UnknownDim(), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform an MPI Alltoallv on a tensor. All other processes that do an alltoall
+on a tensor with the same name must have the same rank for that tensor, and
+have the same dimension on all but the first dimension.
+
+Arguments
+    tensor:     A tensor to distribute.
+    splits:     Number of slices of the first dimension of `tensor` sent to
+                every process, or an empty vector to send the same number to
+                every process.
+
+Output
+    output:    A tensor with the same shape as `tensor` except for the first
+               dimension, holding the slices received from every process,
+               ordered by rank.
+)doc");
+
+class HorovodSparseAllreduceOp : public AsyncOpKernel {
+public:
+  explicit HorovodSparseAllreduceOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
+                         done);
+
+    auto node_name = name();
+    auto device = GetDeviceID(context);
+    auto values = context->input(0);
+    auto indices = context->input(1);
+    auto dense_rows_tensor = context->input(2);
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsScalar(dense_rows_tensor.shape()),
+        errors::InvalidArgument("dense_rows must be a scalar."), done);
+    int64_t dense_rows = dense_rows_tensor.scalar<int64>()();
+    // Both outputs are allocated once the rows of all processes are known.
+    auto ready_event = std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context));
+    auto hvd_context = common::MakePooled<TFOpContext>(context, 0);
+    auto hvd_indices_context = common::MakePooled<TFOpContext>(context, 1);
+    auto hvd_values = common::MakePooled<TFTensor>(values);
+    auto hvd_indices = common::MakePooled<TFTensor>(indices);
+    auto enqueue_result = EnqueueTensorSparseAllreduce(
+        hvd_context, hvd_indices_context, hvd_indices, hvd_values, dense_rows,
+        ready_event, node_name, device,
+        [context, done](const common::Status& status) {
+          context->SetStatus(ConvertStatus(status));
+          done();
+        });
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("HorovodSparseAllreduce").Device(DEVICE_CPU),
+                        HorovodSparseAllreduceOp);
+
+REGISTER_OP("HorovodSparseAllreduce")
+    .Attr("T: {int32, int64, float16, float32, float64}")
+    .Attr("Tindices: {int32, int64}")
+    .Input("values: T")
+    .Input("indices: Tindices")
+    .Input("dense_rows: int64")
+    .Output("sum: T")
+    .Output("sum_indices: Tindices")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(
+          c->ReplaceDim(c->input(0), 0, c->UnknownDim(), &output));
+      c->set_output(0, output);
+      c->set_output(1, c->Vector(c->UnknownDim()));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform an allreduce on a sparse tensor given as rows and their indices. All
+other processes that do a sparse allreduce on a tensor with the same name must
+have the same dimension for that tensor except for the first one, and the same
+`dense_rows`. Rows with the same index are summed, within and across processes.
+
+Arguments
+    values:     Rows of the sparse tensor.
+    indices:    Index of every row of `values` in the dense tensor.
+    dense_rows: Number of rows of the dense tensor, or 0 if unknown. If the
+                rows of all processes would fill more than
+                HOROVOD_SPARSE_DENSITY_THRESHOLD of the dense tensor, all its
+                rows are reduced instead.
+
+Output
+    sum:            Summed rows, one for every index in `sum_indices`.
+    sum_indices:    Indices present on any process, in increasing order.
+)doc");
+
 class HorovodBroadcastOp : public AsyncOpKernel {
 public:
   explicit HorovodBroadcastOp(OpKernelConstruction* context)
@@ -413,11 +730,11 @@ public:
     }
     // ReadyEvent makes sure input tensor is ready, and output is allocated.
     auto ready_event = std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context));
-    auto hvd_context = std::make_shared<TFOpContext>(context);
-    auto hvd_tensor = std::make_shared<TFTensor>(tensor);
+    auto hvd_context = common::MakePooled<TFOpContext>(context);
+    auto hvd_tensor = common::MakePooled<TFTensor>(tensor);
     std::shared_ptr<TFTensor> hvd_output = nullptr;
     if (output != nullptr) {
-      hvd_output = std::make_shared<TFTensor>(*output);
+      hvd_output = common::MakePooled<TFTensor>(*output);
     }
     auto enqueue_result = EnqueueTensorBroadcast(
         hvd_context, hvd_tensor, hvd_output, root_rank_, ready_event, node_name,
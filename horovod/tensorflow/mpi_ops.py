@@ -56,7 +56,9 @@ def _load_library(name, op_list=None):
 
 
 MPI_LIB = _load_library('mpi_lib' + get_ext_suffix(),
-                        ['HorovodAllgather', 'HorovodAllreduce'])
+                        ['HorovodAllgather', 'HorovodAllreduce',
+                         'HorovodGroupedAllreduce', 'HorovodReducescatter',
+                         'HorovodAlltoall'])
 
 _basics = _HorovodBasics(__file__, 'mpi_lib')
 
@@ -75,12 +77,16 @@ def _normalize_name(name):
     return re.sub('[^a-zA-Z0-9_]', '_', name)
 
 
-def _allreduce(tensor, name=None):
+def _allreduce(tensor, name=None, compressed=False, postscale_factor=1.0):
     """An op which sums an input tensor over all the Horovod processes.
 
     The reduction operation is keyed by the name of the op. The tensor type and
     shape must be the same on all Horovod processes for a given name. The reduction
     will not start until all processes are ready to send and receive the tensor.
+    If `compressed` is True, the tensor, which must be a float32 tensor on CPU,
+    is cast to float16 while it is copied for the reduction, and the result is
+    cast back. The sum of a CPU tensor is multiplied by `postscale_factor` while
+    it is copied out of the reduction.
 
     Returns:
       A tensor of the same shape and type as `tensor`, summed across all
@@ -88,7 +94,9 @@ def _allreduce(tensor, name=None):
     """
     if name is None and not _executing_eagerly():
         name = 'HorovodAllreduce_%s' % _normalize_name(tensor.name)
-    return MPI_LIB.horovod_allreduce(tensor, name=name)
+    return MPI_LIB.horovod_allreduce(tensor, name=name,
+                                     compression=1 if compressed else 0,
+                                     postscale_factor=postscale_factor)
 
 
 @ops.RegisterGradient('HorovodAllreduce')
@@ -102,7 +110,42 @@ def _allreduce_grad(op, grad):
     Returns:
       The gradient with respect to the input of the op.
     """
-    return _allreduce(grad)
+    return _allreduce(grad, compressed=op.get_attr('compression') != 0,
+                      postscale_factor=op.get_attr('postscale_factor'))
+
+
+def _grouped_allreduce(tensors, name=None, postscale_factor=1.0):
+    """An op which sums a group of input tensors of the same type over all the
+    Horovod processes.
+
+    The tensors are negotiated together, and only fused with each other. The
+    group is keyed by the name of the op, and must contain tensors of the same
+    types and shapes on all Horovod processes. The sums of CPU tensors are
+    multiplied by `postscale_factor` while they are copied out of the reduction.
+
+    Returns:
+      A list of tensors of the same shapes and type as `tensors`, summed across
+      all processes.
+    """
+    if name is None and not _executing_eagerly():
+        name = 'HorovodGroupedAllreduce_%s' % _normalize_name(tensors[0].name)
+    return MPI_LIB.horovod_grouped_allreduce(tensors, name=name,
+                                             postscale_factor=postscale_factor)
+
+
+@ops.RegisterGradient('HorovodGroupedAllreduce')
+def _grouped_allreduce_grad(op, *grads):
+    """Gradient for grouped allreduce op.
+
+    Args:
+      op: An operation.
+      grads: `Tensor` gradients with respect to the outputs of the op.
+
+    Returns:
+      The gradients with respect to the inputs of the op.
+    """
+    return _grouped_allreduce(list(grads),
+                              postscale_factor=op.get_attr('postscale_factor'))
 
 
 def allgather(tensor, name=None):
@@ -148,6 +191,108 @@ def _allgather_grad(op, grad):
     return splits[rank()]
 
 
+def reducescatter(tensor, name=None):
+    """An op which sums an input tensor over all the Horovod processes, and
+    scatters the result on the first dimension.
+
+    The first dimension is split as evenly as possible between the processes,
+    the first processes receiving one more slice if it is not divisible by the
+    number of processes. The reduction operation is keyed by the name of the op.
+    The tensor type and shape must be the same on all Horovod processes for a
+    given name.
+
+    Returns:
+      A tensor of the same type as `tensor`, holding the part of this process of
+      `tensor` summed across all processes. The shape is identical to the input
+      shape, except for the first dimension.
+    """
+    if name is None and not _executing_eagerly():
+        name = 'HorovodReducescatter_%s' % _normalize_name(tensor.name)
+    return MPI_LIB.horovod_reducescatter(tensor, name=name)
+
+
+@ops.RegisterGradient('HorovodReducescatter')
+def _reducescatter_grad(op, grad):
+    """Gradient for reducescatter op.
+
+    Args:
+      op: An operation.
+      grad: `Tensor` gradient with respect to the output of the op.
+
+    Returns:
+      The gradient with respect to the input of the op.
+    """
+    return allgather(grad)
+
+
+def alltoall(tensor, splits=None, name=None):
+    """An op which sends slices of the first dimension of the input tensor to
+    all other Horovod processes, and receives their slices.
+
+    `splits[i]` consecutive slices are sent to process `i`, in order. If
+    `splits` is None, the same number of slices is sent to every process. The
+    input tensors on the different processes must have the same rank and shape,
+    except for the first dimension.
+
+    Returns:
+      A tensor of the same type as `tensor`, holding the slices received from
+      every process, concatenated on dimension zero in the order of the ranks.
+    """
+    if splits is None:
+        splits = tf.zeros([0], dtype=tf.int32)
+    else:
+        splits = tf.cast(splits, tf.int32)
+    if name is None and not _executing_eagerly():
+        name = 'HorovodAlltoall_%s' % _normalize_name(tensor.name)
+    return MPI_LIB.horovod_alltoall(tensor, splits, name=name)
+
+
+@ops.RegisterGradient('HorovodAlltoall')
+def _alltoall_grad(op, grad):
+    """Gradient for alltoall op.
+
+    Args:
+      op: An operation.
+      grad: `Tensor` gradient with respect to the output of the op.
+
+    Returns:
+      The gradients with respect to the inputs of the op.
+    """
+    # Send the gradients of the received slices back to their processes.
+    splits = op.inputs[1]
+    num_rows = tf.shape(op.inputs[0])[0]
+    splits = tf.cond(tf.size(splits) > 0, lambda: splits,
+                     lambda: tf.fill([size()], num_rows // size()))
+    received_splits = alltoall(splits)
+    return [alltoall(grad, splits=received_splits), None]
+
+
+def sparse_allreduce(values, indices, dense_rows=0, name=None):
+    """An op which sums a sparse tensor over all the Horovod processes.
+
+    The sparse tensor is given as rows `values` and the index of every row in
+    the dense tensor, `indices`. Rows with the same index are summed, within
+    and across processes, by Horovod. The reduction operation is keyed by the
+    name of the op. The type and shape of `values` except for the first
+    dimension, and `dense_rows`, must be the same on all Horovod processes for a
+    given name.
+
+    `dense_rows` is the number of rows of the dense tensor, or 0 if unknown. If
+    it is known and the rows of all processes would fill more than
+    `HOROVOD_SPARSE_DENSITY_THRESHOLD` of the dense tensor, the dense tensor is
+    reduced instead, and the result holds all of its rows.
+
+    Returns:
+      A tuple of the summed rows and their indices, which are the indices
+      present on any process, in increasing order.
+    """
+    dense_rows = tf.cast(dense_rows, tf.int64)
+    if name is None and not _executing_eagerly():
+        name = 'HorovodSparseAllreduce_%s' % _normalize_name(values.name)
+    return MPI_LIB.horovod_sparse_allreduce(values, indices, dense_rows,
+                                            name=name)
+
+
 def broadcast(tensor, root_rank, name=None):
     """An op which broadcasts the input tensor on root rank to the same input tensor
     on all other Horovod processes.
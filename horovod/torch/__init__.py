@@ -28,15 +28,23 @@ except:
 
 from horovod.torch.compression import Compression
 from horovod.torch.mpi_ops import allreduce, allreduce_async, allreduce_, allreduce_async_
+from horovod.torch.mpi_ops import grouped_allreduce, grouped_allreduce_async
+from horovod.torch.mpi_ops import grouped_allreduce_, grouped_allreduce_async_
 from horovod.torch.mpi_ops import allgather, allgather_async
+from horovod.torch.mpi_ops import reducescatter, reducescatter_async
+from horovod.torch.mpi_ops import alltoall, alltoall_async
+from horovod.torch.mpi_ops import sparse_allreduce, sparse_allreduce_async
 from horovod.torch.mpi_ops import broadcast, broadcast_async, broadcast_, broadcast_async_
-from horovod.torch.mpi_ops import poll, synchronize
+from horovod.torch.mpi_ops import poll, synchronize, wait_all, wait_any
 from horovod.torch.mpi_ops import init, shutdown
 from horovod.torch.mpi_ops import size, local_size, rank, local_rank
 from horovod.torch.mpi_ops import mpi_threads_supported
+from horovod.torch.mpi_ops import _bucket_manager
+from horovod.torch.mpi_ops import _allreduce_async, _compressed_in_core
 
 import torch
 import collections
+import os
 
 
 class _DistributedOptimizer(torch.optim.Optimizer):
@@ -74,8 +82,18 @@ class _DistributedOptimizer(torch.optim.Optimizer):
         self._handles = {}
         self._grad_accs = []
         self._requires_update = set()
+        self._buckets = None
         if size() > 1:
-            self._register_hooks()
+            # Gradients are averaged in native buckets if a bucket size is set,
+            # unless they are compressed.
+            bucket_size = int(os.environ.get('HOROVOD_BUCKET_SIZE', 0))
+            if bucket_size > 0 and compression is Compression.none:
+                self._buckets = _bucket_manager(
+                    [p for param_group in self.param_groups
+                     for p in param_group['params'] if p.requires_grad],
+                    bucket_size, backward_passes_per_step)
+            if self._buckets is None:
+                self._register_hooks()
 
     @staticmethod
     def find_duplicates(lst):
@@ -91,6 +109,8 @@ class _DistributedOptimizer(torch.optim.Optimizer):
         self.backward_passes_per_step = passes
         for p in self._allreduce_delay:
             self._allreduce_delay[p] = self.backward_passes_per_step
+        if self._buckets is not None:
+            self._buckets.set_backward_passes_per_step(passes)
 
     def _register_hooks(self):
         for param_group in self.param_groups:
@@ -106,6 +126,15 @@ class _DistributedOptimizer(torch.optim.Optimizer):
     def _allreduce_grad_async(self, p):
         name = self._parameter_names.get(p)
         tensor = p.grad
+        if tensor.is_sparse:
+            # Sparse gradients are not compressed.
+            handle = sparse_allreduce_async(tensor, average=True, name=name)
+            return handle, None
+        if _compressed_in_core(tensor, self._compression):
+            # Horovod casts the gradient while reducing it in place, so the
+            # output is already float32 and decompressing it does nothing.
+            handle = _allreduce_async(tensor, tensor, True, name, compressed=True)
+            return handle, tensor.dtype
         tensor_compressed, ctx = self._compression.compress(tensor)
 
         handle = allreduce_async_(tensor_compressed, average=True, name=name)
@@ -130,6 +159,12 @@ class _DistributedOptimizer(torch.optim.Optimizer):
         return hook
 
     def synchronize(self):
+        if self._buckets is not None:
+            # The averaged gradients are read through their views into the
+            # buckets.
+            self._buckets.synchronize()
+            return
+
         missing_p = self._requires_update - set(self._handles.keys())
         for p in missing_p:
             handle, ctx = self._allreduce_grad_async(p)
@@ -140,10 +175,16 @@ class _DistributedOptimizer(torch.optim.Optimizer):
             if handle is None:
                 handle, ctx = self._allreduce_grad_async(p)
                 self._handles[p] = (handle, ctx)
+        # Block once for all the gradients, so that synchronize() below
+        # returns immediately for each of them.
+        wait_all(handle for handle, _ in self._handles.values())
         for p, (handle, _) in self._handles.items():
             output = synchronize(handle)
             self._allreduce_delay[p] = self.backward_passes_per_step
-            p.grad.set_(self._compression.decompress(output, ctx))
+            if output.is_sparse:
+                p.grad = output
+            else:
+                p.grad.set_(self._compression.decompress(output, ctx))
         self._handles.clear()
 
     def step(self, closure=None):
@@ -20,6 +20,7 @@
 #endif
 
 #include "adapter.h"
+#include "../common/object_pool.h"
 #include "cuda_util.h"
 #include "tensor_util.h"
 
@@ -127,7 +128,7 @@ TorchOpContext<DT, Dev, T>::AllocateOutput(TensorShape shape,
   }
   TensorUtil::ResizeNd<DT, Dev>(output_, shape.dims(), shape_array, nullptr);
   delete[] shape_array;
-  *tensor = std::make_shared<TorchTensor<DT, Dev, T>>(output_);
+  *tensor = MakePooled<TorchTensor<DT, Dev, T>>(output_);
   return Status::OK();
 }
 
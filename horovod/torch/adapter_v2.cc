@@ -14,6 +14,7 @@
 // =============================================================================
 
 #include "adapter_v2.h"
+#include "../common/object_pool.h"
 #include "cuda_util.h"
 
 namespace horovod {
@@ -93,7 +94,7 @@ Status TorchOpContext::AllocateOutput(TensorShape shape,
   }
   with_device device_context(device_);
   output_.resize_(shape_vector);
-  *tensor = std::make_shared<TorchTensor>(output_);
+  *tensor = MakePooled<TorchTensor>(output_);
   return Status::OK();
 }
 
@@ -0,0 +1,223 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <atomic>
+#include <exception>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+#include "bucket_manager.h"
+
+namespace horovod {
+namespace torch {
+
+namespace {
+
+// Managers are numbered in creation order, which is the same on all ranks,
+// so that their buckets have the same names everywhere.
+std::atomic_int manager_count;
+
+class BucketHook : public ::torch::autograd::FunctionPostHook {
+public:
+  BucketHook(std::weak_ptr<BucketManager> manager,
+             std::function<void(BucketManager&)> callback)
+      : manager_(std::move(manager)), callback_(std::move(callback)) {}
+
+  ::torch::autograd::variable_list
+  operator()(const ::torch::autograd::variable_list& outputs,
+             const ::torch::autograd::variable_list& inputs) override {
+    auto manager = manager_.lock();
+    if (manager) {
+      callback_(*manager);
+    }
+    return outputs;
+  }
+
+private:
+  std::weak_ptr<BucketManager> manager_;
+  std::function<void(BucketManager&)> callback_;
+};
+
+} // namespace
+
+std::shared_ptr<BucketManager>
+BucketManager::Create(const std::vector<::torch::Tensor>& params,
+                      int64_t bucket_bytes, int backward_passes_per_step,
+                      AllreduceFunction allreduce, WaitFunction wait) {
+  std::shared_ptr<BucketManager> manager(
+      new BucketManager(backward_passes_per_step, allreduce, wait));
+  manager->AssignBuckets(params, bucket_bytes);
+  manager->RegisterHooks();
+  return manager;
+}
+
+BucketManager::BucketManager(int backward_passes_per_step,
+                             AllreduceFunction allreduce, WaitFunction wait)
+    : backward_passes_per_step_(backward_passes_per_step),
+      allreduce_(std::move(allreduce)), wait_(std::move(wait)) {}
+
+void BucketManager::AssignBuckets(const std::vector<::torch::Tensor>& params,
+                                  int64_t bucket_bytes) {
+  // Bucket being filled and its size in bytes, per type and device.
+  std::map<std::tuple<int, int, int>, std::pair<size_t, int64_t>> open_buckets;
+  std::vector<int64_t> numels;
+  std::vector<at::TensorOptions> options;
+  for (size_t i = params.size(); i-- > 0;) {
+    Param param;
+    param.variable = ::torch::autograd::as_variable_ref(params[i]);
+    auto& data = param.variable.data();
+    auto key = std::make_tuple((int)data.scalar_type(),
+                               (int)data.device().type(),
+                               (int)data.device().index());
+    int64_t param_bytes = data.numel() * (int64_t)data.dtype().itemsize();
+    auto it = open_buckets.find(key);
+    if (it == open_buckets.end() ||
+        (it->second.second > 0 &&
+         it->second.second + param_bytes > bucket_bytes)) {
+      buckets_.emplace_back();
+      numels.push_back(0);
+      options.push_back(data.options());
+      open_buckets[key] = std::make_pair(buckets_.size() - 1, (int64_t)0);
+      it = open_buckets.find(key);
+    }
+    param.bucket = it->second.first;
+    param.offset = numels[param.bucket];
+    param.passes_left = backward_passes_per_step_;
+    it->second.second += param_bytes;
+    numels[param.bucket] += data.numel();
+    buckets_[param.bucket].num_params++;
+    params_.push_back(std::move(param));
+  }
+
+  int manager_id = manager_count.fetch_add(1);
+  for (size_t b = 0; b < buckets_.size(); ++b) {
+    auto& bucket = buckets_[b];
+    bucket.buffer = ::torch::autograd::make_variable(
+        at::zeros({numels[b]}, options[b]), /*requires_grad=*/false);
+    bucket.name = "allreduce.bucket." + std::to_string(manager_id) + "." +
+                  std::to_string(b);
+    bucket.pending = bucket.num_params;
+  }
+
+  // Point the gradients to their slices of the buckets. The gradients are
+  // plain variables over the bucket storage rather than autograd views, so
+  // that optimizers may still detach them in place.
+  for (auto& param : params_) {
+    auto& data = param.variable.data();
+    auto slice = buckets_[param.bucket]
+                     .buffer.data()
+                     .narrow(0, param.offset, data.numel())
+                     .view(data.sizes());
+    param.grad = ::torch::autograd::make_variable(slice,
+                                                  /*requires_grad=*/false);
+    auto& grad = param.variable.grad();
+    if (grad.defined()) {
+      param.grad.copy_(grad);
+    }
+    grad = param.grad;
+  }
+}
+
+void BucketManager::RegisterHooks() {
+  std::weak_ptr<BucketManager> self = shared_from_this();
+  for (size_t i = 0; i < params_.size(); ++i) {
+    auto& param = params_[i];
+    param.grad_accumulator = param.variable.grad_accumulator();
+    if (!param.grad_accumulator) {
+      throw std::invalid_argument(
+          "Parameters of a bucket must be leaves requiring gradients.");
+    }
+    param.grad_accumulator->add_post_hook(
+        std::unique_ptr<::torch::autograd::FunctionPostHook>(new BucketHook(
+            self, [i](BucketManager& manager) { manager.MarkReady(i); })));
+  }
+}
+
+void BucketManager::MarkReady(size_t param_index) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& param = params_[param_index];
+  if (param.passes_left <= 0) {
+    throw std::logic_error(
+        "Gradients were computed more than backward_passes_per_step times "
+        "before call to step(). Increase backward_passes_per_step to "
+        "accumulate gradients locally.");
+  }
+
+  // Move the gradient back into the bucket if it was replaced.
+  auto& grad = param.variable.grad();
+  if (!grad.defined() || grad.data_ptr() != param.grad.data_ptr()) {
+    if (grad.defined()) {
+      param.grad.copy_(grad);
+    } else {
+      param.grad.zero_();
+    }
+    grad = param.grad;
+  }
+
+  if (--param.passes_left == 0) {
+    auto& bucket = buckets_[param.bucket];
+    if (--bucket.pending == 0) {
+      EnqueueBucket(bucket);
+    }
+  }
+}
+
+void BucketManager::EnqueueBucket(Bucket& bucket) {
+  bucket.handle = allreduce_(bucket.buffer, bucket.name);
+}
+
+void BucketManager::Synchronize() {
+  std::vector<int> handles;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto& bucket : buckets_) {
+      if (bucket.handle == -1) {
+        EnqueueBucket(bucket);
+      }
+      handles.push_back(bucket.handle);
+      bucket.handle = -1;
+      bucket.pending = bucket.num_params;
+    }
+    for (auto& param : params_) {
+      param.passes_left = backward_passes_per_step_;
+    }
+  }
+  // Release all the handles before reporting the first error.
+  std::exception_ptr error;
+  for (auto handle : handles) {
+    try {
+      wait_(handle);
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void BucketManager::SetBackwardPassesPerStep(int passes) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  backward_passes_per_step_ = passes;
+  for (auto& param : params_) {
+    param.passes_left = passes;
+  }
+}
+
+} // namespace torch
+} // namespace horovod
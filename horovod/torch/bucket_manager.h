@@ -0,0 +1,118 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_TORCH_BUCKET_MANAGER_H
+#define HOROVOD_TORCH_BUCKET_MANAGER_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <torch/extension.h>
+#include <torch/torch.h>
+#include <torch/csrc/autograd/function.h>
+#include <torch/csrc/autograd/function_hook.h>
+#include <torch/csrc/autograd/variable.h>
+
+namespace horovod {
+namespace torch {
+
+// BucketManager averages the gradients of a set of parameters in flat
+// buckets, from autograd hooks registered in C++.
+//
+// Parameters are assigned to buckets of at most bucket_bytes bytes, of a
+// single type and device, in reverse registration order, which approximates
+// the order in which backward produces their gradients. The gradient of every
+// parameter is a view into its bucket, so autograd accumulates into the
+// bucket directly, and the averaged result is read through the gradient
+// without any copy. A bucket is enqueued from the hook of the last of its
+// parameters to receive a gradient, while backward is still running.
+class BucketManager : public std::enable_shared_from_this<BucketManager> {
+public:
+  // Enqueues an in-place allreduce averaging the tensor and returns its
+  // handle.
+  typedef std::function<int(::torch::Tensor, const std::string&)>
+      AllreduceFunction;
+
+  // Blocks until the operation of the handle has completed, releases it and
+  // throws if it failed.
+  typedef std::function<void(int)> WaitFunction;
+
+  // Creates the buckets of the parameters and registers the hooks. All ranks
+  // must pass the same parameters in the same order.
+  static std::shared_ptr<BucketManager>
+  Create(const std::vector<::torch::Tensor>& params, int64_t bucket_bytes,
+         int backward_passes_per_step, AllreduceFunction allreduce,
+         WaitFunction wait);
+
+  // Enqueues the buckets of parameters which did not receive a gradient in
+  // this step, and waits for all the buckets.
+  void Synchronize();
+
+  void SetBackwardPassesPerStep(int passes);
+
+private:
+  struct Param {
+    ::torch::autograd::Variable variable;
+    // Gradient accumulator the hook is registered on, which the variable only
+    // references weakly.
+    std::shared_ptr<::torch::autograd::Function> grad_accumulator;
+    // View of the bucket the gradient is accumulated into.
+    ::torch::autograd::Variable grad;
+    size_t bucket;
+    // Offset of the gradient in the bucket, in elements.
+    int64_t offset;
+    // Backward passes left before the gradient is ready.
+    int passes_left;
+  };
+
+  struct Bucket {
+    ::torch::autograd::Variable buffer;
+    std::string name;
+    // Parameters whose gradient is not ready yet.
+    size_t pending;
+    size_t num_params = 0;
+    // Handle of the allreduce, or -1 if the bucket is not enqueued yet.
+    int handle = -1;
+  };
+
+  BucketManager(int backward_passes_per_step, AllreduceFunction allreduce,
+                WaitFunction wait);
+
+  void AssignBuckets(const std::vector<::torch::Tensor>& params,
+                     int64_t bucket_bytes);
+
+  void RegisterHooks();
+
+  // Called by the hook of a parameter once its gradient is accumulated.
+  void MarkReady(size_t param_index);
+
+  void EnqueueBucket(Bucket& bucket);
+
+  std::vector<Param> params_;
+  std::vector<Bucket> buckets_;
+  int backward_passes_per_step_;
+  AllreduceFunction allreduce_;
+  WaitFunction wait_;
+  // Hooks of different devices run on different autograd threads.
+  std::mutex mutex_;
+};
+
+} // namespace torch
+} // namespace horovod
+
+#endif // HOROVOD_TORCH_BUCKET_MANAGER_H
@@ -13,42 +13,138 @@
 // limitations under the License.
 // =============================================================================
 
+#include <stdexcept>
+
 #include "handle_manager.h"
 
 namespace horovod {
 namespace torch {
 
+HandleManager::HandleManager(int capacity) : next_slot_(0), waiters_(0) {
+  index_bits_ = 0;
+  while ((1 << index_bits_) < capacity) {
+    ++index_bits_;
+  }
+  index_mask_ = (1u << index_bits_) - 1;
+  generation_mask_ = (1u << (31 - index_bits_)) - 1;
+  slots_.reset(new Slot[index_mask_ + 1]);
+  for (uint32_t i = 0; i <= index_mask_; ++i) {
+    slots_[i].state.store(FREE, std::memory_order_relaxed);
+  }
+}
+
 int HandleManager::AllocateHandle() {
-  int handle = last_handle_.fetch_add(1) + 1;
-  std::lock_guard<std::mutex> guard(mutex_);
-  results_[handle] = nullptr;
-  return handle;
+  for (uint32_t attempt = 0; attempt <= index_mask_; ++attempt) {
+    uint32_t index =
+        next_slot_.fetch_add(1, std::memory_order_relaxed) & index_mask_;
+    auto& slot = slots_[index];
+    uint32_t state = slot.state.load(std::memory_order_relaxed);
+    if ((state & STATE_MASK) != FREE) {
+      continue;
+    }
+    uint32_t generation = (state >> STATE_BITS) + 1;
+    if (slot.state.compare_exchange_strong(
+            state, generation << STATE_BITS | PENDING,
+            std::memory_order_acquire)) {
+      return (int)((generation & generation_mask_) << index_bits_ | index);
+    }
+  }
+  throw std::runtime_error("Too many outstanding handles: at most " +
+                           std::to_string(index_mask_ + 1) +
+                           " operations can be in flight.");
 }
 
 void HandleManager::MarkDone(int handle, const Status& status) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  results_[handle] = std::make_shared<Status>(status);
+  uint32_t state;
+  auto& slot = GetSlot(handle, state);
+  slot.status = status;
+  slot.state.store((state & ~STATE_MASK) | DONE);
+
+  // Waiters check the state with the mutex held before they block, so taking
+  // the mutex ensures that they either see the new state or get notified.
+  if (waiters_.load() > 0) {
+    { std::lock_guard<std::mutex> guard(mutex_); }
+    cond_.notify_all();
+  }
+}
+
+bool HandleManager::PollHandle(int handle) { return IsDone(handle); }
+
+void HandleManager::WaitForHandle(int handle) {
+  Wait([&] { return IsDone(handle); });
+}
+
+void HandleManager::WaitForAllHandles(const std::vector<int>& handles) {
+  for (auto handle : handles) {
+    WaitForHandle(handle);
+  }
 }
 
-bool HandleManager::PollHandle(int handle) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  if (results_.find(handle) == results_.end()) {
+int HandleManager::WaitForAnyHandle(const std::vector<int>& handles) {
+  if (handles.empty()) {
+    throw std::invalid_argument("No handles to wait for.");
+  }
+  int done_handle = -1;
+  Wait([&] {
+    for (auto handle : handles) {
+      if (IsDone(handle)) {
+        done_handle = handle;
+        return true;
+      }
+    }
+    return false;
+  });
+  return done_handle;
+}
+
+Status HandleManager::ReleaseHandle(int handle) {
+  uint32_t state;
+  auto& slot = GetSlot(handle, state);
+  if ((state & STATE_MASK) != DONE) {
+    throw std::invalid_argument("Handle " + std::to_string(handle) +
+                                " has not completed.");
+  }
+  auto status = slot.status;
+  if (!slot.state.compare_exchange_strong(state, (state & ~STATE_MASK) | FREE,
+                                          std::memory_order_release)) {
     throw std::invalid_argument("Handle " + std::to_string(handle) +
                                 " was not created or has been cleared.");
   }
-  return results_[handle] != nullptr;
+  return status;
 }
 
-std::shared_ptr<Status> HandleManager::ReleaseHandle(int handle) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  if (results_.find(handle) == results_.end()) {
+HandleManager::Slot& HandleManager::GetSlot(int handle, uint32_t& state) {
+  auto& slot = slots_[(uint32_t)handle & index_mask_];
+  state = slot.state.load(std::memory_order_acquire);
+  if (handle < 0 || (state & STATE_MASK) == FREE ||
+      ((state >> STATE_BITS) & generation_mask_) !=
+          (uint32_t)handle >> index_bits_) {
     throw std::invalid_argument("Handle " + std::to_string(handle) +
-        " was not created or has been cleared.");
+                                " was not created or has been cleared.");
   }
-  auto status = results_[handle];
-  results_.erase(handle);
-  return status;
+  return slot;
+}
+
+bool HandleManager::IsDone(int handle) {
+  uint32_t state;
+  GetSlot(handle, state);
+  return (state & STATE_MASK) == DONE;
+}
+
+template <class Predicate> void HandleManager::Wait(Predicate predicate) {
+  if (predicate()) {
+    return;
+  }
+  waiters_.fetch_add(1);
+  try {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, predicate);
+  } catch (...) {
+    waiters_.fetch_sub(1);
+    throw;
+  }
+  waiters_.fetch_sub(1);
 }
 
 } // namespace torch
-} // namespace horovod
\ No newline at end of file
+} // namespace horovod
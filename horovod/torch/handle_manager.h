@@ -17,9 +17,10 @@
 #define HOROVOD_TORCH_HANDLE_MANAGER_H
 
 #include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <vector>
 
 #include "../common/common.h"
 
@@ -28,17 +29,74 @@ namespace torch {
 
 using namespace horovod::common;
 
+// HandleManager tracks the completion of asynchronous operations.
+//
+// Handles index a fixed array of slots. The state of every slot (free, pending
+// or done) is published through an atomic word together with a generation,
+// which is bumped every time the slot is allocated and encoded in the handle,
+// so that stale handles are detected. Statuses are stored in the slots, and
+// allocating, completing, polling and releasing handles take no lock. The
+// mutex is only taken to block and wake up threads waiting for handles.
 class HandleManager {
 public:
+  // Capacity is the maximum number of outstanding handles, and is rounded up
+  // to a power of two.
+  explicit HandleManager(int capacity = 1 << 16);
+
   int AllocateHandle();
   void MarkDone(int handle, const Status& status);
   bool PollHandle(int handle);
-  std::shared_ptr<Status> ReleaseHandle(int handle);
+
+  // Blocks until the operation of the handle has completed.
+  void WaitForHandle(int handle);
+
+  // Blocks until the operations of all the handles have completed.
+  void WaitForAllHandles(const std::vector<int>& handles);
+
+  // Blocks until the operation of any of the handles has completed, and
+  // returns that handle.
+  int WaitForAnyHandle(const std::vector<int>& handles);
+
+  // Frees the handle of a completed operation and returns its status.
+  Status ReleaseHandle(int handle);
 
 private:
-  std::atomic_int last_handle_;
-  std::unordered_map<int, std::shared_ptr<Status>> results_;
+  struct Slot {
+    // Generation of the slot, shifted by STATE_BITS, and its state.
+    std::atomic<uint32_t> state;
+    Status status;
+  };
+
+  enum SlotState : uint32_t { FREE = 0, PENDING = 1, DONE = 2 };
+
+  static const int STATE_BITS = 2;
+  static const uint32_t STATE_MASK = (1u << STATE_BITS) - 1;
+
+  // Returns the slot of the handle, and loads its state word. Throws if the
+  // handle was not created or has been released.
+  Slot& GetSlot(int handle, uint32_t& state);
+
+  // Returns whether the operation of the handle has completed.
+  bool IsDone(int handle);
+
+  // Blocks until the predicate, which must only turn true once an operation
+  // completes, is true.
+  template <class Predicate> void Wait(Predicate predicate);
+
+  std::unique_ptr<Slot[]> slots_;
+  int index_bits_;
+  uint32_t index_mask_;
+
+  // Bits of the generation encoded in handles, which keeps them positive.
+  uint32_t generation_mask_;
+
+  // Slot at which the next allocation starts looking for a free slot.
+  std::atomic<uint32_t> next_slot_;
+
+  // Number of threads blocked in Wait, which MarkDone must wake up.
+  std::atomic_int waiters_;
   std::mutex mutex_;
+  std::condition_variable cond_;
 };
 
 } // namespace torch
@@ -13,10 +13,9 @@
 // limitations under the License.
 // =============================================================================
 
-#include <chrono>
 #include <memory>
-#include <thread>
 
+#include "../common/object_pool.h"
 #include "../common/operations.h"
 #include "adapter.h"
 #include "cuda_util.h"
@@ -48,20 +47,25 @@ int DoAllreduce(T* tensor, T* output, int average, char* name) {
   auto handle = handle_manager.AllocateHandle();
   auto device = TensorUtil::GetDevice<DT, Dev>(tensor);
   auto ready_event = RecordReadyEvent(device);
-  auto hvd_tensor = std::make_shared<TorchTensor<DT, Dev, T>>(tensor);
-  auto hvd_context =
-      std::make_shared<TorchOpContext<DT, Dev, T>>(device, output);
-  auto hvd_output = std::make_shared<TorchTensor<DT, Dev, T>>(output);
-
+  auto hvd_tensor = MakePooled<TorchTensor<DT, Dev, T>>(tensor);
+  auto hvd_context = MakePooled<TorchOpContext<DT, Dev, T>>(device, output);
+  auto hvd_output = MakePooled<TorchTensor<DT, Dev, T>>(output);
+
+  // Horovod averages CPU tensors while copying the result out of the fusion
+  // buffer.
+  bool divide_output = average && device != CPU_DEVICE_ID;
+  double postscale_factor =
+      average && device == CPU_DEVICE_ID ? 1.0 / horovod_size() : 1.0;
   auto enqueue_result = EnqueueTensorAllreduce(
       hvd_context, hvd_tensor, hvd_output, ready_event,
       GetOpName("allreduce", name, handle), device,
-      [handle, average, output](const Status& status) {
-        if (average) {
+      [handle, divide_output, output](const Status& status) {
+        if (divide_output) {
           TensorUtil::DivideTensorInPlace<DT, Dev, T>(output, horovod_size());
         }
         handle_manager.MarkDone(handle, status);
-      });
+      },
+      1.0, postscale_factor);
   ThrowIfError(enqueue_result);
 
   return handle;
@@ -75,26 +79,23 @@ int DoAllreduceCudaOnCPU(TC* tensor, TC* output, int average, char* name) {
   // Make async copy of input tensor to CPU tensor and record completion event.
   auto device = TensorUtil::GetDevice<DT, DeviceType::GPU>(tensor);
   auto hvd_cpu_buffer =
-      std::make_shared<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
+      MakePooled<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
           CPU_DEVICE_ID);
   TensorUtil::AsyncCopyCudaToCPU<DT>(tensor, hvd_cpu_buffer->tensor());
   auto ready_event = RecordReadyEvent(device);
 
-  auto hvd_context = std::make_shared<TorchOpContext<DT, DeviceType::CPU, T>>(
+  auto hvd_context = MakePooled<TorchOpContext<DT, DeviceType::CPU, T>>(
       CPU_DEVICE_ID, hvd_cpu_buffer->tensor());
 
   auto handle = handle_manager.AllocateHandle();
   auto enqueue_result = EnqueueTensorAllreduce(
       hvd_context, hvd_cpu_buffer, hvd_cpu_buffer, ready_event,
       GetOpName("allreduce", name, handle), CPU_DEVICE_ID,
-      [handle, average, hvd_cpu_buffer, output](const Status& status) {
+      [handle, hvd_cpu_buffer, output](const Status& status) {
         TensorUtil::CopyCPUToCuda<DT>(hvd_cpu_buffer->tensor(), output);
-        if (average) {
-          TensorUtil::DivideTensorInPlace<DT, DeviceType::GPU>(output,
-                                                               horovod_size());
-        }
         handle_manager.MarkDone(handle, status);
-      });
+      },
+      1.0, average ? 1.0 / horovod_size() : 1.0);
   ThrowIfError(enqueue_result);
 
   return handle;
@@ -107,9 +108,8 @@ int DoAllgather(T* tensor, T* output, char* name) {
 
   auto device = TensorUtil::GetDevice<DT, Dev>(tensor);
   auto ready_event = RecordReadyEvent(device);
-  auto hvd_tensor = std::make_shared<TorchTensor<DT, Dev, T>>(tensor);
-  auto hvd_context =
-      std::make_shared<TorchOpContext<DT, Dev, T>>(device, output);
+  auto hvd_tensor = MakePooled<TorchTensor<DT, Dev, T>>(tensor);
+  auto hvd_context = MakePooled<TorchOpContext<DT, Dev, T>>(device, output);
 
   auto handle = handle_manager.AllocateHandle();
   auto enqueue_result =
@@ -131,15 +131,15 @@ int DoAllgatherCudaOnCPU(TC* tensor, TC* output, char* name) {
   // Make async copy of input tensor to CPU tensor and record completion event.
   auto device = TensorUtil::GetDevice<DT, DeviceType::GPU>(tensor);
   auto hvd_cpu_tensor =
-      std::make_shared<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
+      MakePooled<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
           CPU_DEVICE_ID);
   TensorUtil::AsyncCopyCudaToCPU<DT>(tensor, hvd_cpu_tensor->tensor());
   auto ready_event = RecordReadyEvent(device);
 
   auto hvd_cpu_output =
-      std::make_shared<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
+      MakePooled<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
           CPU_DEVICE_ID);
-  auto hvd_context = std::make_shared<TorchOpContext<DT, DeviceType::CPU, T>>(
+  auto hvd_context = MakePooled<TorchOpContext<DT, DeviceType::CPU, T>>(
       CPU_DEVICE_ID, hvd_cpu_output->tensor());
 
   auto handle = handle_manager.AllocateHandle();
@@ -162,16 +162,15 @@ int DoBroadcast(T* tensor, T* output, int root_rank, char* name) {
 
   auto device = TensorUtil::GetDevice<DT, Dev>(tensor);
   auto ready_event = RecordReadyEvent(device);
-  auto hvd_tensor = std::make_shared<TorchTensor<DT, Dev, T>>(tensor);
-  auto hvd_context =
-      std::make_shared<TorchOpContext<DT, Dev, T>>(device, output);
+  auto hvd_tensor = MakePooled<TorchTensor<DT, Dev, T>>(tensor);
+  auto hvd_context = MakePooled<TorchOpContext<DT, Dev, T>>(device, output);
   std::shared_ptr<Tensor> hvd_output = nullptr;
   if (horovod_rank() == root_rank) {
     if (tensor != output) {
       TensorUtil::Copy<DT, Dev>(output, tensor);
     }
   } else {
-    hvd_output = std::make_shared<TorchTensor<DT, Dev, T>>(output);
+    hvd_output = MakePooled<TorchTensor<DT, Dev, T>>(output);
   }
 
   auto handle = handle_manager.AllocateHandle();
@@ -194,12 +193,12 @@ int DoBroadcastCudaOnCPU(TC* tensor, TC* output, int root_rank, char* name) {
   // Make async copy of input tensor to CPU tensor and record completion event.
   auto device = TensorUtil::GetDevice<DT, DeviceType::GPU>(tensor);
   auto hvd_cpu_buffer =
-      std::make_shared<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
+      MakePooled<TorchTemporaryBuffer<DT, DeviceType::CPU, T>>(
           CPU_DEVICE_ID);
   TensorUtil::AsyncCopyCudaToCPU<DT>(tensor, hvd_cpu_buffer->tensor());
   auto ready_event = RecordReadyEvent(device);
 
-  auto hvd_context = std::make_shared<TorchOpContext<DT, DeviceType::CPU, T>>(
+  auto hvd_context = MakePooled<TorchOpContext<DT, DeviceType::CPU, T>>(
       CPU_DEVICE_ID, hvd_cpu_buffer->tensor());
 
   auto handle = handle_manager.AllocateHandle();
@@ -391,11 +390,19 @@ extern "C" int horovod_torch_poll(int handle) {
 }
 
 extern "C" void horovod_torch_wait_and_clear(int handle) {
-  while (!handle_manager.PollHandle(handle)) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-  }
+  handle_manager.WaitForHandle(handle);
   auto status = handle_manager.ReleaseHandle(handle);
-  ThrowIfError(*status);
+  ThrowIfError(status);
+}
+
+extern "C" void horovod_torch_wait_all(int* handles, int num_handles) {
+  handle_manager.WaitForAllHandles(
+      std::vector<int>(handles, handles + num_handles));
+}
+
+extern "C" int horovod_torch_wait_any(int* handles, int num_handles) {
+  return handle_manager.WaitForAnyHandle(
+      std::vector<int>(handles, handles + num_handles));
 }
 
 } // namespace torch
@@ -89,6 +89,8 @@ BROADCAST_H(torch_cuda_DoubleTensor, THCudaDoubleTensor)
 
 extern "C" int horovod_torch_poll(int handle);
 extern "C" void horovod_torch_wait_and_clear(int handle);
+extern "C" void horovod_torch_wait_all(int* handles, int num_handles);
+extern "C" int horovod_torch_wait_any(int* handles, int num_handles);
 
 } // namespace torch
 } // namespace horovod
@@ -70,13 +70,27 @@ def _allreduce_function_factory(tensor):
     return 'horovod_torch_allreduce_async_' + tensor.type().replace('.', '_')
 
 
-def _allreduce_async(tensor, output, average, name):
+def _compressed_allreduce_function_factory(tensor):
+    return 'horovod_torch_allreduce_fp16_async_' + tensor.type().replace('.', '_')
+
+
+def _compressed_in_core(tensor, compression):
+    """Returns whether Horovod casts the tensor to float16 while copying it
+    into the buffer it is reduced in, instead of in a separate cast. This is
+    only done for float32 CPU tensors."""
+    return (compression is Compression.fp16 and _v2_api and
+            tensor.dtype == torch.float32 and not tensor.is_cuda)
+
+
+def _allreduce_async(tensor, output, average, name, compressed=False):
     if tensor.dtype == torch.float16 and not _fp16_supported:
         raise NotImplementedError(
             'float16 allreduce is not supported for PyTorch version {} < 1.0.0'
             .format(torch.__version__))
 
-    function = _check_function(_allreduce_function_factory, tensor)
+    function_factory = (_compressed_allreduce_function_factory if compressed
+                        else _allreduce_function_factory)
+    function = _check_function(function_factory, tensor)
     handle = getattr(mpi_lib, function)(tensor, output, average,
                                         name.encode() if name is not None else _NULL)
     _handle_map[handle] = (tensor, output)
@@ -111,14 +125,18 @@ class HorovodAllreduce(torch.autograd.Function):
     """An autograd function that performs allreduce on a tensor."""
 
     @staticmethod
-    def forward(ctx, tensor, average, name):
+    def forward(ctx, tensor, average, name, compressed=False):
         ctx.average = average
-        handle = allreduce_async(tensor, average, name)
+        ctx.compressed = compressed
+        output = tensor.new(tensor.shape)
+        handle = _allreduce_async(tensor, output, average, name, compressed)
         return synchronize(handle)
 
     @staticmethod
     def backward(ctx, grad_output):
-        return allreduce(grad_output, ctx.average), None, None
+        compression = Compression.fp16 if ctx.compressed else Compression.none
+        return allreduce(grad_output, ctx.average,
+                         compression=compression), None, None, None
 
 
 def allreduce(tensor, average=True, name=None, compression=Compression.none):
@@ -142,12 +160,15 @@ def allreduce(tensor, average=True, name=None, compression=Compression.none):
         name: A name of the reduction operation.
         compression: Compression algorithm used during allreduce to reduce the amount
                      of data sent during the each parameter update step.  Defaults to
-                     not using compression.
+                     not using compression. Float32 CPU tensors compressed to 16-bit
+                     are cast by Horovod while they are copied for the reduction.
 
     Returns:
         A tensor of the same shape and type as `tensor`, averaged or summed across all
         processes.
     """
+    if _compressed_in_core(tensor, compression):
+        return HorovodAllreduce.apply(tensor, average, name, True)
     tensor_compressed, ctx = compression.compress(tensor)
     summed_tensor_compressed = HorovodAllreduce.apply(tensor_compressed, average, name)
     return compression.decompress(summed_tensor_compressed, ctx)
@@ -200,6 +221,109 @@ def allreduce_(tensor, average=True, name=None):
     return synchronize(handle)
 
 
+def _grouped_allreduce_async(tensors, outputs, average, name):
+    if not _v2_api:
+        raise NotImplementedError(
+            'grouped allreduce is not supported for PyTorch version {} < 1.0.0'
+            .format(torch.__version__))
+
+    for tensor in tensors:
+        _check_function(_allreduce_function_factory, tensor)
+    handles = mpi_lib.horovod_torch_grouped_allreduce_async(
+        tensors, outputs, average, name if name is not None else _NULL)
+    for tensor, output, handle in zip(tensors, outputs, handles):
+        _handle_map[handle] = (tensor, output)
+    return handles
+
+
+def grouped_allreduce_async(tensors, average=True, name=None):
+    """
+    A function that performs asynchronous averaging or summation of a group of input
+    tensors over all the Horovod processes. The input tensors are not modified.
+
+    The tensors of a group are submitted together and reduced in as few fused
+    operations as possible, instead of being fused with whichever tensors happen to be
+    ready at the same time. All processes must group the same tensors in the same order.
+    The tensors must be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to average and sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reduction operation. The tensors of the group are named
+              after it.
+
+    Returns:
+        A list of handles to the allreduce operations, one per tensor, that can be
+        used with `poll()`, `synchronize()` or `wait_all()`.
+    """
+    outputs = [tensor.new(tensor.shape) for tensor in tensors]
+    return _grouped_allreduce_async(tensors, outputs, average, name)
+
+
+def grouped_allreduce(tensors, average=True, name=None):
+    """
+    A function that performs averaging or summation of a group of input tensors over
+    all the Horovod processes. The input tensors are not modified.
+
+    See `grouped_allreduce_async()` for the requirements on the group.
+
+    Arguments:
+        tensors: A list of tensors to average and sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reduction operation.
+
+    Returns:
+        A list of tensors of the same shapes and types as `tensors`, averaged or summed
+        across all processes.
+    """
+    handles = grouped_allreduce_async(tensors, average, name)
+    wait_all(handles)
+    return [synchronize(handle) for handle in handles]
+
+
+def grouped_allreduce_async_(tensors, average=True, name=None):
+    """
+    A function that performs asynchronous in-place averaging or summation of a group
+    of input tensors over all the Horovod processes.
+
+    See `grouped_allreduce_async()` for the requirements on the group.
+
+    Arguments:
+        tensors: A list of tensors to average and sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reduction operation.
+
+    Returns:
+        A list of handles to the allreduce operations, one per tensor, that can be
+        used with `poll()`, `synchronize()` or `wait_all()`.
+    """
+    return _grouped_allreduce_async(tensors, tensors, average, name)
+
+
+def grouped_allreduce_(tensors, average=True, name=None):
+    """
+    A function that performs in-place averaging or summation of a group of input
+    tensors over all the Horovod processes.
+
+    See `grouped_allreduce_async()` for the requirements on the group.
+
+    Arguments:
+        tensors: A list of tensors to average and sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reduction operation.
+
+    Returns:
+        A list of the input tensors, averaged or summed across all processes.
+    """
+    handles = grouped_allreduce_async_(tensors, average, name)
+    wait_all(handles)
+    return [synchronize(handle) for handle in handles]
+
+
 def _allgather_function_factory(tensor):
     return 'horovod_torch_allgather_async_' + tensor.type().replace('.', '_')
 
@@ -280,6 +404,243 @@ def allgather(tensor, name=None):
     return HorovodAllgather.apply(tensor, name)
 
 
+def _reducescatter_async(tensor, output, average, name):
+    if not _v2_api:
+        raise NotImplementedError(
+            'reducescatter is not supported for PyTorch version {} < 1.0.0'
+            .format(torch.__version__))
+
+    _check_function(_allreduce_function_factory, tensor)
+    handle = mpi_lib.horovod_torch_reducescatter_async(
+        tensor, output, average, name if name is not None else _NULL)
+    _handle_map[handle] = (tensor, output)
+    return handle
+
+
+def reducescatter_async(tensor, average=True, name=None):
+    """
+    A function that asynchronously averages or sums the input tensor over all the
+    Horovod processes, and scatters the result on the first dimension. The input
+    tensor is not modified.
+
+    The first dimension is split as evenly as possible between the processes, the
+    first processes receiving one more slice if it is not divisible by the number of
+    processes. The input tensors on the different processes must have the same shape.
+
+    Arguments:
+        tensor: A tensor to average or sum, and scatter.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reducescatter operation.
+
+    Returns:
+        A handle to the reducescatter operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    output = tensor.new()
+    return _reducescatter_async(tensor, output, average, name)
+
+
+class HorovodReducescatter(torch.autograd.Function):
+    """An autograd function that performs reducescatter on a tensor."""
+
+    @staticmethod
+    def forward(ctx, tensor, average, name):
+        ctx.average = average
+        handle = reducescatter_async(tensor, average, name)
+        return synchronize(handle)
+
+    @staticmethod
+    def backward(ctx, grad_output):
+        grad = allgather(grad_output)
+        if ctx.average:
+            grad = grad / size()
+        return grad, None, None
+
+
+def reducescatter(tensor, average=True, name=None):
+    """
+    A function that averages or sums the input tensor over all the Horovod processes,
+    and scatters the result on the first dimension. The input tensor is not modified.
+
+    See `reducescatter_async()` for how the first dimension is split.
+
+    This acts as a thin wrapper around an autograd function.  If your input
+    tensor requires gradients, then callings this function will allow gradients
+    to be computed and backpropagated.
+
+    Arguments:
+        tensor: A tensor to average or sum, and scatter.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the reducescatter operation.
+
+    Returns:
+        A tensor of the same type as `tensor`, holding the part of this process of
+        `tensor` averaged or summed across all processes. The shape is identical to
+        the input shape, except for the first dimension.
+    """
+    return HorovodReducescatter.apply(tensor, average, name)
+
+
+def _alltoall_async(tensor, splits, output, name):
+    if not _v2_api:
+        raise NotImplementedError(
+            'alltoall is not supported for PyTorch version {} < 1.0.0'
+            .format(torch.__version__))
+
+    _check_function(_allgather_function_factory, tensor)
+    handle = mpi_lib.horovod_torch_alltoall_async(
+        tensor, [int(split) for split in splits], output,
+        name if name is not None else _NULL)
+    _handle_map[handle] = (tensor, output)
+    return handle
+
+
+def alltoall_async(tensor, splits=None, name=None):
+    """
+    A function that asynchronously sends slices of the first dimension of the input
+    tensor to all other Horovod processes, and receives their slices. The input
+    tensor is not modified.
+
+    `splits[i]` consecutive slices are sent to process `i`, in order. The input
+    tensors on the different processes must have the same rank and shape, except for
+    the first dimension.
+
+    Arguments:
+        tensor: A tensor to distribute.
+        splits: A list or tensor with the number of slices sent to every process.
+                If not given, the same number of slices is sent to every process.
+        name: A name of the alltoall operation.
+
+    Returns:
+        A handle to the alltoall operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    output = tensor.new()
+    return _alltoall_async(tensor, splits if splits is not None else [], output,
+                           name)
+
+
+class HorovodAlltoall(torch.autograd.Function):
+    """An autograd function that performs alltoall on a tensor."""
+
+    @staticmethod
+    def forward(ctx, tensor, splits, name):
+        ctx.splits = splits
+        handle = alltoall_async(tensor, splits, name)
+        return synchronize(handle)
+
+    @staticmethod
+    def backward(ctx, grad_output):
+        # Send the gradients of the received slices back to their processes.
+        received_splits = None
+        if ctx.splits is not None:
+            splits = torch.LongTensor([int(split) for split in ctx.splits])
+            received_splits = alltoall(splits).tolist()
+        return alltoall(grad_output, received_splits), None, None
+
+
+def alltoall(tensor, splits=None, name=None):
+    """
+    A function that sends slices of the first dimension of the input tensor to all
+    other Horovod processes, and receives their slices. The input tensor is not
+    modified.
+
+    See `alltoall_async()` for the requirements on the tensors.
+
+    This acts as a thin wrapper around an autograd function.  If your input
+    tensor requires gradients, then callings this function will allow gradients
+    to be computed and backpropagated.
+
+    Arguments:
+        tensor: A tensor to distribute.
+        splits: A list or tensor with the number of slices sent to every process.
+                If not given, the same number of slices is sent to every process.
+        name: A name of the alltoall operation.
+
+    Returns:
+        A tensor of the same type as `tensor`, holding the slices received from every
+        process, concatenated on dimension zero in the order of the ranks.
+    """
+    return HorovodAlltoall.apply(tensor, splits, name)
+
+
+class _SparseOutput(object):
+    """Outputs of a sparse allreduce, which form a sparse tensor once the
+    operation is done."""
+
+    def __init__(self, values, indices, size):
+        self.values = values
+        self.indices = indices
+        self.size = size
+
+    def tensor(self):
+        return torch.sparse_coo_tensor(self.indices.unsqueeze(0), self.values,
+                                       self.size).coalesce()
+
+
+def sparse_allreduce_async(tensor, average=True, name=None):
+    """
+    A function that asynchronously averages or sums the input sparse tensor over all
+    the Horovod processes. The input tensor is not modified.
+
+    The tensor must be a sparse COO tensor with a single sparse dimension, such as the
+    gradient of `torch.nn.Embedding(sparse=True)`. Horovod gathers the rows of all
+    processes and sums the rows with the same index, so that the result holds every
+    index once. If the rows of all processes would fill more than
+    `HOROVOD_SPARSE_DENSITY_THRESHOLD` of the dense tensor, the dense tensor is reduced
+    instead. The input tensors on the different processes must have the same shape.
+
+    Arguments:
+        tensor: A sparse tensor to average or sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the sparse allreduce operation.
+
+    Returns:
+        A handle to the sparse allreduce operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    if not _v2_api:
+        raise NotImplementedError(
+            'sparse_allreduce is not supported for PyTorch version {} < 1.0.0'
+            .format(torch.__version__))
+    if not tensor.is_sparse or tensor.sparse_dim() != 1:
+        raise ValueError('sparse_allreduce requires a sparse tensor with a single '
+                         'sparse dimension.')
+
+    values = tensor._values().contiguous()
+    indices = tensor._indices()[0].contiguous()
+    output = _SparseOutput(values.new(), indices.new(), tensor.size())
+    handle = mpi_lib.horovod_torch_sparse_allreduce_async(
+        values, indices, tensor.size(0), output.values, output.indices, average,
+        name if name is not None else _NULL)
+    _handle_map[handle] = ((values, indices), output)
+    return handle
+
+
+def sparse_allreduce(tensor, average=True, name=None):
+    """
+    A function that averages or sums the input sparse tensor over all the Horovod
+    processes. The input tensor is not modified.
+
+    See `sparse_allreduce_async()` for the requirements on the tensors.
+
+    Arguments:
+        tensor: A sparse tensor to average or sum.
+        average: A flag indicating whether to compute average or summation,
+                 defaults to average.
+        name: A name of the sparse allreduce operation.
+
+    Returns:
+        A coalesced sparse tensor of the same shape and type as `tensor`, averaged or
+        summed across all processes.
+    """
+    handle = sparse_allreduce_async(tensor, average, name)
+    return synchronize(handle)
+
+
 def _broadcast_function_factory(tensor):
     return 'horovod_torch_broadcast_async_' + tensor.type().replace('.', '_')
 
@@ -403,6 +764,18 @@ def broadcast_(tensor, root_rank, name=None):
     return synchronize(handle)
 
 
+def _bucket_manager(params, bucket_size, backward_passes_per_step):
+    """
+    Creates a native manager which averages the gradients of the parameters in
+    flat buckets of at most `bucket_size` bytes, from autograd hooks registered
+    in C++. The gradients of the parameters become views into the buckets.
+    Returns None if buckets are not supported by this version of PyTorch.
+    """
+    if not _v2_api:
+        return None
+    return mpi_lib.BucketManager(params, bucket_size, backward_passes_per_step)
+
+
 def poll(handle):
     """
     Polls an allreduce, allgather or broadcast handle to determine whether underlying
@@ -435,4 +808,44 @@ def synchronize(handle):
         return
     mpi_lib.horovod_torch_wait_and_clear(handle)
     _, output = _handle_map.pop(handle)
+    if isinstance(output, _SparseOutput):
+        return output.tensor()
     return output
+
+
+def wait_all(handles):
+    """
+    Blocks until all the given allreduce, allgather or broadcast operations have
+    completed. After `wait_all()` returns, `synchronize()` will return without
+    blocking for any of the handles.
+
+    Arguments:
+        handles: A list of handles returned by allreduce, allgather or broadcast
+                 asynchronous operations.
+    """
+    handles = list(handles)
+    if _v2_api:
+        mpi_lib.horovod_torch_wait_all(handles)
+    else:
+        mpi_lib.horovod_torch_wait_all(mpi_lib._ffi.new('int[]', handles),
+                                       len(handles))
+
+
+def wait_any(handles):
+    """
+    Blocks until any of the given allreduce, allgather or broadcast operations has
+    completed. After `wait_any()` returns, `synchronize()` will return without
+    blocking for the returned handle.
+
+    Arguments:
+        handles: A non-empty list of handles returned by allreduce, allgather or
+                 broadcast asynchronous operations.
+
+    Returns:
+        A handle of a completed operation.
+    """
+    handles = list(handles)
+    if _v2_api:
+        return mpi_lib.horovod_torch_wait_any(handles)
+    return mpi_lib.horovod_torch_wait_any(mpi_lib._ffi.new('int[]', handles),
+                                          len(handles))
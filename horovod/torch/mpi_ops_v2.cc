@@ -13,14 +13,14 @@
 // limitations under the License.
 // =============================================================================
 
-#include <chrono>
 #include <memory>
-#include <thread>
 #include <torch/extension.h>
 #include <torch/torch.h>
 
+#include "../common/object_pool.h"
 #include "../common/operations.h"
 #include "adapter_v2.h"
+#include "bucket_manager.h"
 #include "cuda_util.h"
 #include "handle_manager.h"
 #include "ready_event.h"
@@ -56,20 +56,49 @@ int DoAllreduce(::torch::Tensor tensor, ::torch::Tensor output, int average,
   auto handle = handle_manager.AllocateHandle();
   auto device = GetDeviceID(tensor);
   auto ready_event = RecordReadyEvent(device);
-  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
-  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
-  auto hvd_output = std::make_shared<TorchTensor>(output);
-
+  auto hvd_tensor = MakePooled<TorchTensor>(tensor);
+  auto hvd_context = MakePooled<TorchOpContext>(device, output);
+  auto hvd_output = MakePooled<TorchTensor>(output);
+
+  // Horovod averages CPU tensors while copying the result out of the fusion
+  // buffer.
+  bool divide_output = average && device != CPU_DEVICE_ID;
+  double postscale_factor =
+      average && device == CPU_DEVICE_ID ? 1.0 / horovod_size() : 1.0;
   auto enqueue_result = EnqueueTensorAllreduce(
       hvd_context, hvd_tensor, hvd_output, ready_event,
       GetOpName("allreduce", name, handle), device,
-      [handle, average, output](const Status& status) mutable {
+      [handle, divide_output, output](const Status& status) mutable {
         // Will execute in the `device` context.
-        if (average) {
+        if (divide_output) {
           output.div_(horovod_size());
         }
         handle_manager.MarkDone(handle, status);
-      });
+      },
+      1.0, postscale_factor);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+// Casts the float32 CPU tensor to float16 while copying it into the buffer
+// it is reduced in, and back while copying the result out.
+int DoCompressedAllreduce(::torch::Tensor tensor, ::torch::Tensor output,
+                          int average, const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto hvd_tensor = MakePooled<TorchTensor>(tensor);
+  auto hvd_context = MakePooled<TorchOpContext>(CPU_DEVICE_ID, output);
+  auto hvd_output = MakePooled<TorchTensor>(output);
+
+  auto enqueue_result = EnqueueTensorAllreduce(
+      hvd_context, hvd_tensor, hvd_output, nullptr,
+      GetOpName("allreduce", name, handle), CPU_DEVICE_ID,
+      [handle](const Status& status) {
+        handle_manager.MarkDone(handle, status);
+      },
+      1.0, average ? 1.0 / horovod_size() : 1.0, FP16_COMPRESSION);
   ThrowIfError(enqueue_result);
 
   return handle;
@@ -83,39 +112,111 @@ int DoAllreduceCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output, int ave
   auto device = GetDeviceID(tensor);
   auto cpu_buffer =
       tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-  auto hvd_cpu_buffer = std::make_shared<TorchTensor>(cpu_buffer);
+  auto hvd_cpu_buffer = MakePooled<TorchTensor>(cpu_buffer);
   auto ready_event = RecordReadyEvent(device);
 
-  auto hvd_context =
-      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_buffer);
+  auto hvd_context = MakePooled<TorchOpContext>(CPU_DEVICE_ID, cpu_buffer);
 
   auto handle = handle_manager.AllocateHandle();
   auto enqueue_result = EnqueueTensorAllreduce(
       hvd_context, hvd_cpu_buffer, hvd_cpu_buffer, ready_event,
       GetOpName("allreduce", name, handle), CPU_DEVICE_ID,
-      [handle, average, cpu_buffer, output,
-       device](const Status& status) mutable {
+      [handle, cpu_buffer, output, device](const Status& status) mutable {
         // Since the operation was on CPU, need to perform copy with the GPU
         // device guard.
         with_device device_guard(device);
         output.copy_(cpu_buffer);
-        if (average) {
-          output.div_(horovod_size());
-        }
         handle_manager.MarkDone(handle, status);
-      });
+      },
+      1.0, average ? 1.0 / horovod_size() : 1.0);
   ThrowIfError(enqueue_result);
 
   return handle;
 }
 
+std::vector<int>
+DoGroupedAllreduce(const std::vector<::torch::Tensor>& tensors,
+                   const std::vector<::torch::Tensor>& outputs, int average,
+                   const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+  if (tensors.empty()) {
+    return std::vector<int>();
+  }
+
+  auto device = GetDeviceID(tensors[0]);
+#if HOROVOD_GPU_ALLREDUCE
+  bool cuda_on_cpu = false;
+#else
+  // Without GPU allreduce, GPU tensors are reduced through copies on CPU.
+  bool cuda_on_cpu = device != CPU_DEVICE_ID;
+#endif
+  std::vector<::torch::Tensor> buffers;
+  for (auto& tensor : tensors) {
+    if (GetDeviceID(tensor) != device) {
+      throw std::invalid_argument(
+          "All tensors of a group must be on the same device.");
+    }
+    buffers.push_back(cuda_on_cpu ? tensor.to(::torch::Device(::torch::kCPU),
+                                              /*non_blocking=*/true)
+                                  : tensor);
+  }
+  // A single event covers all the inputs, or their copies to CPU.
+  auto ready_event = RecordReadyEvent(device);
+  auto enqueue_device = cuda_on_cpu ? CPU_DEVICE_ID : device;
+  // Horovod averages tensors reduced on CPU while copying the results out of
+  // the fusion buffer.
+  bool divide_output = average && enqueue_device != CPU_DEVICE_ID;
+  double postscale_factor =
+      average && enqueue_device == CPU_DEVICE_ID ? 1.0 / horovod_size() : 1.0;
+
+  std::vector<int> handles;
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<std::shared_ptr<Tensor>> hvd_tensors;
+  std::vector<std::shared_ptr<Tensor>> hvd_outputs;
+  std::vector<std::shared_ptr<ReadyEvent>> ready_events;
+  std::vector<std::string> names;
+  std::vector<StatusCallback> callbacks;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto handle = handle_manager.AllocateHandle();
+    auto buffer = buffers[i];
+    auto output = outputs[i];
+    auto hvd_output = cuda_on_cpu ? buffer : output;
+    handles.push_back(handle);
+    hvd_contexts.push_back(
+        MakePooled<TorchOpContext>(enqueue_device, hvd_output));
+    hvd_tensors.push_back(MakePooled<TorchTensor>(buffer));
+    hvd_outputs.push_back(MakePooled<TorchTensor>(hvd_output));
+    ready_events.push_back(ready_event);
+    names.push_back(GetOpName(
+        "allreduce", name.empty() ? name : name + "." + std::to_string(i),
+        handle));
+    callbacks.push_back([handle, divide_output, buffer, output, device,
+                         cuda_on_cpu](const Status& status) mutable {
+      if (cuda_on_cpu) {
+        // Since the operation was on CPU, need to perform copy with the GPU
+        // device guard.
+        with_device device_guard(device);
+        output.copy_(buffer);
+      }
+      if (divide_output) {
+        output.div_(horovod_size());
+      }
+      handle_manager.MarkDone(handle, status);
+    });
+  }
+  ThrowIfError(EnqueueTensorAllreduces(hvd_contexts, hvd_tensors, hvd_outputs,
+                                       ready_events, names, enqueue_device,
+                                       callbacks, 1.0, postscale_factor));
+  return handles;
+}
+
 int DoAllgather(::torch::Tensor tensor, ::torch::Tensor output, const std::string& name) {
   ThrowIfError(common::CheckInitialized());
 
   auto device = GetDeviceID(tensor);
   auto ready_event = RecordReadyEvent(device);
-  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
-  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  auto hvd_tensor = MakePooled<TorchTensor>(tensor);
+  auto hvd_context = MakePooled<TorchOpContext>(device, output);
 
   auto handle = handle_manager.AllocateHandle();
   auto enqueue_result =
@@ -137,13 +238,12 @@ int DoAllgatherCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output,
   auto device = GetDeviceID(tensor);
   auto cpu_tensor =
       tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-  auto hvd_cpu_tensor = std::make_shared<TorchTensor>(cpu_tensor);
+  auto hvd_cpu_tensor = MakePooled<TorchTensor>(cpu_tensor);
   auto ready_event = RecordReadyEvent(device);
 
   auto cpu_output = ::torch::empty_like(cpu_tensor);
-  auto hvd_cpu_output = std::make_shared<TorchTensor>(cpu_output);
-  auto hvd_context =
-      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+  auto hvd_cpu_output = MakePooled<TorchTensor>(cpu_output);
+  auto hvd_context = MakePooled<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
 
   auto handle = handle_manager.AllocateHandle();
   auto enqueue_result = EnqueueTensorAllgather(
@@ -163,14 +263,141 @@ int DoAllgatherCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output,
   return handle;
 }
 
+// Reducescatter and alltoall are performed on CPU, GPU tensors are copied to
+// CPU and back.
+int DoReducescatter(::torch::Tensor tensor, ::torch::Tensor output,
+                    int average, const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+  bool cuda_on_cpu = device != CPU_DEVICE_ID;
+  auto buffer = cuda_on_cpu ? tensor.to(::torch::Device(::torch::kCPU),
+                                        /*non_blocking=*/true)
+                            : tensor;
+  auto ready_event = RecordReadyEvent(device);
+  auto cpu_output = cuda_on_cpu ? ::torch::empty_like(buffer) : output;
+  auto hvd_tensor = MakePooled<TorchTensor>(buffer);
+  auto hvd_context = MakePooled<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorReducescatter(
+      hvd_context, hvd_tensor, ready_event,
+      GetOpName("reducescatter", name, handle), CPU_DEVICE_ID,
+      [handle, average, buffer, cpu_output, output, device,
+       cuda_on_cpu](const Status& status) mutable {
+        if (status.ok()) {
+          with_device device_guard(device);
+          if (cuda_on_cpu) {
+            // output needs to be resized before copying in the CPU tensor.
+            output.resize_(cpu_output.sizes());
+            output.copy_(cpu_output);
+          }
+          if (average) {
+            output.div_(horovod_size());
+          }
+        }
+        handle_manager.MarkDone(handle, status);
+      });
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoAlltoall(::torch::Tensor tensor, const std::vector<int64_t>& splits,
+               ::torch::Tensor output, const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+  bool cuda_on_cpu = device != CPU_DEVICE_ID;
+  auto buffer = cuda_on_cpu ? tensor.to(::torch::Device(::torch::kCPU),
+                                        /*non_blocking=*/true)
+                            : tensor;
+  auto ready_event = RecordReadyEvent(device);
+  auto cpu_output = cuda_on_cpu ? ::torch::empty_like(buffer) : output;
+  auto hvd_tensor = MakePooled<TorchTensor>(buffer);
+  auto hvd_context = MakePooled<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorAlltoall(
+      hvd_context, hvd_tensor, splits, ready_event,
+      GetOpName("alltoall", name, handle), CPU_DEVICE_ID,
+      [handle, buffer, cpu_output, output, device,
+       cuda_on_cpu](const Status& status) mutable {
+        if (status.ok() && cuda_on_cpu) {
+          with_device device_guard(device);
+          // output needs to be resized before copying in the CPU tensor.
+          output.resize_(cpu_output.sizes());
+          output.copy_(cpu_output);
+        }
+        handle_manager.MarkDone(handle, status);
+      });
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+// Sparse allreduce is performed on CPU as well. The outputs are resized to the
+// number of distinct indices.
+int DoSparseAllreduce(::torch::Tensor values, ::torch::Tensor indices,
+                      int64_t dense_rows, ::torch::Tensor output,
+                      ::torch::Tensor indices_output, int average,
+                      const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(values);
+  bool cuda_on_cpu = device != CPU_DEVICE_ID;
+  auto buffer = cuda_on_cpu ? values.to(::torch::Device(::torch::kCPU),
+                                        /*non_blocking=*/true)
+                            : values;
+  auto indices_buffer =
+      cuda_on_cpu
+          ? indices.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true)
+          : indices;
+  auto ready_event = RecordReadyEvent(device);
+  auto cpu_output = cuda_on_cpu ? ::torch::empty_like(buffer) : output;
+  auto cpu_indices_output =
+      cuda_on_cpu ? ::torch::empty_like(indices_buffer) : indices_output;
+  auto hvd_values = MakePooled<TorchTensor>(buffer);
+  auto hvd_indices = MakePooled<TorchTensor>(indices_buffer);
+  auto hvd_context = MakePooled<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+  auto hvd_indices_context =
+      MakePooled<TorchOpContext>(CPU_DEVICE_ID, cpu_indices_output);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorSparseAllreduce(
+      hvd_context, hvd_indices_context, hvd_indices, hvd_values, dense_rows,
+      ready_event, GetOpName("sparse_allreduce", name, handle), CPU_DEVICE_ID,
+      [handle, average, buffer, indices_buffer, cpu_output, cpu_indices_output,
+       output, indices_output, device,
+       cuda_on_cpu](const Status& status) mutable {
+        if (status.ok()) {
+          with_device device_guard(device);
+          if (cuda_on_cpu) {
+            // outputs need to be resized before copying in the CPU tensors.
+            output.resize_(cpu_output.sizes());
+            output.copy_(cpu_output);
+            indices_output.resize_(cpu_indices_output.sizes());
+            indices_output.copy_(cpu_indices_output);
+          }
+          if (average) {
+            output.div_(horovod_size());
+          }
+        }
+        handle_manager.MarkDone(handle, status);
+      });
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
 int DoBroadcast(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
                 const std::string& name) {
   ThrowIfError(common::CheckInitialized());
 
   auto device = GetDeviceID(tensor);
   auto ready_event = RecordReadyEvent(device);
-  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
-  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  auto hvd_tensor = MakePooled<TorchTensor>(tensor);
+  auto hvd_context = MakePooled<TorchOpContext>(device, output);
   std::shared_ptr<Tensor> hvd_output = nullptr;
   if (horovod_rank() == root_rank) {
     if (tensor.data_ptr() != output.data_ptr()) {
@@ -178,7 +405,7 @@ int DoBroadcast(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
       output.copy_(tensor);
     }
   } else {
-    hvd_output = std::make_shared<TorchTensor>(output);
+    hvd_output = MakePooled<TorchTensor>(output);
   }
 
   auto handle = handle_manager.AllocateHandle();
@@ -201,11 +428,10 @@ int DoBroadcastCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output, int roo
   auto device = GetDeviceID(tensor);
   auto cpu_buffer =
       tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-  auto hvd_cpu_buffer = std::make_shared<TorchTensor>(cpu_buffer);
+  auto hvd_cpu_buffer = MakePooled<TorchTensor>(cpu_buffer);
   auto ready_event = RecordReadyEvent(device);
 
-  auto hvd_context =
-      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_buffer);
+  auto hvd_context = MakePooled<TorchOpContext>(CPU_DEVICE_ID, cpu_buffer);
 
   auto handle = handle_manager.AllocateHandle();
   auto enqueue_result = EnqueueTensorBroadcast(
@@ -226,11 +452,33 @@ int DoBroadcastCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output, int roo
 int PollHandle(int handle) { return handle_manager.PollHandle(handle) ? 1 : 0; }
 
 void WaitAndClear(int handle) {
-  while (!handle_manager.PollHandle(handle)) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-  }
+  handle_manager.WaitForHandle(handle);
   auto status = handle_manager.ReleaseHandle(handle);
-  ThrowIfError(*status);
+  ThrowIfError(status);
+}
+
+void WaitAll(const std::vector<int>& handles) {
+  handle_manager.WaitForAllHandles(handles);
+}
+
+int WaitAny(const std::vector<int>& handles) {
+  return handle_manager.WaitForAnyHandle(handles);
+}
+
+int AllreduceBucket(::torch::Tensor bucket, const std::string& name) {
+#if !HOROVOD_GPU_ALLREDUCE
+  if (bucket.device().is_cuda()) {
+    return DoAllreduceCudaOnCPU(bucket, bucket, 1, name);
+  }
+#endif
+  return DoAllreduce(bucket, bucket, 1, name);
+}
+
+std::shared_ptr<BucketManager>
+CreateBucketManager(const std::vector<::torch::Tensor>& params,
+                    int64_t bucket_bytes, int backward_passes_per_step) {
+  return BucketManager::Create(params, bucket_bytes, backward_passes_per_step,
+                               AllreduceBucket, WaitAndClear);
 }
 
 PYBIND11_MODULE(mpi_lib_v2, m) {
@@ -258,6 +506,11 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_allreduce_async_torch_cuda_DoubleTensor",
         &DoAllreduceCudaOnCPU);
 #endif
+  m.def("horovod_torch_allreduce_fp16_async_torch_FloatTensor",
+        &DoCompressedAllreduce);
+
+  // grouped allreduce
+  m.def("horovod_torch_grouped_allreduce_async", &DoGroupedAllreduce);
 
   // allgather
   m.def("horovod_torch_allgather_async_torch_ByteTensor", &DoAllgather);
@@ -296,6 +549,13 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
         &DoAllgatherCudaOnCPU);
 #endif
 
+  // reducescatter and alltoall
+  m.def("horovod_torch_reducescatter_async", &DoReducescatter);
+  m.def("horovod_torch_alltoall_async", &DoAlltoall);
+
+  // sparse allreduce
+  m.def("horovod_torch_sparse_allreduce_async", &DoSparseAllreduce);
+
   // broadcast
   m.def("horovod_torch_broadcast_async_torch_ByteTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_CharTensor", &DoBroadcast);
@@ -335,7 +595,22 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
 
   // basics
   m.def("horovod_torch_poll", &PollHandle);
-  m.def("horovod_torch_wait_and_clear", &WaitAndClear);
+  // Waits release the GIL, since operations complete on the background thread.
+  m.def("horovod_torch_wait_and_clear", &WaitAndClear,
+        pybind11::call_guard<pybind11::gil_scoped_release>());
+  m.def("horovod_torch_wait_all", &WaitAll,
+        pybind11::call_guard<pybind11::gil_scoped_release>());
+  m.def("horovod_torch_wait_any", &WaitAny,
+        pybind11::call_guard<pybind11::gil_scoped_release>());
+
+  // gradient buckets
+  pybind11::class_<BucketManager, std::shared_ptr<BucketManager>>(
+      m, "BucketManager")
+      .def(pybind11::init(&CreateBucketManager))
+      .def("synchronize", &BucketManager::Synchronize,
+           pybind11::call_guard<pybind11::gil_scoped_release>())
+      .def("set_backward_passes_per_step",
+           &BucketManager::SetBackwardPassesPerStep);
 }
 
 } // namespace torch
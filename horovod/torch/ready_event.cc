@@ -22,6 +22,7 @@
 #endif
 
 #include "ready_event.h"
+#include "../common/object_pool.h"
 #include "cuda_util.h"
 
 #if HAVE_CUDA
@@ -83,7 +84,7 @@ std::shared_ptr<ReadyEvent> RecordReadyEvent(int device) {
     return std::shared_ptr<ReadyEvent>();
   } else {
 #if HAVE_CUDA
-    return std::make_shared<TorchReadyEvent>(device);
+    return MakePooled<TorchReadyEvent>(device);
 #else
     throw std::logic_error("Internal error. Requested ReadyEvent "
                            "with GPU device but not compiled with CUDA.");
@@ -511,11 +511,18 @@ def get_common_options(build_ext):
                 'third_party/boost/type_traits/include',
                 'third_party/boost/utility/include']
     SOURCES = ['horovod/common/common.cc',
+               'horovod/common/allreduce_engine.cc',
+               'horovod/common/fused_datatype_cache.cc',
                'horovod/common/fusion_buffer_manager.cc',
                'horovod/common/mpi_message.cc',
                'horovod/common/half.cc',
                'horovod/common/operations.cc',
                'horovod/common/parameter_manager.cc',
+               'horovod/common/response_cache.cc',
+               'horovod/common/scale_buffer.cc',
+               'horovod/common/sparse_merge.cc',
+               'horovod/common/tensor_name_registry.cc',
+               'horovod/common/topk_compression.cc',
                'horovod/common/timeline.cc',
                'horovod/common/optim/bayesian_optimization.cc',
                'horovod/common/optim/gaussian_process.cc',
@@ -803,6 +810,7 @@ def build_torch_extension_v2(build_ext, options, torch_version):
                          define_macros=updated_macros,
                          include_dirs=options['INCLUDES'],
                          sources=options['SOURCES'] + ['horovod/torch/mpi_ops_v2.cc',
+                                                       'horovod/torch/bucket_manager.cc',
                                                        'horovod/torch/handle_manager.cc',
                                                        'horovod/torch/ready_event.cc',
                                                        'horovod/torch/cuda_util.cc',
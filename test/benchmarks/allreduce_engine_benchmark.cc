@@ -0,0 +1,238 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Benchmark of the native allreduce algorithms against MPI_Allreduce. Checks
+// that the ring and recursive doubling give the same result as MPI_Allreduce
+// on every rank for every data type, then times the three of them on float32
+// and float16 messages from 1 KB to 64 MB. Run with a number of ranks which is
+// not a power of two to cover the extra ranks of recursive doubling.
+//
+// Build and run from the repository root:
+//
+//   mpicxx -std=c++11 -O2 -mf16c -mavx -Ihorovod/common
+//       test/benchmarks/allreduce_engine_benchmark.cc
+//       horovod/common/allreduce_engine.cc horovod/common/half.cc
+//       horovod/common/mpi_message.cc -o allreduce_engine_benchmark
+//   mpirun -np 3 ./allreduce_engine_benchmark [iterations]
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "allreduce_engine.h"
+#include "half.h"
+
+using namespace horovod::common;
+
+namespace {
+
+int rank;
+int size;
+MPI_Datatype mpi_float16_t;
+MPI_Op mpi_float16_sum;
+
+MPI_Datatype GetDatatype(MPIDataType dtype) {
+  switch (dtype) {
+  case HOROVOD_UINT8:
+    return MPI_UINT8_T;
+  case HOROVOD_INT8:
+    return MPI_INT8_T;
+  case HOROVOD_UINT16:
+    return MPI_UINT16_T;
+  case HOROVOD_INT16:
+    return MPI_INT16_T;
+  case HOROVOD_INT32:
+    return MPI_INT32_T;
+  case HOROVOD_INT64:
+    return MPI_INT64_T;
+  case HOROVOD_FLOAT16:
+    return mpi_float16_t;
+  case HOROVOD_FLOAT32:
+    return MPI_FLOAT;
+  default:
+    return MPI_DOUBLE;
+  }
+}
+
+int Allreduce(AllreduceAlgorithm algorithm, std::vector<char>& buffer,
+              int64_t num_elements, MPIDataType dtype,
+              std::vector<char>& scratch) {
+  auto datatype = GetDatatype(dtype);
+  switch (algorithm) {
+  case AllreduceAlgorithm::RING:
+    return RingAllreduce(buffer.data(), num_elements, dtype, datatype,
+                         MPI_COMM_WORLD, scratch);
+  case AllreduceAlgorithm::RECURSIVE_DOUBLING:
+    return RecursiveDoublingAllreduce(buffer.data(), num_elements, dtype,
+                                      datatype, MPI_COMM_WORLD, scratch);
+  default:
+    return MPI_Allreduce(MPI_IN_PLACE, buffer.data(), (int)num_elements,
+                         datatype,
+                         dtype == HOROVOD_FLOAT16 ? mpi_float16_sum : MPI_SUM,
+                         MPI_COMM_WORLD);
+  }
+}
+
+// Fills the buffer with small values, which sum exactly in every type.
+void Fill(std::vector<char>& buffer, int64_t num_elements, MPIDataType dtype,
+          int seed) {
+  for (int64_t i = 0; i < num_elements; ++i) {
+    int value = (int)((i * 7 + seed * 13) % 5);
+    switch (dtype) {
+    case HOROVOD_UINT8:
+    case HOROVOD_INT8:
+      buffer[i] = (char)value;
+      break;
+    case HOROVOD_UINT16:
+    case HOROVOD_INT16:
+      ((int16_t*)buffer.data())[i] = (int16_t)value;
+      break;
+    case HOROVOD_INT32:
+      ((int32_t*)buffer.data())[i] = value;
+      break;
+    case HOROVOD_INT64:
+      ((int64_t*)buffer.data())[i] = value;
+      break;
+    case HOROVOD_FLOAT16: {
+      float float_value = (float)value;
+      Float2HalfBits(&float_value, (unsigned short*)buffer.data() + i);
+      break;
+    }
+    case HOROVOD_FLOAT32:
+      ((float*)buffer.data())[i] = (float)value;
+      break;
+    default:
+      ((double*)buffer.data())[i] = (double)value;
+      break;
+    }
+  }
+}
+
+void Check(int result, const std::string& what) {
+  if (result != MPI_SUCCESS) {
+    std::cerr << "[" << rank << "] " << what << " failed" << std::endl;
+    std::exit(1);
+  }
+}
+
+void CheckAlgorithms() {
+  std::vector<MPIDataType> dtypes{HOROVOD_UINT8,   HOROVOD_INT8,
+                                  HOROVOD_UINT16,  HOROVOD_INT16,
+                                  HOROVOD_INT32,   HOROVOD_INT64,
+                                  HOROVOD_FLOAT16, HOROVOD_FLOAT32,
+                                  HOROVOD_FLOAT64};
+  std::vector<int64_t> counts{1, 2, 7, (int64_t)size, (int64_t)size + 1, 1000,
+                              65537};
+  std::vector<char> scratch;
+  for (auto dtype : dtypes) {
+    int element_size;
+    MPI_Type_size(GetDatatype(dtype), &element_size);
+    for (auto count : counts) {
+      std::vector<char> expected((size_t)count * element_size);
+      Fill(expected, count, dtype, rank);
+      Check(Allreduce(AllreduceAlgorithm::MPI, expected, count, dtype,
+                      scratch),
+            "MPI_Allreduce");
+      for (auto algorithm : {AllreduceAlgorithm::RING,
+                             AllreduceAlgorithm::RECURSIVE_DOUBLING}) {
+        if (algorithm == AllreduceAlgorithm::RING && count < size) {
+          continue;
+        }
+        std::vector<char> buffer(expected.size());
+        Fill(buffer, count, dtype, rank);
+        Check(Allreduce(algorithm, buffer, count, dtype, scratch),
+              "Native allreduce");
+        if (std::memcmp(buffer.data(), expected.data(), buffer.size()) != 0) {
+          std::cerr << "[" << rank << "] Wrong result of "
+                    << (algorithm == AllreduceAlgorithm::RING
+                            ? "ring"
+                            : "recursive doubling")
+                    << " allreduce of " << count << " "
+                    << MPIDataType_Name(dtype) << std::endl;
+          std::exit(1);
+        }
+      }
+    }
+  }
+}
+
+double Time(AllreduceAlgorithm algorithm, int64_t num_elements,
+            MPIDataType dtype, int iterations) {
+  int element_size;
+  MPI_Type_size(GetDatatype(dtype), &element_size);
+  std::vector<char> buffer((size_t)num_elements * element_size);
+  std::vector<char> scratch;
+  Fill(buffer, num_elements, dtype, rank);
+  Check(Allreduce(algorithm, buffer, num_elements, dtype, scratch), "Warmup");
+  MPI_Barrier(MPI_COMM_WORLD);
+  double start = MPI_Wtime();
+  for (int i = 0; i < iterations; ++i) {
+    Fill(buffer, std::min(num_elements, (int64_t)1), dtype, rank);
+    Check(Allreduce(algorithm, buffer, num_elements, dtype, scratch),
+          "Allreduce");
+  }
+  double elapsed = MPI_Wtime() - start;
+  MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX,
+                MPI_COMM_WORLD);
+  return elapsed / iterations * 1e6;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  MPI_Type_contiguous(2, MPI_BYTE, &mpi_float16_t);
+  MPI_Type_commit(&mpi_float16_t);
+  MPI_Op_create(&float16_sum, 1, &mpi_float16_sum);
+
+  CheckAlgorithms();
+  if (rank == 0) {
+    std::cout << "Native allreduces match MPI_Allreduce on " << size
+              << " ranks" << std::endl;
+    std::cout << "dtype bytes mpi_us ring_us recursive_doubling_us"
+              << std::endl;
+  }
+
+  for (auto dtype : {HOROVOD_FLOAT32, HOROVOD_FLOAT16}) {
+    int element_size = dtype == HOROVOD_FLOAT16 ? 2 : 4;
+    for (int64_t bytes = 1024; bytes <= 64 * 1024 * 1024; bytes *= 8) {
+      int64_t num_elements = bytes / element_size;
+      double mpi_us =
+          Time(AllreduceAlgorithm::MPI, num_elements, dtype, iterations);
+      double ring_us =
+          Time(AllreduceAlgorithm::RING, num_elements, dtype, iterations);
+      double recursive_doubling_us = Time(
+          AllreduceAlgorithm::RECURSIVE_DOUBLING, num_elements, dtype,
+          iterations);
+      if (rank == 0) {
+        std::cout << MPIDataType_Name(dtype) << " " << bytes << " " << mpi_us
+                  << " " << ring_us << " " << recursive_doubling_us
+                  << std::endl;
+      }
+    }
+  }
+
+  MPI_Op_free(&mpi_float16_sum);
+  MPI_Type_free(&mpi_float16_t);
+  MPI_Finalize();
+  return 0;
+}
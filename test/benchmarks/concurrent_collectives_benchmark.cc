@@ -0,0 +1,130 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Benchmark of collective operations performed concurrently on duplicated
+// communicators. Every step enqueues allreduces of mixed sizes, allgathers
+// whose first dimension differs between ranks, and broadcasts, then checks
+// the results. With a small fusion threshold these are performed as many
+// independent responses, which HOROVOD_CONCURRENT_COLLECTIVES spreads over
+// that many communicators.
+//
+// Built by run_tests.sh, and run on its own with
+//
+//   HOROVOD_FUSION_THRESHOLD=1048576 HOROVOD_CONCURRENT_COLLECTIVES=4
+//       mpirun -np 2 ./concurrent_collectives_benchmark [tensors] [steps]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+
+using namespace horovod::common;
+using namespace horovod::test;
+
+int main(int argc, char** argv) {
+  int tensors = argc > 1 ? std::atoi(argv[1]) : 32;
+  int steps = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  horovod_init(nullptr, 0);
+  int rank = horovod_rank();
+  int size = horovod_size();
+  auto context = std::make_shared<CpuContext>();
+  Completions completions;
+
+  std::chrono::duration<double> elapsed(0);
+  for (int step = 0; step < steps; ++step) {
+    std::vector<std::shared_ptr<CpuTensor>> allreduce_outputs;
+    std::vector<std::shared_ptr<CpuTensor>> broadcast_outputs;
+    std::vector<std::shared_ptr<CpuContext>> allgather_contexts;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < tensors; ++i) {
+      // Sizes from 4 KB to 4 MB.
+      int64_t columns = (int64_t)1024 << (i % 11);
+      std::string suffix = "." + std::to_string(i);
+      switch (i % 3) {
+      case 0: {
+        allreduce_outputs.push_back(
+            std::make_shared<CpuTensor>(Shape(1, columns)));
+        auto tensor =
+            std::make_shared<CpuTensor>(Shape(1, columns), (float)rank);
+        Check(EnqueueTensorAllreduce(context, tensor, allreduce_outputs.back(),
+                                     nullptr, "allreduce" + suffix,
+                                     CPU_DEVICE_ID, completions.Callback())
+                  .ok(),
+              "Enqueue failed");
+        break;
+      }
+      case 1: {
+        allgather_contexts.push_back(std::make_shared<CpuContext>());
+        auto tensor = std::make_shared<CpuTensor>(
+            Shape(rank + 1, columns / size), (float)rank);
+        Check(EnqueueTensorAllgather(allgather_contexts.back(), tensor,
+                                     nullptr, "allgather" + suffix,
+                                     CPU_DEVICE_ID, completions.Callback())
+                  .ok(),
+              "Enqueue failed");
+        break;
+      }
+      default: {
+        // Broadcasts are performed in place.
+        broadcast_outputs.push_back(
+            std::make_shared<CpuTensor>(Shape(1, columns), (float)(rank + 1)));
+        auto tensor = broadcast_outputs.back();
+        Check(EnqueueTensorBroadcast(context, tensor, tensor,
+                                     0, nullptr, "broadcast" + suffix,
+                                     CPU_DEVICE_ID, completions.Callback())
+                  .ok(),
+              "Enqueue failed");
+      }
+      }
+    }
+    Check(completions.Wait(tensors) == 0, "Operation failed");
+    elapsed += std::chrono::steady_clock::now() - start;
+
+    float sum = (float)size * (size - 1) / 2;
+    for (auto& output : allreduce_outputs) {
+      for (int64_t k = 0; k < output->num_elements(); ++k) {
+        Check(output->floats()[k] == sum, "Wrong allreduce result");
+      }
+    }
+    for (auto& output : broadcast_outputs) {
+      for (int64_t k = 0; k < output->num_elements(); ++k) {
+        Check(output->floats()[k] == 1.0f, "Wrong broadcast result");
+      }
+    }
+    for (auto& allgather_context : allgather_contexts) {
+      auto& output = allgather_context->output;
+      auto row = output->num_elements() / (size * (size + 1) / 2);
+      int64_t offset = 0;
+      for (int r = 0; r < size; ++r) {
+        for (int64_t k = 0; k < (r + 1) * row; ++k) {
+          Check(output->floats()[offset++] == (float)r,
+                "Wrong allgather result");
+        }
+      }
+    }
+  }
+
+  horovod_shutdown();
+  if (rank == 0) {
+    std::cout << tensors << " tensors: " << elapsed.count() / steps * 1e3
+              << " ms per step" << std::endl;
+  }
+  return 0;
+}
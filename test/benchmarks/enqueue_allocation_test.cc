@@ -0,0 +1,208 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Checks that submitting the same tensors every step does not allocate once
+// the first steps have warmed up the buffers Horovod reuses. Heap allocations
+// made by the submitting thread inside EnqueueTensorAllreduce,
+// EnqueueTensorAllgather and EnqueueTensorBroadcast are counted, as well as
+// the allocations made by any thread over the whole cycle, from the first
+// enqueue of a step until its last callback has run, which include the
+// negotiation and the operations on the background thread. The test fails if
+// either is made after the warm-up steps.
+//
+// Buffers of the submission queue and of the queues of the completion threads
+// are reused once their rings have wrapped around, so the submission queue is
+// sized to hold about one step of tensors and the completion queues a few
+// operations, unless HOROVOD_SUBMISSION_QUEUE_CAPACITY and
+// HOROVOD_COMPLETION_QUEUE_CAPACITY are set.
+// Every tensor has its own context, which reuses the output it allocated for
+// the last step as frameworks do.
+//
+// Built by run_tests.sh, and run on its own with
+//
+//   mpirun -np 2 ./enqueue_allocation_test [tensors] [steps] [warmup steps]
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+
+using namespace horovod::common;
+using namespace horovod::test;
+
+namespace {
+
+// Allocations made by this thread while counting is enabled.
+thread_local bool counting = false;
+thread_local long allocations = 0;
+
+// Allocations made by any thread while a steady-state cycle is counted.
+std::atomic<bool> counting_cycle(false);
+std::atomic<long> cycle_allocations(0);
+
+// Reuses the output it allocated for the last operation if the shape is the
+// same, as frameworks reuse the memory of the outputs of a step.
+class ReusingContext : public CpuContext {
+public:
+  Status AllocateOutput(TensorShape shape,
+                        std::shared_ptr<Tensor>* tensor) override {
+    if (output == nullptr || output->shape() != shape) {
+      return CpuContext::AllocateOutput(shape, tensor);
+    }
+    *tensor = output;
+    return Status::OK();
+  }
+};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+  if (counting) {
+    ++allocations;
+  }
+  if (counting_cycle.load(std::memory_order_relaxed)) {
+    cycle_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+// The deallocation functions are not inlined, since GCC would then see free()
+// called on a pointer returned by operator new and warn.
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr,
+                                               std::size_t) noexcept {
+  std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void* ptr,
+                                                 std::size_t) noexcept {
+  std::free(ptr);
+}
+
+int main(int argc, char** argv) {
+  int num_tensors = argc > 1 ? std::atoi(argv[1]) : 100;
+  int steps = argc > 2 ? std::atoi(argv[2]) : 120;
+  int warmup_steps = argc > 3 ? std::atoi(argv[3]) : steps - 20;
+
+  setenv("HOROVOD_SUBMISSION_QUEUE_CAPACITY",
+         std::to_string(num_tensors).c_str(), 0);
+  setenv("HOROVOD_COMPLETION_QUEUE_CAPACITY", "8", 0);
+  horovod_init(nullptr, 0);
+  int rank = horovod_rank();
+
+  std::vector<std::shared_ptr<OpContext>> contexts;
+  std::vector<std::shared_ptr<Tensor>> tensors;
+  std::vector<std::shared_ptr<Tensor>> outputs;
+  for (int i = 0; i < num_tensors; ++i) {
+    contexts.push_back(std::make_shared<ReusingContext>());
+    tensors.push_back(std::make_shared<CpuTensor>(Shape(16, 1 + i % 7)));
+    outputs.push_back(std::make_shared<CpuTensor>(Shape(16, 1 + i % 7)));
+  }
+
+  Completions completions;
+  long steady_allocations = 0;
+  std::vector<std::string> names(num_tensors);
+  std::vector<std::shared_ptr<OpContext>> context_args(num_tensors);
+  std::vector<std::shared_ptr<Tensor>> tensor_args(num_tensors);
+  std::vector<std::shared_ptr<Tensor>> output_args(num_tensors);
+  std::vector<StatusCallback> callbacks(num_tensors);
+  for (int step = 0; step < steps; ++step) {
+    // The arguments are built outside of the counted region, since the
+    // framework adapters own them.
+    for (int i = 0; i < num_tensors; ++i) {
+      const char* op = i % 3 == 0 ? "allreduce"
+                                  : i % 3 == 1 ? "allgather" : "broadcast";
+      names[i] = std::string(op) + ".model.layer." + std::to_string(i) +
+                 ".weight";
+      context_args[i] = contexts[i];
+      tensor_args[i] = tensors[i];
+      output_args[i] = outputs[i];
+      callbacks[i] = completions.Callback();
+    }
+
+    counting_cycle = step >= warmup_steps;
+    for (int i = 0; i < num_tensors; ++i) {
+      Status status;
+      counting = true;
+      switch (i % 3) {
+      case 0:
+        status = EnqueueTensorAllreduce(
+            std::move(context_args[i]), std::move(tensor_args[i]),
+            std::move(output_args[i]), nullptr, std::move(names[i]),
+            CPU_DEVICE_ID, std::move(callbacks[i]));
+        break;
+      case 1:
+        status = EnqueueTensorAllgather(
+            std::move(context_args[i]), std::move(tensor_args[i]), nullptr,
+            std::move(names[i]), CPU_DEVICE_ID, std::move(callbacks[i]));
+        break;
+      default:
+        status = EnqueueTensorBroadcast(
+            std::move(context_args[i]), std::move(tensor_args[i]),
+            std::move(output_args[i]), 0, nullptr, std::move(names[i]),
+            CPU_DEVICE_ID, std::move(callbacks[i]));
+        break;
+      }
+      counting = false;
+      CheckStatus(status);
+    }
+    int failed = completions.Wait(num_tensors);
+    counting_cycle = false;
+    Check(failed == 0, "Operation failed");
+
+    if (step >= warmup_steps) {
+      steady_allocations += allocations;
+    }
+    allocations = 0;
+  }
+  long steady_cycle_allocations = cycle_allocations;
+  horovod_shutdown();
+
+  int steady_steps = steps - warmup_steps;
+  if (steady_allocations > 0) {
+    std::cerr << "[" << rank << "] " << steady_allocations
+              << " allocations while enqueueing " << num_tensors
+              << " tensors for " << steady_steps << " steps" << std::endl;
+    return 1;
+  }
+  if (steady_cycle_allocations > 0) {
+    std::cerr << "[" << rank << "] " << steady_cycle_allocations
+              << " allocations over the whole cycle of " << num_tensors
+              << " tensors for " << steady_steps << " steps" << std::endl;
+    return 1;
+  }
+  std::cout << "[" << rank << "] No allocations while performing "
+            << num_tensors << " tensors for " << steady_steps << " steps"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,216 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// CPU tensors and helpers shared by the tests and benchmarks which call the
+// enqueue functions of horovod/common directly. They are built and run by
+// run_tests.sh.
+
+#ifndef HOROVOD_TEST_BENCHMARKS_FIXTURE_H
+#define HOROVOD_TEST_BENCHMARKS_FIXTURE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "operations.h"
+
+namespace horovod {
+namespace test {
+
+using namespace horovod::common;
+
+inline int64_t ElementSize(MPIDataType dtype) {
+  switch (dtype) {
+  case HOROVOD_UINT16:
+  case HOROVOD_INT16:
+  case HOROVOD_FLOAT16:
+    return 2;
+  case HOROVOD_INT32:
+  case HOROVOD_FLOAT32:
+    return 4;
+  case HOROVOD_INT64:
+  case HOROVOD_FLOAT64:
+    return 8;
+  default:
+    return 1;
+  }
+}
+
+class CpuBuffer : public PersistentBuffer {
+public:
+  explicit CpuBuffer(int64_t size) : buffer_(size) {}
+  const void* AccessData(std::shared_ptr<OpContext> context) const override {
+    return buffer_.data();
+  }
+
+private:
+  std::vector<char> buffer_;
+};
+
+class CpuTensor : public Tensor {
+public:
+  CpuTensor(MPIDataType dtype, TensorShape shape)
+      : dtype_(dtype), shape_(shape),
+        buffer_(shape.num_elements() * ElementSize(dtype)) {}
+
+  // A float32 tensor with every element set to value.
+  explicit CpuTensor(TensorShape shape, float value = 0.0f)
+      : CpuTensor(HOROVOD_FLOAT32, shape) {
+    for (int64_t i = 0; i < num_elements(); ++i) {
+      floats()[i] = value;
+    }
+  }
+
+  const MPIDataType dtype() const override { return dtype_; }
+  const TensorShape shape() const override { return shape_; }
+  const void* data() const override { return buffer_.data(); }
+  int64_t size() const override { return (int64_t)buffer_.size(); }
+
+  int64_t num_elements() const { return shape_.num_elements(); }
+  float* floats() { return (float*)buffer_.data(); }
+  const float* floats() const { return (const float*)buffer_.data(); }
+
+  // Element i of an int32 or int64 tensor.
+  int64_t Index(int64_t i) const {
+    return dtype_ == HOROVOD_INT32 ? ((const int32_t*)buffer_.data())[i]
+                                   : ((const int64_t*)buffer_.data())[i];
+  }
+  void SetIndex(int64_t i, int64_t index) {
+    if (dtype_ == HOROVOD_INT32) {
+      ((int32_t*)buffer_.data())[i] = (int32_t)index;
+    } else {
+      ((int64_t*)buffer_.data())[i] = index;
+    }
+  }
+
+private:
+  MPIDataType dtype_;
+  TensorShape shape_;
+  std::vector<char> buffer_;
+};
+
+// Keeps the output allocated by an operation, of the given type.
+class CpuContext : public OpContext {
+public:
+  explicit CpuContext(MPIDataType dtype = HOROVOD_FLOAT32) : dtype_(dtype) {}
+  Status AllocatePersistent(int64_t size,
+                            std::shared_ptr<PersistentBuffer>* tensor) override {
+    *tensor = std::make_shared<CpuBuffer>(size);
+    return Status::OK();
+  }
+  Status AllocateOutput(TensorShape shape,
+                        std::shared_ptr<Tensor>* tensor) override {
+    output = std::make_shared<CpuTensor>(dtype_, shape);
+    *tensor = output;
+    return Status::OK();
+  }
+  Framework framework() const override { return PYTORCH; }
+
+  std::shared_ptr<CpuTensor> output;
+
+private:
+  MPIDataType dtype_;
+};
+
+// Counts completed operations, and the failed ones.
+class Completions {
+public:
+  StatusCallback Callback() {
+    return [this](const Status& status) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (!status.ok()) {
+        ++failed_;
+      }
+      ++done_;
+      cond_.notify_all();
+    };
+  }
+
+  // Waits until count operations have completed, and returns the number of
+  // failed ones. Both counts start from zero again.
+  int Wait(int count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] { return done_ >= count; });
+    return Reset();
+  }
+
+  // Like Wait, but returns -1 if count operations have not completed within
+  // the timeout.
+  int WaitFor(int count, std::chrono::seconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!cond_.wait_for(lock, timeout, [&] { return done_ >= count; })) {
+      return -1;
+    }
+    return Reset();
+  }
+
+  int done() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return done_;
+  }
+
+private:
+  int Reset() {
+    int failed = failed_;
+    done_ = 0;
+    failed_ = 0;
+    return failed;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int done_ = 0;
+  int failed_ = 0;
+};
+
+inline void Check(bool condition, const std::string& message) {
+  if (!condition) {
+    std::cerr << "[" << horovod_rank() << "] " << message << std::endl;
+    std::exit(1);
+  }
+}
+
+inline void CheckStatus(const Status& status) {
+  // The message is only built on failure, since this is also called on the
+  // paths whose allocations are counted.
+  if (!status.ok()) {
+    Check(false, "Enqueue failed: " + status.reason());
+  }
+}
+
+inline TensorShape Shape(int64_t dim0) {
+  TensorShape shape;
+  shape.AddDim(dim0);
+  return shape;
+}
+
+inline TensorShape Shape(int64_t dim0, int64_t dim1) {
+  TensorShape shape;
+  shape.AddDim(dim0);
+  shape.AddDim(dim1);
+  return shape;
+}
+
+} // namespace test
+} // namespace horovod
+
+#endif // HOROVOD_TEST_BENCHMARKS_FIXTURE_H
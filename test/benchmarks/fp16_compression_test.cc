@@ -0,0 +1,146 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Test of allreduce with float16 compression. Every step enqueues float32
+// tensors of various sizes, most of them compressed and some not, with scale
+// factors, then checks the results within the precision of float16. Tensors
+// are fused, running with HOROVOD_FUSION_THRESHOLD=0 reduces them one at a
+// time, and running with HOROVOD_ALLREDUCE_CHUNK_SIZE set pipelines the fused
+// ones. Compressed and uncompressed tensors must not be fused together, a
+// compression which differs between ranks must fail on every rank, and
+// compression of tensors other than float32 must be rejected.
+//
+// Built by run_tests.sh, and run on its own with
+//
+//   mpirun -np 3 ./fp16_compression_test [tensors] [steps]
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+
+using namespace horovod::common;
+using namespace horovod::test;
+
+namespace {
+
+int rank;
+int size;
+
+const double PRESCALE = 0.5;
+const double POSTSCALE = 0.25;
+
+// Sizes are odd, so that the vectorized casts leave a remainder.
+int64_t Elements(int i) { return i % 4 == 3 ? 256 * 1024 + 5 : 1000 + i; }
+
+// Every fifth tensor is not compressed.
+Compression TensorCompression(int i) {
+  return i % 5 == 4 ? NO_COMPRESSION : FP16_COMPRESSION;
+}
+
+// Value of element k of tensor i sent by rank r.
+float Value(int r, int i, int step, int64_t k) {
+  return (float)((r + i + step + k) % 17) * 0.37f - 2.0f;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int tensors = argc > 1 ? std::atoi(argv[1]) : 16;
+  int steps = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  horovod_init(nullptr, 0);
+  rank = horovod_rank();
+  size = horovod_size();
+  Completions completions;
+  auto context = std::make_shared<CpuContext>();
+
+  for (int step = 0; step < steps; ++step) {
+    std::vector<std::shared_ptr<CpuTensor>> outputs;
+    for (int i = 0; i < tensors; ++i) {
+      auto tensor = std::make_shared<CpuTensor>(HOROVOD_FLOAT32,
+                                                Shape(Elements(i)));
+      for (int64_t k = 0; k < Elements(i); ++k) {
+        tensor->floats()[k] = Value(rank, i, step, k);
+      }
+      // Odd tensors are reduced in place.
+      auto output = i % 2 == 1 ? tensor
+                               : std::make_shared<CpuTensor>(
+                                     HOROVOD_FLOAT32, Shape(Elements(i)));
+      outputs.push_back(output);
+      Check(EnqueueTensorAllreduce(context, tensor, output, nullptr,
+                                   "fp16." + std::to_string(i), CPU_DEVICE_ID,
+                                   completions.Callback(), PRESCALE, POSTSCALE,
+                                   TensorCompression(i))
+                .ok(),
+            "Enqueue failed");
+    }
+    Check(completions.Wait(tensors) == 0, "Operation failed");
+
+    for (int i = 0; i < tensors; ++i) {
+      for (int64_t k = 0; k < Elements(i); ++k) {
+        double expected = 0;
+        double magnitude = 0;
+        for (int r = 0; r < size; ++r) {
+          expected += Value(r, i, step, k);
+          magnitude += std::fabs(Value(r, i, step, k));
+        }
+        expected *= PRESCALE * POSTSCALE;
+        magnitude *= PRESCALE * POSTSCALE;
+        // Every rank rounds its input and every partial sum to float16, with
+        // a relative error of at most 2^-11 each.
+        double tolerance = TensorCompression(i) == NO_COMPRESSION
+                               ? 1e-5 * (magnitude + 1)
+                               : 2 * size * magnitude / 2048 + 1e-6;
+        Check(std::fabs(outputs[i]->floats()[k] - expected) <= tolerance,
+              "Wrong result of tensor " + std::to_string(i) + " at " +
+                  std::to_string(k) + ": " +
+                  std::to_string(outputs[i]->floats()[k]) + " instead of " +
+                  std::to_string(expected));
+      }
+    }
+  }
+
+  // A compression which differs between ranks fails on every rank.
+  if (size > 1) {
+    auto tensor = std::make_shared<CpuTensor>(HOROVOD_FLOAT32, Shape(16));
+    Check(EnqueueTensorAllreduce(context, tensor, tensor, nullptr, "fp16.mixed",
+                                 CPU_DEVICE_ID, completions.Callback(), 1.0,
+                                 1.0,
+                                 rank == 0 ? FP16_COMPRESSION : NO_COMPRESSION)
+              .ok(),
+          "Enqueue failed");
+    Check(completions.Wait(1) == 1, "Mismatched compression did not fail");
+  }
+
+  // Only float32 tensors are compressed.
+  auto ints = std::make_shared<CpuTensor>(HOROVOD_INT32, Shape(16));
+  Check(!EnqueueTensorAllreduce(context, ints, ints, nullptr, "fp16.int",
+                                CPU_DEVICE_ID, completions.Callback(), 1.0, 1.0,
+                                FP16_COMPRESSION)
+             .ok(),
+        "Compression of an int32 tensor was accepted");
+
+  horovod_shutdown();
+  if (rank == 0) {
+    std::cout << "Float16 compression passed on " << size << " ranks"
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Microbenchmark of the PyTorch HandleManager. Producer threads allocate
+// handles and wait for them like the Python thread does, while a completer
+// thread marks them done like the Horovod background thread does.
+//
+// Build and run from the repository root:
+//
+//   g++ -std=c++11 -O2 -pthread -Ihorovod/torch
+//       test/benchmarks/handle_manager_benchmark.cc
+//       horovod/torch/handle_manager.cc horovod/common/common.cc
+//       -o handle_manager_benchmark
+//   ./handle_manager_benchmark [producers] [handles per step] [steps]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "handle_manager.h"
+
+using namespace horovod::torch;
+
+int main(int argc, char** argv) {
+  int producers = argc > 1 ? std::atoi(argv[1]) : 4;
+  int handles_per_step = argc > 2 ? std::atoi(argv[2]) : 1000;
+  int steps = argc > 3 ? std::atoi(argv[3]) : 1000;
+
+  HandleManager handle_manager;
+
+  // Handles published by a producer thread to the completer thread. Handle i
+  // is stored at index i % handles_per_step, which is only reused once the
+  // producer has waited for handle i.
+  struct Channel {
+    std::vector<int> handles;
+    std::atomic_int published;
+    int completed;
+  };
+  std::vector<std::unique_ptr<Channel>> channels;
+  for (int p = 0; p < producers; ++p) {
+    channels.emplace_back(new Channel());
+    channels[p]->handles.resize(handles_per_step);
+    channels[p]->published = 0;
+    channels[p]->completed = 0;
+  }
+  std::atomic_bool done(false);
+
+  std::thread completer([&] {
+    while (!done) {
+      bool idle = true;
+      for (auto& channel : channels) {
+        int published = channel->published.load(std::memory_order_acquire);
+        for (; channel->completed < published; ++channel->completed) {
+          handle_manager.MarkDone(
+              channel->handles[channel->completed % handles_per_step],
+              Status::OK());
+          idle = false;
+        }
+      }
+      if (idle) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      auto& channel = *channels[p];
+      std::vector<int> handles(handles_per_step);
+      for (int step = 0; step < steps; ++step) {
+        for (int i = 0; i < handles_per_step; ++i) {
+          handles[i] = handle_manager.AllocateHandle();
+          channel.handles[i] = handles[i];
+          channel.published.fetch_add(1, std::memory_order_release);
+        }
+        for (auto handle : handles) {
+          handle_manager.PollHandle(handle);
+        }
+        handle_manager.WaitForAllHandles(handles);
+        for (auto handle : handles) {
+          auto status = handle_manager.ReleaseHandle(handle);
+          if (!status.ok()) {
+            std::cerr << "Unexpected status: " << status.reason() << std::endl;
+            std::exit(1);
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  done = true;
+  completer.join();
+
+  double operations = (double)producers * handles_per_step * steps;
+  std::cout << producers << " producers, " << handles_per_step
+            << " handles per step, " << steps << " steps: " << elapsed
+            << " s, " << operations / elapsed / 1e6
+            << " M handles per second" << std::endl;
+  return 0;
+}
@@ -0,0 +1,102 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Checks that a tensor whose input data is not ready does not hold back other
+// tensors. Every rank enqueues a tensor with a FutureReadyEvent which is not
+// set, a group of tensors with one such event, and tensors without events.
+// The test fails unless the tensors without events complete while the others
+// wait, and the others complete once their events are set.
+//
+// Built by run_tests.sh, and run on its own with
+//
+//   mpirun -np 2 ./ready_event_test
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+
+using namespace horovod::common;
+using namespace horovod::test;
+
+namespace {
+
+const std::chrono::seconds TIMEOUT(30);
+
+} // namespace
+
+int main(int argc, char** argv) {
+  horovod_init(nullptr, 0);
+  int rank = horovod_rank();
+  int size = horovod_size();
+
+  auto context = std::make_shared<CpuContext>();
+  auto make_tensor = [&]() {
+    return std::make_shared<CpuTensor>(Shape(16), 1.0f);
+  };
+
+  // A tensor whose data is not ready, and a group with one such tensor.
+  Completions late;
+  auto late_event = std::make_shared<FutureReadyEvent>();
+  auto late_tensor = make_tensor();
+  auto late_output = make_tensor();
+  CheckStatus(EnqueueTensorAllreduce(context, late_tensor, late_output,
+                                     late_event, "late", CPU_DEVICE_ID,
+                                     late.Callback()));
+
+  auto group_event = std::make_shared<FutureReadyEvent>();
+  std::vector<std::shared_ptr<OpContext>> contexts(2, context);
+  std::vector<std::shared_ptr<Tensor>> group_tensors{make_tensor(),
+                                                     make_tensor()};
+  std::vector<std::shared_ptr<Tensor>> group_outputs{make_tensor(),
+                                                     make_tensor()};
+  std::vector<std::shared_ptr<ReadyEvent>> group_events{nullptr, group_event};
+  std::vector<std::string> group_names{"group.0", "group.1"};
+  std::vector<StatusCallback> group_callbacks{late.Callback(),
+                                              late.Callback()};
+  CheckStatus(EnqueueTensorAllreduces(contexts, group_tensors, group_outputs,
+                                      group_events, group_names,
+                                      CPU_DEVICE_ID, group_callbacks));
+
+  // Tensors without events are performed while the others wait for data.
+  Completions early;
+  std::vector<std::shared_ptr<Tensor>> early_outputs;
+  for (int i = 0; i < 4; ++i) {
+    early_outputs.push_back(make_tensor());
+    CheckStatus(EnqueueTensorAllreduce(context, make_tensor(),
+                                       early_outputs.back(), nullptr,
+                                       "early." + std::to_string(i),
+                                       CPU_DEVICE_ID, early.Callback()));
+  }
+  Check(early.WaitFor(4, TIMEOUT) == 0,
+        "Tensors without events did not complete");
+  Check(late.done() == 0, "Tensors completed before their data was ready");
+
+  // The data becomes ready.
+  late_tensor->floats()[0] = 2.0f;
+  late_event->Set();
+  group_event->Set();
+  Check(late.WaitFor(3, TIMEOUT) == 0, "Tensors did not complete once ready");
+  Check(late_output->floats()[0] == 2.0f * size,
+        "Wrong result of the late tensor");
+
+  horovod_shutdown();
+  std::cout << "[" << rank << "] Tensors without events completed while "
+            << "others waited for data" << std::endl;
+  return 0;
+}
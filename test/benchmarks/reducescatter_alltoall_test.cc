@@ -0,0 +1,172 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Test of the reducescatter and alltoall operations. Every step enqueues
+// reducescatters whose first dimension is not always divisible by the number
+// of ranks, and alltoalls whose splits differ between ranks and steps, then
+// checks the results. Small tensors are fused, and the tensors are requested
+// again in later steps, which goes through the response cache. Invalid
+// splits must fail on every rank.
+//
+// Built by run_tests.sh, and run on its own with
+//
+//   mpirun -np 3 ./reducescatter_alltoall_test [tensors] [steps]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+
+using namespace horovod::common;
+using namespace horovod::test;
+
+namespace {
+
+int rank;
+int size;
+
+// Value of element column of slice row sent by rank r.
+float Value(int r, int64_t row, int64_t column) {
+  return (float)(r * 1000 + row * 10 + column % 10);
+}
+
+// Number of slices rank r sends to rank to in tensor i at the given step.
+// Some of them are zero.
+int64_t Split(int r, int to, int i, int step) {
+  return (r + 2 * to + i + step) % 4;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int tensors = argc > 1 ? std::atoi(argv[1]) : 16;
+  int steps = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  horovod_init(nullptr, 0);
+  rank = horovod_rank();
+  size = horovod_size();
+  Completions completions;
+
+  for (int step = 0; step < steps; ++step) {
+    std::vector<std::shared_ptr<CpuContext>> reducescatter_contexts;
+    std::vector<std::shared_ptr<CpuContext>> alltoall_contexts;
+    for (int i = 0; i < tensors; ++i) {
+      // Small tensors are fused, large ones are not.
+      int64_t columns = i % 4 == 3 ? 64 * 1024 : 16;
+      std::string suffix = "." + std::to_string(i);
+
+      int64_t rows = size * 2 + i % 3 - 1;
+      auto tensor = std::make_shared<CpuTensor>(Shape(rows, columns));
+      for (int64_t k = 0; k < tensor->shape().num_elements(); ++k) {
+        tensor->floats()[k] = Value(rank, k / columns, k % columns);
+      }
+      reducescatter_contexts.push_back(std::make_shared<CpuContext>());
+      Check(EnqueueTensorReducescatter(reducescatter_contexts.back(), tensor,
+                                       nullptr, "reducescatter" + suffix,
+                                       CPU_DEVICE_ID, completions.Callback())
+                .ok(),
+            "Enqueue failed");
+
+      // Every other tensor keeps its splits and sends the same number of
+      // slices to every rank.
+      std::vector<int64_t> splits;
+      if (i % 2 == 0) {
+        rows = 0;
+        for (int to = 0; to < size; ++to) {
+          splits.push_back(Split(rank, to, i, step));
+          rows += splits.back();
+        }
+      } else {
+        rows = 2 * size;
+      }
+      tensor = std::make_shared<CpuTensor>(Shape(rows, columns));
+      for (int64_t k = 0; k < tensor->shape().num_elements(); ++k) {
+        tensor->floats()[k] = Value(rank, k / columns, k % columns);
+      }
+      alltoall_contexts.push_back(std::make_shared<CpuContext>());
+      Check(EnqueueTensorAlltoall(alltoall_contexts.back(), tensor, splits,
+                                  nullptr, "alltoall" + suffix, CPU_DEVICE_ID,
+                                  completions.Callback())
+                .ok(),
+            "Enqueue failed");
+    }
+    Check(completions.Wait(2 * tensors) == 0, "Operation failed");
+
+    for (int i = 0; i < tensors; ++i) {
+      int64_t columns = i % 4 == 3 ? 64 * 1024 : 16;
+      int64_t rows = size * 2 + i % 3 - 1;
+      int64_t first_row =
+          rank * (rows / size) + std::min<int64_t>(rank, rows % size);
+      int64_t my_rows = rows / size + (rank < rows % size ? 1 : 0);
+      auto& output = reducescatter_contexts[i]->output;
+      Check(output->num_elements() == my_rows * columns,
+            "Wrong reducescatter shape");
+      auto values = output->floats();
+      for (int64_t k = 0; k < output->num_elements(); ++k) {
+        float expected = 0;
+        for (int r = 0; r < size; ++r) {
+          expected += Value(r, first_row + k / columns, k % columns);
+        }
+        Check(values[k] == expected, "Wrong reducescatter result");
+      }
+
+      auto& alltoall_output = alltoall_contexts[i]->output;
+      auto received = alltoall_output->floats();
+      int64_t received_size = alltoall_output->num_elements();
+      int64_t offset = 0;
+      for (int r = 0; r < size; ++r) {
+        // First slice and number of slices sent by rank r to this rank.
+        int64_t begin = 0;
+        int64_t count = 2;
+        if (i % 2 == 0) {
+          for (int to = 0; to < rank; ++to) {
+            begin += Split(r, to, i, step);
+          }
+          count = Split(r, rank, i, step);
+        } else {
+          begin = 2 * rank;
+        }
+        for (int64_t k = 0; k < count * columns; ++k) {
+          Check(offset < received_size &&
+                    received[offset++] ==
+                        Value(r, begin + k / columns, k % columns),
+                "Wrong alltoall result");
+        }
+      }
+      Check(offset == received_size, "Wrong alltoall shape");
+    }
+  }
+
+  // Splits which do not sum to the first dimension fail on every rank.
+  auto tensor = std::make_shared<CpuTensor>(Shape(size, 4));
+  std::vector<int64_t> splits(size, rank == 0 ? 2 : 1);
+  Check(EnqueueTensorAlltoall(std::make_shared<CpuContext>(), tensor, splits,
+                              nullptr, "alltoall.invalid", CPU_DEVICE_ID,
+                              completions.Callback())
+            .ok(),
+        "Enqueue failed");
+  Check(completions.Wait(1) == 1, "Invalid splits did not fail");
+
+  horovod_shutdown();
+  if (rank == 0) {
+    std::cout << "Reducescatter and alltoall passed on " << size << " ranks"
+              << std::endl;
+  }
+  return 0;
+}
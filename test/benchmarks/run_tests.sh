@@ -0,0 +1,99 @@
+#!/usr/bin/env bash
+# Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+# Builds the C++ tests and benchmarks of this directory against horovod/common
+# and runs them. The tests run with their default sizes and the benchmarks
+# with small ones, so that every check they make is exercised.
+#
+#   test/benchmarks/run_tests.sh [build directory]
+#
+# MPIRUN is the launcher, without the number of processes (default: mpirun).
+# CXX is the MPI compiler wrapper (default: mpicxx). CXXFLAGS is added to the
+# compiler flags, for example to point at Eigen and LBFGSpp installed outside
+# of third_party.
+
+set -e
+
+ROOT="$(cd "$(dirname "$0")/../.." && pwd)"
+BUILD="${1:-${ROOT}/build/test_benchmarks}"
+MPIRUN="${MPIRUN:-mpirun}"
+CXX="${CXX:-mpicxx}"
+FLAGS="-std=c++11 -O2 -pthread -mf16c -mavx -DEIGEN_MPL2_ONLY=1
+       -I${ROOT}/horovod/common -I${ROOT}/third_party/eigen
+       -I${ROOT}/third_party/lbfgs/include ${CXXFLAGS}"
+
+mkdir -p "${BUILD}/obj"
+
+echo "Building horovod/common"
+for src in "${ROOT}"/horovod/common/*.cc "${ROOT}"/horovod/common/optim/*.cc; do
+  ${CXX} ${FLAGS} -c "${src}" -o "${BUILD}/obj/$(basename "${src}" .cc).o" &
+done
+wait
+rm -f "${BUILD}/libhorovod_common.a"
+ar rcs "${BUILD}/libhorovod_common.a" "${BUILD}"/obj/*.o
+
+build() {
+  local name=$1
+  shift
+  echo "Building ${name}"
+  ${CXX} ${FLAGS} "${ROOT}/test/benchmarks/${name}.cc" "$@" \
+      -o "${BUILD}/${name}"
+}
+
+for name in ready_event_test enqueue_allocation_test \
+            concurrent_collectives_benchmark allreduce_engine_benchmark \
+            reducescatter_alltoall_test sparse_allreduce_test \
+            fp16_compression_test topk_compression_test; do
+  build ${name} "${BUILD}/libhorovod_common.a"
+done
+build submission_queue_benchmark
+build handle_manager_benchmark -I"${ROOT}/horovod/torch" \
+    "${ROOT}/horovod/torch/handle_manager.cc" "${BUILD}/obj/common.o"
+
+# Runs a program on the given number of processes, with the environment
+# variables given before the number.
+run() {
+  local env=()
+  while [[ $1 == *=* ]]; do
+    env+=("$1")
+    shift
+  done
+  local np=$1
+  local name=$2
+  shift 2
+  echo "Running ${name} on ${np} processes${env[*]:+ with ${env[*]}}"
+  env "${env[@]}" ${MPIRUN} -np ${np} "${BUILD}/${name}" "$@"
+}
+
+run 2 ready_event_test
+run 2 enqueue_allocation_test
+run HOROVOD_FUSION_THRESHOLD=1048576 HOROVOD_CONCURRENT_COLLECTIVES=4 \
+    2 concurrent_collectives_benchmark 16 5
+run HOROVOD_FUSION_THRESHOLD=1048576 HOROVOD_ZERO_COPY_FUSION=1 \
+    2 concurrent_collectives_benchmark 16 5
+run 3 allreduce_engine_benchmark 1
+run 3 reducescatter_alltoall_test
+run 3 sparse_allreduce_test
+run HOROVOD_SPARSE_DENSITY_THRESHOLD=0.01 3 sparse_allreduce_test
+run 3 fp16_compression_test
+run HOROVOD_FUSION_THRESHOLD=0 3 fp16_compression_test
+run HOROVOD_ALLREDUCE_CHUNK_SIZE=65536 3 fp16_compression_test
+run 3 topk_compression_test
+run HOROVOD_FUSION_THRESHOLD=0 3 topk_compression_test
+"${BUILD}/submission_queue_benchmark" 4 10000
+"${BUILD}/handle_manager_benchmark" 4 100 100
+
+echo "All tests passed"
@@ -0,0 +1,163 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Test of the sparse allreduce operation. Every step enqueues sparse tensors
+// whose number of rows differs between ranks and steps, with indices repeated
+// within a rank and shared between ranks, then checks that every index is
+// returned once with the sum of its rows. Small tensors are fused, and both
+// int32 and int64 indices are used. Running with
+// HOROVOD_SPARSE_DENSITY_THRESHOLD set to a small fraction reduces the dense
+// tensors instead when their number of rows is known. Indices out of range
+// must fail on every rank.
+//
+// Built by run_tests.sh, and run on its own with
+//
+//   mpirun -np 3 ./sparse_allreduce_test [tensors] [steps]
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+
+using namespace horovod::common;
+using namespace horovod::test;
+
+namespace {
+
+int rank;
+int size;
+
+const int64_t DENSE_ROWS = 50;
+
+// Number of rows rank r sends in tensor i at the given step.
+int64_t Rows(int r, int i, int step) { return 3 + (r + i + step) % 5; }
+
+// Index of row k sent by rank r in tensor i at the given step. The last row
+// repeats the index of the first one.
+int64_t Index(int r, int i, int step, int64_t k) {
+  if (k == Rows(r, i, step) - 1) {
+    k = 0;
+  }
+  return (r * 7 + k * 3 + i + step) % DENSE_ROWS;
+}
+
+// Value of element column of row k sent by rank r.
+float Value(int r, int64_t k, int64_t column) {
+  return (float)(r * 1000 + k * 10 + column % 10);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int tensors = argc > 1 ? std::atoi(argv[1]) : 16;
+  int steps = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  horovod_init(nullptr, 0);
+  rank = horovod_rank();
+  size = horovod_size();
+  Completions completions;
+
+  for (int step = 0; step < steps; ++step) {
+    std::vector<std::shared_ptr<CpuContext>> contexts;
+    std::vector<std::shared_ptr<CpuContext>> indices_contexts;
+    for (int i = 0; i < tensors; ++i) {
+      // Small tensors are fused, large ones are not.
+      int64_t columns = i % 4 == 3 ? 16 * 1024 : 16;
+      auto index_dtype = i % 2 == 0 ? HOROVOD_INT32 : HOROVOD_INT64;
+      int64_t rows = Rows(rank, i, step);
+      auto indices = std::make_shared<CpuTensor>(index_dtype, Shape(rows));
+      auto values =
+          std::make_shared<CpuTensor>(HOROVOD_FLOAT32, Shape(rows, columns));
+      for (int64_t k = 0; k < rows; ++k) {
+        indices->SetIndex(k, Index(rank, i, step, k));
+        for (int64_t c = 0; c < columns; ++c) {
+          values->floats()[k * columns + c] = Value(rank, k, c);
+        }
+      }
+      // The number of rows of some dense tensors is unknown.
+      int64_t dense_rows = i % 4 == 1 ? 0 : DENSE_ROWS;
+      contexts.push_back(std::make_shared<CpuContext>(HOROVOD_FLOAT32));
+      indices_contexts.push_back(std::make_shared<CpuContext>(index_dtype));
+      Check(EnqueueTensorSparseAllreduce(
+                contexts.back(), indices_contexts.back(), indices, values,
+                dense_rows, nullptr, "sparse." + std::to_string(i),
+                CPU_DEVICE_ID, completions.Callback())
+                .ok(),
+            "Enqueue failed");
+    }
+    Check(completions.Wait(tensors) == 0, "Operation failed");
+
+    for (int i = 0; i < tensors; ++i) {
+      int64_t columns = i % 4 == 3 ? 16 * 1024 : 16;
+      std::map<int64_t, std::vector<float>> expected;
+      for (int r = 0; r < size; ++r) {
+        for (int64_t k = 0; k < Rows(r, i, step); ++k) {
+          auto& row = expected[Index(r, i, step, k)];
+          row.resize(columns);
+          for (int64_t c = 0; c < columns; ++c) {
+            row[c] += Value(r, k, c);
+          }
+        }
+      }
+
+      // Reduced dense tensors also hold the rows no rank sent, as zeros.
+      auto& indices = indices_contexts[i]->output;
+      auto& values = contexts[i]->output;
+      int64_t rows = indices->shape().dim_size(0);
+      Check(values->shape().dim_size(0) == rows &&
+                values->shape().dim_size(1) == columns,
+            "Wrong sparse allreduce shape");
+      Check(rows == (int64_t)expected.size() ||
+                (i % 4 != 1 && rows == DENSE_ROWS),
+            "Wrong number of rows");
+      for (int64_t k = 0; k < rows; ++k) {
+        int64_t index = indices->Index(k);
+        Check(k == 0 || index > indices->Index(k - 1),
+              "Indices are not sorted");
+        auto it = expected.find(index);
+        for (int64_t c = 0; c < columns; ++c) {
+          float value = it == expected.end() ? 0 : it->second[c];
+          Check(values->floats()[k * columns + c] == value,
+                "Wrong sparse allreduce result");
+        }
+      }
+    }
+  }
+
+  // An index out of the range of the dense tensor on a single rank fails on
+  // every rank, since all the rows are gathered.
+  auto indices = std::make_shared<CpuTensor>(HOROVOD_INT64, Shape(2));
+  auto values = std::make_shared<CpuTensor>(HOROVOD_FLOAT32, Shape(2, 4));
+  indices->SetIndex(0, 1);
+  indices->SetIndex(1, rank == 0 ? -1 : 0);
+  Check(EnqueueTensorSparseAllreduce(
+            std::make_shared<CpuContext>(HOROVOD_FLOAT32),
+            std::make_shared<CpuContext>(HOROVOD_INT64), indices, values, 0,
+            nullptr, "sparse.invalid", CPU_DEVICE_ID, completions.Callback())
+            .ok(),
+        "Enqueue failed");
+  Check(completions.Wait(1) == 1, "Invalid index did not fail");
+
+  horovod_shutdown();
+  if (rank == 0) {
+    std::cout << "Sparse allreduce passed on " << size << " ranks" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,212 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Contention benchmark of the submission queue. Producer threads submit
+// named requests like framework threads enqueueing tensors, while a consumer
+// thread drains them like the Horovod background thread does. The consumer
+// holds the mutex for a while every cycle, standing in for fusion planning.
+// The MPSCQueue is compared with a vector protected by a mutex, which is how
+// tensors used to be submitted.
+//
+// Build and run from the repository root:
+//
+//   g++ -std=c++11 -O2 -pthread -Ihorovod/common
+//       test/benchmarks/submission_queue_benchmark.cc
+//       -o submission_queue_benchmark
+//   ./submission_queue_benchmark [producers] [submissions per producer]
+//       [queue capacity] [planning us]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mpsc_queue.h"
+
+using namespace horovod::common;
+
+namespace {
+
+struct Request {
+  std::string name;
+  int64_t size = 0;
+};
+
+// Spins for the given duration, standing in for work of the background
+// thread.
+void Work(std::chrono::microseconds duration) {
+  auto until = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < until)
+    ;
+}
+
+struct Result {
+  double elapsed;
+  double max_submit_us;
+};
+
+// Runs the producers and returns the elapsed time, and the longest time a
+// producer spent in a single submission.
+template <class Submit>
+Result RunProducers(int producers, int submissions, Submit submit) {
+  std::vector<double> max_submit_us(producers, 0);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      std::string name;
+      for (int i = 0; i < submissions; ++i) {
+        name = "tensor." + std::to_string(p) + "." + std::to_string(i % 512);
+        auto before = std::chrono::steady_clock::now();
+        submit(name, i);
+        double us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - before)
+                        .count();
+        if (us > max_submit_us[p]) {
+          max_submit_us[p] = us;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  Result result;
+  result.elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  result.max_submit_us = 0;
+  for (auto us : max_submit_us) {
+    if (us > result.max_submit_us) {
+      result.max_submit_us = us;
+    }
+  }
+  return result;
+}
+
+void Report(const char* label, int producers, int submissions,
+            const Result& result) {
+  double total = (double)producers * submissions;
+  std::cout << label << ": " << result.elapsed << " s, "
+            << total / result.elapsed / 1e6 << " M submissions per second, "
+            << "longest submission " << result.max_submit_us << " us"
+            << std::endl;
+}
+
+Result BenchmarkMutex(int producers, int submissions,
+                      std::chrono::microseconds planning) {
+  std::mutex mutex;
+  std::vector<Request> queue;
+  std::atomic_bool done(false);
+  int64_t drained = 0;
+
+  std::thread consumer([&] {
+    std::vector<Request> cycle;
+    while (!done) {
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::swap(cycle, queue);
+        // Fusion planning used to run with the mutex held.
+        Work(planning);
+      }
+      drained += cycle.size();
+      cycle.clear();
+      std::this_thread::yield();
+    }
+  });
+
+  auto result =
+      RunProducers(producers, submissions, [&](const std::string& name, int i) {
+        std::lock_guard<std::mutex> guard(mutex);
+        queue.emplace_back();
+        queue.back().name = name;
+        queue.back().size = i;
+      });
+  done = true;
+  consumer.join();
+  drained += queue.size();
+  if (drained != (int64_t)producers * submissions) {
+    std::cerr << "Lost submissions: " << drained << std::endl;
+    std::exit(1);
+  }
+  return result;
+}
+
+Result BenchmarkMPSCQueue(int producers, int submissions, uint64_t capacity,
+                          std::chrono::microseconds planning) {
+  MPSCQueue<Request> queue(capacity);
+  std::atomic_bool done(false);
+  int64_t drained = 0;
+  int64_t checksum = 0;
+
+  auto drain = [&] {
+    while (queue.Ready()) {
+      checksum += queue.Peek().size;
+      queue.Pop();
+      ++drained;
+    }
+  };
+
+  std::thread consumer([&] {
+    while (!done) {
+      drain();
+      // Fusion planning no longer blocks the producers.
+      Work(planning);
+      std::this_thread::yield();
+    }
+  });
+
+  auto result =
+      RunProducers(producers, submissions, [&](const std::string& name, int i) {
+        auto position = queue.Reserve(1);
+        auto& request = queue.At(position);
+        request.name.assign(name);
+        request.size = i;
+        queue.Publish(position);
+      });
+  done = true;
+  consumer.join();
+  drain();
+  int64_t expected_checksum =
+      (int64_t)producers * submissions * (submissions - 1) / 2;
+  if (drained != (int64_t)producers * submissions ||
+      checksum != expected_checksum) {
+    std::cerr << "Lost submissions: " << drained << std::endl;
+    std::exit(1);
+  }
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int producers = argc > 1 ? std::atoi(argv[1]) : 16;
+  int submissions = argc > 2 ? std::atoi(argv[2]) : 100000;
+  uint64_t capacity = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 16384;
+  std::chrono::microseconds planning(argc > 4 ? std::atoi(argv[4]) : 50);
+
+  std::cout << producers << " producers, " << submissions
+            << " submissions per producer, queue capacity " << capacity
+            << ", planning " << planning.count() << " us" << std::endl;
+  Report("mutex", producers, submissions,
+         BenchmarkMutex(producers, submissions, planning));
+  Report("mpsc queue", producers, submissions,
+         BenchmarkMPSCQueue(producers, submissions, capacity, planning));
+  return 0;
+}
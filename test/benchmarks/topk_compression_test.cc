@@ -0,0 +1,166 @@
+// Copyright 2019 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Test of allreduce with top-k compression. Every step enqueues float32
+// tensors with scale factors, then checks the results against a simulation of
+// the selection and residuals of every rank. Values are multiples of a power
+// of two, so that sums are exact and results must match exactly, and many
+// elements have the same magnitude. Small tensors are selected exactly, large
+// ones through a sampled threshold. Tensors are fused, and running with
+// HOROVOD_FUSION_THRESHOLD=0 reduces them one at a time. Horovod is restarted
+// once, after which the residuals must start from zero again. Compression of
+// tensors other than float32 must be rejected.
+//
+// Built by run_tests.sh, and run on its own with
+//
+//   mpirun -np 3 ./topk_compression_test [tensors] [steps]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+
+using namespace horovod::common;
+using namespace horovod::test;
+
+namespace {
+
+int rank;
+int size;
+
+const char* RATIO = "0.05";
+const float PRESCALE = 0.5f;
+const float POSTSCALE = 0.25f;
+
+// Large tensors are selected through a sampled threshold.
+int64_t Elements(int i) { return i % 4 == 3 ? 100 * 1024 + i : 300 + 37 * i; }
+
+int64_t K(int i) {
+  return std::max((int64_t)1,
+                  (int64_t)std::ceil(std::atof(RATIO) * Elements(i)));
+}
+
+// Value of element k of tensor i sent by rank r.
+float Value(int r, int i, int step, int64_t k) {
+  return (float)((k * 37 + r * 11 + i * 5 + step * 3) % 61 - 30) / 64;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int tensors = argc > 1 ? std::atoi(argv[1]) : 8;
+  int steps = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  setenv(HOROVOD_TOPK_RATIO, RATIO, 1);
+  // MPI is initialized here, so that Horovod can be restarted.
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+  Completions completions;
+  auto context = std::make_shared<CpuContext>();
+
+  // Horovod is restarted once, which must drop the residuals.
+  for (int session = 0; session < 2; ++session) {
+    horovod_init(nullptr, 0);
+    rank = horovod_rank();
+    size = horovod_size();
+
+    // Residuals of every rank for every tensor, as simulated by the test.
+    std::vector<std::vector<std::vector<float>>> residuals(
+        size, std::vector<std::vector<float>>(tensors));
+    for (int r = 0; r < size; ++r) {
+      for (int i = 0; i < tensors; ++i) {
+        residuals[r][i].resize(Elements(i));
+      }
+    }
+
+    for (int step = 0; step < steps; ++step) {
+      std::vector<std::shared_ptr<CpuTensor>> outputs;
+      for (int i = 0; i < tensors; ++i) {
+        auto tensor = std::make_shared<CpuTensor>(HOROVOD_FLOAT32,
+                                                  Shape(Elements(i)));
+        for (int64_t k = 0; k < Elements(i); ++k) {
+          tensor->floats()[k] = Value(rank, i, step, k);
+        }
+        // Odd tensors are reduced in place.
+        auto output = i % 2 == 1 ? tensor
+                                 : std::make_shared<CpuTensor>(
+                                       HOROVOD_FLOAT32, Shape(Elements(i)));
+        outputs.push_back(output);
+        Check(EnqueueTensorAllreduce(context, tensor, output, nullptr,
+                                     "topk." + std::to_string(i),
+                                     CPU_DEVICE_ID, completions.Callback(),
+                                     PRESCALE, POSTSCALE, TOPK_COMPRESSION)
+                  .ok(),
+              "Enqueue failed");
+      }
+      Check(completions.Wait(tensors) == 0, "Operation failed");
+
+      for (int i = 0; i < tensors; ++i) {
+        std::vector<float> expected(Elements(i));
+        std::vector<int64_t> order(Elements(i));
+        for (int r = 0; r < size; ++r) {
+          auto& residual = residuals[r][i];
+          for (int64_t k = 0; k < Elements(i); ++k) {
+            residual[k] += PRESCALE * Value(r, i, step, k);
+          }
+          // Of elements of equal magnitude, the first ones are selected.
+          std::iota(order.begin(), order.end(), 0);
+          std::stable_sort(order.begin(), order.end(),
+                           [&](int64_t a, int64_t b) {
+                             return std::fabs(residual[a]) >
+                                    std::fabs(residual[b]);
+                           });
+          for (int64_t j = 0; j < K(i); ++j) {
+            expected[order[j]] += residual[order[j]];
+            residual[order[j]] = 0;
+          }
+        }
+        for (int64_t k = 0; k < Elements(i); ++k) {
+          Check(outputs[i]->floats()[k] == expected[k] * POSTSCALE,
+                "Wrong result of tensor " + std::to_string(i) + " at " +
+                    std::to_string(k) + ": " +
+                    std::to_string(outputs[i]->floats()[k]) + " instead of " +
+                    std::to_string(expected[k] * POSTSCALE));
+        }
+      }
+    }
+
+    if (session == 0) {
+      horovod_shutdown();
+    }
+  }
+
+  // Only float32 tensors are compressed.
+  auto ints = std::make_shared<CpuTensor>(HOROVOD_INT32, Shape(16));
+  Check(!EnqueueTensorAllreduce(context, ints, ints, nullptr, "topk.int",
+                                CPU_DEVICE_ID, completions.Callback(), 1.0, 1.0,
+                                TOPK_COMPRESSION)
+             .ok(),
+        "Compression of an int32 tensor was accepted");
+
+  horovod_shutdown();
+  MPI_Finalize();
+  if (rank == 0) {
+    std::cout << "Top-k compression passed on " << size << " ranks"
+              << std::endl;
+  }
+  return 0;
+}
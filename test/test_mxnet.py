@@ -247,6 +247,82 @@ class MXTests(unittest.TestCase):
         except (MXNetError, RuntimeError):
             pass
 
+    def test_horovod_reducescatter(self):
+        """Test that the reducescatter correctly sums and scatters 1D, 2D, 3D
+        tensors, even if the first dimension is not divisible by the size."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = ['int32',   'int64',
+                  'float32', 'float64']
+        dims = [1, 2, 3]
+        ctx = self._current_context()
+        count = 0
+        rows = 2 * size + 1
+        for dtype, dim in itertools.product(dtypes, dims):
+            # Row i holds the value i on every process.
+            tensor = mx.nd.arange(rows, ctx=ctx).reshape(
+                (rows,) + (1,) * (dim - 1))
+            tensor = mx.nd.tile(tensor, reps=(1,) + (17,) * (dim - 1))
+            tensor = tensor.astype(dtype)
+            reduced = hvd.reducescatter(tensor, average=False,
+                                        name='reducescatter_' + str(count))
+            count += 1
+
+            # The first rows % size ranks receive one row more.
+            first_row = rank * (rows // size) + min(rank, rows % size)
+            num_rows = rows // size + (1 if rank < rows % size else 0)
+            expected = tensor[first_row:first_row + num_rows] * size
+            assert reduced.shape == expected.shape, \
+                'hvd.reducescatter produces incorrect reduced shape'
+            assert same(reduced.asnumpy(), expected.asnumpy()), \
+                'hvd.reducescatter produces incorrect reduced tensor'
+
+    def test_horovod_alltoall(self):
+        """Test that the alltoall correctly distributes 1D, 2D, 3D tensors,
+        with splits which differ among the processes."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = ['int32',   'int64',
+                  'float32', 'float64']
+        dims = [1, 2, 3]
+        ctx = self._current_context()
+        count = 0
+        for dtype, dim in itertools.product(dtypes, dims):
+            # Process r sends (r + i) % 3 + 1 slices holding the value i to
+            # process i.
+            splits = [(rank + i) % 3 + 1 for i in range(size)]
+            tensor = mx.nd.concat(
+                *[mx.nd.ones((splits[i],) + (17,) * (dim - 1), ctx=ctx) * i
+                  for i in range(size)], dim=0)
+            tensor = tensor.astype(dtype)
+            received = hvd.alltoall(tensor, splits=splits,
+                                    name='alltoall_' + str(count))
+            count += 1
+
+            rows = sum((r + rank) % 3 + 1 for r in range(size))
+            assert received.shape == (rows,) + (17,) * (dim - 1), \
+                'hvd.alltoall produces incorrect shape'
+            assert (received.asnumpy() == rank).all(), \
+                'hvd.alltoall produces incorrect tensor'
+
+    def test_horovod_alltoall_splits_error(self):
+        """Test that the alltoall raises an error if the splits do not add up
+        to the first dimension of the tensor."""
+        hvd.init()
+        size = hvd.size()
+
+        tensor = mx.nd.ones(shape=(size + 1, 17),
+                            ctx=self._current_context())
+
+        try:
+            output = hvd.alltoall(tensor, splits=[1] * size)
+            output.wait_to_read()
+            assert False, 'hvd.alltoall did not throw error'
+        except (MXNetError, RuntimeError):
+            pass
+
     def test_horovod_broadcast(self):
         """Test that the broadcast correctly broadcasts 1D, 2D, 3D tensors."""
         hvd.init()
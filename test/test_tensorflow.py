@@ -137,6 +137,24 @@ class MPITests(tf.test.TestCase):
         self.assertTrue(self.evaluate(tf.reduce_all(tests)),
                         "hvd.allreduce produces incorrect results")
 
+    def test_horovod_grouped_allreduce_cpu(self):
+        """Test on CPU that the grouped allreduce correctly sums a group of
+        1D, 2D, 3D tensors."""
+        hvd.init()
+        size = hvd.size()
+        dtypes = [tf.int32, tf.int64, tf.float32, tf.float64]
+        tests = []
+        for dtype in dtypes:
+            with tf.device("/cpu:0"):
+                tf.set_random_seed(1234)
+                tensors = [tf.random_uniform([17] * dim, -100, 100, dtype=dtype)
+                           for dim in [1, 2, 3]]
+                summed = hvd.grouped_allreduce(tensors, average=False)
+            for tensor, result in zip(tensors, summed):
+                tests.append(tf.reduce_all(tf.equal(result, tensor * size)))
+        self.assertTrue(self.evaluate(tf.reduce_all(tests)),
+                        "hvd.grouped_allreduce produces incorrect results")
+
     def test_horovod_allreduce_gpu(self):
         """Test that the allreduce works on GPUs.
 
@@ -642,6 +660,185 @@ class MPITests(tf.test.TestCase):
                             "error: %s" %
                             (grad_out, expected, str(err)))
 
+    def test_horovod_reducescatter(self):
+        """Test that the reducescatter correctly sums and scatters 1D, 2D, 3D
+        tensors, even if the first dimension is not divisible by the size."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [tf.int32, tf.int64, tf.float16, tf.float32, tf.float64]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            rows = 2 * size + 1
+            with tf.device("/cpu:0"):
+                # Row i holds the value i on every process.
+                tensor = tf.reshape(tf.range(rows), [rows] + [1] * (dim - 1))
+                tensor = tf.cast(tf.tile(tensor, [1] + [17] * (dim - 1)), dtype)
+                reduced = hvd.reducescatter(tensor)
+            reduced_tensor = self.evaluate(reduced)
+
+            # The first rows % size ranks receive one row more.
+            first_row = rank * (rows // size) + min(rank, rows % size)
+            num_rows = rows // size + (1 if rank < rows % size else 0)
+            self.assertEqual(list(reduced_tensor.shape),
+                             [num_rows] + [17] * (dim - 1))
+            for i in range(num_rows):
+                self.assertTrue(
+                    np.all(reduced_tensor[i] == (first_row + i) * size),
+                    "hvd.reducescatter produces incorrect reduced tensor")
+
+    def test_horovod_reducescatter_error(self):
+        """Test that the reducescatter returns an error if the shapes of the
+        tensors differ among the processes."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            return
+
+        with tf.device("/cpu:0"):
+            tensor = tf.ones([17 + rank, 17], dtype=tf.float32)
+            with self.assertRaises(tf.errors.FailedPreconditionError):
+                self.evaluate(hvd.reducescatter(tensor))
+
+    def test_horovod_alltoall(self):
+        """Test that the alltoall correctly distributes 1D, 2D, 3D tensors,
+        with even splits and with splits which differ among the processes."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [tf.uint8, tf.int8, tf.uint16, tf.int16,
+                  tf.int32, tf.int64, tf.float16, tf.float32,
+                  tf.float64]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            # Process r sends (r + i) % 3 slices holding the value i to
+            # process i, or two slices if the splits are even.
+            for splits in [None, [(rank + i) % 3 for i in range(size)]]:
+                counts = splits if splits is not None else [2] * size
+                with tf.device("/cpu:0"):
+                    tensor = tf.concat(
+                        [tf.ones([counts[i]] + [17] * (dim - 1)) * i
+                         for i in range(size)], axis=0)
+                    tensor = tf.cast(tensor, dtype=dtype)
+                    received = hvd.alltoall(tensor, splits=splits)
+                received_tensor = self.evaluate(received)
+
+                rows = 2 * size if splits is None else \
+                    sum((r + rank) % 3 for r in range(size))
+                self.assertEqual(list(received_tensor.shape),
+                                 [rows] + [17] * (dim - 1))
+                self.assertTrue(
+                    np.all(received_tensor.astype(np.int32) == rank),
+                    "hvd.alltoall produces incorrect tensor")
+
+    def test_horovod_alltoall_splits_error(self):
+        """Test that the alltoall returns an error if the splits do not add up
+        to the first dimension of the tensor."""
+        hvd.init()
+        size = hvd.size()
+
+        with tf.device("/cpu:0"):
+            tensor = tf.ones([size + 1, 17], dtype=tf.float32)
+            with self.assertRaises(tf.errors.FailedPreconditionError):
+                self.evaluate(hvd.alltoall(tensor, splits=[1] * size))
+
+    def test_horovod_alltoall_grad(self):
+        """Test the correctness of the alltoall gradient."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [tf.float32, tf.float64]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            splits = [(rank + i) % 3 for i in range(size)]
+            shape = [sum(splits)] + [17] * (dim - 1)
+            with tf.device("/cpu:0"):
+                if _executing_eagerly():
+                    tensor = self.tfe.Variable(tf.ones(shape, dtype=dtype))
+                    with tf.GradientTape() as tape:
+                        received = hvd.alltoall(tensor, splits=splits)
+                        grad_ys = tf.ones_like(received) * 2
+                    grad_out = tape.gradient(received, tensor, grad_ys)
+                else:
+                    tensor = tf.ones(shape, dtype=dtype)
+                    received = hvd.alltoall(tensor, splits=splits)
+                    grad_ys = tf.ones_like(received) * 2
+                    grad = tf.gradients(received, tensor, grad_ys)[0]
+                    grad_out = self.evaluate(grad)
+
+            # The gradient is sent back to the processes the slices came from.
+            expected = np.ones(shape) * 2
+            err = np.linalg.norm(expected - grad_out)
+            self.assertLess(err, 0.00000001,
+                            "gradient %s differs from expected %s, "
+                            "error: %s" % (grad_out, expected, str(err)))
+
+    def test_horovod_sparse_allreduce(self):
+        """Test that the sparse allreduce sums the rows with the same index
+        within and across processes, and returns every index once."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [tf.int32, tf.int64, tf.float32, tf.float64]
+        index_dtypes = [tf.int32, tf.int64]
+        for dtype, index_dtype in itertools.product(dtypes, index_dtypes):
+            # Process r sends index r twice, and index size which every
+            # process sends.
+            with tf.device("/cpu:0"):
+                indices = tf.constant([rank, size, rank], dtype=index_dtype)
+                values = tf.cast(tf.ones([3, 17]), dtype=dtype)
+                summed, summed_indices = hvd.sparse_allreduce(values, indices)
+            summed, summed_indices = self.evaluate([summed, summed_indices])
+
+            self.assertEqual(list(summed_indices), list(range(size + 1)))
+            expected = np.array([[2] * 17] * size + [[size] * 17])
+            self.assertTrue(np.all(summed == expected),
+                            "hvd.sparse_allreduce produces incorrect tensor")
+
+    def test_horovod_sparse_allreduce_indexed_slices(self):
+        """Test that the allreduce of IndexedSlices averages the rows with the
+        same index."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        with tf.device("/cpu:0"):
+            slices = tf.IndexedSlices(
+                tf.ones([2, 5]) * (rank + 1),
+                tf.constant([0, rank + 1], dtype=tf.int64),
+                dense_shape=tf.constant([size + 1, 5], dtype=tf.int64))
+            averaged = hvd.allreduce(slices)
+            dense = tf.convert_to_tensor(averaged)
+        dense = self.evaluate(dense)
+
+        expected = np.zeros([size + 1, 5])
+        expected[0] = sum(r + 1 for r in range(size)) / float(size)
+        for r in range(size):
+            expected[r + 1] = (r + 1) / float(size)
+        err = np.linalg.norm(expected - dense)
+        self.assertLess(err, 0.00001,
+                        "hvd.allreduce of IndexedSlices produces incorrect "
+                        "tensor %s, expected %s" % (dense, expected))
+
+    def test_horovod_sparse_allreduce_index_error(self):
+        """Test that the sparse allreduce returns an error if an index is
+        negative on any process."""
+        hvd.init()
+        rank = hvd.rank()
+
+        with tf.device("/cpu:0"):
+            indices = tf.constant([0, -1 if rank == 0 else 1], dtype=tf.int64)
+            values = tf.ones([2, 17])
+            with self.assertRaises(tf.errors.InvalidArgumentError):
+                self.evaluate(hvd.sparse_allreduce(values, indices))
+
     def test_horovod_broadcast(self):
         """Test that the broadcast correctly broadcasts 1D, 2D, 3D tensors."""
         hvd.init()
@@ -763,6 +960,25 @@ class MPITests(tf.test.TestCase):
                             "gradient %s differs from expected %s, "
                             "error: %s" % (grad_out, expected, str(err)))
 
+    def test_horovod_allreduce_fp16_compression(self):
+        """Test that the allreduce of float32 CPU tensors compressed to 16-bit
+        by Horovod sums them within float16 precision, and keeps their type."""
+        hvd.init()
+        size = hvd.size()
+        dims = [1, 2, 3]
+        for dim in dims:
+            with tf.device("/cpu:0"):
+                tf.set_random_seed(1234)
+                tensor = tf.random_uniform([17] * dim, -1.0, 1.0)
+                summed = hvd.allreduce(tensor, average=False,
+                                       device_dense="/cpu:0",
+                                       compression=hvd.Compression.fp16)
+            self.assertEqual(summed.dtype, tf.float32)
+            difference = self.evaluate(tf.abs(summed - tensor * size))
+            self.assertTrue(difference.max() <= size * 1e-3,
+                            "hvd.allreduce with fp16 compression produces "
+                            "incorrect results")
+
     def test_compression_fp16(self):
         valid_dtypes = [tf.float16, tf.float32, tf.float64]
         invalid_dtypes = [tf.uint8, tf.int8, tf.uint16, tf.int16,
@@ -177,6 +177,34 @@ class TorchTests(unittest.TestCase):
 
             assert max_difference <= threshold, 'hvd.allreduce produces incorrect results'
 
+    def test_horovod_grouped_allreduce(self):
+        """Test that the grouped allreduce correctly sums and averages a group of
+        1D, 2D, 3D tensors."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            # Grouped allreduce is only supported with the v2 API.
+            return
+        hvd.init()
+        size = hvd.size()
+        dtypes = [torch.IntTensor, torch.LongTensor,
+                  torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        for dtype in dtypes:
+            torch.manual_seed(1234)
+            tensors = [torch.FloatTensor(*([17] * dim)).random_(-100, 100).type(dtype)
+                       for dim in [1, 2, 3]]
+            summed = hvd.grouped_allreduce(tensors, average=False)
+            for tensor, result in zip(tensors, summed):
+                assert torch.equal(result, tensor * size), \
+                    'hvd.grouped_allreduce produces incorrect results'
+
+            inplace = [tensor.clone() for tensor in tensors]
+            hvd.grouped_allreduce_(inplace, average=False)
+            for tensor, result in zip(tensors, inplace):
+                assert torch.equal(result, tensor * size), \
+                    'hvd.grouped_allreduce_ produces incorrect results'
+
     def test_horovod_allreduce_async_fused(self):
         """Test that the allreduce correctly sums 1D, 2D, 3D tensors
         with Tensor Fusion."""
@@ -227,6 +255,24 @@ class TorchTests(unittest.TestCase):
 
             assert max_difference <= threshold, 'hvd.allreduce produces incorrect results'
 
+    def test_horovod_wait_all_any(self):
+        """Test that wait_all() and wait_any() block until operations complete."""
+        hvd.init()
+        size = hvd.size()
+        tensors = [torch.FloatTensor(17).fill_(i) for i in range(10)]
+        handles = [hvd.allreduce_async(tensor, average=False, name='wait.%d' % i)
+                   for i, tensor in enumerate(tensors)]
+
+        handle = hvd.wait_any(handles)
+        assert handle in handles, 'hvd.wait_any returns an unknown handle'
+        assert hvd.poll(handle), 'hvd.wait_any returns an incomplete handle'
+
+        hvd.wait_all(handles)
+        for i, handle in enumerate(handles):
+            assert hvd.poll(handle), 'hvd.wait_all returns before completion'
+            summed = hvd.synchronize(handle)
+            assert summed.eq(i * size).all(), 'hvd.allreduce produces incorrect results'
+
     def test_horovod_allreduce_multi_gpu(self):
         """Test that the allreduce works on multiple GPUs."""
         # Only do this test if there are GPUs available.
@@ -368,8 +414,12 @@ class TorchTests(unittest.TestCase):
 
         hvd.allreduce_async(tensor, name='duplicate_name')
         try:
-            for i in range(10):
-                hvd.allreduce_async(tensor, name='duplicate_name')
+            # Duplicate names are detected by the background thread, which
+            # fails the duplicate operations.
+            handles = [hvd.allreduce_async(tensor, name='duplicate_name')
+                       for i in range(10)]
+            for handle in handles:
+                hvd.synchronize(handle)
             assert False, 'hvd.allreduce_async did not throw error'
         except (torch.FatalError, ValueError):
             pass
@@ -561,8 +611,10 @@ class TorchTests(unittest.TestCase):
 
         hvd.allgather_async(tensor, name='duplicate_name')
         try:
-            for i in range(10):
-                hvd.allgather_async(tensor, name='duplicate_name')
+            handles = [hvd.allgather_async(tensor, name='duplicate_name')
+                       for i in range(10)]
+            for handle in handles:
+                hvd.synchronize(handle)
             assert False, 'hvd.allgather_async did not throw error'
         except (torch.FatalError, ValueError):
             pass
@@ -610,6 +662,244 @@ class TorchTests(unittest.TestCase):
                             "gradient %s differs from expected %s, "
                             "error: %s" % (grad_out, expected, str(err)))
 
+    def test_horovod_reducescatter(self):
+        """Test that the reducescatter correctly sums and scatters 1D, 2D, 3D
+        tensors, even if the first dimension is not divisible by the size."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            # Reducescatter is only supported with the v2 API.
+            return
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = [torch.IntTensor, torch.LongTensor,
+                  torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            rows = 2 * size + 1
+            torch.manual_seed(1234)
+            tensor = torch.FloatTensor(*([rows] + [17] * (dim - 1))).random_(-100, 100)
+            tensor = tensor.type(dtype)
+            reduced = hvd.reducescatter(tensor, average=False)
+
+            # The first rows % size ranks receive one row more.
+            first_row = rank * (rows // size) + min(rank, rows % size)
+            num_rows = rows // size + (1 if rank < rows % size else 0)
+            expected = tensor[first_row:first_row + num_rows] * size
+            assert list(reduced.shape) == list(expected.shape), \
+                'hvd.reducescatter produces incorrect reduced shape'
+            assert torch.equal(reduced, expected), \
+                'hvd.reducescatter produces incorrect reduced tensor'
+
+    def test_horovod_reducescatter_error(self):
+        """Test that the reducescatter returns an error if the shapes of the
+        tensors differ among the processes."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            return
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            return
+
+        tensor = torch.FloatTensor(*([17 + rank] + [17] * 2)).fill_(1)
+
+        try:
+            hvd.reducescatter(tensor)
+            assert False, 'hvd.reducescatter did not throw error'
+        except (torch.FatalError, RuntimeError):
+            pass
+
+    def test_horovod_reducescatter_grad(self):
+        """Test the correctness of the reducescatter gradient."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            return
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            tensor = torch.FloatTensor(*([2 * size] + [17] * (dim - 1))).fill_(1)
+            tensor = tensor.type(dtype)
+            tensor.requires_grad_()
+
+            reduced = hvd.reducescatter(tensor, average=False)
+            reduced.backward(torch.ones([2] + [17] * (dim - 1)).type(dtype) * rank)
+            grad_out = tensor.grad.data.cpu().numpy()
+
+            # Every process receives the gradients of all processes, gathered.
+            expected = np.concatenate(
+                [np.ones([2] + [17] * (dim - 1)) * r for r in range(size)])
+            err = np.linalg.norm(expected - grad_out)
+            self.assertLess(err, 0.00000001,
+                            "gradient %s differs from expected %s, "
+                            "error: %s" % (grad_out, expected, str(err)))
+
+    def test_horovod_alltoall(self):
+        """Test that the alltoall correctly distributes 1D, 2D, 3D tensors,
+        with even splits and with splits which differ among the processes."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            # Alltoall is only supported with the v2 API.
+            return
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = [torch.ByteTensor, torch.CharTensor, torch.ShortTensor,
+                  torch.IntTensor, torch.LongTensor, torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.ByteTensor, torch.cuda.CharTensor, torch.cuda.ShortTensor,
+                       torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            # Slices sent to process r hold the value r.
+            tensor = torch.cat([torch.FloatTensor(*([2] + [17] * (dim - 1))).fill_(r)
+                                for r in range(size)]).type(dtype)
+            received = hvd.alltoall(tensor)
+            assert list(received.shape) == [2 * size] + [17] * (dim - 1), \
+                'hvd.alltoall produces incorrect shape'
+            assert received.data.min() == rank and received.data.max() == rank, \
+                'hvd.alltoall produces incorrect tensor'
+
+            # Process r sends (r + i) % 3 slices to process i.
+            splits = [(rank + i) % 3 for i in range(size)]
+            tensor = torch.cat([torch.FloatTensor(*([splits[i]] + [17] * (dim - 1))).fill_(i)
+                                for i in range(size)]).type(dtype)
+            received = hvd.alltoall(tensor, splits=splits)
+            rows = sum((r + rank) % 3 for r in range(size))
+            assert list(received.shape) == [rows] + [17] * (dim - 1), \
+                'hvd.alltoall produces incorrect shape'
+            if rows > 0:
+                assert received.data.min() == rank and received.data.max() == rank, \
+                    'hvd.alltoall produces incorrect tensor'
+
+    def test_horovod_alltoall_splits_error(self):
+        """Test that the alltoall returns an error if the splits do not add up
+        to the first dimension of the tensor."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            return
+        hvd.init()
+        size = hvd.size()
+
+        tensor = torch.FloatTensor(*([size + 1] + [17] * 2)).fill_(1)
+
+        try:
+            hvd.alltoall(tensor, splits=[1] * size)
+            assert False, 'hvd.alltoall did not throw error'
+        except (torch.FatalError, RuntimeError):
+            pass
+
+    def test_horovod_alltoall_grad(self):
+        """Test the correctness of the alltoall gradient."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            return
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            splits = [(rank + i) % 3 for i in range(size)]
+            tensor = torch.FloatTensor(*([sum(splits)] + [17] * (dim - 1))).fill_(1)
+            tensor = tensor.type(dtype)
+            tensor.requires_grad_()
+
+            received = hvd.alltoall(tensor, splits=splits)
+            received.backward(torch.ones(received.shape).type(dtype) * 2)
+            grad_out = tensor.grad.data.cpu().numpy()
+
+            # The gradient is sent back to the processes the slices came from.
+            expected = np.ones([sum(splits)] + [17] * (dim - 1)) * 2
+            err = np.linalg.norm(expected - grad_out)
+            self.assertLess(err, 0.00000001,
+                            "gradient %s differs from expected %s, "
+                            "error: %s" % (grad_out, expected, str(err)))
+
+    def test_horovod_sparse_allreduce(self):
+        """Test that the sparse allreduce sums the rows with the same index
+        within and across processes, and returns every index once."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            # Sparse allreduce is only supported with the v2 API.
+            return
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        for dtype in dtypes:
+            # Process r sends index r twice, and index size which every
+            # process sends.
+            indices = torch.LongTensor([[rank, size, rank]])
+            values = torch.ones(3, 17).type(dtype)
+            tensor = torch.sparse_coo_tensor(indices, values, (size + 1, 17))
+            if dtype.is_cuda:
+                tensor = tensor.cuda()
+            summed = hvd.sparse_allreduce(tensor, average=False)
+            assert summed.is_sparse, 'hvd.sparse_allreduce produces dense tensor'
+            assert summed._indices()[0].tolist() == list(range(size + 1)), \
+                'hvd.sparse_allreduce produces incorrect indices'
+            expected = torch.ones(size + 1, 17).double() * 2
+            expected[size] = size
+            assert torch.equal(summed.to_dense().double().cpu(), expected), \
+                'hvd.sparse_allreduce produces incorrect tensor'
+
+            averaged = hvd.sparse_allreduce(tensor)
+            assert torch.equal(averaged.to_dense().double().cpu(), expected / size), \
+                'hvd.sparse_allreduce produces incorrect average'
+
+    def test_horovod_sparse_allreduce_index_error(self):
+        """Test that the sparse allreduce returns an error if an index is out of
+        range of the dense tensor on any process."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            return
+        hvd.init()
+        rank = hvd.rank()
+
+        indices = torch.LongTensor([[0, 5 if rank == 0 else 1]])
+        tensor = torch.sparse_coo_tensor(indices, torch.ones(2, 17), (5, 17))
+
+        try:
+            hvd.sparse_allreduce(tensor)
+            assert False, 'hvd.sparse_allreduce did not throw error'
+        except (torch.FatalError, RuntimeError):
+            pass
+
+    def test_horovod_sparse_allreduce_optimizer(self):
+        """Test that the distributed optimizer averages the sparse gradients of
+        an embedding."""
+        if LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            return
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        embedding = torch.nn.Embedding(size + 1, 4, sparse=True)
+        torch.nn.init.zeros_(embedding.weight)
+        opt = torch.optim.SGD(embedding.parameters(), lr=1.0)
+        opt = hvd.DistributedOptimizer(
+            opt, named_parameters=embedding.named_parameters())
+        opt.zero_grad()
+        embedding(torch.LongTensor([rank, size])).sum().backward()
+        opt.step()
+
+        expected = torch.zeros(size + 1, 4)
+        expected[:size] = -1.0 / size
+        expected[size] = -1.0
+        assert torch.allclose(embedding.weight.data, expected), \
+            'hvd.DistributedOptimizer produces incorrect sparse update'
+
     def test_horovod_broadcast(self):
         """Test that the broadcast correctly broadcasts 1D, 2D, 3D tensors."""
         hvd.init()
@@ -759,8 +1049,10 @@ class TorchTests(unittest.TestCase):
 
         hvd.broadcast_async(tensor, root_rank=0, name='duplicate_name')
         try:
-            for i in range(10):
-                hvd.broadcast_async(tensor, root_rank=0, name='duplicate_name')
+            handles = [hvd.broadcast_async(tensor, root_rank=0, name='duplicate_name')
+                       for i in range(10)]
+            for handle in handles:
+                hvd.synchronize(handle)
             assert False, 'hvd.broadcast_async did not throw error'
         except (torch.FatalError, ValueError):
             pass
@@ -1037,6 +1329,69 @@ class TorchTests(unittest.TestCase):
                 err = np.linalg.norm(expected - tensor_decompressed.data.numpy())
                 self.assertLess(err, 0.00000001)
 
+    def test_horovod_allreduce_fp16_compression(self):
+        """Test that the allreduce of float32 CPU tensors compressed to 16-bit
+        by Horovod sums them within float16 precision, and keeps their type."""
+        hvd.init()
+        size = hvd.size()
+        dims = [1, 2, 3]
+        for dim in dims:
+            torch.manual_seed(1234)
+            tensor = torch.FloatTensor(*([17] * dim)).uniform_(-1, 1)
+            tensor.requires_grad_()
+            summed = hvd.allreduce(tensor, average=False,
+                                   compression=hvd.Compression.fp16)
+            self.assertEqual(summed.dtype, torch.float32)
+            max_difference = summed.data.sub(tensor.data * size).abs().max()
+            self.assertTrue(max_difference <= size * 1e-3,
+                            'hvd.allreduce with fp16 compression produces '
+                            'incorrect results')
+
+            summed.sum().backward()
+            expected = np.ones([17] * dim) * size
+            err = np.linalg.norm(expected - tensor.grad.data.numpy())
+            self.assertLess(err, 0.00000001)
+
+    def test_bucketed_gradients(self):
+        """Test that gradients averaged in native buckets match the averages
+        of the local gradients."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # Buckets are only used with several workers and the v2 API.
+        if size == 1 or LooseVersion(torch.__version__) < LooseVersion('1.0.0'):
+            return
+
+        os.environ['HOROVOD_BUCKET_SIZE'] = '1024'
+        try:
+            torch.manual_seed(1234)
+            model = torch.nn.Sequential(torch.nn.Linear(20, 30),
+                                        torch.nn.ReLU(),
+                                        torch.nn.Linear(30, 10))
+            reference = torch.nn.Sequential(torch.nn.Linear(20, 30),
+                                            torch.nn.ReLU(),
+                                            torch.nn.Linear(30, 10))
+            reference.load_state_dict(model.state_dict())
+            opt = hvd.DistributedOptimizer(
+                torch.optim.SGD(model.parameters(), lr=0.1),
+                named_parameters=model.named_parameters())
+
+            for step in range(3):
+                x = torch.randn(8, 20) * (rank + 1)
+                opt.zero_grad()
+                reference.zero_grad()
+                model(x).sum().backward()
+                reference(x).sum().backward()
+                opt.synchronize()
+                for p, ref in zip(model.parameters(), reference.parameters()):
+                    expected = hvd.allreduce(ref.grad)
+                    max_difference = p.grad.sub(expected).abs().max()
+                    assert max_difference <= 1e-4, \
+                        'bucketed gradients are not averaged correctly'
+        finally:
+            del os.environ['HOROVOD_BUCKET_SIZE']
+
     def test_force_allreduce(self):
         """Test that allreduce is forced on all gradients during opt.step()."""
         hvd.init()